@@ -0,0 +1,300 @@
+// CameraProtocol.h
+#pragma once
+//
+// Versioned wire protocol for the ESP-NOW camera link (ESPCAMSENDER,
+// ESPNOWCAMRECIEVER and the Modules/ESPNOWCamera Master/Slave pair).
+//
+// Every message starts with a packed CamMsgHeader carrying the message
+// type, protocol version, frame ID, per-packet sequence number and a
+// CRC-16 over the whole message. Receivers validate with camCheck() and
+// dispatch on the type byte instead of guessing from the payload length.
+//
+// Place this file alongside your .ino files and #include "CameraProtocol.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <string.h>
+#endif
+#include <stddef.h>
+
+#define CAM_PROTOCOL_VERSION 6
+#define CAM_MAX_MESSAGE      250   // ESP-NOW payload limit
+#define CAM_PACKET_PAYLOAD   240   // Image bytes per data packet
+
+// -------- Message types --------
+enum CamMsgType : uint8_t {
+  CAM_MSG_HEADER  = 1,  // ImageHeader: starts a frame
+  CAM_MSG_DATA    = 2,  // ImagePacket: seq = packet number
+  CAM_MSG_PARITY  = 3,  // ImagePacket: seq = FEC parity index (see PacketFec.h)
+  CAM_MSG_NACK    = 4,  // NackPacket: missing-packet report / ACK
+  CAM_MSG_COMMAND = 5,  // CommandPacket: master -> camera
+  CAM_MSG_TEXT    = 6,  // TextMessagePacket: either direction
+  CAM_MSG_REPORT  = 7,  // ReceiverReport: link statistics, receiver -> camera
+  CAM_MSG_CAPS    = 8,  // CapsPacket: display capabilities, receiver -> camera
+  CAM_MSG_TYPE_COUNT
+};
+
+// -------- Common header (8 bytes) --------
+struct __attribute__((packed)) CamMsgHeader {
+  uint8_t  type;       // CamMsgType
+  uint8_t  version;    // CAM_PROTOCOL_VERSION
+  uint16_t frameId;    // Frame the message belongs to (0 for commands/text)
+  uint16_t seq;        // Packet number within the frame
+  uint16_t crc;        // CRC-16/CCITT-FALSE of the message with crc = 0
+};
+
+// -------- Frame header --------
+struct __attribute__((packed)) ImageHeader {
+  CamMsgHeader hdr;
+  uint32_t imageSize;
+  uint16_t width;
+  uint16_t height;
+  uint16_t totalPackets;
+  uint8_t  format;
+  uint8_t  quality;
+  uint8_t  resolutionMode;
+  uint8_t  fecGroup;        // Data packets per FEC block (0 = FEC off)
+  uint8_t  fecParity;       // Parity packets per block
+  uint32_t captureMs;       // Sensor capture time on the sender's clock (ms since boot)
+  uint8_t  layer;           // CamLayer of this frame
+  uint8_t  layers;          // Frames per capture: frame IDs of one layer step by this
+};
+
+// ImageHeader.format
+enum CamFrameFormat : uint8_t {
+  CAM_FORMAT_JPEG  = 0,  // One JPEG image
+  CAM_FORMAT_TILES = 1,  // Changed tiles of the previous frame: CamTileRecord + JPEG, repeated
+};
+
+// -------- Simulcast layers --------
+// A camera feeding displays of different sizes sends each capture as up to
+// CAM_LAYER_COUNT frames with consecutive IDs: the full picture, unicast to
+// the displays it fits, and a half-scale base layer broadcast once for the
+// others. A single-layer sender sends CAM_LAYER_FULL with layers = 1.
+enum CamLayer : uint8_t {
+  CAM_LAYER_FULL = 0,
+  CAM_LAYER_BASE = 1,
+  CAM_LAYER_COUNT
+};
+
+#define CAM_LAYER_HOLD_MS 1000   // Full layer silent this long: follow the base layer
+
+// -------- Tile record (CAM_FORMAT_TILES frame payload) --------
+// Followed by `length` bytes of JPEG for the tile at (col, row) in units
+// of CAM_TILE_SIZE pixels; edge tiles may be smaller.
+#define CAM_TILE_SIZE 32
+
+struct __attribute__((packed)) CamTileRecord {
+  uint8_t  col;
+  uint8_t  row;
+  uint16_t length;
+};
+
+// -------- Image data / parity packet --------
+// Sent with length CAM_PACKET_HEADER_SIZE + payload bytes; only the last
+// data packet of a frame is shorter than CAM_PACKET_PAYLOAD.
+struct __attribute__((packed)) ImagePacket {
+  CamMsgHeader hdr;
+  uint16_t totalPackets;
+  uint8_t  data[CAM_PACKET_PAYLOAD];
+};
+
+#define CAM_PACKET_HEADER_SIZE offsetof(ImagePacket, data)
+
+// -------- Selective-repeat report --------
+// Bitmap of the packets of hdr.frameId that are still missing.
+// missingCount == 0 acknowledges the frame.
+#define NACK_BITMAP_BYTES 32   // 256 packets per report
+#define NACK_IDLE_MS 30        // Receiver waits this long for stragglers before reporting
+#define NACK_WAIT_MS 120       // Sender waits this long for a report after each pass
+#define NACK_MAX_ROUNDS 4      // Repair rounds per frame before giving up
+
+struct __attribute__((packed)) NackPacket {
+  CamMsgHeader hdr;
+  uint16_t totalPackets;
+  uint16_t missingCount;
+  uint16_t firstPacket;                 // Packet number of bitmap bit 0
+  uint8_t  bitmap[NACK_BITMAP_BYTES];   // Bit set = packet missing
+};
+
+// -------- Command (master -> camera) --------
+struct __attribute__((packed)) CommandPacket {
+  CamMsgHeader hdr;
+  char     command[32];
+  uint32_t timestamp;
+};
+
+// -------- Text message (bidirectional) --------
+struct __attribute__((packed)) TextMessagePacket {
+  CamMsgHeader hdr;
+  char     message[200];
+  uint32_t timestamp;
+  uint8_t  fromMaster;   // 1 = from master, 0 = from camera
+};
+
+// -------- Link statistics (receiver -> camera) --------
+// Sent every RATE_REPORT_MS; counts cover the time since the previous report
+#define RATE_REPORT_MS 1000
+
+struct __attribute__((packed)) ReceiverReport {
+  CamMsgHeader hdr;
+  uint16_t periodMs;
+  uint16_t framesDisplayed;
+  uint16_t framesLost;        // Timed out, superseded or never started
+  uint16_t packetsExpected;   // Data packets of the frames finished in the period
+  uint16_t packetsLost;       // ...not there on the first pass (FEC, resent or never)
+  uint32_t bytesReceived;     // Image bytes of completed frames (goodput)
+};
+
+// -------- Display capabilities (receiver -> camera) --------
+// Panel size in its native orientation and the TFT_eSPI rotation it is
+// drawn with; the camera captures only what fits (see CameraWindow.h).
+// A receiver fed by several cameras also says how many, and each camera
+// keeps to its share of the airtime.
+// Repeated every CAPS_REPEAT_MS so a restarted camera picks it up.
+#define CAPS_REPEAT_MS 5000
+
+struct __attribute__((packed)) CapsPacket {
+  CamMsgHeader hdr;
+  uint16_t panelWidth;
+  uint16_t panelHeight;
+  uint8_t  rotation;   // 0-3; odd rotations swap width and height
+  uint8_t  cameras;    // Cameras streaming to the receiver (0 = not given, as 1)
+};
+
+// Receive-side dispatch: one handler per CamMsgType
+typedef void (*CamMsgHandler)(const uint8_t* mac, const uint8_t* data, int len);
+
+// -------- CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), nibble table --------
+inline uint16_t camCrc16Update(uint16_t crc, const uint8_t* data, size_t len) {
+  static const uint16_t table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+  };
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)];
+  }
+  return crc;
+}
+
+// CRC of a whole message, treating the crc field as zero
+inline uint16_t camMessageCrc(const uint8_t* msg, size_t len) {
+  static const uint8_t zero[2] = {0, 0};
+  const size_t crcOffset = offsetof(CamMsgHeader, crc);
+  uint16_t crc = camCrc16Update(0xFFFF, msg, crcOffset);
+  crc = camCrc16Update(crc, zero, 2);
+  return camCrc16Update(crc, msg + crcOffset + 2, len - crcOffset - 2);
+}
+
+inline void camInitHeader(CamMsgHeader& hdr, CamMsgType type, uint16_t frameId, uint16_t seq) {
+  hdr.type = type;
+  hdr.version = CAM_PROTOCOL_VERSION;
+  hdr.frameId = frameId;
+  hdr.seq = seq;
+  hdr.crc = 0;
+}
+
+// Fills in the CRC; call last, right before esp_now_send
+inline void camSeal(void* msg, size_t len) {
+  CamMsgHeader* hdr = (CamMsgHeader*)msg;
+  hdr->crc = camMessageCrc((const uint8_t*)msg, len);
+}
+
+// Returns the CamMsgType of a valid message, or 0 if the length, version
+// or CRC does not match (including legacy, unversioned payloads)
+inline uint8_t camCheck(const uint8_t* data, int len) {
+  if (len < (int)sizeof(CamMsgHeader) || len > CAM_MAX_MESSAGE) return 0;
+
+  const CamMsgHeader* hdr = (const CamMsgHeader*)data;
+  if (hdr->version != CAM_PROTOCOL_VERSION) return 0;
+
+  switch (hdr->type) {
+    case CAM_MSG_HEADER:  if (len != sizeof(ImageHeader)) return 0; break;
+    case CAM_MSG_DATA:
+    case CAM_MSG_PARITY:  if (len <= (int)CAM_PACKET_HEADER_SIZE || len > (int)sizeof(ImagePacket)) return 0; break;
+    case CAM_MSG_NACK:    if (len != sizeof(NackPacket)) return 0; break;
+    case CAM_MSG_COMMAND: if (len != sizeof(CommandPacket)) return 0; break;
+    case CAM_MSG_TEXT:    if (len != sizeof(TextMessagePacket)) return 0; break;
+    case CAM_MSG_REPORT:  if (len != sizeof(ReceiverReport)) return 0; break;
+    case CAM_MSG_CAPS:    if (len != sizeof(CapsPacket)) return 0; break;
+    default: return 0;
+  }
+
+  uint16_t crc;
+  memcpy(&crc, data + offsetof(CamMsgHeader, crc), sizeof(crc));
+  if (crc != camMessageCrc(data, len)) return 0;
+  return hdr->type;
+}
+
+// Fills in the missing-packet report of a frame from its received bitset
+// (one bit per data packet, 64 per word). The bitmap starts at the first
+// gap so large frames are covered over several rounds; a complete frame,
+// or one the receiver gives up on, gets an empty report (an ACK).
+inline void camBuildNack(NackPacket& nack, uint16_t frameId, const uint64_t* received,
+                         uint16_t totalPackets, bool giveUp) {
+  memset(&nack, 0, sizeof(nack));
+  camInitHeader(nack.hdr, CAM_MSG_NACK, frameId, 0);
+  nack.totalPackets = totalPackets;
+  if (giveUp) return;
+
+  uint16_t first = 0;
+  while (first < totalPackets && ((received[first >> 6] >> (first & 63)) & 1)) first++;
+  if (first >= totalPackets) return;
+
+  nack.firstPacket = first;
+  for (uint16_t i = first; i < totalPackets && i - first < NACK_BITMAP_BYTES * 8; i++) {
+    if (!((received[i >> 6] >> (i & 63)) & 1)) {
+      uint16_t bit = i - first;
+      nack.bitmap[bit >> 3] |= 1 << (bit & 7);
+      nack.missingCount++;
+    }
+  }
+}
+
+// Simulcast: true for a frame of the layer a display follows. The camera
+// sends the full layer only to displays it fits, so a display takes it
+// whenever it arrives and the base layer only once it has stopped coming.
+inline bool camLayerWanted(const ImageHeader& header, uint32_t& lastFullMs, uint32_t now) {
+  if (header.layer == CAM_LAYER_FULL) {
+    lastFullMs = now;
+    return true;
+  }
+  return !lastFullMs || now - lastFullMs > CAM_LAYER_HOLD_MS;
+}
+
+// -------- Golden layout: any change here is a protocol version bump --------
+#ifdef __cplusplus
+  static_assert(sizeof(CamMsgHeader) == 8, "CamMsgHeader size unexpected");
+  static_assert(offsetof(CamMsgHeader, type) == 0, "CamMsgHeader.type offset");
+  static_assert(offsetof(CamMsgHeader, version) == 1, "CamMsgHeader.version offset");
+  static_assert(offsetof(CamMsgHeader, frameId) == 2, "CamMsgHeader.frameId offset");
+  static_assert(offsetof(CamMsgHeader, seq) == 4, "CamMsgHeader.seq offset");
+  static_assert(offsetof(CamMsgHeader, crc) == 6, "CamMsgHeader.crc offset");
+
+  static_assert(sizeof(ImageHeader) == 8 + 4 + 2 + 2 + 2 + 5 + 4 + 2, "ImageHeader size unexpected");
+  static_assert(offsetof(ImageHeader, imageSize) == 8, "ImageHeader.imageSize offset");
+  static_assert(offsetof(ImageHeader, totalPackets) == 16, "ImageHeader.totalPackets offset");
+  static_assert(offsetof(ImageHeader, format) == 18, "ImageHeader.format offset");
+  static_assert(offsetof(ImageHeader, fecParity) == 22, "ImageHeader.fecParity offset");
+  static_assert(offsetof(ImageHeader, captureMs) == 23, "ImageHeader.captureMs offset");
+  static_assert(offsetof(ImageHeader, layer) == 27, "ImageHeader.layer offset");
+
+  static_assert(sizeof(CamTileRecord) == 4, "CamTileRecord size unexpected");
+
+  static_assert(sizeof(ImagePacket) == CAM_MAX_MESSAGE, "ImagePacket must fill one ESP-NOW frame");
+  static_assert(offsetof(ImagePacket, data) == 10, "ImagePacket.data offset");
+
+  static_assert(sizeof(NackPacket) == 8 + 6 + NACK_BITMAP_BYTES, "NackPacket size unexpected");
+  static_assert(offsetof(NackPacket, bitmap) == 14, "NackPacket.bitmap offset");
+
+  static_assert(sizeof(CommandPacket) == 8 + 32 + 4, "CommandPacket size unexpected");
+  static_assert(sizeof(TextMessagePacket) == 8 + 200 + 4 + 1, "TextMessagePacket size unexpected");
+  static_assert(sizeof(TextMessagePacket) <= CAM_MAX_MESSAGE, "TextMessagePacket too large");
+  static_assert(sizeof(ReceiverReport) == 8 + 10 + 4, "ReceiverReport size unexpected");
+  static_assert(sizeof(CapsPacket) == 8 + 6, "CapsPacket size unexpected");
+#endif
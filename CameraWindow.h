@@ -0,0 +1,111 @@
+// CameraWindow.h
+#pragma once
+//
+// Viewport-aware capture: fit the sensor output to the receiver's panel.
+//
+// A receiver announces its panel in a CapsPacket (CameraProtocol.h). When
+// the configured frame size is larger than the visible area, the camera
+// uses OV2640 sensor windowing (set_res_raw) to capture only the centred
+// part the panel shows, at the same scale, so the pixels that would be
+// cropped are never encoded, sent or decoded.
+//
+// camViewportWindow() computes that window, camJpegSize() reads the real
+// size of a captured JPEG (the frame buffer keeps the nominal size).
+// Receivers showing a frame that is still too large (sensors without
+// windowing) decode it at the camDecodeScale() reduction and crop the rest.
+// No Arduino dependencies: builds on a desktop compiler.
+//
+// Place this file alongside your .ino files and #include "CameraWindow.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+#endif
+
+typedef struct {
+  uint8_t  mode;           // OV2640 sensor mode: 0 UXGA, 1 SVGA, 2 CIF
+  uint16_t offsetX;        // Window in sensor mode pixels
+  uint16_t offsetY;
+  uint16_t windowWidth;
+  uint16_t windowHeight;
+  uint16_t outputWidth;    // JPEG size
+  uint16_t outputHeight;
+} CamWindow;
+
+// Visible area of a panel drawn with TFT_eSPI setRotation(rotation)
+inline void camViewportSize(uint16_t panelWidth, uint16_t panelHeight, uint8_t rotation,
+                            uint16_t& width, uint16_t& height) {
+  bool swap = rotation & 1;
+  width = swap ? panelHeight : panelWidth;
+  height = swap ? panelWidth : panelHeight;
+}
+
+// Window that crops a width x height OV2640 frame to the centred
+// viewWidth x viewHeight part. Returns false when the whole frame is
+// visible and the normal frame size should be used.
+inline bool camViewportWindow(uint16_t width, uint16_t height, uint16_t viewWidth, uint16_t viewHeight,
+                              CamWindow& win) {
+  if (!viewWidth || !viewHeight || (width <= viewWidth && height <= viewHeight)) return false;
+
+  // Sensor mode the driver uses for this frame size, and its full size
+  uint16_t modeWidth, modeHeight;
+  if (width <= 400 && height <= 296) {
+    win.mode = 2;
+    modeWidth = 400;
+    modeHeight = 296;
+  } else if (width <= 800 && height <= 600) {
+    win.mode = 1;
+    modeWidth = 800;
+    modeHeight = 600;
+  } else {
+    win.mode = 0;
+    modeWidth = 1600;
+    modeHeight = 1200;
+  }
+
+  // Whole JPEG MCUs (16x8 for 4:2:2)
+  win.outputWidth = (width < viewWidth ? width : viewWidth) & ~15;
+  win.outputHeight = (height < viewHeight ? height : viewHeight) & ~7;
+  if (!win.outputWidth || !win.outputHeight) return false;
+
+  // Same scale as the full frame: the window covers what the output shows
+  win.windowWidth = ((uint32_t)win.outputWidth * modeWidth / width) & ~3;
+  win.windowHeight = ((uint32_t)win.outputHeight * modeHeight / height) & ~3;
+  win.offsetX = ((modeWidth - win.windowWidth) / 2) & ~1;
+  win.offsetY = ((modeHeight - win.windowHeight) / 2) & ~1;
+  return true;
+}
+
+// JPEG decode scale (1, 2, 4 or 8) for a width x height frame on a
+// viewWidth x viewHeight viewport: the largest reduction whose output still
+// covers the viewport, so frames at least twice the viewport size skip most
+// of the IDCT and colour conversion (tjpgd uses only DC terms at 1/8)
+inline uint8_t camDecodeScale(uint16_t width, uint16_t height, uint16_t viewWidth, uint16_t viewHeight) {
+  uint8_t scale = 1;
+  while (scale < 8 && width / (scale * 2) >= viewWidth && height / (scale * 2) >= viewHeight) {
+    scale *= 2;
+  }
+  return scale;
+}
+
+// Size from the SOF segment of a JPEG; false if there is none
+inline bool camJpegSize(const uint8_t* jpeg, uint32_t len, uint16_t& width, uint16_t& height) {
+  if (len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return false;
+
+  uint32_t pos = 2;
+  while (pos + 9 <= len && jpeg[pos] == 0xFF) {
+    uint8_t marker = jpeg[pos + 1];
+    uint16_t segLen = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+    if (marker >= 0xC0 && marker <= 0xC3) {
+      height = (jpeg[pos + 5] << 8) | jpeg[pos + 6];
+      width = (jpeg[pos + 7] << 8) | jpeg[pos + 8];
+      return true;
+    }
+    if (marker == 0xDA || segLen < 2) return false;
+    pos += 2 + segLen;
+  }
+  return false;
+}
@@ -20,6 +20,8 @@ const uint8_t WIFI_CHANNEL = 1;   // Keep both devices on same channel
 uint8_t DISPLAY_PEER_MAC[] = {0x24, 0xEC, 0x4A, 0xE8, 0x6C, 0xB4};
 // Device C (Ringer/LED/Matrix)
 uint8_t RINGER_PEER_MAC[]  = {0x3C, 0x8A, 0x1F, 0xD4, 0x53, 0xBC};
+// Camera display (Modules/ESPNOWCamera/Master_Display): saves its pre-roll on RING / emergency
+uint8_t CAMERA_PEER_MAC[]  = {0xE8, 0x06, 0x90, 0x97, 0x92, 0xC4};
 
 // --------- Item Types ----------
 enum ItemType {
@@ -164,7 +166,32 @@ bool sendToRinger(const char* cmd, int value = 0) {
   if (ENABLE_DEBUG) Serial.printf("[A→C cmd] %s (%d)\n", cmd, value);
   return true;
 }
-void c_ring()     { sendToRinger("RING");    sendToRinger("LED_ON");  }
+// --------- Event triggers to the camera display ---------
+bool sendToCamera(const uint8_t* data, size_t len) {
+  esp_err_t r = esp_now_send(CAMERA_PEER_MAC, data, len);
+  if (r != ESP_OK) {
+    Serial.printf("[A→Cam] send err=%d\n", r);
+    return false;
+  }
+  return true;
+}
+
+void cameraRing() {
+  RingerMessage m{};
+  strlcpy(m.command, "RING", sizeof(m.command));
+  sendToCamera((uint8_t*)&m, sizeof(m));
+}
+
+void cameraEmergency(int index, const char* name) {
+  Payload p{};
+  p.action = ACT_EMERGENCY;
+  p.index  = index;
+  strlcpy(p.name, name, sizeof(p.name));
+  sendToCamera((uint8_t*)&p, sizeof(p));
+}
+
+void c_bell()     { sendToRinger("RING");    sendToRinger("LED_ON"); }
+void c_ring()     { c_bell(); cameraRing(); }
 void c_stopAll()  { sendToRinger("STOP");    sendToRinger("LED_OFF"); }
 
 // --------- ESPNOW callback ----------
@@ -229,7 +256,8 @@ void handleEmergency(int itemIndex) {
   const char* name = validIndex(itemIndex) ? ITEMS[itemIndex] : "Unknown";
   Serial.printf("[EMERGENCY] %s\n", name);
   sendDisplayToC(ACT_EMERGENCY, itemIndex, name, 0);
-  c_ring();
+  cameraEmergency(itemIndex, name);
+  c_bell();   // The camera already has its trigger: c_ring() would send a second one
 }
 
 void rotary_onButtonClick() {
@@ -389,6 +417,15 @@ void setupESPNow() {
   if (esp_now_add_peer(&peerC) != ESP_OK) {
     Serial.println("[ESP-NOW] add peer C failed");
   }
+
+  // Camera display
+  esp_now_peer_info_t peerCam{};
+  memcpy(peerCam.peer_addr, CAMERA_PEER_MAC, 6);
+  peerCam.channel = WIFI_CHANNEL;
+  peerCam.encrypt = false;
+  if (esp_now_add_peer(&peerCam) != ESP_OK) {
+    Serial.println("[ESP-NOW] add camera peer failed");
+  }
 }
 
 void printSystemInfo() {
@@ -1,21 +1,49 @@
 #include "esp_camera.h"
+#include "img_converters.h"
 #include <WiFi.h>
 #include <esp_now.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
+#include "CameraProtocol.h"
+#include "PacketFec.h"
+#include "SendWindow.h"
+#include "RateController.h"
+#include "CameraWindow.h"
+#include "FrameSender.h"
 
 // Resolution control - change this value (0-4) to adjust quality/speed
 #define RESOLUTION_MODE 0
 
-// Automatic resolution adjustment based on performance
-#define AUTO_RESOLUTION_ADJUST 0
+// Adaptive bitrate: frame size and JPEG quality follow the receiver's
+// reports (RateController.h); 0 keeps RESOLUTION_MODE fixed
+#define AUTO_RESOLUTION_ADJUST 1
 
-// Performance thresholds for auto-adjustment
-#define TARGET_FPS 5.0f
-#define MIN_FPS_THRESHOLD 4.0f
-#define MAX_FPS_THRESHOLD 6.0f
+// Hold each frame until the receiver acknowledges it and resend only missing packets
+#define SELECTIVE_REPEAT 1
+
+// Forward error correction: FEC_PARITY_PACKETS parity packets after every
+// FEC_GROUP_SIZE data packets (set FEC_GROUP_SIZE to 0 to disable)
+#define FEC_GROUP_SIZE 8
+#define FEC_PARITY_PACKETS 1
+
+// Simulcast: displays at most half the size of the picture get a base
+// layer scaled to their panels (1/2, 1/4 or 1/8) instead, re-encoded from
+// each capture and broadcast once for all of them; the full layer is
+// unicast to the other displays (0 = full layer to every display)
+#define SIMULCAST 1
+#define BASE_LAYER_QUALITY 60          // fmt2jpg quality (0-100) of the base layer
+#define BASE_MAX_PIXELS ((400 / 2) * (296 / 2))   // Half of CIF, the largest ResolutionConfig
+
+// Fan-out: a layer going to two or more displays is broadcast once instead
+// of unicast to each, and their repair requests are merged (NackMerge.h)
+// into one rebroadcast per round (0 = unicast to each display)
+#define FANOUT_BROADCAST 1
+
+// Adaptive bitrate targets
+#define TARGET_FPS_X10 50              // Display rate to hold, in 0.1 FPS
+#define RATE_MAX_FRAME_BYTES 35000     // MAX_FRAME_SIZE in ESPNOWCAMRECIEVER.ino
 
 // Camera pins for Freenove ESP32-S3
 #define PWDN_GPIO_NUM     -1
@@ -35,24 +63,49 @@
 #define HREF_GPIO_NUM     7
 #define PCLK_GPIO_NUM     13
 
-uint8_t receiverMac[] = {0x84, 0xFC, 0xE6, 0x50, 0xA2, 0x2C}; // UPDATE WITH YOUR RECEIVER MAC
+// Displays fed by this camera - UPDATE WITH YOUR RECEIVER MACS (all-zero
+// entries are unused, at most 8)
+const uint8_t receiverMacs[][6] = {
+  {0x84, 0xFC, 0xE6, 0x50, 0xA2, 0x2C},   // ESPNOWCAMRECIEVER, 240x240
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00}    // Master_Display, 320x240
+};
+
+const int NUM_RECEIVERS = sizeof(receiverMacs) / sizeof(receiverMacs[0]);
+static_assert(NUM_RECEIVERS <= 8, "Receivers are tracked in 8-bit masks");
+
+const uint8_t broadcastMac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
-// Common packet structures
+// What a display announced (CapsPacket) and the layer it is sent
 typedef struct {
-  uint16_t packetNum;
-  uint16_t totalPackets;
-  uint16_t dataSize;
-  uint8_t data[240];
-} ImagePacket;
+  uint16_t viewWidth;           // 0 = not announced yet: gets the full layer
+  uint16_t viewHeight;
+  uint8_t layer;                // CamLayer
+} Receiver;
+
+// Wire messages (ImageHeader, ImagePacket, NackPacket) are defined in CameraProtocol.h
 
+// Packet waiting for the packet task; len is the on-air message length
 typedef struct {
-  uint32_t imageSize;
-  uint16_t width;
-  uint16_t height;
-  uint8_t format;
-  uint8_t quality;
-  uint8_t resolutionMode;
-} ImageHeader;
+  uint16_t len;
+  int8_t dest;                  // Receiver index, or CAM_TX_BROADCAST
+  ImagePacket packet;
+} QueuedPacket;
+
+// Reports from a display, tagged with its receiver index
+typedef struct {
+  int8_t peer;
+  NackPacket nack;
+} PeerNack;
+
+typedef struct {
+  int8_t peer;
+  ReceiverReport report;
+} PeerReport;
+
+typedef struct {
+  int8_t peer;
+  CapsPacket caps;
+} PeerCaps;
 
 // Resolution configurations (using proper ESP32 frame sizes)
 typedef struct {
@@ -76,58 +129,239 @@ const ResolutionConfig resolutionConfigs[] = {
 
 const int NUM_RESOLUTION_MODES = sizeof(resolutionConfigs) / sizeof(resolutionConfigs[0]);
 
+// Rate ladder: resolution mode and quality chosen together, smallest frames first
+const RateRung rateLadder[] = {
+  {4, 18,  3000},   // 96x96
+  {3, 20,  4000},   // QQVGA, coarse
+  {3, 12,  6000},   // QQVGA
+  {0, 20,  8000},   // HQVGA, coarse
+  {0, 14, 11000},   // HQVGA
+  {1, 18, 13000},   // QVGA
+  {1, 12, 18000},   // QVGA, fine
+  {2, 12, 24000}    // CIF
+};
+
+const int NUM_RATE_RUNGS = sizeof(rateLadder) / sizeof(rateLadder[0]);
+
 typedef struct {
   camera_fb_t* fb;
   uint32_t timestamp;
 } FrameBuffer;
 
+// Frames sent and kept until their receivers acknowledge them: one per
+// layer of each capture in flight
+#define CAPTURES_IN_FLIGHT 2
+#define CAPTURE_LAYERS (SIMULCAST ? CAM_LAYER_COUNT : 1)
+#define FRAMES_IN_FLIGHT (CAPTURES_IN_FLIGHT * CAPTURE_LAYERS)
+
 // RTOS components
 QueueHandle_t frameQueue;
 QueueHandle_t transmitQueue;
+QueueHandle_t nackQueue;
+QueueHandle_t reportQueue;
+QueueHandle_t capsQueue;
 SemaphoreHandle_t wifiSemaphore;
 TaskHandle_t captureTaskHandle;
 TaskHandle_t transmitTaskHandle;
 TaskHandle_t packetTaskHandle;
 
+// In-flight packet window, advanced by the send callback
+SendWindow sendWindow;
+TaskHandle_t volatile windowWaiter = nullptr;
+
 // Performance tracking
 volatile unsigned long lastFPSTime = 0;
 volatile int capturedFrames = 0;
 volatile int transmittedFrames = 0;
 volatile int droppedFrames = 0;
+volatile int retransmittedPackets = 0;
+volatile int unackedFrames = 0;
+volatile int baseFrames = 0;
+volatile int airPackets = 0;    // Messages put on the air, headers and repairs included
+uint16_t frameId = 0;
+CamTxFrame inFlight[FRAMES_IN_FLIGHT];   // owner: the driver buffer, or baseLayers[i]
+camera_fb_t baseLayers[FRAMES_IN_FLIGHT];  // Base layer JPEGs (fmt2jpg buffers, freed once done)
+FrameSender sender;
 volatile int currentResolutionMode = RESOLUTION_MODE;
-volatile float currentFPS = 0.0f;
-volatile unsigned long lastResolutionAdjust = 0;
+volatile int currentQuality = resolutionConfigs[RESOLUTION_MODE].quality;
+RateController rateController;
+
+// Largest viewport any display announced (0 = none yet); the sensor is
+// windowed to it
+uint16_t viewWidth = 0;
+uint16_t viewHeight = 0;
+
+Receiver receivers[NUM_RECEIVERS];
+uint8_t listedReceivers = 0;    // Bits of the non-zero receiverMacs entries
+uint8_t* baseRgb = nullptr;     // Scaled RGB565 decode of a capture (base layer)
+
+// Crops the sensor output to the receiver's viewport. A frame size change
+// resets the sensor window, so this follows every set_framesize().
+void applyViewport() {
+  sensor_t* s = esp_camera_sensor_get();
+  if (!s || s->id.PID != OV2640_PID) return;
+  
+  const ResolutionConfig& config = resolutionConfigs[currentResolutionMode];
+  CamWindow win;
+  if (!camViewportWindow(config.width, config.height, viewWidth, viewHeight, win)) return;
+  
+  s->set_res_raw(s, win.mode, 0, 0, 0, win.offsetX, win.offsetY, win.windowWidth, win.windowHeight,
+                 win.outputWidth, win.outputHeight, false, false);
+  Serial.printf("Viewport %ux%u: %s captured as %ux%u\n", viewWidth, viewHeight,
+                config.name, win.outputWidth, win.outputHeight);
+}
+
+// Switches the sensor to a rung of the rate ladder
+void applyRung(uint8_t rung) {
+  const RateRung& r = rateLadder[rung];
+  sensor_t* s = esp_camera_sensor_get();
+  if (!s) return;
+  
+  bool resize = r.mode != currentResolutionMode;
+  if (resize) {
+    s->set_framesize(s, resolutionConfigs[r.mode].frameSize);
+  }
+  if (r.quality != currentQuality) {
+    s->set_quality(s, r.quality);
+  }
+  currentResolutionMode = r.mode;
+  currentQuality = r.quality;
+  if (resize) {
+    applyViewport();
+  }
+  Serial.printf("Rate: rung %d, %s (%dx%d), Quality %d, budget %lu bytes/frame\n",
+                rung, resolutionConfigs[r.mode].name,
+                resolutionConfigs[r.mode].width, resolutionConfigs[r.mode].height,
+                r.quality, (unsigned long)rateController.getBudget());
+}
 
-void adjustResolution() {
+// Layer whose displays drive the rate ladder: the full layer while any
+// display takes it, since the ladder sizes the capture
+uint8_t rateLayer() {
+  for (int i = 0; i < NUM_RECEIVERS; i++) {
+    if ((listedReceivers & (1 << i)) && receivers[i].layer == CAM_LAYER_FULL) return CAM_LAYER_FULL;
+  }
+  return CAM_LAYER_BASE;
+}
+
+// Feeds one receiver report to the rate controller. The RATE line holds the
+// raw report, so a captured log can be replayed through RateController.
+void handleReport(int peer, const ReceiverReport& report) {
+  if (receivers[peer].layer != rateLayer()) return;
+  
+  RateSample sample;
+  sample.periodMs = report.periodMs;
+  sample.framesDisplayed = report.framesDisplayed;
+  sample.framesLost = report.framesLost;
+  sample.packetsExpected = report.packetsExpected;
+  sample.packetsLost = report.packetsLost;
+  sample.bytesReceived = report.bytesReceived;
+  
+  unsigned long now = millis();
+  Serial.printf("RATE,%lu,%u,%u,%u,%u,%u,%lu,%u\n", now, sample.periodMs, sample.framesDisplayed,
+                sample.framesLost, sample.packetsExpected, sample.packetsLost,
+                (unsigned long)sample.bytesReceived, rateController.getRungIndex());
+  
   if (!AUTO_RESOLUTION_ADJUST) return;
-  if (millis() - lastResolutionAdjust < 5000) return;
-  
-  int newMode = currentResolutionMode;
-  
-  if (currentFPS < MIN_FPS_THRESHOLD && currentResolutionMode < NUM_RESOLUTION_MODES - 1) {
-    newMode = currentResolutionMode + 1;
-    Serial.printf("FPS too low (%.1f), reducing to mode %d (%s)\n", 
-                  currentFPS, newMode, resolutionConfigs[newMode].name);
-  } else if (currentFPS > MAX_FPS_THRESHOLD && currentResolutionMode > 0) {
-    newMode = currentResolutionMode - 1;
-    Serial.printf("FPS good (%.1f), increasing to mode %d (%s)\n", 
-                  currentFPS, newMode, resolutionConfigs[newMode].name);
-  }
-  
-  if (newMode != currentResolutionMode) {
-    sensor_t* s = esp_camera_sensor_get();
-    if (s) {
-      s->set_framesize(s, resolutionConfigs[newMode].frameSize);
-      s->set_quality(s, resolutionConfigs[newMode].quality);
-      currentResolutionMode = newMode;
-      Serial.printf("Resolution: %s (%dx%d), Quality: %d\n", 
-                    resolutionConfigs[newMode].name,
-                    resolutionConfigs[newMode].width,
-                    resolutionConfigs[newMode].height,
-                    resolutionConfigs[newMode].quality);
+  
+  uint8_t before = rateController.getRungIndex();
+  uint8_t rung = rateController.update(sample, now);
+  if (rung != before) {
+    applyRung(rung);
+  }
+}
+
+// A display announced its panel: capture only what the largest one can
+// show (with SIMULCAST the smaller ones get the base layer)
+void handleCaps(int peer, const CapsPacket& caps) {
+  uint16_t width, height;
+  camViewportSize(caps.panelWidth, caps.panelHeight, caps.rotation, width, height);
+  if (width == receivers[peer].viewWidth && height == receivers[peer].viewHeight) return;  // Periodic repeat
+  
+  receivers[peer].viewWidth = width;
+  receivers[peer].viewHeight = height;
+  
+  width = 0;
+  height = 0;
+  for (int i = 0; i < NUM_RECEIVERS; i++) {
+    width = max(width, receivers[i].viewWidth);
+    height = max(height, receivers[i].viewHeight);
+  }
+  if (width == viewWidth && height == viewHeight) return;
+  
+  viewWidth = width;
+  viewHeight = height;
+  
+  // Back to the full frame first, then window it for the new viewport
+  sensor_t* s = esp_camera_sensor_get();
+  if (s) {
+    s->set_framesize(s, resolutionConfigs[currentResolutionMode].frameSize);
+  }
+  applyViewport();
+}
+
+// Receivers (bits) that get a width x height capture as the full layer:
+// any that has not announced its panel yet, and the ones no 1/2 reduction
+// of it would still cover, which crop the full picture instead (a 240x240
+// panel and a 320x240 capture)
+uint8_t fullLayerReceivers(uint16_t width, uint16_t height) {
+  uint8_t mask = 0;
+  for (int i = 0; i < NUM_RECEIVERS; i++) {
+    const Receiver& r = receivers[i];
+    if (!SIMULCAST || !baseRgb || !r.viewWidth || camDecodeScale(width, height, r.viewWidth, r.viewHeight) < 2) {
+      mask |= 1 << i;
+    }
+  }
+  return mask & listedReceivers;
+}
+
+// Base layer reduction for the displays in baseMask: the largest of 1/2,
+// 1/4 and 1/8 that still covers every one of their viewports, the way the
+// receivers pick their decode scale. Each of them is at most half the
+// capture (fullLayerReceivers()), so 1/2 always does. Base displays larger
+// than the smallest one show it centred, smaller than their panel.
+uint8_t baseLayerScale(uint16_t width, uint16_t height, uint8_t baseMask) {
+  uint16_t minWidth = UINT16_MAX;
+  uint16_t minHeight = UINT16_MAX;
+  for (int i = 0; i < NUM_RECEIVERS; i++) {
+    if (baseMask & (1 << i)) {
+      minWidth = min(minWidth, receivers[i].viewWidth);
+      minHeight = min(minHeight, receivers[i].viewHeight);
     }
-    lastResolutionAdjust = millis();
   }
+  
+  uint8_t scale = camDecodeScale(width, height, minWidth, minHeight);
+  while (scale < 8 && (uint32_t)(width / scale) * (height / scale) > BASE_MAX_PIXELS) {
+    scale *= 2;
+  }
+  return scale;
+}
+
+// Scaled re-encode of a capture for the base layer. The JPEG is decoded at
+// the reduced scale, so full-size pixels are never produced.
+bool encodeBaseLayer(camera_fb_t* fb, uint16_t width, uint16_t height, uint8_t scale, camera_fb_t& base) {
+  uint16_t baseWidth = width / scale;
+  uint16_t baseHeight = height / scale;
+  if (!baseRgb || (uint32_t)baseWidth * baseHeight > BASE_MAX_PIXELS) return false;
+  jpg_scale_t jpgScale = scale == 8 ? JPG_SCALE_8X : scale == 4 ? JPG_SCALE_4X : JPG_SCALE_2X;
+  if (!jpg2rgb565(fb->buf, fb->len, baseRgb, jpgScale)) return false;
+  
+  uint8_t* jpg = nullptr;
+  size_t jpgLen = 0;
+  if (!fmt2jpg(baseRgb, baseWidth * baseHeight * 2, baseWidth, baseHeight,
+               PIXFORMAT_RGB565, BASE_LAYER_QUALITY, &jpg, &jpgLen)) {
+    Serial.println("Base layer encode failed");
+    return false;
+  }
+  
+  base = {};
+  base.buf = jpg;
+  base.len = jpgLen;
+  base.width = baseWidth;
+  base.height = baseHeight;
+  base.format = PIXFORMAT_JPEG;
+  base.timestamp = fb->timestamp;
+  return true;
 }
 
 void captureTask(void* parameter) {
@@ -169,82 +403,297 @@ void captureTask(void* parameter) {
   }
 }
 
+// Sends as soon as the window has room instead of sleeping per packet;
+// call with wifiSemaphore held
+void sendWindowed(int8_t dest, const void* msg, int len) {
+  windowWaiter = xTaskGetCurrentTaskHandle();
+  while (!sendWindow.canSend()) {
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SEND_WINDOW_TIMEOUT_MS)) == 0) {
+      sendWindow.expire();
+    }
+  }
+  
+  sendWindow.onSent();
+  const uint8_t* mac = dest == CAM_TX_BROADCAST ? broadcastMac : receiverMacs[dest];
+  if (esp_now_send(mac, (const uint8_t*)msg, len) != ESP_OK) {
+    sendWindow.onRejected();
+  } else {
+    airPackets++;
+  }
+}
+
 void packetTransmissionTask(void* parameter) {
-  ImagePacket packet;
+  QueuedPacket item;
   
   for(;;) {
-    if (xQueueReceive(transmitQueue, &packet, portMAX_DELAY) == pdTRUE) {
+    if (xQueueReceive(transmitQueue, &item, portMAX_DELAY) == pdTRUE) {
       xSemaphoreTake(wifiSemaphore, portMAX_DELAY);
-      esp_now_send(receiverMac, (uint8_t*)&packet, sizeof(packet));
-      vTaskDelay(pdMS_TO_TICKS(1));
+      sendWindowed(item.dest, &item.packet, item.len);
       xSemaphoreGive(wifiSemaphore);
     }
   }
 }
 
+// FrameSender output: headers go out right away, packets through the
+// packet task. Repairs go to the front of the queue: behind the next frame
+// they would arrive after the receiver has given up on this one.
+void sendMessage(void* ctx, int8_t dest, const void* msg, uint16_t len, CamTxKind kind) {
+  if (kind == CAM_TX_HEADER) {
+    xSemaphoreTake(wifiSemaphore, portMAX_DELAY);
+    sendWindowed(dest, msg, len);
+    xSemaphoreGive(wifiSemaphore);
+    return;
+  }
+  
+  QueuedPacket item;
+  item.dest = dest;
+  item.len = len;
+  memcpy(&item.packet, msg, len);
+  if (kind == CAM_TX_REPAIR) {
+    xQueueSendToFront(transmitQueue, &item, portMAX_DELAY);
+    retransmittedPackets++;
+  } else {
+    xQueueSend(transmitQueue, &item, portMAX_DELAY);
+  }
+}
+
+void reportStats() {
+  if (millis() - lastFPSTime <= 3000) return;
+  
+  float captureFPS = capturedFrames / ((millis() - lastFPSTime) / 1000.0);
+  float transmitFPS = transmittedFrames / ((millis() - lastFPSTime) / 1000.0);
+  float airPerFrame = transmittedFrames ? (float)airPackets / transmittedFrames : 0;
+  
+  Serial.printf("Mode %d (%s) q%d: Cap %.1f FPS, Tx %.1f FPS (%d base), Drop %d, Q %d, Resent %d, Air %.1f pkt/frame, Unacked %d, Win %u, %lu pkt/s, Rx %u.%u FPS, loss %u.%u%%\n", 
+                currentResolutionMode, resolutionConfigs[currentResolutionMode].name, currentQuality,
+                captureFPS, transmitFPS, baseFrames, droppedFrames, 
+                uxQueueMessagesWaiting(frameQueue), retransmittedPackets, airPerFrame, unackedFrames,
+                sendWindow.getWindow(), (unsigned long)sendWindow.getRate(),
+                rateController.getFpsX10() / 10, rateController.getFpsX10() % 10,
+                rateController.getLossPermille() / 10, rateController.getLossPermille() % 10);
+  
+  capturedFrames = 0;
+  transmittedFrames = 0;
+  droppedFrames = 0;
+  retransmittedPackets = 0;
+  unackedFrames = 0;
+  baseFrames = 0;
+  airPackets = 0;
+  lastFPSTime = millis();
+}
+
+// Returns the camera buffer (or frees the base layer) once the frame is
+// acknowledged or given up
+void frameDone(void* ctx, CamTxFrame& frame, bool acked) {
+  camera_fb_t* fb = (camera_fb_t*)frame.owner;
+  if (frame.layer == CAM_LAYER_BASE) {
+    free(fb->buf);
+    baseFrames++;
+  } else {
+    esp_camera_fb_return(fb);
+  }
+  if (!acked) {
+    unackedFrames++;
+  }
+  transmittedFrames++;
+  reportStats();
+}
+
+// Sends one layer of a capture from a free slot
+void startFrame(CamTxFrame& frame, camera_fb_t* fb, uint16_t id, uint8_t layer, uint8_t waiting) {
+  ImageHeader header;
+  // A windowed frame is smaller than its nominal frame size
+  uint16_t width, height;
+  if (!camJpegSize(fb->buf, fb->len, width, height)) {
+    width = fb->width;
+    height = fb->height;
+  }
+  header.width = width;
+  header.height = height;
+  header.format = CAM_FORMAT_JPEG;
+  header.quality = layer == CAM_LAYER_BASE ? BASE_LAYER_QUALITY : currentQuality;
+  header.resolutionMode = currentResolutionMode;
+  header.captureMs = fb->timestamp.tv_sec * 1000UL + fb->timestamp.tv_usec / 1000;
+  header.layer = layer;
+  header.layers = CAPTURE_LAYERS;
+  
+  // A full layer broadcast would also reach the base layer's displays, which
+  // would switch to it: only broadcast when every display takes it
+  bool broadcast = layer == CAM_LAYER_BASE ||
+                   (FANOUT_BROADCAST && (waiting & (waiting - 1)) && waiting == listedReceivers);
+  sender.start(frame, fb->buf, fb->len, fb, id, header, waiting, broadcast, millis());
+}
+
+// Tells which layer each display now gets, logging the switches
+void assignLayers(uint8_t fullMask) {
+  for (int i = 0; i < NUM_RECEIVERS; i++) {
+    if (!(listedReceivers & (1 << i))) continue;
+    
+    uint8_t layer = (fullMask & (1 << i)) ? CAM_LAYER_FULL : CAM_LAYER_BASE;
+    if (layer != receivers[i].layer) {
+      receivers[i].layer = layer;
+      Serial.printf("Receiver %d: %s layer\n", i, layer == CAM_LAYER_FULL ? "full" : "base");
+    }
+  }
+}
+
 void transmitTask(void* parameter) {
   FrameBuffer frameWrapper;
+  PeerNack nack;
+  PeerReport report;
+  PeerCaps caps;
   
   for(;;) {
-    if (xQueueReceive(frameQueue, &frameWrapper, portMAX_DELAY) == pdTRUE) {
-      camera_fb_t* fb = frameWrapper.fb;
-      
-      xSemaphoreTake(wifiSemaphore, portMAX_DELAY);
-      
-      ImageHeader header;
-      header.imageSize = fb->len;
-      header.width = fb->width;
-      header.height = fb->height;
-      header.format = 0;
-      header.quality = resolutionConfigs[currentResolutionMode].quality;
-      header.resolutionMode = currentResolutionMode;
-      
-      esp_now_send(receiverMac, (uint8_t*)&header, sizeof(header));
-      vTaskDelay(pdMS_TO_TICKS(3));
-      xSemaphoreGive(wifiSemaphore);
-      
-      uint16_t totalPackets = (fb->len + 239) / 240;
-      
-      for (uint16_t i = 0; i < totalPackets; i++) {
-        ImagePacket packet;
-        packet.packetNum = i;
-        packet.totalPackets = totalPackets;
-        
-        uint32_t startIdx = i * 240;
-        uint32_t endIdx = min(startIdx + 240, (uint32_t)fb->len);
-        packet.dataSize = endIdx - startIdx;
-        
-        memcpy(packet.data, &fb->buf[startIdx], packet.dataSize);
-        xQueueSend(transmitQueue, &packet, portMAX_DELAY);
+    while (xQueueReceive(nackQueue, &nack, 0) == pdTRUE) {
+      sender.onNack(nack.peer, nack.nack, millis());
+    }
+    while (xQueueReceive(reportQueue, &report, 0) == pdTRUE) {
+      handleReport(report.peer, report.report);
+    }
+    while (xQueueReceive(capsQueue, &caps, 0) == pdTRUE) {
+      handleCaps(caps.peer, caps.caps);
+    }
+    sender.repair(millis());
+    // Nothing counts as idle while our own packets are still queued
+    if (uxQueueMessagesWaiting(transmitQueue) == 0) {
+      sender.expire(millis());
+    }
+    
+    // A new capture may start while earlier ones are still being repaired,
+    // once there is a free slot for each of its layers
+    CamTxFrame* slots[CAM_LAYER_COUNT];
+    int freeSlots = 0;
+    bool waiting = false;
+    for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
+      if (inFlight[i].data) {
+        waiting = true;
+      } else if (freeSlots < CAPTURE_LAYERS) {
+        slots[freeSlots++] = &inFlight[i];
       }
-      
-      esp_camera_fb_return(fb);
-      transmittedFrames++;
-      
-      // Calculate FPS and adjust resolution
-      if (millis() - lastFPSTime > 3000) {
-        float captureFPS = capturedFrames / ((millis() - lastFPSTime) / 1000.0);
-        float transmitFPS = transmittedFrames / ((millis() - lastFPSTime) / 1000.0);
-        currentFPS = transmitFPS;
-        
-        Serial.printf("Mode %d (%s): Cap %.1f FPS, Tx %.1f FPS, Drop %d, Q %d\n", 
-                      currentResolutionMode, resolutionConfigs[currentResolutionMode].name,
-                      captureFPS, transmitFPS, droppedFrames, 
-                      uxQueueMessagesWaiting(frameQueue));
-        
-        adjustResolution();
-        
-        capturedFrames = 0;
-        transmittedFrames = 0;
-        droppedFrames = 0;
-        lastFPSTime = millis();
+    }
+    
+    if (freeSlots < CAPTURE_LAYERS) {
+      // Window full: sleep until a report arrives
+      if (xQueueReceive(nackQueue, &nack, pdMS_TO_TICKS(5)) == pdTRUE) {
+        sender.onNack(nack.peer, nack.nack, millis());
+      }
+      sender.repair(millis());
+      continue;
+    }
+    
+    TickType_t wait = waiting ? pdMS_TO_TICKS(5) : portMAX_DELAY;
+    if (xQueueReceive(frameQueue, &frameWrapper, wait) != pdTRUE) {
+      continue;
+    }
+    
+    camera_fb_t* fb = frameWrapper.fb;
+    uint16_t width = fb->width;
+    uint16_t height = fb->height;
+    camJpegSize(fb->buf, fb->len, width, height);
+    
+    uint8_t fullMask = fullLayerReceivers(width, height);
+    uint8_t baseMask = SIMULCAST ? listedReceivers & ~fullMask : 0;
+    assignLayers(fullMask);
+    
+    // Layers of one capture take consecutive frame IDs
+    uint16_t id = frameId + 1;
+    frameId += CAPTURE_LAYERS;
+    
+    CamTxFrame& full = *slots[CAM_LAYER_FULL];
+    if (fullMask) {
+      rateController.onFrame(fb->len);
+      startFrame(full, fb, id + CAM_LAYER_FULL, CAM_LAYER_FULL, fullMask);
+    }
+    
+    // Encoded while the full layer's packets drain; the capture is still held
+    if (baseMask) {
+      CamTxFrame& base = *slots[CAM_LAYER_BASE];
+      camera_fb_t& baseFb = baseLayers[&base - inFlight];
+      if (encodeBaseLayer(fb, width, height, baseLayerScale(width, height, baseMask), baseFb)) {
+        if (!fullMask) {
+          rateController.onFrame(baseFb.len);
+        }
+        startFrame(base, &baseFb, id + CAM_LAYER_BASE, CAM_LAYER_BASE, baseMask);
+        if (!SELECTIVE_REPEAT) {
+          sender.finish(base, true);
+        }
       }
     }
+    
+    if (!fullMask) {
+      esp_camera_fb_return(fb);
+    } else if (!SELECTIVE_REPEAT) {
+      sender.finish(full, true);
+    }
   }
 }
 
 void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
-  // Minimal callback
+  sendWindow.onComplete(status == ESP_NOW_SEND_SUCCESS, millis());
+  if (windowWaiter) {
+    xTaskNotifyGive(windowWaiter);
+  }
+}
+
+// Index of a listed display in receiverMacs, -1 for anyone else
+int findReceiver(const uint8_t* mac) {
+  for (int i = 0; i < NUM_RECEIVERS; i++) {
+    if ((listedReceivers & (1 << i)) && memcmp(mac, receiverMacs[i], 6) == 0) return i;
+  }
+  return -1;
+}
+
+void onNack(const uint8_t *mac, const uint8_t *data, int len) {
+  PeerNack item;
+  item.peer = findReceiver(mac);
+  if (nackQueue && item.peer >= 0) {
+    memcpy(&item.nack, data, sizeof(item.nack));
+    xQueueSend(nackQueue, &item, 0);
+  }
+}
+
+void onReport(const uint8_t *mac, const uint8_t *data, int len) {
+  PeerReport item;
+  item.peer = findReceiver(mac);
+  if (reportQueue && item.peer >= 0) {
+    memcpy(&item.report, data, sizeof(item.report));
+    xQueueSend(reportQueue, &item, 0);
+  }
+}
+
+// One slot per display; a dropped announcement is repeated within seconds
+void onCaps(const uint8_t *mac, const uint8_t *data, int len) {
+  PeerCaps item;
+  item.peer = findReceiver(mac);
+  if (capsQueue && item.peer >= 0) {
+    memcpy(&item.caps, data, sizeof(item.caps));
+    xQueueSend(capsQueue, &item, 0);
+  }
+}
+
+bool addPeer(const uint8_t* mac) {
+  esp_now_peer_info_t peerInfo = {};
+  memcpy(peerInfo.peer_addr, mac, 6);
+  peerInfo.channel = 0;
+  peerInfo.encrypt = false;
+  peerInfo.ifidx = WIFI_IF_STA;
+  return esp_now_add_peer(&peerInfo) == ESP_OK;
+}
+
+// Dispatch table indexed by CamMsgType; the sender only listens for reports
+const CamMsgHandler rxHandlers[CAM_MSG_TYPE_COUNT] = {
+  nullptr, nullptr, nullptr, nullptr,
+  onNack,    // CAM_MSG_NACK
+  nullptr, nullptr,
+  onReport,  // CAM_MSG_REPORT
+  onCaps     // CAM_MSG_CAPS
+};
+
+void OnDataRecv(const uint8_t *mac, const uint8_t *incomingData, int len) {
+  uint8_t type = camCheck(incomingData, len);
+  if (type && rxHandlers[type]) {
+    rxHandlers[type](mac, incomingData, len);
+  }
 }
 
 void setup() {
@@ -278,7 +727,7 @@ void setup() {
   config.grab_mode = CAMERA_GRAB_LATEST;
   config.fb_location = CAMERA_FB_IN_PSRAM;
   config.jpeg_quality = resolutionConfigs[RESOLUTION_MODE].quality;
-  config.fb_count = 2;
+  config.fb_count = CAPTURES_IN_FLIGHT + 1;   // Captures being repaired + one capturing
   
   esp_err_t err = esp_camera_init(&config);
   if (err != ESP_OK) {
@@ -295,26 +744,57 @@ void setup() {
   }
   
   esp_now_register_send_cb(OnDataSent);
+  esp_now_register_recv_cb(OnDataRecv);
   
-  esp_now_peer_info_t peerInfo;
-  memcpy(peerInfo.peer_addr, receiverMac, 6);
-  peerInfo.channel = 0;
-  peerInfo.encrypt = false;
-  peerInfo.ifidx = WIFI_IF_STA;
+  static const uint8_t unusedMac[6] = {0};
+  for (int i = 0; i < NUM_RECEIVERS; i++) {
+    if (memcmp(receiverMacs[i], unusedMac, 6) == 0) continue;
+    if (!addPeer(receiverMacs[i])) {
+      Serial.println("Failed to add peer");
+      return;
+    }
+    listedReceivers |= 1 << i;
+  }
   
-  if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-    Serial.println("Failed to add peer");
-    return;
+  if (SIMULCAST) {
+    if (!addPeer(broadcastMac)) {
+      Serial.println("Failed to add broadcast peer");
+      return;
+    }
+    baseRgb = (uint8_t*)(psramFound() ? ps_malloc(BASE_MAX_PIXELS * 2) : malloc(BASE_MAX_PIXELS * 2));
+    if (!baseRgb) {
+      Serial.println("No memory for the base layer: full layer only");
+    }
   }
   
   frameQueue = xQueueCreate(3, sizeof(FrameBuffer));
-  transmitQueue = xQueueCreate(100, sizeof(ImagePacket));
+  transmitQueue = xQueueCreate(100, sizeof(QueuedPacket));
+  nackQueue = xQueueCreate(4 * FRAMES_IN_FLIGHT * NUM_RECEIVERS, sizeof(PeerNack));
+  reportQueue = xQueueCreate(2 * NUM_RECEIVERS, sizeof(PeerReport));
+  capsQueue = xQueueCreate(NUM_RECEIVERS, sizeof(PeerCaps));
   wifiSemaphore = xSemaphoreCreateMutex();
   
-  if (!frameQueue || !transmitQueue || !wifiSemaphore) {
+  if (!frameQueue || !transmitQueue || !nackQueue || !reportQueue || !capsQueue || !wifiSemaphore) {
     Serial.println("Failed to create RTOS components");
     return;
   }
+  
+  // Repairs are queued at the front of transmitQueue
+  sender.begin(inFlight, FRAMES_IN_FLIGHT, sendMessage, frameDone, nullptr, true);
+  sender.setFec(FEC_GROUP_SIZE, FEC_PARITY_PACKETS);
+  
+  // Start on the ladder rung that matches RESOLUTION_MODE
+  uint8_t startRung = 0;
+  for (int i = 0; i < NUM_RATE_RUNGS; i++) {
+    if (rateLadder[i].mode == RESOLUTION_MODE && rateLadder[i].quality == currentQuality) {
+      startRung = i;
+    }
+  }
+  rateController.begin(rateLadder, NUM_RATE_RUNGS, startRung, TARGET_FPS_X10, RATE_MAX_FRAME_BYTES);
+  if (AUTO_RESOLUTION_ADJUST) {
+    applyRung(startRung);
+  }
+  
   pinMode(48,OUTPUT);
   digitalWrite(48,LOW);
   xTaskCreatePinnedToCore(captureTask, "CaptureTask", 4096, NULL, 3, &captureTaskHandle, 0);
@@ -6,26 +6,47 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
+#include "CameraProtocol.h"
+#include "PacketFec.h"
+#include "PacketRing.h"
+#include "JpegConceal.h"
+#include "CameraWindow.h"
+#include "StripRenderer.h"
+#include "JitterBuffer.h"
+
+// Frames reassembled at the same time, so the sender can start a new frame
+// while retransmissions for the previous one are still arriving
+#define RX_FRAMES 2
+
+// Jitter buffer: frames are shown at a steady rate from their capture
+// times, held at most JITTER_FRAMES frames / JITTER_MAX_DELAY_MS
+#define JITTER_FRAMES 2
+#define JITTER_MAX_DELAY_MS 250
+
+#define FRAME_POOL_SLOTS (RX_FRAMES + JITTER_FRAMES + 1)   // + held for playout + on screen
+#include "FramePool.h"
+#include "FrameReassembly.h"
 
 // Resolution control - change this value (0-4) to adjust quality/speed
 #define RESOLUTION_MODE 0
 
-// Common packet structures (must match sender)
-typedef struct {
-  uint16_t packetNum;
-  uint16_t totalPackets;
-  uint16_t dataSize;
-  uint8_t data[240];
-} ImagePacket;
+// Report missing packets back to the sender instead of waiting for the timeout
+#define SELECTIVE_REPEAT 1
 
-typedef struct {
-  uint32_t imageSize;
-  uint16_t width;
-  uint16_t height;
-  uint8_t format;
-  uint8_t quality;
-  uint8_t resolutionMode;
-} ImageHeader;
+// Send decoded MCU rows to the panel with DMA while the next row decodes,
+// instead of one SPI write per block
+#define STRIP_RENDER 0
+
+// Panel announced to the camera (CapsPacket), which then sends only what fits
+#define PANEL_WIDTH 240
+#define PANEL_HEIGHT 240
+#define PANEL_ROTATION 0
+
+// Largest JPEG accepted; every frame slot is this big
+// (largest ResolutionConfig::maxExpectedSize in ESPCAMSENDER.ino)
+#define MAX_FRAME_SIZE 35000
+
+// Wire messages (ImageHeader, ImagePacket, NackPacket) are defined in CameraProtocol.h
 
 // Resolution display configurations
 typedef struct {
@@ -49,144 +70,256 @@ const int NUM_DISPLAY_MODES = sizeof(displayConfigs) / sizeof(displayConfigs[0])
 TFT_eSPI tft = TFT_eSPI();
 
 typedef struct {
-  uint8_t* imageData;
+  uint8_t* imageData;   // Points into framePool
+  int8_t slot;          // Pool slot to release once displayed
   uint32_t imageSize;
   uint16_t width;
   uint16_t height;
   uint8_t resolutionMode;
   uint32_t timestamp;
+  uint32_t captureMs;      // Sender clock, from the ImageHeader
+  uint64_t concealedRows;  // MCU rows patched by JpegConceal.h, keep the previous frame there
+  uint8_t mcuHeight;
 } CompleteImage;
 
 // RTOS components
 QueueHandle_t imageQueue;
-QueueHandle_t packetQueue;
+PacketRing rxRing;   // Receive callback -> packet task, lock-free
 SemaphoreHandle_t displaySemaphore;
 TaskHandle_t packetProcessingTaskHandle;
 TaskHandle_t displayTaskHandle;
 
-// Image reconstruction
-uint8_t* imageBuffer = nullptr;
-uint32_t expectedImageSize = 0;
-uint16_t expectedTotalPackets = 0;
-bool* packetReceived = nullptr;
-uint32_t packetsReceivedCount = 0;
-unsigned long lastPacketTime = 0;
-bool receivingImage = false;
+// Reassembly state of one frame (FrameReassembly.h), assembled in a pool slot
+struct FrameContext : RxFrame {
+  int8_t slot;                  // framePool slot the image is assembled in
+};
+
+// Image reconstruction, assembled in place in pool slots
+FramePool framePool;
+FrameContext frames[RX_FRAMES];
+RxSequence sequence = {};
+uint32_t lastFullLayerMs = 0;   // Simulcast sender: last full-layer header (camLayerWanted)
+
+// Header of the image being drawn (used by tft_output)
 ImageHeader currentHeader;
+uint64_t currentConcealedRows = 0;
+uint8_t currentMcuHeight = 8;
+
+// Visible area, and where the frame being drawn lands on it
+uint16_t viewWidth = PANEL_WIDTH;
+uint16_t viewHeight = PANEL_HEIGHT;
+uint8_t currentScale = 1;      // TJpgDec scale of the frame being drawn
+int16_t currentLeft = 0;       // Panel position of the decoded frame's origin
+int16_t currentTop = 0;
+bool currentClipped = false;   // Decode stopped below the viewport
+StripRenderer strips;
+
+// Frames waiting for their playout time, by pool slot
+JitterBuffer jitter;
+CompleteImage heldFrames[FRAME_POOL_SLOTS];
+
+// Selective-repeat state
+uint8_t senderMac[6];
+bool senderKnown = false;
 
 // Performance tracking
 volatile unsigned long lastDisplayTime = 0;
 volatile int imagesReceived = 0;
 volatile int imagesDisplayed = 0;
 volatile int packetsProcessed = 0;
+volatile int packetsRepaired = 0;
+volatile int packetsRecovered = 0;
+volatile int framesSkipped = 0;
+volatile int framesSuperseded = 0;
+volatile int framesConcealed = 0;
+
+// Link statistics for the sender's rate controller, reset every report
+unsigned long lastReportTime = 0;
+unsigned long lastCapsTime = 0;
+bool capsSent = false;
+volatile int reportDisplayed = 0;
+int reportFramesLost = 0;
+int reportPacketsExpected = 0;
+int reportPacketsLost = 0;
+uint32_t reportBytes = 0;
 
 // TJpg callback with dynamic positioning
 bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
-  if (currentHeader.resolutionMode < NUM_DISPLAY_MODES) {
-    const DisplayConfig& config = displayConfigs[currentHeader.resolutionMode];
-    
-    if (config.width <= 240 && config.height <= 240) {
-      // Image fits, center it
-      tft.pushImage(x + config.displayX, y + config.displayY, w, h, bitmap);
-    } else {
-      // Image larger than display, crop center portion
-      int16_t cropX = (config.width - 240) / 2;
-      int16_t cropY = (config.height - 240) / 2;
-      
-      if (x >= cropX && y >= cropY && 
-          x + w <= cropX + 240 && y + h <= cropY + 240) {
-        tft.pushImage(x - cropX, y - cropY, w, h, bitmap);
-      }
+  // Lost band of a concealed frame: leave the previous frame on screen
+  if (jpegConcealRowLost(currentConcealedRows, y, currentScale, currentMcuHeight)) {
+    return 1;
+  }
+  
+  // Smaller frames are centred; larger ones (camera not windowed to the
+  // panel) are cropped to their centre
+  int16_t left = x + currentLeft;
+  int16_t top = y + currentTop;
+  
+  // MCUs arrive row by row: past the bottom of the viewport nothing else
+  // is visible, so stop the decode instead of entropy-decoding the rest
+  if (top >= (int16_t)viewHeight) {
+    currentClipped = true;
+    return 0;
+  }
+  if (left >= (int16_t)viewWidth || left + w <= 0 || top + h <= 0) {
+    return 1;
+  }
+  
+  if (strips.ready()) {
+    if (!strips.block(left, top, w, h, bitmap)) {
+      currentClipped = true;
+      return 0;
     }
-  } else {
-    // Fallback - center on display
-    int16_t centerX = (240 - currentHeader.width) / 2;
-    int16_t centerY = (240 - currentHeader.height) / 2;
-    if (centerX < 0) centerX = 0;
-    if (centerY < 0) centerY = 0;
-    tft.pushImage(x + centerX, y + centerY, w, h, bitmap);
+    return 1;
   }
+  
+  // Blocks straddling the edge are clipped by TFT_eSPI
+  tft.pushImage(left, top, w, h, bitmap);
   return 1;
 }
 
-void packetProcessingTask(void* parameter) {
-  ImagePacket packet;
+// Queues the reassembled frame for the display task
+void completeImageReception(FrameContext& frame) {
+  if (SELECTIVE_REPEAT) {
+    sendNack(frame, false);  // Acknowledge so the sender can release the frame
+  }
   
-  for(;;) {
-    if (xQueueReceive(packetQueue, &packet, portMAX_DELAY) == pdTRUE) {
-      packetsProcessed++;
-      
-      if (!receivingImage || packet.packetNum >= expectedTotalPackets) {
-        continue;
-      }
-      
-      if (packetReceived[packet.packetNum]) {
-        continue;
+  // Verify JPEG header
+  if (frame.imageBuffer[0] == 0xFF && frame.imageBuffer[1] == 0xD8) {
+    // Hand the slot itself to the display task
+    CompleteImage completeImg;
+    completeImg.imageData = frame.imageBuffer;
+    completeImg.slot = frame.slot;
+    completeImg.imageSize = frame.header.imageSize;
+    completeImg.width = frame.header.width;
+    completeImg.height = frame.header.height;
+    completeImg.resolutionMode = frame.header.resolutionMode;
+    completeImg.timestamp = millis();
+    completeImg.captureMs = frame.header.captureMs;
+    completeImg.concealedRows = 0;
+    completeImg.mcuHeight = 8;
+    
+    if (xQueueSend(imageQueue, &completeImg, 0) != pdTRUE) {
+      CompleteImage oldImg;
+      if (xQueueReceive(imageQueue, &oldImg, 0) == pdTRUE) {
+        framePool.release(oldImg.slot);
       }
-      
-      uint32_t bufferPos = packet.packetNum * 240;
-      uint32_t copySize = min((uint32_t)packet.dataSize, expectedImageSize - bufferPos);
-      
-      if (bufferPos + copySize <= expectedImageSize) {
-        memcpy(&imageBuffer[bufferPos], packet.data, copySize);
-        packetReceived[packet.packetNum] = true;
-        packetsReceivedCount++;
-        
-        if (packetsReceivedCount >= expectedTotalPackets) {
-          // Verify JPEG header
-          if (imageBuffer[0] == 0xFF && imageBuffer[1] == 0xD8) {
-            CompleteImage completeImg;
-            completeImg.imageData = (uint8_t*)malloc(expectedImageSize);
-            if (completeImg.imageData) {
-              memcpy(completeImg.imageData, imageBuffer, expectedImageSize);
-              completeImg.imageSize = expectedImageSize;
-              completeImg.width = currentHeader.width;
-              completeImg.height = currentHeader.height;
-              completeImg.resolutionMode = currentHeader.resolutionMode;
-              completeImg.timestamp = millis();
-              
-              if (xQueueSend(imageQueue, &completeImg, 0) != pdTRUE) {
-                CompleteImage oldImg;
-                if (xQueueReceive(imageQueue, &oldImg, 0) == pdTRUE) {
-                  free(oldImg.imageData);
-                }
-                xQueueSend(imageQueue, &completeImg, 0);
-              }
-              
-              imagesReceived++;
-            }
-          }
-          resetImageReception();
-        }
+      xQueueSend(imageQueue, &completeImg, 0);
+    }
+    frame.slot = -1;
+    
+    imagesReceived++;
+    reportBytes += frame.header.imageSize;
+  }
+  
+  // Older frames still in reassembly would be shown out of order; drop them
+  // and acknowledge them so the sender stops repairing them too
+  for (int i = 0; i < RX_FRAMES; i++) {
+    FrameContext& other = frames[i];
+    if (&other == &frame || !other.active) continue;
+    if (rxNewer(frame.header.hdr.frameId, other.header.hdr.frameId)) {
+      if (SELECTIVE_REPEAT) {
+        sendNack(other, true);
       }
-      
-      lastPacketTime = millis();
+      framesSuperseded++;
+      resetFrame(other);
     }
   }
+  
+  resetFrame(frame);
+}
+
+void processPacket(const ImagePacket& packet, int len) {
+  // Packets are routed by frame ID; a frame never merges packets of another
+  FrameContext* frame = rxFindFrame(frames, RX_FRAMES, packet.hdr.frameId);
+  if (!frame) {
+    return;
+  }
+  
+  uint8_t result = rxAddPacket(*frame, packet, len, millis());
+  if (result & RX_PACKET_REPAIRED) {
+    packetsRepaired++;
+  }
+  if (result & RX_PACKET_RECOVERED) {
+    packetsRecovered++;
+  }
+  if (result & RX_FRAME_COMPLETE) {
+    completeImageReception(*frame);
+  }
+}
+
+// Moves finished frames into the jitter buffer and waits until one is due.
+// Returns false when it woke up without a frame to draw.
+bool nextFrame(CompleteImage& image) {
+  uint32_t wait = jitter.timeToNext(millis());
+  TickType_t ticks = (wait == JITTER_IDLE) ? portMAX_DELAY : pdMS_TO_TICKS(wait);
+  
+  while (xQueueReceive(imageQueue, &image, ticks) == pdTRUE) {
+    heldFrames[image.slot] = image;
+    int16_t dropped = jitter.push(image.slot, image.captureMs, millis());
+    if (dropped >= 0) {
+      framePool.release(dropped);
+    }
+    ticks = 0;   // Take whatever else is queued, then schedule
+  }
+  
+  // Fallen behind: skip to the newest frame that is due
+  int16_t slot;
+  while ((slot = jitter.takeLate(millis())) >= 0) {
+    framePool.release(slot);
+  }
+  
+  slot = jitter.takeDue(millis());
+  if (slot < 0) {
+    return false;
+  }
+  image = heldFrames[slot];
+  return true;
 }
 
 void displayTask(void* parameter) {
   CompleteImage image;
   
   for(;;) {
-    if (xQueueReceive(imageQueue, &image, portMAX_DELAY) == pdTRUE) {
+    if (nextFrame(image)) {
       xSemaphoreTake(displaySemaphore, portMAX_DELAY);
       
       unsigned long displayStart = millis();
       
-      // Clear screen for new resolution mode
+      // Clear screen when the frame size changes
       static uint8_t lastResolutionMode = 255;
-      if (image.resolutionMode != lastResolutionMode) {
+      static uint16_t lastWidth = 0;
+      static uint16_t lastHeight = 0;
+      if (image.resolutionMode != lastResolutionMode || image.width != lastWidth || image.height != lastHeight) {
         tft.fillScreen(TFT_BLUE);
         lastResolutionMode = image.resolutionMode;
+        lastWidth = image.width;
+        lastHeight = image.height;
       }
       
       // Update current header for callback
       currentHeader.width = image.width;
       currentHeader.height = image.height;
       currentHeader.resolutionMode = image.resolutionMode;
+      currentConcealedRows = image.concealedRows;
+      currentMcuHeight = image.mcuHeight;
       
-      if (TJpgDec.drawJpg(0, 0, image.imageData, image.imageSize) != JDR_OK) {
+      // Frames at least twice the viewport are decoded scaled down
+      currentScale = camDecodeScale(image.width, image.height, viewWidth, viewHeight);
+      currentLeft = ((int16_t)viewWidth - (int16_t)(image.width / currentScale)) / 2;
+      currentTop = ((int16_t)viewHeight - (int16_t)(image.height / currentScale)) / 2;
+      currentClipped = false;
+      TJpgDec.setJpgScale(currentScale);
+      
+      if (strips.ready()) {
+        strips.startFrame(currentLeft, currentTop, image.width / currentScale, image.height / currentScale,
+                          0, 0, viewWidth, viewHeight);
+      }
+      JRESULT result = TJpgDec.drawJpg(0, 0, image.imageData, image.imageSize);
+      if (strips.ready()) {
+        strips.endFrame();
+      }
+      if (result != JDR_OK && !(result == JDR_INTR && currentClipped)) {
         tft.setTextColor(TFT_RED, TFT_BLUE);
         tft.setTextSize(1);
         tft.drawString("DECODE ERROR", 80, 110);
@@ -195,8 +328,9 @@ void displayTask(void* parameter) {
       
       xSemaphoreGive(displaySemaphore);
       
-      free(image.imageData);
+      framePool.release(image.slot);
       imagesDisplayed++;
+      reportDisplayed++;
       
       unsigned long displayTime = millis() - displayStart;
       
@@ -205,67 +339,264 @@ void displayTask(void* parameter) {
         float displayFPS = imagesDisplayed / ((millis() - lastDisplayTime) / 1000.0);
         
         if (image.resolutionMode < NUM_DISPLAY_MODES) {
-          Serial.printf("Mode %d (%s): Rx %.1f FPS, Display %.1f FPS, %lums\n", 
+          Serial.printf("Mode %d (%s): Rx %.1f FPS, Display %.1f FPS, %lums, Repaired %d, FEC %d, Missed %d, Superseded %d, Concealed %d, Overflow %lu, Allocs %lu\n", 
                         image.resolutionMode, displayConfigs[image.resolutionMode].name,
-                        receiveFPS, displayFPS, displayTime);
+                        receiveFPS, displayFPS, displayTime, packetsRepaired, packetsRecovered,
+                        framesSkipped, framesSuperseded, framesConcealed, (unsigned long)rxRing.getDrops(),
+                        (unsigned long)framePool.getAllocations());
+        }
+        Serial.printf("Playout delay %lu ms (%d/%d held, interval %lu ms), late %lu, overflow %lu\n",
+                      (unsigned long)jitter.getDelayMs(), jitter.getCount(), jitter.getDepth(),
+                      (unsigned long)jitter.getIntervalMs(), (unsigned long)jitter.getFramesLate(),
+                      (unsigned long)jitter.getFramesOverflow());
+        if (strips.ready()) {
+          Serial.printf("DMA strips: %u per frame, decode %lu us, SPI wait %lu us\n",
+                        strips.getStrips(), (unsigned long)strips.getDecodeUs(), (unsigned long)strips.getWaitUs());
         }
         
         imagesReceived = 0;
         imagesDisplayed = 0;
         packetsProcessed = 0;
+        packetsRepaired = 0;
+        packetsRecovered = 0;
+        framesSkipped = 0;
+        framesSuperseded = 0;
+        framesConcealed = 0;
         lastDisplayTime = millis();
       }
     }
   }
 }
 
-void resetImageReception() {
-  if (imageBuffer) {
-    free(imageBuffer);
-    imageBuffer = nullptr;
+// Releases a frame's slot; a slot still held here belongs to an incomplete frame
+void resetFrame(FrameContext& frame) {
+  if (frame.active) {
+    reportPacketsExpected += frame.header.totalPackets;
+    reportPacketsLost += frame.header.totalPackets - frame.firstPass;
+    if (frame.packetsReceived < frame.header.totalPackets) {
+      reportFramesLost++;
+    }
+  }
+  if (frame.slot >= 0) {
+    framePool.release(frame.slot);
+    frame.slot = -1;
   }
-  if (packetReceived) {
-    free(packetReceived);
-    packetReceived = nullptr;
+  frame.imageBuffer = nullptr;
+  frame.active = false;
+}
+
+// The sender becomes a peer once its first header arrives
+bool senderPeerReady() {
+  if (!senderKnown) return false;
+  
+  if (!esp_now_is_peer_exist(senderMac)) {
+    esp_now_peer_info_t peerInfo = {};
+    memcpy(peerInfo.peer_addr, senderMac, 6);
+    peerInfo.channel = 0;
+    peerInfo.encrypt = false;
+    peerInfo.ifidx = WIFI_IF_STA;
+    if (esp_now_add_peer(&peerInfo) != ESP_OK) return false;
   }
-  expectedImageSize = 0;
-  expectedTotalPackets = 0;
-  packetsReceivedCount = 0;
-  receivingImage = false;
+  return true;
+}
+
+// Reports the missing packets of a frame; an empty bitmap is an ACK, also
+// used to release a frame the receiver has given up on
+void sendNack(FrameContext& frame, bool giveUp) {
+  if (!senderPeerReady()) return;
+  
+  NackPacket nack;
+  rxBuildNack(frame, nack, giveUp, millis());
+  esp_now_send(senderMac, (uint8_t*)&nack, sizeof(nack));
+}
+
+// Tells the sender what actually got through, for its rate controller
+void sendReport() {
+  unsigned long now = millis();
+  if (now - lastReportTime < RATE_REPORT_MS) return;
+  
+  if (senderPeerReady()) {
+    ReceiverReport report;
+    camInitHeader(report.hdr, CAM_MSG_REPORT, 0, 0);
+    report.periodMs = min(now - lastReportTime, 60000UL);
+    report.framesDisplayed = reportDisplayed;
+    report.framesLost = reportFramesLost;
+    report.packetsExpected = reportPacketsExpected;
+    report.packetsLost = reportPacketsLost;
+    report.bytesReceived = reportBytes;
+    camSeal(&report, sizeof(report));
+    esp_now_send(senderMac, (uint8_t*)&report, sizeof(report));
+  }
+  
+  reportDisplayed = 0;
+  reportFramesLost = 0;
+  reportPacketsExpected = 0;
+  reportPacketsLost = 0;
+  reportBytes = 0;
+  lastReportTime = now;
+}
+
+// Announces the panel to the sender, and again now and then in case the
+// camera restarted
+void sendCaps() {
+  unsigned long now = millis();
+  if (capsSent && now - lastCapsTime < CAPS_REPEAT_MS) return;
+  if (!senderPeerReady()) return;
+  
+  CapsPacket caps;
+  camInitHeader(caps.hdr, CAM_MSG_CAPS, 0, 0);
+  caps.panelWidth = PANEL_WIDTH;
+  caps.panelHeight = PANEL_HEIGHT;
+  caps.rotation = PANEL_ROTATION;
+  caps.cameras = 1;
+  camSeal(&caps, sizeof(caps));
+  esp_now_send(senderMac, (uint8_t*)&caps, sizeof(caps));
+  
+  capsSent = true;
+  lastCapsTime = now;
+}
+
+void checkRepair() {
+  if (!SELECTIVE_REPEAT) return;
+  
+  unsigned long now = millis();
+  for (int i = 0; i < RX_FRAMES; i++) {
+    if (rxNackDue(frames[i], now)) {
+      sendNack(frames[i], false);
+      frames[i].nackRounds++;
+    }
+  }
+}
+
+void onImageHeader(const uint8_t *mac, const uint8_t *data, int len) {
+  const ImageHeader& header = *(const ImageHeader*)data;
+  if (!rxHeaderValid(header, MAX_FRAME_SIZE)) return;
+  if (rxFindFrame(frames, RX_FRAMES, header.hdr.frameId)) return;  // Duplicate header
+  
+  // A simulcast sender gives this panel the base layer when the full
+  // picture does not fit it; the other layer's packets are dropped undecoded
+  if (!camLayerWanted(header, lastFullLayerMs, millis())) return;
+  
+  // Frames whose header never arrived show up as gaps in the frame ID
+  uint16_t missed = rxMissedFrames(sequence, header);
+  framesSkipped += missed;
+  reportFramesLost += missed;
+  
+  // Free context, or the oldest frame in reassembly
+  FrameContext* frame = rxPickFrame(frames, RX_FRAMES, header.hdr.frameId);
+  resetFrame(*frame);
+  
+  // Reuse a free slot, dropping the oldest undisplayed frame if necessary
+  frame->slot = framePool.acquire();
+  if (frame->slot < 0) {
+    CompleteImage oldImg;
+    if (xQueueReceive(imageQueue, &oldImg, 0) == pdTRUE) {
+      framePool.release(oldImg.slot);
+      frame->slot = framePool.acquire();
+    }
+  }
+  if (frame->slot < 0) {
+    return;
+  }
+  
+  rxStartFrame(*frame, header, framePool.data(frame->slot), millis());
+  memcpy(senderMac, mac, 6);
+  senderKnown = true;
 }
 
+void onImagePacket(const uint8_t *mac, const uint8_t *data, int len) {
+  processPacket(*(const ImagePacket*)data, len);
+}
+
+// Dispatch table indexed by CamMsgType (runs in the packet task)
+const CamMsgHandler rxHandlers[CAM_MSG_TYPE_COUNT] = {
+  nullptr,
+  onImageHeader,   // CAM_MSG_HEADER
+  onImagePacket,   // CAM_MSG_DATA
+  onImagePacket,   // CAM_MSG_PARITY
+  nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+// Runs in the Wi-Fi task: one copy into the ring, no allocation, locking or printing
 void OnDataRecv(const uint8_t *mac, const uint8_t *incomingData, int len) {
-  if (len == sizeof(ImageHeader)) {
-    ImageHeader* header = (ImageHeader*)incomingData;
-    
-    resetImageReception();
-    
-    expectedImageSize = header->imageSize;
-    expectedTotalPackets = (expectedImageSize + 239) / 240;
-    currentHeader = *header;
-    
-    imageBuffer = (uint8_t*)malloc(expectedImageSize);
-    packetReceived = (bool*)calloc(expectedTotalPackets, sizeof(bool));
+  if (rxRing.push(mac, incomingData, len) && packetProcessingTaskHandle) {
+    xTaskNotifyGive(packetProcessingTaskHandle);
+  }
+}
+
+void packetProcessingTask(void* parameter) {
+  PacketSlot* slot;
+  
+  for(;;) {
+    // Wake up periodically so gaps are reported even when the stream goes quiet
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
     
-    if (imageBuffer && packetReceived) {
-      receivingImage = true;
-      packetsReceivedCount = 0;
-      lastPacketTime = millis();
-    } else {
-      resetImageReception();
+    // Messages are validated and handled in place, then the slot is handed back
+    while ((slot = rxRing.peek()) != nullptr) {
+      uint8_t type = camCheck(slot->data, slot->len);
+      if (type && rxHandlers[type]) {
+        rxHandlers[type](slot->mac, slot->data, slot->len);
+        packetsProcessed++;
+      }
+      rxRing.release();
     }
-    return;
+    
+    checkRepair();
+    checkTimeout();
+    sendReport();
+    sendCaps();
   }
+}
+
+// Shows a frame whose missing packets will not come any more, with the lost
+// restart intervals patched from the previous frame
+bool concealFrame(FrameContext& frame) {
+  int slot = framePool.acquire();
+  if (slot < 0) return false;
+  
+  JpegConcealInfo info;
+  uint32_t size = jpegConceal(frame.imageBuffer, frame.header.imageSize, frame.receivedBits, CAM_PACKET_PAYLOAD,
+                              framePool.data(slot), framePool.getSlotSize(), info);
+  if (size == 0) {
+    framePool.release(slot);
+    return false;
+  }
+  
+  CompleteImage completeImg;
+  completeImg.imageData = framePool.data(slot);
+  completeImg.slot = slot;
+  completeImg.imageSize = size;
+  completeImg.width = frame.header.width;
+  completeImg.height = frame.header.height;
+  completeImg.resolutionMode = frame.header.resolutionMode;
+  completeImg.timestamp = millis();
+  completeImg.captureMs = frame.header.captureMs;
+  completeImg.concealedRows = info.rows;
+  completeImg.mcuHeight = info.mcuHeight;
   
-  if (len == sizeof(ImagePacket) && receivingImage) {
-    ImagePacket packet = *(ImagePacket*)incomingData;
-    xQueueSendFromISR(packetQueue, &packet, NULL);
+  if (xQueueSend(imageQueue, &completeImg, 0) != pdTRUE) {
+    framePool.release(slot);
+    return false;
   }
+  
+  framesConcealed++;
+  return true;
 }
 
 void checkTimeout() {
-  if (receivingImage && (millis() - lastPacketTime > 3000)) {
-    resetImageReception();
+  for (int i = 0; i < RX_FRAMES; i++) {
+    FrameContext& frame = frames[i];
+    if (!frame.active) continue;
+    
+    unsigned long idle = millis() - frame.lastPacketTime;
+    bool settled = rxSettled(frame, SELECTIVE_REPEAT, millis());
+    if (settled) {
+      concealFrame(frame);
+    }
+    
+    if (idle > 3000 || settled) {
+      resetFrame(frame);
+    }
   }
 }
 
@@ -274,7 +605,8 @@ void setup() {
   Serial.println("RTOS Camera Receiver Starting (240x240 Display)");
   
   tft.init();
-  tft.setRotation(0);
+  tft.setRotation(PANEL_ROTATION);
+  camViewportSize(PANEL_WIDTH, PANEL_HEIGHT, PANEL_ROTATION, viewWidth, viewHeight);
   tft.fillScreen(TFT_BLUE);
   tft.setTextColor(TFT_WHITE, TFT_BLUE);
   tft.setTextSize(2);
@@ -286,6 +618,10 @@ void setup() {
   TJpgDec.setSwapBytes(true);
   TJpgDec.setCallback(tft_output);
   
+  if (STRIP_RENDER && !strips.begin(&tft)) {
+    Serial.println("DMA strips unavailable, drawing blocks directly");
+  }
+  
   WiFi.mode(WIFI_STA);
   Serial.printf("Receiver MAC: %s\n", WiFi.macAddress().c_str());
   
@@ -294,13 +630,32 @@ void setup() {
     return;
   }
   
+  // Frame slots plus the per-frame tracking buffers, all allocated once.
+  // Parity never exceeds one packet per data packet plus one partial block.
+  uint16_t maxPackets = (MAX_FRAME_SIZE + CAM_PACKET_PAYLOAD - 1) / CAM_PACKET_PAYLOAD;
+  uint16_t maxParity = maxPackets + FEC_MAX_PARITY;
+  if (!framePool.begin(MAX_FRAME_SIZE)) {
+    Serial.println("Failed to allocate frame pool");
+    return;
+  }
+  for (int i = 0; i < RX_FRAMES; i++) {
+    frames[i].slot = -1;
+    frames[i].receivedBits = (uint64_t*)framePool.allocate(bitsetWords(maxPackets) * sizeof(uint64_t));
+    frames[i].parityBuffer = (uint8_t*)framePool.allocate(maxParity * FEC_PAYLOAD_SIZE);
+    frames[i].parityBits = (uint64_t*)framePool.allocate(bitsetWords(maxParity) * sizeof(uint64_t));
+    if (!frames[i].receivedBits || !frames[i].parityBuffer || !frames[i].parityBits) {
+      Serial.println("Failed to allocate reassembly buffers");
+      return;
+    }
+  }
+  
   esp_now_register_recv_cb(OnDataRecv);
   
   imageQueue = xQueueCreate(2, sizeof(CompleteImage));
-  packetQueue = xQueueCreate(150, sizeof(ImagePacket));
+  jitter.begin(JITTER_FRAMES, JITTER_MAX_DELAY_MS);
   displaySemaphore = xSemaphoreCreateMutex();
   
-  if (!imageQueue || !packetQueue || !displaySemaphore) {
+  if (!imageQueue || !displaySemaphore) {
     Serial.println("Failed to create RTOS components");
     return;
   }
@@ -316,6 +671,6 @@ void setup() {
 }
 
 void loop() {
-  checkTimeout();
+  // Reception timeouts are handled by the packet task, which owns the frame state
   vTaskDelay(pdMS_TO_TICKS(100));
 }
\ No newline at end of file
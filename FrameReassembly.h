@@ -0,0 +1,229 @@
+// FrameReassembly.h
+#pragma once
+//
+// Receiving side of the selective-repeat image stream, shared by the
+// display sketches and the simulated link in sim/: one frame's packets
+// stored by packet number, lost ones rebuilt from FEC parity (PacketFec.h),
+// and the timing of its NACKs and of giving it up.
+//
+// A receiver keeps a few RxFrame contexts (its own context type derives
+// from RxFrame to add fields) and owns their buffers: imageBuffer (a pool
+// slot), and receivedBits, parityBuffer and parityBits sized for its
+// largest frame. rxStartFrame() takes a header into a free context or the
+// oldest one (rxPickFrame()), rxAddPacket() stores a data or parity packet
+// and tells what it did, rxNackDue() says when a NACK built by
+// rxBuildNack() should go out and rxSettled() when nothing more will come.
+// What a completed or abandoned frame turns into stays with the receiver.
+// Time is passed in.
+//
+// Place this file alongside your .ino files and #include "FrameReassembly.h"
+// after FramePool.h. Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <string.h>
+#endif
+#include "CameraProtocol.h"
+#include "PacketFec.h"
+#include "FramePool.h"
+
+// Reassembly state of one frame; frames are matched by header.hdr.frameId
+struct RxFrame {
+  bool active;
+  ImageHeader header;
+  uint8_t* imageBuffer;
+  uint16_t packetsReceived;
+  uint16_t firstPass;           // Data packets that arrived before the first NACK
+  uint16_t recovered;           // Packets rebuilt by FEC
+  uint16_t repaired;            // Packets that arrived after a NACK
+  uint64_t* receivedBits;       // One bit per data packet
+  uint8_t* parityBuffer;        // FEC parity packets of this frame
+  uint64_t* parityBits;
+  uint16_t parityPackets;       // Expected parity packets (0 = FEC off)
+  uint32_t lastPacketTime;
+  uint32_t lastNackTime;
+  uint8_t nackRounds;
+};
+
+// What rxAddPacket() did, as bits
+enum RxPacketResult : uint8_t {
+  RX_PACKET_STORED    = 0x01,   // A new data packet
+  RX_PACKET_REPAIRED  = 0x02,   // ... that came after a NACK
+  RX_PACKET_RECOVERED = 0x04,   // A lost packet rebuilt from parity
+  RX_FRAME_COMPLETE   = 0x08    // Every data packet is present
+};
+
+// Last frame ID seen from a sender, for counting frames whose header never
+// arrived
+struct RxSequence {
+  uint16_t lastFrameId;
+  bool haveLast;
+};
+
+// a is a later frame than b (IDs wrap at 65535)
+inline bool rxNewer(uint16_t a, uint16_t b) {
+  uint16_t age = a - b;
+  return age > 0 && age < 0x8000;
+}
+
+// A header whose packet count matches its size, of at most maxSize bytes
+inline bool rxHeaderValid(const ImageHeader& header, uint32_t maxSize) {
+  uint16_t totalPackets = (header.imageSize + CAM_PACKET_PAYLOAD - 1) / CAM_PACKET_PAYLOAD;
+  return header.totalPackets == totalPackets && header.imageSize > 0 && header.imageSize <= maxSize;
+}
+
+// Frames missed before this header: gaps in the frame ID, which steps by
+// the number of simulcast layers
+inline uint16_t rxMissedFrames(RxSequence& seq, const ImageHeader& header) {
+  uint16_t missed = 0;
+  uint8_t step = header.layers ? header.layers : 1;
+  uint16_t gap = header.hdr.frameId - seq.lastFrameId;
+  if (!seq.haveLast || rxNewer(header.hdr.frameId, seq.lastFrameId)) {
+    if (seq.haveLast && gap > step) missed = gap / step - 1;
+    seq.lastFrameId = header.hdr.frameId;
+    seq.haveLast = true;
+  }
+  return missed;
+}
+
+template <typename Frame>
+Frame* rxFindFrame(Frame* frames, int count, uint16_t frameId) {
+  for (int i = 0; i < count; i++) {
+    if (frames[i].active && frames[i].header.hdr.frameId == frameId) return &frames[i];
+  }
+  return nullptr;
+}
+
+// Context for a new frame: a free one, or the one with the oldest frame,
+// which the caller abandons
+template <typename Frame>
+Frame* rxPickFrame(Frame* frames, int count, uint16_t frameId) {
+  Frame* frame = nullptr;
+  uint16_t oldestAge = 0;
+  for (int i = 0; i < count; i++) {
+    if (!frames[i].active) return &frames[i];
+
+    uint16_t age = frameId - frames[i].header.hdr.frameId;
+    if (!frame || age > oldestAge) {
+      frame = &frames[i];
+      oldestAge = age;
+    }
+  }
+  return frame;
+}
+
+// Sets a context up for the frame of header, assembled in image. FEC
+// settings out of range turn FEC off for the frame.
+inline void rxStartFrame(RxFrame& frame, const ImageHeader& header, uint8_t* image, uint32_t now) {
+  frame.header = header;
+  frame.imageBuffer = image;
+  bitsetClear(frame.receivedBits, header.totalPackets);
+
+  uint8_t maxParity = header.fecGroup < FEC_MAX_PARITY ? header.fecGroup : FEC_MAX_PARITY;
+  bool fecValid = header.fecGroup > 0 && header.fecGroup <= FEC_MAX_GROUP &&
+                  header.fecParity > 0 && header.fecParity <= maxParity;
+  if (!fecValid) {
+    frame.header.fecGroup = 0;
+    frame.header.fecParity = 0;
+  }
+  frame.parityPackets = fecParityCount(header.totalPackets, frame.header.fecGroup, frame.header.fecParity);
+  bitsetClear(frame.parityBits, frame.parityPackets);
+
+  frame.packetsReceived = 0;
+  frame.firstPass = 0;
+  frame.recovered = 0;
+  frame.repaired = 0;
+  frame.lastPacketTime = now;
+  frame.lastNackTime = 0;
+  frame.nackRounds = 0;
+  frame.active = true;
+}
+
+// Rebuilds the lost packet of (block, cls) once its parity packet and all
+// other packets of the class are present
+inline uint8_t rxRecover(RxFrame& frame, uint16_t block, uint8_t cls) {
+  const ImageHeader& header = frame.header;
+  uint16_t parityIndex = block * header.fecParity + cls;
+  if (parityIndex >= frame.parityPackets || !bitsetTest(frame.parityBits, parityIndex)) return 0;
+
+  int recovered = fecRecover(frame.imageBuffer, header.imageSize, frame.receivedBits, header.totalPackets,
+                             header.fecGroup, header.fecParity, block, cls,
+                             &frame.parityBuffer[parityIndex * FEC_PAYLOAD_SIZE]);
+  if (recovered < 0) return 0;
+
+  bitsetSet(frame.receivedBits, recovered);
+  frame.packetsReceived++;
+  frame.recovered++;
+  return RX_PACKET_RECOVERED;
+}
+
+// Stores a data or parity packet of the frame (RxPacketResult bits).
+// Parity packets are kept until their block can be rebuilt.
+inline uint8_t rxAddPacket(RxFrame& frame, const ImagePacket& packet, int len, uint32_t now) {
+  const ImageHeader& header = frame.header;
+  uint8_t result = 0;
+
+  if (packet.hdr.type == CAM_MSG_PARITY) {
+    uint16_t parityIndex = packet.hdr.seq;
+    if (len != sizeof(ImagePacket) || parityIndex >= frame.parityPackets ||
+        bitsetTest(frame.parityBits, parityIndex)) {
+      return 0;
+    }
+    memcpy(&frame.parityBuffer[parityIndex * FEC_PAYLOAD_SIZE], packet.data, FEC_PAYLOAD_SIZE);
+    bitsetSet(frame.parityBits, parityIndex);
+    frame.lastPacketTime = now;
+    result = rxRecover(frame, parityIndex / header.fecParity, parityIndex % header.fecParity);
+  } else {
+    uint16_t packetNum = packet.hdr.seq;
+    if (packetNum >= header.totalPackets || bitsetTest(frame.receivedBits, packetNum)) return 0;
+
+    uint32_t bufferPos = (uint32_t)packetNum * CAM_PACKET_PAYLOAD;
+    uint32_t copySize = fecPacketSize(header.imageSize, packetNum);
+    if (len < (int)(CAM_PACKET_HEADER_SIZE + copySize) || bufferPos + copySize > header.imageSize) return 0;
+
+    memcpy(&frame.imageBuffer[bufferPos], packet.data, copySize);
+    bitsetSet(frame.receivedBits, packetNum);
+    frame.packetsReceived++;
+    frame.lastPacketTime = now;
+    result = RX_PACKET_STORED;
+    if (frame.nackRounds > 0) {
+      frame.repaired++;
+      result |= RX_PACKET_REPAIRED;
+    } else {
+      frame.firstPass++;
+    }
+
+    if (header.fecGroup > 0 && frame.packetsReceived < header.totalPackets) {
+      result |= rxRecover(frame, packetNum / header.fecGroup, (packetNum % header.fecGroup) % header.fecParity);
+    }
+  }
+
+  if (frame.packetsReceived >= header.totalPackets) result |= RX_FRAME_COMPLETE;
+  return result;
+}
+
+// Missing packets to report: the frame has been quiet for NACK_IDLE_MS
+// since its last packet and its last report, and has rounds left
+inline bool rxNackDue(const RxFrame& frame, uint32_t now) {
+  return frame.active && frame.packetsReceived < frame.header.totalPackets &&
+         frame.nackRounds < NACK_MAX_ROUNDS &&
+         now - frame.lastPacketTime >= NACK_IDLE_MS && now - frame.lastNackTime >= NACK_IDLE_MS;
+}
+
+// The frame's report, sealed: its missing packets, or an ACK when it is
+// complete or given up
+inline void rxBuildNack(RxFrame& frame, NackPacket& nack, bool giveUp, uint32_t now) {
+  camBuildNack(nack, frame.header.hdr.frameId, frame.receivedBits, frame.header.totalPackets, giveUp);
+  camSeal(&nack, sizeof(nack));
+  frame.lastNackTime = now;
+}
+
+// Nothing more is coming for the frame: its repair rounds are spent, or,
+// without repair, it has been quiet for a while
+inline bool rxSettled(const RxFrame& frame, bool repair, uint32_t now) {
+  uint32_t idle = now - frame.lastPacketTime;
+  return idle > 2 * NACK_WAIT_MS && (!repair || frame.nackRounds >= NACK_MAX_ROUNDS);
+}
@@ -0,0 +1,136 @@
+// AviWriter.h
+#pragma once
+//
+// Byte layout of an MJPEG AVI whose frames are all known before writing,
+// as the pre-roll recorder has them: the file size, and with it every
+// header field, can be computed up front, so the file is preallocated and
+// written front to back in one pass with no seeking back to patch sizes.
+//
+//   RIFF 'AVI '
+//     LIST 'hdrl'  avih, LIST 'strl' (strh, strf)
+//     LIST 'movi'  '00dc' chunk per JPEG (padded to an even size)
+//     idx1         one entry per frame, offsets from the 'movi' fourcc
+//
+// No Arduino dependencies: builds on a desktop compiler.
+//
+// Place this file alongside your .ino files and #include "AviWriter.h".
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+#endif
+
+#define AVI_HEADER_SIZE   224   // RIFF, hdrl and the 'movi' list header
+#define AVI_CHUNK_HEADER  8
+#define AVI_INDEX_ENTRY   16
+
+inline void aviPut32(uint8_t* p, uint32_t v) {
+  p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+inline void aviPut16(uint8_t* p, uint16_t v) {
+  p[0] = v; p[1] = v >> 8;
+}
+
+inline void aviFourcc(uint8_t* p, const char* cc) {
+  p[0] = cc[0]; p[1] = cc[1]; p[2] = cc[2]; p[3] = cc[3];
+}
+
+// Bytes a JPEG of `size` takes in the 'movi' list
+inline uint32_t aviChunkSize(uint32_t size) {
+  return AVI_CHUNK_HEADER + size + (size & 1);
+}
+
+// Whole file: `chunkBytes` is the sum of aviChunkSize() over all frames
+inline uint32_t aviFileSize(uint32_t frames, uint32_t chunkBytes) {
+  return AVI_HEADER_SIZE + chunkBytes + AVI_CHUNK_HEADER + frames * AVI_INDEX_ENTRY;
+}
+
+// The first AVI_HEADER_SIZE bytes of the file
+inline void aviHeader(uint8_t* out, uint16_t width, uint16_t height, uint32_t frames,
+                      uint32_t chunkBytes, uint32_t usPerFrame, uint32_t largestFrame) {
+  uint8_t* p = out;
+  for (int i = 0; i < AVI_HEADER_SIZE; i++) out[i] = 0;
+  if (!usPerFrame) usPerFrame = 1;
+
+  aviFourcc(p, "RIFF");
+  aviPut32(p + 4, aviFileSize(frames, chunkBytes) - 8);
+  aviFourcc(p + 8, "AVI ");
+  p += 12;
+
+  aviFourcc(p, "LIST");
+  aviPut32(p + 4, 4 + 64 + 12 + 64 + 48);
+  aviFourcc(p + 8, "hdrl");
+  p += 12;
+
+  // Main header
+  aviFourcc(p, "avih");
+  aviPut32(p + 4, 56);
+  aviPut32(p + 8, usPerFrame);
+  aviPut32(p + 12, (uint32_t)((uint64_t)largestFrame * 1000000 / usPerFrame));  // Max bytes/s
+  aviPut32(p + 20, 0x10);                // AVIF_HASINDEX
+  aviPut32(p + 24, frames);
+  aviPut32(p + 32, 1);                   // Streams
+  aviPut32(p + 36, largestFrame);        // Suggested buffer size
+  aviPut32(p + 40, width);
+  aviPut32(p + 44, height);
+  p += 64;
+
+  aviFourcc(p, "LIST");
+  aviPut32(p + 4, 4 + 64 + 48);
+  aviFourcc(p + 8, "strl");
+  p += 12;
+
+  // Stream header: rate / scale = frames per second
+  aviFourcc(p, "strh");
+  aviPut32(p + 4, 56);
+  aviFourcc(p + 8, "vids");
+  aviFourcc(p + 12, "MJPG");
+  aviPut32(p + 28, usPerFrame);          // Scale
+  aviPut32(p + 32, 1000000);             // Rate
+  aviPut32(p + 40, frames);              // Length
+  aviPut32(p + 44, largestFrame);
+  aviPut32(p + 48, 0xFFFFFFFF);          // Default quality
+  aviPut16(p + 60, width);               // rcFrame right, bottom
+  aviPut16(p + 62, height);
+  p += 64;
+
+  // Stream format: BITMAPINFOHEADER
+  aviFourcc(p, "strf");
+  aviPut32(p + 4, 40);
+  aviPut32(p + 8, 40);
+  aviPut32(p + 12, width);
+  aviPut32(p + 16, height);
+  aviPut16(p + 20, 1);                   // Planes
+  aviPut16(p + 22, 24);                  // Bits per pixel
+  aviFourcc(p + 24, "MJPG");
+  aviPut32(p + 28, (uint32_t)width * height * 3);
+  p += 48;
+
+  aviFourcc(p, "LIST");
+  aviPut32(p + 4, 4 + chunkBytes);
+  aviFourcc(p + 8, "movi");
+}
+
+// Header of a frame's '00dc' chunk
+inline void aviChunk(uint8_t* out, uint32_t size) {
+  aviFourcc(out, "00dc");
+  aviPut32(out + 4, size);
+}
+
+// Header of the idx1 chunk
+inline void aviIndexHeader(uint8_t* out, uint32_t frames) {
+  aviFourcc(out, "idx1");
+  aviPut32(out + 4, frames * AVI_INDEX_ENTRY);
+}
+
+// Index entry of a frame whose chunk starts `offset` bytes after the 'movi'
+// fourcc (the first one is at 4)
+inline void aviIndexEntry(uint8_t* out, uint32_t offset, uint32_t size) {
+  aviFourcc(out, "00dc");
+  aviPut32(out + 4, 0x10);               // AVIIF_KEYFRAME
+  aviPut32(out + 8, offset);
+  aviPut32(out + 12, size);
+}
@@ -0,0 +1,185 @@
+// ClipIndex.h
+#pragma once
+//
+// Frame index of a recorded MJPEG AVI clip (the files EventRecorder writes,
+// or any AVI with an idx1 chunk), for players that scrub through a clip.
+//
+// open() walks the RIFF chunks once and turns idx1 into a table of file
+// offsets, so seeking to any frame is one array lookup and one read. The
+// file is read through a callback, so the index does not care whether it
+// comes from FFat, SD or a desktop file.
+//
+// clipZoomBlock() blows a block decoded at a reduced JPEG scale back up
+// to full size, for fast previews while scrubbing.
+//
+// No Arduino dependencies: builds on a desktop compiler.
+//
+// Place this file alongside your .ino files and #include "ClipIndex.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <stdlib.h>
+  #include <string.h>
+#endif
+
+#define CLIP_MAX_FRAMES 4096   // Larger indexes are cut short
+
+// Reads len bytes at offset; false on a short read
+typedef bool (*ClipReadFunc)(void* ctx, uint32_t offset, uint8_t* buf, uint32_t len);
+
+typedef struct {
+  uint32_t offset;   // JPEG data in the file
+  uint32_t size;
+} ClipFrame;
+
+inline uint32_t clipGet32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+class ClipIndex {
+private:
+  ClipFrame* frames;
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t largest;
+  uint16_t width;
+  uint16_t height;
+  uint32_t usPerFrame;
+
+  // Index storage, kept between clips and grown when needed (PSRAM when present)
+  bool reserve(uint32_t entries) {
+    if (entries <= capacity) return true;
+    free(frames);
+#if __has_include(<Arduino.h>)
+    frames = (ClipFrame*)(psramFound() ? ps_malloc(entries * sizeof(ClipFrame))
+                                       : malloc(entries * sizeof(ClipFrame)));
+#else
+    frames = (ClipFrame*)malloc(entries * sizeof(ClipFrame));
+#endif
+    capacity = frames ? entries : 0;
+    return frames != nullptr;
+  }
+
+public:
+  ClipIndex() : frames(nullptr), capacity(0), count(0), largest(0), width(0), height(0), usPerFrame(0) {}
+  ~ClipIndex() { free(frames); }
+
+  // Builds the index of a clip of fileSize bytes; false when it is not an
+  // MJPEG AVI with an index
+  bool open(ClipReadFunc read, void* ctx, uint32_t fileSize) {
+    count = 0;
+    largest = 0;
+    width = 0;
+    height = 0;
+    usPerFrame = 0;
+
+    uint8_t chunk[12];
+    if (fileSize < 12 || !read(ctx, 0, chunk, 12) ||
+        memcmp(chunk, "RIFF", 4) != 0 || memcmp(chunk + 8, "AVI ", 4) != 0) {
+      return false;
+    }
+    uint32_t end = clipGet32(chunk + 4) + 8;
+    if (end > fileSize) end = fileSize;
+
+    // Top-level chunks: hdrl (sizes, rate), movi (frames), idx1 (index)
+    uint32_t movi = 0;
+    uint32_t indexPos = 0;
+    uint32_t indexSize = 0;
+    uint32_t pos = 12;
+    while (pos + 12 <= end) {
+      if (!read(ctx, pos, chunk, 12)) return false;
+      uint32_t size = clipGet32(chunk + 4);
+
+      if (memcmp(chunk, "LIST", 4) == 0 && memcmp(chunk + 8, "hdrl", 4) == 0) {
+        uint8_t avih[8 + 40];
+        if (read(ctx, pos + 12, avih, sizeof(avih)) && memcmp(avih, "avih", 4) == 0) {
+          usPerFrame = clipGet32(avih + 8);
+          width = clipGet32(avih + 8 + 32);
+          height = clipGet32(avih + 8 + 36);
+        }
+      } else if (memcmp(chunk, "LIST", 4) == 0 && memcmp(chunk + 8, "movi", 4) == 0) {
+        movi = pos + 8;
+      } else if (memcmp(chunk, "idx1", 4) == 0) {
+        indexPos = pos + 8;
+        indexSize = size;
+      }
+
+      if (size > end - pos - 8) break;
+      pos += 8 + size + (size & 1);
+    }
+    if (!movi || !indexPos || !width || !height) return false;
+
+    uint32_t entries = indexSize / 16;
+    if (entries > CLIP_MAX_FRAMES) entries = CLIP_MAX_FRAMES;
+    if (!entries || !reserve(entries)) return false;
+
+    // Offsets normally count from the 'movi' fourcc; a few writers store
+    // file offsets instead, recognisable by the first one
+    uint32_t base = movi;
+    bool baseKnown = false;
+
+    uint8_t batch[32 * 16];
+    for (uint32_t i = 0; i < entries; i += 32) {
+      uint32_t n = entries - i < 32 ? entries - i : 32;
+      if (!read(ctx, indexPos + i * 16, batch, n * 16)) return false;
+
+      for (uint32_t j = 0; j < n; j++) {
+        const uint8_t* e = batch + j * 16;
+        if (e[2] != 'd' || (e[3] != 'c' && e[3] != 'b')) continue;  // Not video
+
+        uint32_t offset = clipGet32(e + 8);
+        uint32_t size = clipGet32(e + 12);
+        if (!baseKnown) {
+          if (offset >= movi) base = 0;
+          baseKnown = true;
+        }
+        uint32_t data = base + offset + 8;
+        if (data < movi || data > fileSize || size > fileSize - data) continue;
+
+        frames[count].offset = data;
+        frames[count].size = size;
+        if (size > largest) largest = size;
+        count++;
+      }
+    }
+    if (!usPerFrame) usPerFrame = 200000;
+    return count > 0;
+  }
+
+  uint32_t getCount() { return count; }
+  const ClipFrame& frame(uint32_t i) { return frames[i]; }
+  uint32_t getLargest() { return largest; }
+  uint16_t getWidth() { return width; }
+  uint16_t getHeight() { return height; }
+  uint32_t getUsPerFrame() { return usPerFrame; }
+
+  // Frame shown ms into the clip, and the other way round
+  uint32_t frameAt(uint32_t ms) {
+    if (!count) return 0;
+    uint32_t i = (uint32_t)((uint64_t)ms * 1000 / usPerFrame);
+    return i < count ? i : count - 1;
+  }
+
+  uint32_t timeOf(uint32_t frame) {
+    return (uint32_t)((uint64_t)frame * usPerFrame / 1000);
+  }
+};
+
+// Repeats every pixel of a w x h block zoom times in both directions
+inline void clipZoomBlock(const uint16_t* src, uint16_t w, uint16_t h, uint8_t zoom, uint16_t* dst) {
+  uint16_t outWidth = w * zoom;
+  for (uint16_t y = 0; y < h; y++) {
+    uint16_t* row = dst + (uint32_t)y * zoom * outWidth;
+    for (uint16_t x = 0; x < w; x++) {
+      uint16_t pixel = src[y * w + x];
+      for (uint8_t i = 0; i < zoom; i++) row[x * zoom + i] = pixel;
+    }
+    for (uint8_t i = 1; i < zoom; i++) {
+      memcpy(row + (uint32_t)i * outWidth, row, outWidth * sizeof(uint16_t));
+    }
+  }
+}
@@ -4,6 +4,7 @@
 CommandHandler::CommandHandler() {
   display = nullptr;
   comm = nullptr;
+  player = nullptr;
   streamingActive = false;
   lastCommandTime = 0;
   inputBuffer = "";
@@ -51,14 +52,11 @@ void CommandHandler::executeCommand(const String& cmd) {
   if (cmd == "CAPTURE" || cmd == "C") {
     Serial.println("Requesting single frame...");
     
-    // Clear any old images from queue before requesting new capture
+    // Save what was on screen up to now, then clear any old images from
+    // queue before requesting new capture
     if (comm) {
-      CompleteImage oldImg;
-      while (comm->hasCompleteImage()) {
-        oldImg = comm->getCompleteImage();
-        comm->freeImage(oldImg);
-        Serial.println("[Master] Cleared old image from queue");
-      }
+      comm->getRecorder().trigger("capture");
+      comm->flushImages();
     }
     
     if (comm->sendCommand("CAPTURE")) {
@@ -80,6 +78,123 @@ void CommandHandler::executeCommand(const String& cmd) {
       display->showReady();
     }
   }
+  else if (cmd == "REPAIR ON" || cmd == "REPAIR OFF") {
+    bool enable = (cmd == "REPAIR ON");
+    Serial.printf("Selective-repeat recovery %s\n", enable ? "enabled" : "disabled");
+    if (comm->sendCommand(enable ? "REPAIR_ON" : "REPAIR_OFF")) {
+      comm->setRepairEnabled(enable);
+    }
+  }
+  else if (cmd == "MOTION ON" || cmd == "MOTION OFF") {
+    bool enable = (cmd == "MOTION ON");
+    Serial.printf("Motion-gated streaming %s\n", enable ? "enabled" : "disabled");
+    comm->sendCommand(enable ? "MOTION_ON" : "MOTION_OFF");
+  }
+  else if (cmd == "TILES ON" || cmd == "TILES OFF") {
+    bool enable = (cmd == "TILES ON");
+    Serial.printf("Tile delta streaming %s\n", enable ? "enabled" : "disabled");
+    comm->sendCommand(enable ? "TILES_ON" : "TILES_OFF");
+  }
+  else if (cmd == "PROGRESSIVE ON" || cmd == "PROGRESSIVE OFF") {
+    bool enable = (cmd == "PROGRESSIVE ON");
+    comm->setProgressive(enable);
+    Serial.printf("Progressive display %s\n", enable ? "enabled" : "disabled");
+  }
+  else if (cmd == "PARALLEL ON" || cmd == "PARALLEL OFF") {
+    bool enable = (cmd == "PARALLEL ON");
+    display->setParallelDecode(enable);
+    Serial.printf("Parallel decode %s\n", enable ? "enabled" : "disabled");
+  }
+  else if (cmd.startsWith("JITTER")) {
+    // JITTER <frames> <ms> | JITTER OFF
+    int frames = 1, maxMs = 0;
+    if (cmd != "JITTER OFF" && sscanf(cmd.c_str(), "JITTER %d %d", &frames, &maxMs) != 2) {
+      Serial.printf("Usage: JITTER <frames 1-%d> <max delay ms> | JITTER OFF\n", JITTER_MAX_DEPTH);
+      return;
+    }
+    if (frames < 1 || frames > JITTER_MAX_DEPTH || maxMs < 0) {
+      Serial.println("Error: invalid jitter buffer depth!");
+      return;
+    }
+    comm->setJitter(frames, maxMs);
+    Serial.printf("Jitter buffer: up to %d frames, %d ms\n", frames, maxMs);
+  }
+  else if (cmd.startsWith("FEC")) {
+    // FEC <group> <parity> | FEC OFF
+    int group = 0, parity = 0;
+    if (cmd != "FEC OFF" && sscanf(cmd.c_str(), "FEC %d %d", &group, &parity) != 2) {
+      Serial.println("Usage: FEC <group 2-32> <parity 1-4> | FEC OFF");
+      return;
+    }
+    if (group != 0 && (group < 2 || group > FEC_MAX_GROUP || parity < 1 ||
+                       parity > FEC_MAX_PARITY || parity > group)) {
+      Serial.println("Error: invalid FEC ratio!");
+      return;
+    }
+    
+    char fecCmd[32];
+    snprintf(fecCmd, sizeof(fecCmd), "FEC:%d:%d", group, parity);
+    if (comm->sendCommand(fecCmd)) {
+      if (group == 0) {
+        Serial.println("FEC disabled");
+      } else {
+        Serial.printf("FEC set to %d parity per %d data packets\n", parity, group);
+      }
+    }
+  }
+  else if (cmd == "CLIPS") {
+    listClips();
+  }
+  else if (cmd == "PLAY" || cmd.startsWith("PLAY ")) {
+    playClip(cmd);
+  }
+  else if (cmd == "PAUSE") {
+    player->pause();
+  }
+  else if (cmd.startsWith("STEP")) {
+    // STEP <frames>, negative goes back
+    int frames = 0;
+    if (!player->isOpen() || sscanf(cmd.c_str(), "STEP %d", &frames) != 1) {
+      Serial.println("Usage: STEP <frames> (while a clip is open)");
+      return;
+    }
+    player->step(frames);
+  }
+  else if (cmd.startsWith("SEEK")) {
+    // SEEK <ms into the clip>
+    int ms = 0;
+    if (!player->isOpen() || sscanf(cmd.c_str(), "SEEK %d", &ms) != 1 || ms < 0) {
+      Serial.println("Usage: SEEK <ms> (while a clip is open)");
+      return;
+    }
+    player->seekMs(ms);
+  }
+  else if (cmd == "CLOSE") {
+    player->close();
+    Serial.println("Clip closed, back to the camera");
+    if (!streamingActive) {
+      display->showReady();
+    }
+  }
+  else if (cmd == "VIEW" || cmd.startsWith("VIEW ")) {
+    // VIEW ALL | VIEW <camera>; the display follows in loop()
+    int camera = 0;
+    if (cmd == "VIEW ALL") {
+      comm->setFocus(-1);
+      Serial.printf("Mosaic of %d cameras\n", comm->getCameraCount());
+    } else if (sscanf(cmd.c_str(), "VIEW %d", &camera) == 1 && camera >= 1 && camera <= CAM_SOURCES &&
+               comm->getCamera(camera - 1).known) {
+      comm->setFocus(camera - 1);
+      Serial.printf("Camera %d full screen\n", camera);
+    } else {
+      Serial.printf("Usage: VIEW ALL | VIEW <1-%d> (a camera that has been seen)\n", CAM_SOURCES);
+    }
+  }
+  else if (cmd == "PAIR") {
+    comm->openPairing();
+    Serial.printf("Accepting new cameras for %d s (%d of %d entries in use)\n", PAIR_WINDOW_MS / 1000,
+                  comm->getCameraCount(), CAM_SOURCES);
+  }
   else if (cmd == "STATUS" || cmd == "?") {
     printStatus();
   }
@@ -93,11 +208,76 @@ void CommandHandler::executeCommand(const String& cmd) {
   Serial.println();
 }
 
+// Event clips saved by the pre-roll recorder
+void CommandHandler::listClips() {
+  File root = FFat.open("/");
+  if (!root || !root.isDirectory()) {
+    Serial.println("No FFat filesystem");
+    return;
+  }
+  
+  int clips = 0;
+  File file = root.openNextFile();
+  while (file) {
+    const char* name = file.name();
+    if (strstr(name, "event_") && strstr(name, ".avi")) {
+      Serial.printf("  %s  %lu KB\n", name, (unsigned long)(file.size() / 1024));
+      clips++;
+    }
+    file = root.openNextFile();
+  }
+  Serial.printf("%d clips (PLAY <n> to watch)\n", clips);
+}
+
+// PLAY resumes the open clip or opens the last one saved; PLAY <n> opens
+// /event_<n>.avi
+void CommandHandler::playClip(const String& cmd) {
+  char path[32];
+  int number = 0;
+  
+  if (sscanf(cmd.c_str(), "PLAY %d", &number) == 1) {
+    snprintf(path, sizeof(path), "/event_%04d.avi", number);
+  } else if (player->isOpen()) {
+    player->play();
+    return;
+  } else if (comm->getRecorder().getLastFile()[0]) {
+    strncpy(path, comm->getRecorder().getLastFile(), sizeof(path));
+  } else {
+    Serial.println("Usage: PLAY <n> (CLIPS lists them)");
+    return;
+  }
+  
+  if (!player->open(FFat, path)) {
+    Serial.printf("Cannot open %s\n", path);
+    return;
+  }
+  Serial.printf("Playing %s: %lu frames, %dx%d, %lu ms (PAUSE, STEP <n>, SEEK <ms>, CLOSE)\n",
+                path, (unsigned long)player->getFrameCount(), player->getWidth(), player->getHeight(),
+                (unsigned long)player->getDurationMs());
+  player->play();
+}
+
 void CommandHandler::showHelp() {
   Serial.println("\n=== COMMAND LIST ===");
-  Serial.println("CAPTURE (C)       - Request single frame from camera");
+  Serial.println("CAPTURE (C)       - Request single frame from camera (saves the pre-roll)");
   Serial.println("START_STREAM (S)  - Start continuous 2 FPS streaming");
   Serial.println("STOP_STREAM (X)   - Stop streaming");
+  Serial.println("REPAIR ON|OFF     - Toggle missing-packet recovery");
+  Serial.println("FEC <n> <k>|OFF   - k parity packets per n data packets");
+  Serial.println("PROGRESSIVE ON|OFF - Decode frames while they arrive");
+  Serial.println("PARALLEL ON|OFF   - Decode each frame on both cores");
+  Serial.println("JITTER <f> <ms>|OFF - Playout buffer depth in frames and ms");
+  Serial.println("MOTION ON|OFF     - Stream only while the scene moves");
+  Serial.println("TILES ON|OFF      - Send only the parts of the picture that changed");
+  Serial.println("CLIPS             - List recorded event clips");
+  Serial.println("PLAY [n]          - Play clip n (or the last one) on the display");
+  Serial.println("PAUSE             - Pause the clip");
+  Serial.println("STEP <n>          - Scrub n frames (negative goes back)");
+  Serial.println("SEEK <ms>         - Jump to a time in the clip");
+  Serial.println("CLOSE             - Close the clip, back to the camera");
+  Serial.println("VIEW ALL          - Show every camera in a 2x2 mosaic");
+  Serial.println("VIEW <n>          - Show camera n full screen");
+  Serial.println("PAIR              - Accept cameras that are not listed for 60 s");
   Serial.println("STATUS (?)        - Show system status");
   Serial.println("HELP (H)          - Show this help");
   Serial.println("MSG: <text>       - Send text message to slave");
@@ -115,6 +295,63 @@ void CommandHandler::printStatus() {
   Serial.printf("Frames Displayed: %d\n", display->getFramesDisplayed());
   Serial.printf("Total Received: %d\n", comm->getReceivedCount());
   Serial.printf("Total Lost: %d\n", comm->getLostCount());
+  Serial.printf("Frames Missed (no header): %d\n", comm->getSkippedFrames());
+  Serial.printf("Frames Superseded: %d (%d/%d in reassembly)\n",
+                comm->getSupersededFrames(), comm->getFramesInFlight(), RX_FRAMES * comm->getCameraCount());
+  Serial.printf("Frames Concealed (lost bands kept from previous frame): %d\n", comm->getConcealedFrames());
+  Serial.printf("View: %s\n", comm->isMosaic() ? "mosaic" :
+                comm->getFocus() >= 0 ? "one camera (VIEW)" : "one camera");
+  for (int i = 0; i < CAM_SOURCES; i++) {
+    const CameraSource& cam = comm->getCamera(i);
+    if (!cam.known) continue;
+    Serial.printf("  Cam %d %02X:%02X:%02X:%02X:%02X:%02X: %.1f FPS, %d received, %d lost, %d missed, %d concealed%s\n",
+                  i + 1, cam.mac[0], cam.mac[1], cam.mac[2], cam.mac[3], cam.mac[4], cam.mac[5],
+                  cam.fps, cam.received, cam.lost, cam.skipped, cam.concealed,
+                  comm->getFocus() == i ? " (full screen)" : "");
+  }
+  if (comm->getPairingLeft()) {
+    Serial.printf("Pairing: open for %lu s\n", comm->getPairingLeft() / 1000);
+  }
+  Serial.printf("Stray Packets Dropped: %d\n", comm->getForeignPackets());
+  Serial.printf("RX Ring Overflows: %lu\n", (unsigned long)comm->getRingDrops());
+  Serial.printf("Frame Pool: %d/%d slots busy, %lu frames, %lu heap allocations since boot\n",
+                comm->getSlotsInUse(), FRAME_POOL_SLOTS,
+                (unsigned long)comm->getFramesPooled(), (unsigned long)comm->getFrameAllocations());
+  Serial.printf("Packet Repair: %s (%d NACKs, %d packets recovered)\n",
+                comm->isRepairEnabled() ? "ON" : "OFF",
+                comm->getNackCount(), comm->getRepairedCount());
+  Serial.printf("FEC Recovered: %d packets\n", comm->getRecoveredCount());
+  Serial.printf("Progressive Display: %s (last frame: first MCU %lu ms, complete %lu ms after header)\n",
+                comm->isProgressive() ? "ON" : "OFF",
+                display->getFirstBlockLatency(), display->getFrameLatency());
+  JitterBuffer& jitter = comm->getJitter();
+  Serial.printf("Jitter Buffer: %d/%d frames, playout delay %lu ms (frame interval %lu ms, %lu late, %lu overflow)\n",
+                jitter.getCount(), jitter.getDepth(), (unsigned long)jitter.getDelayMs(),
+                (unsigned long)jitter.getIntervalMs(), (unsigned long)jitter.getFramesLate(),
+                (unsigned long)jitter.getFramesOverflow());
+  EventRecorder& recorder = comm->getRecorder();
+  if (recorder.isReady()) {
+    Serial.printf("Pre-roll Recorder: %d frames buffered%s, %d events saved (%lu frames, %d ignored while writing)\n",
+                  recorder.getBuffered(), recorder.isWriting() ? ", writing" : "",
+                  recorder.getEventsSaved(), (unsigned long)recorder.getFramesSaved(), recorder.getEventsIgnored());
+    if (recorder.getEventsSaved()) {
+      Serial.printf("  Last: %s, %lu KB in %lu ms\n", recorder.getLastFile(),
+                    (unsigned long)(recorder.getLastFileBytes() / 1024), (unsigned long)recorder.getLastWriteMs());
+    }
+  } else {
+    Serial.println("Pre-roll Recorder: OFF (no FFat)");
+  }
+  if (player->isOpen()) {
+    Serial.printf("Clip Player: %s frame %ld/%lu, %s (cache %lu hits, %lu misses, %lu read)\n",
+                  player->getPath(), (long)player->getPosition() + 1, (unsigned long)player->getFrameCount(),
+                  player->isPlaying() ? "playing" : "paused", (unsigned long)player->getCacheHits(),
+                  (unsigned long)player->getCacheMisses(), (unsigned long)player->getFramesFetched());
+  }
+  Serial.printf("Parallel Decode: %s (%lu frames split across both cores)\n",
+                display->isParallelDecode() ? "ON" : "OFF", (unsigned long)display->getParallelFrames());
+  Serial.printf("Rendering: %s (last frame: decode %lu us, %s %lu us)\n",
+                display->isStripRender() ? "DMA strips" : "sprite", (unsigned long)display->getDecodeUs(),
+                display->isStripRender() ? "DMA wait" : "push", (unsigned long)display->getPushUs());
   Serial.printf("Free Heap: %d bytes\n", esp_get_free_heap_size());
   Serial.printf("Uptime: %lu seconds\n", millis() / 1000);
   Serial.println("=====================\n");
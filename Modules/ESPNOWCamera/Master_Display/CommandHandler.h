@@ -10,6 +10,7 @@ class CommandHandler {
 private:
   DisplayManager* display;
   CommunicationManager* comm;
+  ClipPlayer* player;
   
   String inputBuffer;
   bool streamingActive;
@@ -17,11 +18,14 @@ private:
   
   void executeCommand(const String& cmd);
   void showHelp();
+  void listClips();
+  void playClip(const String& cmd);
   
 public:
   CommandHandler();
   void setDisplayManager(DisplayManager* mgr) { display = mgr; }
   void setCommunicationManager(CommunicationManager* mgr) { comm = mgr; }
+  void setClipPlayer(ClipPlayer* clips) { player = clips; }
   void processSerialCommands();
   void printStatus();
 };
@@ -5,22 +5,42 @@ CommunicationManager* CommunicationManager::instance = nullptr;
 
 CommunicationManager::CommunicationManager() {
   instance = this;
-  imageBuffer = nullptr;
-  expectedImageSize = 0;
-  expectedTotalPackets = 0;
-  packetReceived = nullptr;
-  packetsReceivedCount = 0;
-  receivingImage = false;
-  lastPacketTime = 0;
-  totalReceived = 0;
-  totalLost = 0;
+  static const uint8_t none[6] = {0, 0, 0, 0, 0, 0};
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    CameraSource& src = sources[s];
+    memset(&src, 0, sizeof(CameraSource));
+    memcpy(src.mac, cameraMacs[s], 6);
+    src.known = memcmp(src.mac, none, 6) != 0;
+    src.listed = src.known;
+    for (int i = 0; i < RX_FRAMES; i++) {
+      src.frames[i].source = s;
+      src.frames[i].slot = -1;
+    }
+  }
+  focus = -1;
+  repairEnabled = true;
+  pairUntil = 0;
+  panelWidth = 0;
+  panelHeight = 0;
+  panelRotation = 0;
+  progressive = false;
+  stream.state = STREAM_IDLE;
+  stream.available = 0;
+  stream.slot = -1;
+  jitterSource = -1;
+  packetTaskHandle = nullptr;
+  nacksSent = 0;
+  packetsRepaired = 0;
+  packetsRecovered = 0;
+  foreignPackets = 0;
+  lastRateTime = 0;
 }
 
+// Runs for every NACK, CAPS and command sent: only failures are worth a line
 static void onDataSent(const uint8_t *mac, esp_now_send_status_t status) {
-  if (status == ESP_NOW_SEND_SUCCESS) {
-    Serial.println("[Master] Command sent successfully");
-  } else {
-    Serial.println("[Master] Command send FAILED!");
+  if (status != ESP_NOW_SEND_SUCCESS) {
+    Serial.printf("[Master] Send to %02X:%02X:%02X:%02X:%02X:%02X FAILED!\n",
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
   }
 }
 
@@ -35,31 +55,59 @@ bool CommunicationManager::begin() {
     return false;
   }
   
-  esp_now_register_recv_cb(onDataReceived);
   esp_now_register_send_cb(onDataSent);
   
-  // Add peer (slave camera)
-  esp_now_peer_info_t peerInfo = {};
-  memcpy(peerInfo.peer_addr, slaveMac, 6);
-  peerInfo.channel = 0;
-  peerInfo.encrypt = false;
-  peerInfo.ifidx = WIFI_IF_STA;
+  // Add peers (listed slave cameras; others are added when they show up)
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    if (sources[s].known && !addPeer(sources[s].mac)) {
+      Serial.println("Failed to add peer!");
+      return false;
+    }
+  }
   
-  if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-    Serial.println("Failed to add peer!");
+  // Frame slots plus the per-frame tracking buffers of every camera, all
+  // allocated once. Parity never exceeds one packet per data packet plus
+  // one partial block.
+  uint16_t maxPackets = (FRAME_SLOT_SIZE + CAM_PACKET_PAYLOAD - 1) / CAM_PACKET_PAYLOAD;
+  uint16_t maxParity = maxPackets + FEC_MAX_PARITY;
+  if (!framePool.begin(FRAME_SLOT_SIZE)) {
+    Serial.printf("Failed to allocate frame pool: %d slots of %d bytes (%lu KB)%s\n",
+                  FRAME_POOL_SLOTS, FRAME_SLOT_SIZE, (unsigned long)FRAME_POOL_SLOTS * FRAME_SLOT_SIZE / 1024,
+                  psramFound() ? "" : ", no PSRAM found");
     return false;
   }
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    for (int i = 0; i < RX_FRAMES; i++) {
+      FrameContext& frame = sources[s].frames[i];
+      frame.receivedBits = (uint64_t*)framePool.allocate(bitsetWords(maxPackets) * sizeof(uint64_t));
+      frame.parityBuffer = (uint8_t*)framePool.allocate(maxParity * FEC_PAYLOAD_SIZE);
+      frame.parityBits = (uint64_t*)framePool.allocate(bitsetWords(maxParity) * sizeof(uint64_t));
+      if (!frame.receivedBits || !frame.parityBuffer || !frame.parityBits) {
+        Serial.printf("Failed to allocate reassembly buffers (camera %d, frame %d)%s\n", s + 1, i,
+                      psramFound() ? "" : ", no PSRAM found");
+        return false;
+      }
+    }
+  }
   
   // Create RTOS components
-  imageQueue = xQueueCreate(2, sizeof(CompleteImage));
-  packetQueue = xQueueCreate(150, sizeof(ImagePacket));
+  // Two frames queued, one more for every further camera in the mosaic
+  imageQueue = xQueueCreate(CAM_SOURCES + 1, sizeof(CompleteImage));
+  jitter.begin(JITTER_FRAMES, JITTER_MAX_DELAY_MS);
   rxMutex = xSemaphoreCreateMutex();
   
-  if (!imageQueue || !packetQueue || !rxMutex) {
+  if (!imageQueue || !rxMutex) {
     Serial.println("Failed to create RTOS components!");
     return false;
   }
   
+  // Optional: without FFat the display runs as before
+  recorder.begin(&framePool);
+  static const uint8_t none[6] = {0, 0, 0, 0, 0, 0};
+  if (memcmp(deviceMasterMac, none, 6) == 0) {
+    Serial.println("Event triggers off: set deviceMasterMac in CommunicationManager.h");
+  }
+  
   // Start packet processing task
   xTaskCreatePinnedToCore(
     packetProcessingTask,
@@ -71,25 +119,192 @@ bool CommunicationManager::begin() {
     0
   );
   
+  // Register only once the packet task can be notified
+  esp_now_register_recv_cb(onDataReceived);
+  
   Serial.println("Communication initialized successfully");
   return true;
 }
 
+// Camera 1 (the first entry of cameraMacs)
 void CommunicationManager::setSlaveMac(uint8_t* mac) {
-  memcpy(slaveMac, mac, 6);
+  memcpy(sources[0].mac, mac, 6);
+  sources[0].known = true;
+  sources[0].listed = true;
   Serial.printf("Slave MAC set to: %02X:%02X:%02X:%02X:%02X:%02X\n",
                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 }
 
+void CommunicationManager::setPanel(uint16_t width, uint16_t height, uint8_t rotation) {
+  panelWidth = width;
+  panelHeight = height;
+  panelRotation = rotation;
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    sources[s].lastCapsTime = 0;
+  }
+}
+
+bool CommunicationManager::addPeer(const uint8_t* mac) {
+  if (esp_now_is_peer_exist(mac)) return true;
+  
+  esp_now_peer_info_t peerInfo = {};
+  memcpy(peerInfo.peer_addr, mac, 6);
+  peerInfo.channel = 0;
+  peerInfo.encrypt = false;
+  peerInfo.ifidx = WIFI_IF_STA;
+  return esp_now_add_peer(&peerInfo) == ESP_OK;
+}
+
+// Source index of a camera, -1 if it is not one of ours
+int CommunicationManager::findSource(const uint8_t* mac) {
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    if (sources[s].known && memcmp(sources[s].mac, mac, 6) == 0) return s;
+  }
+  return -1;
+}
+
+// Gives a camera that is not listed a source when its header arrives
+// (packet task). A camera that went quiet gets its own entry back; a new
+// one is only adopted while PAIR is open. -1 when it is refused or all
+// CAM_SOURCES are taken.
+int CommunicationManager::adoptSource(const uint8_t* mac) {
+  static const uint8_t none[6] = {0, 0, 0, 0, 0, 0};
+  int s = -1;
+  for (int i = 0; i < CAM_SOURCES && s < 0; i++) {
+    if (!sources[i].known && memcmp(sources[i].mac, mac, 6) == 0) s = i;
+  }
+  bool returning = s >= 0;
+  
+  // A never-used entry first, then one a quiet camera left
+  if (!returning && getPairingLeft()) {
+    for (int i = 0; i < CAM_SOURCES && s < 0; i++) {
+      if (!sources[i].known && memcmp(sources[i].mac, none, 6) == 0) s = i;
+    }
+    for (int i = 0; i < CAM_SOURCES && s < 0; i++) {
+      if (!sources[i].known) s = i;
+    }
+  }
+  if (s < 0 || !addPeer(mac)) return -1;
+  
+  CameraSource& src = sources[s];
+  if (!returning) {
+    memcpy(src.mac, mac, 6);
+    src.received = 0;
+    src.lost = 0;
+    src.skipped = 0;
+    src.superseded = 0;
+    src.concealed = 0;
+    src.rateFrames = 0;
+    src.fps = 0;
+  }
+  src.sequence.haveLast = false;
+  src.lastFullLayerMs = 0;
+  src.lastHeardTime = millis();
+  src.known = true;
+  
+  // Every camera's airtime share changes
+  for (int i = 0; i < CAM_SOURCES; i++) {
+    sources[i].lastCapsTime = 0;
+  }
+  Serial.printf("[Master] Camera %d %s: %02X:%02X:%02X:%02X:%02X:%02X\n", s + 1, returning ? "back" : "joined",
+                mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  return s;
+}
+
+// Releases the entry of an adopted camera that has sent no header for
+// SOURCE_QUIET_MS (packet task), so a camera that was switched off does
+// not hold it for good. The MAC stays: if it comes back before another
+// camera pairs into the entry, it takes it up again without PAIR.
+void CommunicationManager::checkSources() {
+  unsigned long now = millis();
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    CameraSource& src = sources[s];
+    if (!src.known || src.listed || now - src.lastHeardTime < SOURCE_QUIET_MS) continue;
+    
+    xSemaphoreTake(rxMutex, portMAX_DELAY);
+    for (int i = 0; i < RX_FRAMES; i++) {
+      if (src.frames[i].active) resetFrame(src.frames[i]);
+    }
+    src.known = false;
+    xSemaphoreGive(rxMutex);
+    
+    esp_now_del_peer(src.mac);
+    if (focus == s) focus = -1;
+    for (int i = 0; i < CAM_SOURCES; i++) {
+      sources[i].lastCapsTime = 0;
+    }
+    Serial.printf("[Master] Camera %d quiet for %d s, released\n", s + 1, SOURCE_QUIET_MS / 1000);
+  }
+}
+
+int CommunicationManager::getCameraCount() {
+  int count = 0;
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    if (sources[s].known) count++;
+  }
+  return count;
+}
+
+// Camera whose frames fill the screen: the one in focus, or the only one
+// there is; -1 in the mosaic
+int8_t CommunicationManager::shownSource() {
+  if (focus >= 0) return focus;
+  if (getCameraCount() > 1) return -1;
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    if (sources[s].known) return s;
+  }
+  return 0;
+}
+
+// Full-screen view of one camera, or the mosaic (-1). Display side: held
+// frames of the previous view are dropped.
+void CommunicationManager::setFocus(int8_t source) {
+  focus = source;
+  flushImages();
+}
+
+// Tells each camera what the panel can show and how many cameras share
+// the channel; repeated so a camera that restarts picks it up again
+void CommunicationManager::sendCaps() {
+  if (!panelWidth) return;
+  
+  CapsPacket caps;
+  camInitHeader(caps.hdr, CAM_MSG_CAPS, 0, 0);
+  caps.panelWidth = panelWidth;
+  caps.panelHeight = panelHeight;
+  caps.rotation = panelRotation;
+  caps.cameras = getCameraCount();
+  camSeal(&caps, sizeof(caps));
+  
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    CameraSource& src = sources[s];
+    if (!src.known || (src.lastCapsTime && millis() - src.lastCapsTime < CAPS_REPEAT_MS)) continue;
+    esp_now_send(src.mac, (uint8_t*)&caps, sizeof(caps));
+    src.lastCapsTime = millis();
+  }
+}
+
+// Sends a message to every camera; false if any send failed
+bool CommunicationManager::sendAll(const void* msg, size_t len) {
+  bool ok = true;
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    if (sources[s].known && esp_now_send(sources[s].mac, (const uint8_t*)msg, len) != ESP_OK) {
+      ok = false;
+    }
+  }
+  return ok;
+}
+
 bool CommunicationManager::sendCommand(const char* command) {
   CommandPacket cmd;
+  memset(&cmd, 0, sizeof(cmd));
+  camInitHeader(cmd.hdr, CAM_MSG_COMMAND, 0, 0);
   strncpy(cmd.command, command, sizeof(cmd.command) - 1);
   cmd.command[sizeof(cmd.command) - 1] = '\0';
   cmd.timestamp = millis();
+  camSeal(&cmd, sizeof(cmd));
   
-  esp_err_t result = esp_now_send(slaveMac, (uint8_t*)&cmd, sizeof(cmd));
-  
-  if (result == ESP_OK) {
+  if (sendAll(&cmd, sizeof(cmd))) {
     Serial.printf("Command sent: %s\n", command);
     return true;
   } else {
@@ -100,14 +315,15 @@ bool CommunicationManager::sendCommand(const char* command) {
 
 bool CommunicationManager::sendTextMessage(const char* message) {
   TextMessagePacket msg;
+  memset(&msg, 0, sizeof(msg));
+  camInitHeader(msg.hdr, CAM_MSG_TEXT, 0, 0);
   strncpy(msg.message, message, sizeof(msg.message) - 1);
   msg.message[sizeof(msg.message) - 1] = '\0';
   msg.timestamp = millis();
   msg.fromMaster = 1;  // From master
+  camSeal(&msg, sizeof(msg));
   
-  esp_err_t result = esp_now_send(slaveMac, (uint8_t*)&msg, sizeof(msg));
-  
-  if (result == ESP_OK) {
+  if (sendAll(&msg, sizeof(msg))) {
     Serial.printf("📤 [Message sent to Slave]: %s\n", message);
     return true;
   } else {
@@ -116,173 +332,635 @@ bool CommunicationManager::sendTextMessage(const char* message) {
   }
 }
 
+// Dispatch table indexed by CamMsgType (runs in the packet task)
+const CamMsgHandler CommunicationManager::handlers[CAM_MSG_TYPE_COUNT] = {
+  nullptr,                                   // 0: invalid
+  CommunicationManager::onImageHeader,       // CAM_MSG_HEADER
+  CommunicationManager::onImagePacket,       // CAM_MSG_DATA
+  CommunicationManager::onImagePacket,       // CAM_MSG_PARITY
+  nullptr,                                   // CAM_MSG_NACK (camera side only)
+  nullptr,                                   // CAM_MSG_COMMAND (camera side only)
+  CommunicationManager::onTextMessage,       // CAM_MSG_TEXT
+  nullptr,                                   // CAM_MSG_REPORT (camera side only)
+  nullptr                                    // CAM_MSG_CAPS: sent by the master only
+};
+
+// Runs in the Wi-Fi task: one copy into the ring, no allocation, locking or printing
 void CommunicationManager::onDataReceived(const uint8_t *mac, const uint8_t *data, int len) {
   if (!instance) return;
   
-  // Check for image header
-  if (len == sizeof(ImageHeader)) {
-    ImageHeader* header = (ImageHeader*)data;
-    
-    Serial.printf("[Master] Receiving new image: %dx%d, %d bytes, %d packets\n",
-                  header->width, header->height, header->imageSize,
-                  (header->imageSize + 239) / 240);
-    
-    xSemaphoreTake(instance->rxMutex, portMAX_DELAY);
-    instance->resetReception();
-    
-    instance->expectedImageSize = header->imageSize;
-    instance->expectedTotalPackets = (header->imageSize + 239) / 240;
-    instance->currentHeader = *header;
-    
-    instance->imageBuffer = (uint8_t*)malloc(header->imageSize);
-    instance->packetReceived = (bool*)calloc(instance->expectedTotalPackets, sizeof(bool));
-    
-    if (instance->imageBuffer && instance->packetReceived) {
-      instance->receivingImage = true;
-      instance->packetsReceivedCount = 0;
-      instance->lastPacketTime = millis();
-      Serial.printf("Receiving image: %dx%d, %d bytes, %d packets\n",
-                    header->width, header->height, header->imageSize, 
-                    instance->expectedTotalPackets);
-    } else {
-      instance->resetReception();
-      Serial.println("Memory allocation failed!");
+  if (instance->rxRing.push(mac, data, len)) {
+    xTaskNotifyGive(instance->packetTaskHandle);
+  }
+}
+
+void CommunicationManager::onImageHeader(const uint8_t *mac, const uint8_t *data, int len) {
+  const ImageHeader* header = (const ImageHeader*)data;
+  uint16_t totalPackets = (header->imageSize + CAM_PACKET_PAYLOAD - 1) / CAM_PACKET_PAYLOAD;
+  
+  if (header->totalPackets != totalPackets) {
+    Serial.printf("[Master] Frame #%u: inconsistent header, ignored\n", header->hdr.frameId);
+    return;
+  }
+  
+  int source = instance->findSource(mac);
+  if (source < 0) source = instance->adoptSource(mac);
+  if (source < 0) {
+    instance->foreignPackets++;  // Not paired, or a fifth camera
+    static unsigned long lastRefusal = 0;
+    if (millis() - lastRefusal > 10000) {
+      lastRefusal = millis();
+      Serial.printf("[Master] Frames from %02X:%02X:%02X:%02X:%02X:%02X ignored: not paired (PAIR) or no free entry\n",
+                    mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
     }
-    
-    xSemaphoreGive(instance->rxMutex);
     return;
   }
+  CameraSource& src = instance->sources[source];
+  src.lastHeardTime = millis();
   
-  // Check for image packet
-  if (len == sizeof(ImagePacket) && instance->receivingImage) {
-    ImagePacket packet = *(ImagePacket*)data;
-    xQueueSendFromISR(instance->packetQueue, &packet, NULL);
+  if (header->imageSize == 0 || header->imageSize > FRAME_SLOT_SIZE) {
+    Serial.printf("[Cam %d] Frame #%u: %lu bytes does not fit a %d byte slot\n",
+                  source + 1, header->hdr.frameId, (unsigned long)header->imageSize, FRAME_SLOT_SIZE);
+    src.lost++;
     return;
   }
   
-  // Check for text message
-  if (len == sizeof(TextMessagePacket)) {
-    TextMessagePacket* msg = (TextMessagePacket*)data;
-    if (msg->fromMaster == 0) {  // Message from slave
-      Serial.printf("\n📨 [Message from Slave]: %s\n\n", msg->message);
-    }
+  xSemaphoreTake(instance->rxMutex, portMAX_DELAY);
+  
+  if (rxFindFrame(src.frames, RX_FRAMES, header->hdr.frameId)) {
+    xSemaphoreGive(instance->rxMutex);
+    return;  // Duplicate header
+  }
+  
+  // A simulcast camera also broadcasts a base layer for smaller displays;
+  // its packets find no frame here and are dropped undecoded
+  if (!camLayerWanted(*header, src.lastFullLayerMs, millis())) {
+    xSemaphoreGive(instance->rxMutex);
     return;
   }
+  
+  Serial.printf("[Cam %d] Receiving frame #%u: %dx%d, %lu bytes, %d packets\n",
+                source + 1, header->hdr.frameId, header->width, header->height,
+                (unsigned long)header->imageSize, totalPackets);
+  
+  // Frames whose header never arrived show up as gaps in the frame ID
+  uint16_t missed = rxMissedFrames(src.sequence, *header);
+  if (missed) {
+    src.skipped += missed;
+    Serial.printf("[Cam %d] %d frame(s) missed before #%u\n", source + 1, missed, header->hdr.frameId);
+  }
+  
+  if (!instance->startFrame(src, source, *header)) {
+    Serial.println("[Master] No free frame slot!");
+    src.lost++;
+  }
+  
+  xSemaphoreGive(instance->rxMutex);
+}
+
+void CommunicationManager::onImagePacket(const uint8_t *mac, const uint8_t *data, int len) {
+  int source = instance->findSource(mac);
+  if (source < 0) {
+    instance->foreignPackets++;
+    return;
+  }
+  instance->processPacket(instance->sources[source], *(const ImagePacket*)data, len);
+}
+
+void CommunicationManager::onTextMessage(const uint8_t *mac, const uint8_t *data, int len) {
+  const TextMessagePacket* msg = (const TextMessagePacket*)data;
+  if (msg->fromMaster == 0) {  // Message from slave
+    Serial.printf("\n📨 [Message from Slave %d]: %s\n\n", instance->findSource(mac) + 1, msg->message);
+  }
 }
 
 void CommunicationManager::packetProcessingTask(void* param) {
   CommunicationManager* self = (CommunicationManager*)param;
-  ImagePacket packet;
+  PacketSlot* slot;
   
   for(;;) {
-    if (xQueueReceive(self->packetQueue, &packet, portMAX_DELAY) == pdTRUE) {
-      self->processPacket(packet);
+    // Wake up periodically so gaps are reported even when the stream goes quiet
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+    
+    // Messages are validated and handled in place, then the slot is handed back
+    while ((slot = self->rxRing.peek()) != nullptr) {
+      uint8_t type = camCheck(slot->data, slot->len);
+      if (type && handlers[type]) {
+        handlers[type](slot->mac, slot->data, slot->len);
+      } else if (!type && self->findSource(slot->mac) < 0) {
+        // Not a camera message, and not from a camera either (a camera
+        // packet that failed its CRC can have a trigger's length)
+        self->checkTrigger(slot->mac, slot->data, slot->len);
+      }
+      self->rxRing.release();
     }
+    
+    self->checkRepair();
+    
+    // Timeouts live here, not in loop(), which blocks while a frame is streamed
+    self->checkTimeouts();
+    self->checkSources();
+    self->sendCaps();
+    self->updateRates();
+  }
+}
+
+// Frames per second each camera delivered over the last CAM_RATE_MS
+void CommunicationManager::updateRates() {
+  unsigned long now = millis();
+  if (now - lastRateTime < CAM_RATE_MS) return;
+  
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    CameraSource& src = sources[s];
+    src.fps = lastRateTime ? src.rateFrames * 1000.0f / (now - lastRateTime) : 0;
+    src.rateFrames = 0;
+  }
+  lastRateTime = now;
+}
+
+// Sets up reassembly for a new frame; when every context of the camera is
+// busy its oldest frame is abandoned (caller holds rxMutex)
+FrameContext* CommunicationManager::startFrame(CameraSource& src, int8_t source, const ImageHeader& header) {
+  FrameContext* frame = rxPickFrame(src.frames, RX_FRAMES, header.hdr.frameId);
+  if (frame->active) {
+    Serial.printf("[Cam %d] Frame #%u abandoned: %d/%d packets\n", source + 1,
+                  frame->header.hdr.frameId, frame->packetsReceived, frame->header.totalPackets);
+    src.lost++;
+    resetFrame(*frame);
+  }
+  
+  frame->slot = acquireSlot();
+  if (frame->slot < 0) return nullptr;
+  
+  rxStartFrame(*frame, header, framePool.data(frame->slot), millis());
+  frame->contiguous = 0;
+  
+  // Offer the frame to the display while it is still arriving (only when
+  // its camera has the whole screen)
+  frame->streamed = false;
+  if (progressive && header.format == CAM_FORMAT_JPEG && shownSource() == source &&
+      stream.state.load(std::memory_order_acquire) == STREAM_IDLE) {
+    stream.imageData = frame->imageBuffer;
+    stream.slot = frame->slot;
+    stream.source = source;
+    stream.imageSize = header.imageSize;
+    stream.width = header.width;
+    stream.height = header.height;
+    stream.frameId = header.hdr.frameId;
+    stream.captureMs = header.captureMs;
+    stream.startTime = millis();
+    stream.available.store(0, std::memory_order_relaxed);
+    stream.state.store(STREAM_RECEIVING, std::memory_order_release);
+    frame->streamed = true;
+  }
+  return frame;
+}
+
+// Releases a frame's slot; a slot still held here belongs to an incomplete frame
+void CommunicationManager::resetFrame(FrameContext& frame) {
+  if (frame.streamed && endStream(frame, STREAM_ABORTED)) {
+    frame.slot = -1;  // The display releases it after stopping its decode
   }
+  frame.streamed = false;
+  if (frame.slot >= 0) {
+    framePool.release(frame.slot);
+    frame.slot = -1;
+  }
+  frame.imageBuffer = nullptr;
+  frame.active = false;
 }
 
-void CommunicationManager::processPacket(const ImagePacket& packet) {
+void CommunicationManager::processPacket(CameraSource& src, const ImagePacket& packet, int len) {
   xSemaphoreTake(rxMutex, portMAX_DELAY);
   
-  if (!receivingImage || packet.packetNum >= expectedTotalPackets) {
+  // Packets are routed by camera and frame ID; a frame never merges packets
+  // of another
+  FrameContext* frame = rxFindFrame(src.frames, RX_FRAMES, packet.hdr.frameId);
+  if (!frame) {
+    foreignPackets++;
     xSemaphoreGive(rxMutex);
     return;
   }
   
-  if (packetReceived[packet.packetNum]) {
-    xSemaphoreGive(rxMutex);
-    return;
+  uint8_t result = rxAddPacket(*frame, packet, len, millis());
+  if (result & RX_PACKET_REPAIRED) {
+    packetsRepaired++;
+  }
+  if (result & RX_PACKET_RECOVERED) {
+    packetsRecovered++;
+  }
+  if (result & (RX_PACKET_STORED | RX_PACKET_RECOVERED)) {
+    advanceStream(*frame);
+  }
+  if (result & RX_FRAME_COMPLETE) {
+    completeImage(*frame);
   }
   
-  uint32_t bufferPos = packet.packetNum * 240;
-  uint32_t copySize = min((uint32_t)packet.dataSize, expectedImageSize - bufferPos);
+  xSemaphoreGive(rxMutex);
+}
+
+// Hands the reassembled frame's slot to the display side; frames of a camera
+// that is not on screen are only counted (caller holds rxMutex)
+void CommunicationManager::completeImage(FrameContext& frame) {
+  const ImageHeader& header = frame.header;
+  CameraSource& src = sources[frame.source];
+  int8_t shown = shownSource();
   
-  if (bufferPos + copySize <= expectedImageSize) {
-    memcpy(&imageBuffer[bufferPos], packet.data, copySize);
-    packetReceived[packet.packetNum] = true;
-    packetsReceivedCount++;
-    lastPacketTime = millis();
-    
-    // Check if image is complete
-    if (packetsReceivedCount >= expectedTotalPackets) {
-      // Verify JPEG header
-      if (imageBuffer[0] == 0xFF && imageBuffer[1] == 0xD8) {
-        CompleteImage img;
-        img.imageData = (uint8_t*)malloc(expectedImageSize);
-        
-        if (img.imageData) {
-          memcpy(img.imageData, imageBuffer, expectedImageSize);
-          img.imageSize = expectedImageSize;
-          img.width = currentHeader.width;
-          img.height = currentHeader.height;
-          img.resolutionMode = currentHeader.resolutionMode;
-          img.timestamp = millis();
-          
-          if (xQueueSend(imageQueue, &img, 0) != pdTRUE) {
-            // Queue full, remove old image
-            CompleteImage oldImg;
-            if (xQueueReceive(imageQueue, &oldImg, 0) == pdTRUE) {
-              free(oldImg.imageData);
-            }
-            xQueueSend(imageQueue, &img, 0);
-          }
-          
-          totalReceived++;
-          Serial.printf("Image complete! (%d/%d packets)\n", 
-                       packetsReceivedCount, expectedTotalPackets);
+  // A streamed frame is already with the display, unless it gave up on it
+  if (frame.streamed && endStream(frame, STREAM_COMPLETE)) {
+    frame.slot = -1;
+    src.received++;
+    src.rateFrames++;
+    Serial.printf("[Cam %d] Frame #%u complete (streamed): %d packets, %d FEC-recovered, %d resent in %d rounds\n", 
+                  frame.source + 1, header.hdr.frameId, header.totalPackets,
+                  frame.recovered, frame.repaired, frame.nackRounds);
+  }
+  // Verify JPEG header (tile frames are checked record by record when drawn)
+  else if (header.format == CAM_FORMAT_TILES ||
+           (frame.imageBuffer[0] == 0xFF && frame.imageBuffer[1] == 0xD8)) {
+    if (shown >= 0 && shown != frame.source) {
+      // Not on screen: the slot goes back with resetFrame() below
+    } else {
+      CompleteImage img;
+      img.slot = frame.slot;
+      img.source = frame.source;
+      img.imageData = frame.imageBuffer;
+      img.imageSize = header.imageSize;
+      img.width = header.width;
+      img.height = header.height;
+      img.resolutionMode = header.resolutionMode;
+      img.format = header.format;
+      img.frameId = header.hdr.frameId;
+      img.timestamp = millis();
+      img.captureMs = header.captureMs;
+      img.concealedRows = 0;
+      img.mcuHeight = 8;
+      
+      if (xQueueSend(imageQueue, &img, 0) != pdTRUE) {
+        // Queue full, remove old image
+        CompleteImage oldImg;
+        if (xQueueReceive(imageQueue, &oldImg, 0) == pdTRUE) {
+          freeImage(oldImg);
         }
-      } else {
-        Serial.println("Invalid JPEG header!");
-        totalLost++;
+        xQueueSend(imageQueue, &img, 0);
       }
+      frame.slot = -1;  // Owned by the display side now
+    }
+    
+    src.received++;
+    src.rateFrames++;
+    Serial.printf("[Cam %d] Frame #%u complete: %d packets, %d FEC-recovered, %d resent in %d rounds\n", 
+                 frame.source + 1, header.hdr.frameId, header.totalPackets,
+                 frame.recovered, frame.repaired, frame.nackRounds);
+  } else {
+    Serial.println("Invalid JPEG header!");
+    src.lost++;
+  }
+  
+  // Acknowledge so the slave can release the frame right away
+  if (repairEnabled) {
+    sendNack(frame);
+  }
+  
+  // Older frames of the same camera still in reassembly would be shown out
+  // of order; drop them and acknowledge them so the slave stops repairing
+  // them too
+  for (int i = 0; i < RX_FRAMES; i++) {
+    FrameContext& other = src.frames[i];
+    if (&other == &frame || !other.active) continue;
+    if (rxNewer(header.hdr.frameId, other.header.hdr.frameId)) {
+      Serial.printf("[Cam %d] Frame #%u superseded by #%u: %d/%d packets\n", frame.source + 1,
+                    other.header.hdr.frameId, header.hdr.frameId,
+                    other.packetsReceived, other.header.totalPackets);
+      if (repairEnabled) {
+        sendNack(other, true);
+      }
+      src.superseded++;
+      src.lost++;
+      resetFrame(other);
+    }
+  }
+  
+  resetFrame(frame);
+}
+
+void CommunicationManager::checkRepair() {
+  if (!repairEnabled) return;
+  
+  unsigned long now = millis();
+  
+  xSemaphoreTake(rxMutex, portMAX_DELAY);
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    for (int i = 0; i < RX_FRAMES; i++) {
+      FrameContext& frame = sources[s].frames[i];
+      if (!rxNackDue(frame, now)) continue;
       
-      resetReception();
+      sendNack(frame);
+      frame.nackRounds++;
     }
   }
+  xSemaphoreGive(rxMutex);
+}
+
+// Reports the missing packets of a frame (caller holds rxMutex). An empty
+// bitmap acknowledges a complete frame, or one the master has given up on.
+void CommunicationManager::sendNack(FrameContext& frame, bool giveUp) {
+  // The bitmap starts at the first gap so large frames are covered over several rounds
+  NackPacket nack;
+  rxBuildNack(frame, nack, giveUp, millis());
+  esp_now_send(sources[frame.source].mac, (uint8_t*)&nack, sizeof(nack));
   
+  if (nack.missingCount > 0) {
+    nacksSent++;
+    Serial.printf("[Cam %d] Frame #%u NACK round %d: %d packets missing from #%d\n",
+                  frame.source + 1, frame.header.hdr.frameId, frame.nackRounds + 1,
+                  nack.missingCount, nack.firstPacket);
+  }
+}
+
+void CommunicationManager::checkTimeouts() {
+  // Check for timeout - increased to 5 seconds for reliability.
+  // Once every repair round is spent there is nothing left to wait for.
+  xSemaphoreTake(rxMutex, portMAX_DELAY);
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    for (int i = 0; i < RX_FRAMES; i++) {
+      FrameContext& frame = sources[s].frames[i];
+      if (!frame.active) continue;
+      
+      unsigned long idle = millis() - frame.lastPacketTime;
+      bool settled = rxSettled(frame, repairEnabled, millis());
+      if (settled && !frame.streamed && concealFrame(frame)) {
+        resetFrame(frame);
+        continue;
+      }
+      
+      if (idle > 5000 || settled) {
+        Serial.printf("[Cam %d] Frame #%u timeout! Got %d/%d packets\n", s + 1,
+                      frame.header.hdr.frameId, frame.packetsReceived, frame.header.totalPackets);
+        sources[s].lost++;
+        resetFrame(frame);
+      }
+    }
+  }
   xSemaphoreGive(rxMutex);
 }
 
-void CommunicationManager::resetReception() {
-  if (imageBuffer) {
-    free(imageBuffer);
-    imageBuffer = nullptr;
+// Queues a frame whose missing packets will not come any more, with the lost
+// restart intervals patched from the previous frame (caller holds rxMutex).
+// A camera that is not on screen gets nothing to conceal.
+bool CommunicationManager::concealFrame(FrameContext& frame) {
+  int8_t shown = shownSource();
+  if (shown >= 0 && shown != frame.source) return false;
+  
+  int slot = framePool.acquire();
+  if (slot < 0) return false;
+  
+  JpegConcealInfo info;
+  uint32_t size = jpegConceal(frame.imageBuffer, frame.header.imageSize, frame.receivedBits, CAM_PACKET_PAYLOAD,
+                              framePool.data(slot), framePool.getSlotSize(), info);
+  if (size == 0) {
+    framePool.release(slot);
+    return false;
   }
-  if (packetReceived) {
-    free(packetReceived);
-    packetReceived = nullptr;
+  
+  CompleteImage img;
+  img.slot = slot;
+  img.source = frame.source;
+  img.imageData = framePool.data(slot);
+  img.imageSize = size;
+  img.width = frame.header.width;
+  img.height = frame.header.height;
+  img.resolutionMode = frame.header.resolutionMode;
+  img.format = CAM_FORMAT_JPEG;
+  img.frameId = frame.header.hdr.frameId;
+  img.timestamp = millis();
+  img.captureMs = frame.header.captureMs;
+  img.concealedRows = info.rows;
+  img.mcuHeight = info.mcuHeight;
+  
+  if (xQueueSend(imageQueue, &img, 0) != pdTRUE) {
+    framePool.release(slot);
+    return false;
   }
-  expectedImageSize = 0;
-  expectedTotalPackets = 0;
-  packetsReceivedCount = 0;
-  receivingImage = false;
+  
+  CameraSource& src = sources[frame.source];
+  src.concealed++;
+  src.received++;
+  src.rateFrames++;
+  Serial.printf("[Cam %d] Frame #%u concealed: %d/%d packets, %d/%d restart intervals patched\n",
+                frame.source + 1, frame.header.hdr.frameId, frame.packetsReceived, frame.header.totalPackets,
+                info.damaged, info.intervals);
+  return true;
 }
 
-void CommunicationManager::processIncomingData() {
-  // Check for timeout - increased to 5 seconds for reliability
-  if (receivingImage && (millis() - lastPacketTime > 5000)) {
-    xSemaphoreTake(rxMutex, portMAX_DELAY);
-    Serial.printf("[Master] Reception timeout! Got %d/%d packets\n", 
-                  packetsReceivedCount, expectedTotalPackets);
-    totalLost++;
-    resetReception();
-    xSemaphoreGive(rxMutex);
+int CommunicationManager::getFramesInFlight() {
+  int count = 0;
+  for (int s = 0; s < CAM_SOURCES; s++) {
+    for (int i = 0; i < RX_FRAMES; i++) {
+      if (sources[s].frames[i].active) count++;
+    }
   }
+  return count;
+}
+
+// Totals over every camera
+int CommunicationManager::getReceivedCount() {
+  int count = 0;
+  for (int s = 0; s < CAM_SOURCES; s++) count += sources[s].received;
+  return count;
 }
 
-bool CommunicationManager::hasCompleteImage() {
-  return uxQueueMessagesWaiting(imageQueue) > 0;
+int CommunicationManager::getLostCount() {
+  int count = 0;
+  for (int s = 0; s < CAM_SOURCES; s++) count += sources[s].lost;
+  return count;
 }
 
-CompleteImage CommunicationManager::getCompleteImage() {
+int CommunicationManager::getSkippedFrames() {
+  int count = 0;
+  for (int s = 0; s < CAM_SOURCES; s++) count += sources[s].skipped;
+  return count;
+}
+
+int CommunicationManager::getSupersededFrames() {
+  int count = 0;
+  for (int s = 0; s < CAM_SOURCES; s++) count += sources[s].superseded;
+  return count;
+}
+
+int CommunicationManager::getConcealedFrames() {
+  int count = 0;
+  for (int s = 0; s < CAM_SOURCES; s++) count += sources[s].concealed;
+  return count;
+}
+
+// Moves finished frames into the jitter buffer and returns the one due for
+// display, if any (display side only). The mosaic gets frames as they come:
+// one playout clock cannot follow several cameras.
+bool CommunicationManager::nextImage(CompleteImage& img) {
+  int8_t shown = shownSource();
+  int16_t slot;
+  
+  // The jitter buffer follows one camera; a new one starts from scratch
+  if (shown != jitterSource) {
+    while ((slot = jitter.takeAny()) >= 0) {
+      framePool.release(slot);
+    }
+    jitter.restart();
+    jitterSource = shown;
+  }
+  
+  CompleteImage incoming;
+  while (xQueueReceive(imageQueue, &incoming, 0) == pdTRUE) {
+    if (shown < 0) {
+      img = incoming;
+      return true;
+    }
+    if (incoming.source != shown) {
+      freeImage(incoming);  // Queued just before the view changed
+      continue;
+    }
+    heldImages[incoming.slot] = incoming;
+    int16_t dropped = jitter.push(incoming.slot, incoming.captureMs, millis());
+    if (dropped >= 0 && !skipImage(dropped, img)) return true;
+  }
+  
+  // Fallen behind: skip to the newest frame that is due
+  while ((slot = jitter.takeLate(millis())) >= 0) {
+    if (!skipImage(slot, img)) return true;
+  }
+  
+  slot = jitter.takeDue(millis());
+  if (slot < 0) return false;
+  img = heldImages[slot];
+  return true;
+}
+
+// Releases a frame the jitter buffer gave up on. Tile updates cannot be
+// skipped (the tiles they carry would stay stale until the next key frame),
+// so those are handed back in img to be drawn now; returns false then.
+bool CommunicationManager::skipImage(int16_t slot, CompleteImage& img) {
+  if (heldImages[slot].format == CAM_FORMAT_TILES) {
+    img = heldImages[slot];
+    return false;
+  }
+  framePool.release(slot);
+  return true;
+}
+
+// Drops every finished frame that has not been drawn yet
+void CommunicationManager::flushImages() {
   CompleteImage img;
-  xQueueReceive(imageQueue, &img, 0);
-  return img;
+  while (xQueueReceive(imageQueue, &img, 0) == pdTRUE) {
+    freeImage(img);
+  }
+  int16_t slot;
+  while ((slot = jitter.takeAny()) >= 0) {
+    framePool.release(slot);
+  }
 }
 
 void CommunicationManager::freeImage(CompleteImage& img) {
   if (img.imageData) {
-    free(img.imageData);
+    framePool.release(img.slot);
     img.imageData = nullptr;
   }
-}
\ No newline at end of file
+}
+
+// Called once a frame has been drawn: whole JPEGs stay in their slots as
+// pre-roll (the recorder gives them back), anything else is freed now.
+// Concealed frames are not kept, their patched rows only look right on screen.
+void CommunicationManager::retireImage(CompleteImage& img) {
+  if (img.imageData && img.format == CAM_FORMAT_JPEG && !img.concealedRows && img.source == recordSource() &&
+      recorder.keep(img.slot, img.imageData, img.imageSize, img.width, img.height, img.captureMs)) {
+    img.imageData = nullptr;
+    return;
+  }
+  freeImage(img);
+}
+
+// Doorbell and emergency messages from DeviceMaster (protocol.h) save the
+// pre-roll; they fail camCheck() and arrive here instead. Only the
+// configured deviceMasterMac can trigger.
+void CommunicationManager::checkTrigger(const uint8_t* mac, const uint8_t* data, int len) {
+  static const uint8_t none[6] = {0, 0, 0, 0, 0, 0};
+  if (memcmp(deviceMasterMac, none, 6) == 0 || memcmp(mac, deviceMasterMac, 6) != 0) return;
+  
+  if (len == sizeof(RingerMessage)) {
+    const RingerMessage* msg = (const RingerMessage*)data;
+    if (strncmp(msg->command, "RING", sizeof(msg->command)) == 0) recorder.trigger("ring");
+  } else if (len == sizeof(DisplayPayload)) {
+    const DisplayPayload* msg = (const DisplayPayload*)data;
+    if (msg->action == ACT_EMERGENCY) recorder.trigger("emergency");
+  }
+}
+
+// Publishes the bytes now present in order from the start of a streamed
+// frame (caller holds rxMutex)
+void CommunicationManager::advanceStream(FrameContext& frame) {
+  if (!frame.streamed) return;
+  
+  uint16_t totalPackets = frame.header.totalPackets;
+  uint16_t contiguous = frame.contiguous;
+  while (contiguous < totalPackets && bitsetTest(frame.receivedBits, contiguous)) contiguous++;
+  if (contiguous == frame.contiguous) return;
+  frame.contiguous = contiguous;
+  
+  uint32_t bytes = (uint32_t)contiguous * CAM_PACKET_PAYLOAD;
+  if (bytes > frame.header.imageSize) bytes = frame.header.imageSize;
+  stream.available.store(bytes, std::memory_order_release);
+}
+
+// Ends the packet task's part of a streamed frame. Returns true when the
+// display now owns the slot, false when the display had already given up
+// and the frame goes back to the normal path (caller holds rxMutex).
+bool CommunicationManager::endStream(FrameContext& frame, StreamState state) {
+  frame.streamed = false;
+  
+  if (state == STREAM_COMPLETE) {
+    stream.available.store(frame.header.imageSize, std::memory_order_release);
+  }
+  
+  uint8_t expected = STREAM_RECEIVING;
+  if (stream.state.compare_exchange_strong(expected, state, std::memory_order_acq_rel)) {
+    return true;
+  }
+  
+  stream.state.store(STREAM_IDLE, std::memory_order_release);  // Was STREAM_DETACHED
+  return false;
+}
+
+bool CommunicationManager::hasStreamingImage() {
+  uint8_t state = stream.state.load(std::memory_order_acquire);
+  return state == STREAM_RECEIVING || state == STREAM_COMPLETE || state == STREAM_ABORTED;
+}
+
+// Called by the display side once it stops decoding the streamed frame
+void CommunicationManager::finishStream() {
+  uint8_t expected = STREAM_RECEIVING;
+  if (stream.state.compare_exchange_strong(expected, STREAM_DETACHED, std::memory_order_acq_rel)) {
+    return;  // Still being received; the packet task keeps the slot
+  }
+  
+  // A frame that arrived whole joins the pre-roll like any displayed frame
+  if (expected != STREAM_COMPLETE || stream.source != recordSource() ||
+      !recorder.keep(stream.slot, stream.imageData, stream.imageSize, stream.width, stream.height, stream.captureMs)) {
+    framePool.release(stream.slot);
+  }
+  stream.slot = -1;
+  stream.state.store(STREAM_IDLE, std::memory_order_release);
+}
+
+// Free slot for a new frame; when every slot is busy the oldest frame still
+// waiting for display is dropped in favour of the new one
+int CommunicationManager::acquireSlot() {
+  int slot = framePool.acquire();
+  if (slot < 0) {
+    CompleteImage oldImg;
+    if (xQueueReceive(imageQueue, &oldImg, 0) == pdTRUE) {
+      freeImage(oldImg);
+      slot = framePool.acquire();
+    }
+  }
+  return slot;
+}
@@ -5,54 +5,222 @@
 #include <WiFi.h>
 #include <esp_now.h>
 #include "DataStructures.h"
+#include "PacketRing.h"
+#include "JpegConceal.h"
+#include "JitterBuffer.h"
+#include "EventRecorder.h"
+#include "protocol.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 
+// Largest JPEG accepted; every frame slot is this big (QVGA at quality 4 from Slave_Camera)
+#define FRAME_SLOT_SIZE 40000
+
+// Frames reassembled at the same time per camera, so a new frame can start
+// while retransmissions for the previous one are still arriving
+#define RX_FRAMES 3
+
+// Camera slaves streaming to this display at once, each with its own
+// reassembly contexts and statistics; shown as a 2x2 mosaic
+#define CAM_SOURCES 4
+#define CAM_RATE_MS 2000    // Window of the per-camera frame rate
+#define PAIR_WINDOW_MS 60000   // PAIR accepts cameras that are not listed for this long
+#define SOURCE_QUIET_MS 60000  // An adopted camera silent this long gives up its entry
+
+// Jitter buffer: finished frames are shown at a steady rate from their
+// capture times, held at most JITTER_FRAMES frames / JITTER_MAX_DELAY_MS
+// (change at run time with the JITTER command, up to JITTER_MAX_DEPTH)
+#define JITTER_FRAMES 2
+#define JITTER_MAX_DELAY_MS 250
+#define JITTER_MAX_DEPTH 4
+
+// Reassembly + held for playout + queued (2) + on screen + pre-roll recorder,
+// and one frame in reassembly plus one queued for every further camera.
+//
+// Memory budget, all allocated in begin() (PSRAM when present): with the
+// values above, 32 slots x FRAME_SLOT_SIZE = 1.28 MB, plus per reassembly
+// context (RX_FRAMES x CAM_SOURCES = 12) about 41 KB of parity buffer and
+// bitsets, 0.49 MB: about 1.8 MB. Without PSRAM the pool cannot be
+// allocated and begin() fails. The slot mask is 32 bits wide, so raising
+// RX_FRAMES, JITTER_MAX_DEPTH, PREROLL_FRAMES or CAM_SOURCES means lowering
+// another of them.
+#define FRAME_POOL_SLOTS (RX_FRAMES + JITTER_MAX_DEPTH + 3 + PREROLL_FRAMES + 2 * (CAM_SOURCES - 1))
+static_assert(FRAME_POOL_SLOTS <= 32, "FRAME_POOL_SLOTS over 32: lower PREROLL_FRAMES, JITTER_MAX_DEPTH or CAM_SOURCES");
+#include "FramePool.h"
+#include "FrameReassembly.h"
+
+// Reassembly state of one frame (FrameReassembly.h); several frames can be
+// in flight at once, matched by header.hdr.frameId
+struct FrameContext : RxFrame {
+  int8_t source;                // Camera sending it, replies go back there
+  int8_t slot;                  // Frame pool slot the image is assembled in
+  bool streamed;                // Being decoded while it arrives (see StreamingImage)
+  uint16_t contiguous;          // Data packets received in order from the start
+};
+
+// One camera slave and its frames in reassembly, each assembled in place
+// in a pool slot
+typedef struct {
+  uint8_t mac[6];
+  bool known;                      // Listed in cameraMacs, or adopted while PAIR was open
+  bool listed;                     // In cameraMacs: never times out
+  unsigned long lastHeardTime;     // Last header from this camera
+  FrameContext frames[RX_FRAMES];
+  RxSequence sequence;             // Frame IDs seen, for counting missed frames
+  uint32_t lastFullLayerMs;        // Simulcast camera: last full-layer header (camLayerWanted)
+  unsigned long lastCapsTime;
+  
+  // Statistics
+  int received;
+  int lost;
+  int skipped;
+  int superseded;
+  int concealed;
+  uint32_t rateFrames;             // Frames finished in the current rate window
+  float fps;
+} CameraSource;
+
 class CommunicationManager {
 private:
-  // Slave device MAC address - UPDATE THIS!
-  uint8_t slaveMac[6] = {0x3C, 0x84, 0x27, 0xC0, 0x2B, 0x90};
-  
-  // Image reception state
-  uint8_t* imageBuffer;
-  uint32_t expectedImageSize;
-  uint16_t expectedTotalPackets;
-  bool* packetReceived;
-  uint32_t packetsReceivedCount;
-  bool receivingImage;
-  ImageHeader currentHeader;
-  unsigned long lastPacketTime;
+  // Camera slave MAC addresses - UPDATE THESE! Camera 1 is the one the
+  // pre-roll recorder follows in the mosaic. A camera that is not listed
+  // takes a free (all-zero) entry with its first header, but only within
+  // PAIR_WINDOW_MS of a PAIR command.
+  const uint8_t cameraMacs[CAM_SOURCES][6] = {
+    {0x3C, 0x84, 0x27, 0xC0, 0x2B, 0x90},
+    {0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0}
+  };
+  
+  // DeviceMaster (the rotary controller) MAC - UPDATE THIS! Its RING and
+  // emergency messages save the pre-roll; all zero turns triggers off
+  const uint8_t deviceMasterMac[6] = {0, 0, 0, 0, 0, 0};
+  
+  FramePool framePool;
+  CameraSource sources[CAM_SOURCES];
+  
+  // Camera filling the screen, -1 for the mosaic (which a single camera
+  // fills on its own)
+  volatile int8_t focus;
+  
+  // Selective-repeat state
+  bool repairEnabled;
+  
+  // millis() until which cameras that are not listed are adopted (PAIR);
+  // set on the loop task, read by the packet task
+  volatile unsigned long pairUntil;
+  
+  // Panel announced to each camera every CAPS_REPEAT_MS (0 = not set)
+  uint16_t panelWidth;
+  uint16_t panelHeight;
+  uint8_t panelRotation;
+  
+  // Progressive display: at most one frame is decoded while it arrives
+  bool progressive;
+  StreamingImage stream;
+  
+  // Finished frames of the camera on screen waiting for their playout time,
+  // by pool slot (display side); the mosaic draws frames as they come
+  JitterBuffer jitter;
+  int8_t jitterSource;
+  CompleteImage heldImages[FRAME_POOL_SLOTS];
+  
+  // Displayed frames stay in their slots as pre-roll until an event saves them
+  EventRecorder recorder;
+  
+  // Receive callback -> packet task hand-off (lock-free, no copies in between)
+  PacketRing rxRing;
   
   // RTOS components
   QueueHandle_t imageQueue;
-  QueueHandle_t packetQueue;
   SemaphoreHandle_t rxMutex;
   TaskHandle_t packetTaskHandle;
   
-  // Statistics
-  int totalReceived;
-  int totalLost;
+  // Statistics (per camera in CameraSource)
+  int nacksSent;
+  int packetsRepaired;
+  int packetsRecovered;
+  int foreignPackets;
+  unsigned long lastRateTime;
   
   static CommunicationManager* instance;
+  static const CamMsgHandler handlers[CAM_MSG_TYPE_COUNT];
   static void onDataReceived(const uint8_t *mac, const uint8_t *data, int len);
+  static void onImageHeader(const uint8_t *mac, const uint8_t *data, int len);
+  static void onImagePacket(const uint8_t *mac, const uint8_t *data, int len);
+  static void onTextMessage(const uint8_t *mac, const uint8_t *data, int len);
   static void packetProcessingTask(void* param);
   
-  void resetReception();
-  void processPacket(const ImagePacket& packet);
+  int findSource(const uint8_t* mac);
+  int adoptSource(const uint8_t* mac);
+  void checkSources();
+  bool addPeer(const uint8_t* mac);
+  bool sendAll(const void* msg, size_t len);
+  int8_t shownSource();
+  int8_t recordSource() { int8_t shown = shownSource(); return shown >= 0 ? shown : 0; }
+  void updateRates();
+  FrameContext* startFrame(CameraSource& src, int8_t source, const ImageHeader& header);
+  void resetFrame(FrameContext& frame);
+  int acquireSlot();
+  void processPacket(CameraSource& src, const ImagePacket& packet, int len);
+  void completeImage(FrameContext& frame);
+  void checkRepair();
+  void sendNack(FrameContext& frame, bool giveUp = false);
+  void checkTimeouts();
+  void sendCaps();
+  bool concealFrame(FrameContext& frame);
+  void advanceStream(FrameContext& frame);
+  bool endStream(FrameContext& frame, StreamState state);
+  bool skipImage(int16_t slot, CompleteImage& img);
+  void checkTrigger(const uint8_t* mac, const uint8_t* data, int len);
   
 public:
   CommunicationManager();
   bool begin();
   bool sendCommand(const char* command);
   bool sendTextMessage(const char* message);
-  void processIncomingData();
-  bool hasCompleteImage();
-  CompleteImage getCompleteImage();
+  bool nextImage(CompleteImage& img);
+  void flushImages();
   void freeImage(CompleteImage& img);
+  void retireImage(CompleteImage& img);
+  bool hasStreamingImage();
+  StreamingImage& getStreamingImage() { return stream; }
+  void finishStream();
   void setSlaveMac(uint8_t* mac);
-  int getReceivedCount() { return totalReceived; }
-  int getLostCount() { return totalLost; }
+  void setPanel(uint16_t width, uint16_t height, uint8_t rotation);
+  void setFocus(int8_t source);
+  void openPairing() { pairUntil = millis() + PAIR_WINDOW_MS; }
+  unsigned long getPairingLeft() {
+    long left = (long)(pairUntil - millis());
+    return left > 0 ? left : 0;
+  }
+  int8_t getFocus() { return focus; }
+  bool isMosaic() { return focus < 0 && getCameraCount() > 1; }
+  int getCameraCount();
+  const CameraSource& getCamera(int source) { return sources[source]; }
+  int getReceivedCount();
+  int getLostCount();
+  int getNackCount() { return nacksSent; }
+  int getRepairedCount() { return packetsRepaired; }
+  int getRecoveredCount() { return packetsRecovered; }
+  int getSkippedFrames();
+  int getSupersededFrames();
+  int getConcealedFrames();
+  int getFramesInFlight();
+  int getForeignPackets() { return foreignPackets; }
+  uint32_t getRingDrops() { return rxRing.getDrops(); }
+  int getSlotsInUse() { return framePool.getInUse(); }
+  uint32_t getFramesPooled() { return framePool.getFramesServed(); }
+  uint32_t getFrameAllocations() { return framePool.getAllocations(); }
+  void setRepairEnabled(bool enabled) { repairEnabled = enabled; }
+  bool isRepairEnabled() { return repairEnabled; }
+  void setJitter(uint8_t frames, uint32_t maxMs) { jitter.begin(frames, maxMs); }
+  JitterBuffer& getJitter() { return jitter; }
+  EventRecorder& getRecorder() { return recorder; }
+  void setProgressive(bool enabled) { progressive = enabled; }
+  bool isProgressive() { return progressive; }
 };
 
 #endif
\ No newline at end of file
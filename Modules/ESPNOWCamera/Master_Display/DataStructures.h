@@ -4,46 +4,52 @@
 #define DATA_STRUCTURES_H
 
 #include <Arduino.h>
+#include "CameraProtocol.h"
+#include "PacketFec.h"
+#include <atomic>
 
-// Image data packet (240 bytes payload)
-typedef struct {
-  uint16_t packetNum;
-  uint16_t totalPackets;
-  uint16_t dataSize;
-  uint8_t data[240];
-} ImagePacket;
+// Wire messages (ImageHeader, ImagePacket, NackPacket, CommandPacket,
+// TextMessagePacket) are defined in CameraProtocol.h
 
-// Image header information
+// Complete image structure for display
 typedef struct {
+  uint8_t* imageData;       // Points into the receiver's frame pool
+  int8_t slot;              // Pool slot to release once displayed
+  int8_t source;            // Camera it came from (CommunicationManager source)
   uint32_t imageSize;
   uint16_t width;
   uint16_t height;
-  uint8_t format;
-  uint8_t quality;
   uint8_t resolutionMode;
-} ImageHeader;
-
-// Command packet from master to slave
-typedef struct {
-  char command[32];
+  uint8_t format;           // CamFrameFormat: whole JPEG or changed tiles
+  uint16_t frameId;
   uint32_t timestamp;
-} CommandPacket;
+  uint32_t captureMs;       // Sender clock, from the ImageHeader (jitter buffer)
+  uint64_t concealedRows;   // MCU rows patched by JpegConceal.h, keep the previous frame there
+  uint8_t mcuHeight;
+} CompleteImage;
 
-// Text message packet (bidirectional)
-typedef struct {
-  char message[200];
-  uint32_t timestamp;
-  uint8_t fromMaster;  // 1 = from master, 0 = from slave
-} TextMessagePacket;
+// Progressive display: the display decodes one frame while the packet task
+// is still assembling it. Whoever finishes last releases the pool slot.
+enum StreamState : uint8_t {
+  STREAM_IDLE = 0,
+  STREAM_RECEIVING,    // Packet task owns the slot, bytes keep arriving
+  STREAM_COMPLETE,     // All bytes present, display owns the slot
+  STREAM_ABORTED,      // Frame dropped before completion, display owns the slot
+  STREAM_DETACHED      // Display gave up first, packet task still owns the slot
+};
 
-// Complete image structure for display
 typedef struct {
+  std::atomic<uint8_t> state;       // StreamState
+  std::atomic<uint32_t> available;  // Bytes present in order from the image start
   uint8_t* imageData;
+  int8_t slot;
+  int8_t source;
   uint32_t imageSize;
   uint16_t width;
   uint16_t height;
-  uint8_t resolutionMode;
-  uint32_t timestamp;
-} CompleteImage;
+  uint16_t frameId;
+  uint32_t captureMs;               // Sender clock (pre-roll recorder)
+  unsigned long startTime;          // Header arrival
+} StreamingImage;
 
 #endif
\ No newline at end of file
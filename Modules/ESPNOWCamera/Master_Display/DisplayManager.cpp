@@ -3,14 +3,79 @@
 
 DisplayManager* DisplayManager::instance = nullptr;
 
+// tjpgd work area for streamed frames (same size TJpg_Decoder uses)
+#define STREAM_WORK_SIZE 3100
+static uint8_t streamWork[STREAM_WORK_SIZE] __attribute__((aligned(4)));
+
+// Work area for the bottom half of a parallel decode
+static uint8_t splitWork[STREAM_WORK_SIZE] __attribute__((aligned(4)));
+
+// One MCU of a clip preview after blowing it up (16x16 at most)
+static uint16_t zoomBlock[16 * 16];
+
 DisplayManager::DisplayManager() : sprite(&tft) {
   instance = this;
   lastDisplayTime = 0;
   framesDisplayed = 0;
   currentFPS = 0.0;
+  concealedRows = 0;
+  mcuHeight = 8;
+  drawX = 0;
+  drawY = 0;
+  drawScale = 1;
+  drawZoom = 1;
+  drawClipped = false;
+  camViewportSize(PANEL_WIDTH, PANEL_HEIGHT, PANEL_ROTATION, viewWidth, viewHeight);
+  mosaic = false;
+  setArea(-1);
+  streamSource = nullptr;
+  streamPos = 0;
+  firstBlockShown = false;
+  firstBlockTime = 0;
+  firstBlockLatency = 0;
+  frameLatency = 0;
+  parallelDecode = false;
+  decodeTaskHandle = nullptr;
+  decodeWaiter = nullptr;
+  parallelFrames = 0;
+  shownWidth = 0;
+  shownHeight = 0;
+  decodeUs = 0;
+  pushUs = 0;
 }
 
 bool DisplayManager::jpegCallback(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+  // Clip preview: the block was decoded at a reduced scale, draw it full size
+  if (instance && instance->drawZoom > 1) {
+    uint8_t zoom = instance->drawZoom;
+    clipZoomBlock(bitmap, w, h, zoom, zoomBlock);
+    instance->drawZoom = 1;
+    bool more = jpegCallback(instance->drawX + x * zoom, instance->drawY + y * zoom, w * zoom, h * zoom, zoomBlock);
+    instance->drawZoom = zoom;
+    return more;
+  }
+  
+  // Lost band of a concealed frame: the sprite still holds the previous frame
+  if (instance && jpegConcealRowLost(instance->concealedRows, y - instance->drawY, instance->drawScale,
+                                     instance->mcuHeight)) {
+    return true;
+  }
+  
+  // MCUs arrive row by row: below the area nothing else is visible, so
+  // stop the decode instead of entropy-decoding the rest
+  if (instance && y >= instance->areaY + (int16_t)instance->areaHeight) {
+    instance->drawClipped = true;
+    return false;
+  }
+  
+  if (instance && instance->strips.ready()) {
+    if (!instance->strips.block(x, y, w, h, bitmap)) {
+      instance->drawClipped = true;
+      return false;
+    }
+    return true;
+  }
+  
   if (instance && instance->sprite.created()) {
     instance->sprite.pushImage(x, y, w, h, bitmap);
     return true;
@@ -18,89 +83,538 @@ bool DisplayManager::jpegCallback(int16_t x, int16_t y, uint16_t w, uint16_t h,
   return false;
 }
 
+// Where messages are drawn: the sprite, or the panel itself when frames
+// are rendered in strips
+TFT_eSPI& DisplayManager::canvas() {
+  if (sprite.created()) return sprite;
+  shownWidth = 0;
+  shownHeight = 0;
+  return tft;
+}
+
+// Sends the sprite to the panel; a mosaic cell sends only its own quarter
+void DisplayManager::present() {
+  if (!sprite.created()) return;
+  if (areaCell >= 0) {
+    sprite.pushSprite(areaX, areaY, areaX, areaY, areaWidth, areaHeight);
+  } else {
+    sprite.pushSprite(0, 0);
+  }
+}
+
+// Points frame drawing at one mosaic cell, or the whole view (-1)
+void DisplayManager::setArea(int8_t cell) {
+  areaCell = cell;
+  if (cell < 0) {
+    areaX = 0;
+    areaY = 0;
+    areaWidth = viewWidth;
+    areaHeight = viewHeight;
+  } else {
+    areaWidth = viewWidth / MOSAIC_COLUMNS;
+    areaHeight = viewHeight / MOSAIC_ROWS;
+    areaX = (cell % MOSAIC_COLUMNS) * areaWidth;
+    areaY = (cell / MOSAIC_COLUMNS) * areaHeight;
+  }
+}
+
+// Camera number in the corner of the current cell, over the picture
+void DisplayManager::labelCell() {
+  TFT_eSPI& screen = sprite.created() ? sprite : tft;
+  char label[8];
+  snprintf(label, sizeof(label), "CAM %d", areaCell + 1);
+  screen.setTextColor(TFT_WHITE, TFT_BLACK);
+  screen.setTextDatum(TL_DATUM);
+  screen.setTextSize(1);
+  screen.drawString(label, areaX + 3, areaY + 3);
+}
+
+// tjpgd input for a streamed frame: waits until the packet task has the
+// requested bytes; returning short ends the decode
+size_t DisplayManager::streamInput(JDEC* jd, uint8_t* buf, size_t len) {
+  DisplayManager* self = (DisplayManager*)jd->device;
+  StreamingImage* stream = self->streamSource;
+  
+  for (;;) {
+    uint8_t state = stream->state.load(std::memory_order_acquire);
+    uint32_t available = stream->available.load(std::memory_order_acquire);
+    if (self->streamPos + len <= available) break;
+    
+    if (state == STREAM_COMPLETE) {
+      len = available > self->streamPos ? available - self->streamPos : 0;
+      break;
+    }
+    if (state != STREAM_RECEIVING) return 0;
+    
+    vTaskDelay(1);  // Next packet (or its repair) is still on the way
+  }
+  
+  if (buf) {
+    memcpy(buf, stream->imageData + self->streamPos, len);
+  }
+  self->streamPos += len;
+  return len;
+}
+
+// Draws each decoded block straight to the panel so the frame fills in as
+// it arrives
+int DisplayManager::streamOutput(JDEC* jd, void* bitmap, JRECT* rect) {
+  DisplayManager* self = (DisplayManager*)jd->device;
+  
+  if (!self->firstBlockShown) {
+    self->firstBlockShown = true;
+    self->firstBlockTime = millis();
+  }
+  
+  int16_t top = self->drawY + rect->top;
+  if (top >= self->areaY + (int16_t)self->areaHeight) {
+    self->drawClipped = true;
+    return 0;
+  }
+  
+  self->tft.pushImage(self->drawX + rect->left, top,
+                      rect->right - rect->left + 1, rect->bottom - rect->top + 1,
+                      (uint16_t*)bitmap);
+  return 1;
+}
+
+// tjpgd input for one half of a split frame
+size_t DisplayManager::splitInput(JDEC* jd, uint8_t* buf, size_t len) {
+  SplitJob* job = (SplitJob*)jd->device;
+  return job->part.read(buf, len);
+}
+
+// Draws one half of a split frame into its own band of the sprite
+int DisplayManager::splitOutput(JDEC* jd, void* bitmap, JRECT* rect) {
+  SplitJob* job = (SplitJob*)jd->device;
+  DisplayManager* self = job->display;
+  int16_t y = job->top + rect->top;
+  
+  // Lost band of a concealed frame: the sprite still holds the previous frame
+  if (jpegConcealRowLost(self->concealedRows, y, self->drawScale, self->mcuHeight)) {
+    return 1;
+  }
+  if (self->drawY + y >= self->areaY + (int16_t)self->areaHeight) {
+    job->clipped = true;
+    return 0;
+  }
+  
+  self->sprite.pushImage(self->drawX + rect->left, self->drawY + y,
+                         rect->right - rect->left + 1, rect->bottom - rect->top + 1,
+                         (uint16_t*)bitmap);
+  return 1;
+}
+
+void DisplayManager::decodeHalf(SplitJob& job, uint8_t* work) {
+  JDEC jdec;
+  uint8_t scaleShift = 0;
+  while ((1 << scaleShift) < drawScale) scaleShift++;
+  
+  job.part.pos = 0;
+  job.clipped = false;
+  job.result = jd_prepare(&jdec, splitInput, work, STREAM_WORK_SIZE, &job);
+  if (job.result == JDR_OK) {
+    job.result = jd_decomp(&jdec, splitOutput, scaleShift);
+  }
+  if (job.result == JDR_INTR && job.clipped) {
+    job.result = JDR_OK;
+  }
+}
+
+// Decodes the bottom half of each split frame on core 0 while the display
+// task decodes the top half
+void DisplayManager::decodeTask(void* parameter) {
+  DisplayManager* self = (DisplayManager*)parameter;
+  
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    self->decodeHalf(self->splitJobs[1], splitWork);
+    xTaskNotifyGive(self->decodeWaiter);
+  }
+}
+
+// Splits a frame with restart markers at a row boundary and decodes the
+// halves on both cores into disjoint bands of the sprite. Returns false,
+// without drawing anything, when the frame cannot be split.
+bool DisplayManager::decodeParallel(const CompleteImage& img) {
+  if (!decodeTaskHandle || !sprite.created() ||
+      !jpegSplit(img.imageData, img.imageSize, splitJobs[0].part, splitJobs[1].part)) {
+    return false;
+  }
+  
+  splitJobs[0].display = this;
+  splitJobs[0].top = 0;
+  splitJobs[1].display = this;
+  splitJobs[1].top = splitJobs[0].part.height / drawScale;
+  
+  sprite.setSwapBytes(true);
+  decodeWaiter = xTaskGetCurrentTaskHandle();
+  xTaskNotifyGive(decodeTaskHandle);
+  decodeHalf(splitJobs[0], streamWork);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  sprite.setSwapBytes(false);
+  
+  parallelFrames++;
+  return true;
+}
+
+// Picks the decode scale for a frame and centres it in the area: smaller
+// frames (keepalive thumbnails) get a border, larger ones (sensors the
+// camera cannot window, every frame in a mosaic cell) are scaled down
+// while they still fill the area and cropped to their centre
+void DisplayManager::placeFrame(uint16_t width, uint16_t height) {
+  drawScale = camDecodeScale(width, height, areaWidth, areaHeight);
+  drawX = areaX + ((int16_t)areaWidth - (int16_t)(width / drawScale)) / 2;
+  drawY = areaY + ((int16_t)areaHeight - (int16_t)(height / drawScale)) / 2;
+  drawClipped = false;
+}
+
 bool DisplayManager::begin() {
   Serial.println("Initializing display...");
   
   tft.init();
-  tft.setRotation(3);  // Landscape 320x240
+  tft.setRotation(PANEL_ROTATION);  // Landscape 320x240
   tft.fillScreen(TFT_BLACK);
   
-  // Create sprite buffer
-  if (!sprite.createSprite(320, 240)) {
-    Serial.println("Failed to create sprite!");
-    return false;
+  // Frames go to the panel in DMA strips, or through a full-frame sprite
+  if (STRIP_RENDER && strips.begin(&tft)) {
+    Serial.println("Rendering frames in DMA strips (no frame sprite)");
+  } else {
+    if (STRIP_RENDER) {
+      Serial.println("DMA strips unavailable, using the frame sprite");
+    }
+    if (!sprite.createSprite(viewWidth, viewHeight)) {
+      Serial.println("Failed to create sprite!");
+      return false;
+    }
+    sprite.fillSprite(TFT_BLACK);
   }
   
-  sprite.fillSprite(TFT_BLACK);
-  
   // Setup JPEG decoder
   TJpgDec.setJpgScale(1);
   TJpgDec.setSwapBytes(true);
   TJpgDec.setCallback(jpegCallback);
   
+  // Second decoder for PARALLEL ON, below the packet task's priority
+  xTaskCreatePinnedToCore(decodeTask, "JpegDecode", 4096, this, 1, &decodeTaskHandle, 0);
+  if (!decodeTaskHandle) {
+    Serial.println("Parallel decode unavailable");
+  }
+  
   Serial.println("Display initialized successfully");
   return true;
 }
 
 void DisplayManager::showReady() {
-  sprite.fillSprite(TFT_BLACK);
-  sprite.setTextColor(TFT_GREEN, TFT_BLACK);
-  sprite.setTextDatum(MC_DATUM);
-  sprite.setTextSize(2);
-  sprite.drawString("CAMERA READY", 160, 100);
-  sprite.setTextSize(1);
-  sprite.drawString("Send commands via Serial", 160, 140);
-  sprite.pushSprite(0, 0);
+  TFT_eSPI& screen = canvas();
+  screen.fillScreen(TFT_BLACK);
+  screen.setTextColor(TFT_GREEN, TFT_BLACK);
+  screen.setTextDatum(MC_DATUM);
+  screen.setTextSize(2);
+  screen.drawString("CAMERA READY", 160, 100);
+  screen.setTextSize(1);
+  screen.drawString("Send commands via Serial", 160, 140);
+  present();
 }
 
 void DisplayManager::showWaiting() {
-  sprite.fillSprite(TFT_BLACK);
-  sprite.setTextColor(TFT_YELLOW, TFT_BLACK);
-  sprite.setTextDatum(MC_DATUM);
-  sprite.setTextSize(2);
-  sprite.drawString("WAITING...", 160, 120);
-  sprite.pushSprite(0, 0);
+  TFT_eSPI& screen = canvas();
+  screen.fillScreen(TFT_BLACK);
+  screen.setTextColor(TFT_YELLOW, TFT_BLACK);
+  screen.setTextDatum(MC_DATUM);
+  screen.setTextSize(2);
+  screen.drawString("WAITING...", 160, 120);
+  present();
 }
 
 void DisplayManager::showError(const char* message) {
-  sprite.fillSprite(TFT_BLACK);
-  sprite.setTextColor(TFT_RED, TFT_BLACK);
-  sprite.setTextDatum(MC_DATUM);
-  sprite.setTextSize(1);
-  sprite.drawString("ERROR:", 160, 100);
-  sprite.drawString(message, 160, 120);
-  sprite.pushSprite(0, 0);
+  TFT_eSPI& screen = canvas();
+  screen.fillScreen(TFT_BLACK);
+  screen.setTextColor(TFT_RED, TFT_BLACK);
+  screen.setTextDatum(MC_DATUM);
+  screen.setTextSize(1);
+  screen.drawString("ERROR:", 160, 100);
+  screen.drawString(message, 160, 120);
+  present();
   Serial.printf("Display Error: %s\n", message);
 }
 
 bool DisplayManager::displayImage(const CompleteImage& img) {
+  setArea(-1);
+  return drawFrame(img);
+}
+
+// Draws a frame into its camera's quarter of the mosaic
+bool DisplayManager::displayCell(const CompleteImage& img, int8_t cell) {
+  if (cell < 0 || cell >= MOSAIC_COLUMNS * MOSAIC_ROWS) return false;
+  
+  setArea(cell);
+  bool drawn = drawFrame(img);
+  setArea(-1);
+  return drawn;
+}
+
+// Switches between one camera on the whole view and the mosaic, whose
+// cells say NO SIGNAL until their camera's first frame
+void DisplayManager::setMosaic(bool enabled) {
+  mosaic = enabled;
+  if (!enabled) {
+    showWaiting();
+    return;
+  }
+  
+  TFT_eSPI& screen = canvas();
+  screen.fillScreen(TFT_BLACK);
+  for (int8_t cell = 0; cell < MOSAIC_COLUMNS * MOSAIC_ROWS; cell++) {
+    setArea(cell);
+    labelCell();
+    screen.setTextColor(TFT_DARKGREY, TFT_BLACK);
+    screen.setTextDatum(MC_DATUM);
+    screen.drawString("NO SIGNAL", areaX + areaWidth / 2, areaY + areaHeight / 2);
+  }
+  setArea(-1);
+  present();
+}
+
+// Decodes a frame into the current area (whole view or mosaic cell). The
+// sprite viewport keeps cropped blocks out of the neighbouring cells.
+bool DisplayManager::drawFrame(const CompleteImage& img) {
+  if (img.format == CAM_FORMAT_TILES) {
+    return displayTiles(img);
+  }
+  
   unsigned long startTime = millis();
   
-  sprite.fillSprite(TFT_BLACK);
+  concealedRows = img.concealedRows;
+  mcuHeight = img.mcuHeight;
+  placeFrame(img.width, img.height);
+  if (strips.ready()) {
+    if (areaCell >= 0) {
+      // Cells change cameras' frame sizes independently: clear any border
+      if (drawX > areaX || drawY > areaY) {
+        tft.fillRect(areaX, areaY, areaWidth, areaHeight, TFT_BLACK);
+      }
+    }
+    // The panel keeps the last frame: clear the border only when it moves
+    else if (img.width != shownWidth || img.height != shownHeight) {
+      tft.fillScreen(TFT_BLACK);
+      shownWidth = img.width;
+      shownHeight = img.height;
+    }
+  } else {
+    sprite.setViewport(areaX, areaY, areaWidth, areaHeight, false);
+    if (!concealedRows) {
+      sprite.fillRect(areaX, areaY, areaWidth, areaHeight, TFT_BLACK);
+    }
+  }
   
-  // Decode and render JPEG
-  if (TJpgDec.drawJpg(0, 0, img.imageData, img.imageSize) != JDR_OK) {
+  // Decode and render JPEG, split across both cores when possible
+  unsigned long decodeStart = micros();
+  JRESULT result;
+  bool split = parallelDecode && decodeParallel(img);
+  if (split) {
+    result = splitJobs[0].result != JDR_OK ? splitJobs[0].result : splitJobs[1].result;
+  } else {
+    TJpgDec.setJpgScale(drawScale);
+    if (strips.ready()) {
+      strips.startFrame(drawX, drawY, img.width / drawScale, img.height / drawScale,
+                        areaX, areaY, areaWidth, areaHeight);
+    }
+    result = TJpgDec.drawJpg(drawX, drawY, img.imageData, img.imageSize);
+    if (strips.ready()) {
+      strips.endFrame();
+    }
+    if (result == JDR_INTR && drawClipped) result = JDR_OK;
+  }
+  concealedRows = 0;
+  if (sprite.created()) {
+    sprite.resetViewport();
+  }
+  if (result != JDR_OK) {
+    if (areaCell >= 0) {
+      // One bad frame should not blank the other cameras
+      Serial.printf("Cam %d: JPEG decode failed\n", areaCell + 1);
+      return false;
+    }
     showError("JPEG Decode Failed");
     return false;
   }
   
+  if (areaCell >= 0) {
+    labelCell();
+  }
+  
   // Push to screen
-  sprite.pushSprite(0, 0);
+  if (strips.ready()) {
+    decodeUs = strips.getDecodeUs();
+    pushUs = strips.getWaitUs();
+  } else {
+    decodeUs = micros() - decodeStart;
+    unsigned long pushStart = micros();
+    present();
+    pushUs = micros() - pushStart;
+  }
   
   framesDisplayed++;
   unsigned long displayTime = millis() - startTime;
+  updateFPS();
+  
+  Serial.printf("Image displayed: %dx%d, %lu bytes, %lu ms (decode %lu us, %s %lu us)%s\n", 
+                img.width, img.height, (unsigned long)img.imageSize, displayTime,
+                (unsigned long)decodeUs, strips.ready() ? "DMA wait" : "push", (unsigned long)pushUs,
+                split ? " (split)" : "");
+  
+  return true;
+}
+
+// Draws a frame of a recorded clip (ClipPlayer.h). A preview is decoded at
+// clipPreviewScale() and blown up, several times faster while scrubbing.
+bool DisplayManager::displayClipFrame(const uint8_t* data, uint32_t size, uint16_t width, uint16_t height,
+                                      bool preview) {
+  unsigned long decodeStart = micros();
+  
+  concealedRows = 0;
+  placeFrame(width, height);
+  uint8_t scale = preview ? clipPreviewScale(drawScale) : drawScale;
+  drawZoom = scale / drawScale;
+  
+  if (strips.ready()) {
+    if (width != shownWidth || height != shownHeight) {
+      tft.fillScreen(TFT_BLACK);
+      shownWidth = width;
+      shownHeight = height;
+    }
+    strips.startFrame(drawX, drawY, width / drawScale, height / drawScale, 0, 0, viewWidth, viewHeight);
+  } else {
+    sprite.fillSprite(TFT_BLACK);
+  }
   
-  // Calculate FPS
+  // Zoomed blocks are placed by the callback, from the origin
+  TJpgDec.setJpgScale(scale);
+  JRESULT result = drawZoom > 1 ? TJpgDec.drawJpg(0, 0, data, size) : TJpgDec.drawJpg(drawX, drawY, data, size);
+  drawZoom = 1;
+  if (strips.ready()) {
+    strips.endFrame();
+  }
+  if (result == JDR_INTR && drawClipped) result = JDR_OK;
+  if (result != JDR_OK) {
+    showError("Clip Decode Failed");
+    return false;
+  }
+  
+  decodeUs = micros() - decodeStart;
+  unsigned long pushStart = micros();
+  present();
+  pushUs = micros() - pushStart;
+  return true;
+}
+
+// Draws the changed tiles of a tile-delta frame over the picture already in
+// the area; everything else stays as the last frame left it
+bool DisplayManager::displayTiles(const CompleteImage& img) {
+  unsigned long startTime = millis();
+  
+  concealedRows = 0;
+  placeFrame(img.width, img.height);
+  if (sprite.created()) {
+    sprite.setViewport(areaX, areaY, areaWidth, areaHeight, false);
+  }
+  TJpgDec.setJpgScale(drawScale);
+  uint32_t pos = 0;
+  int tiles = 0;
+  while (pos + sizeof(CamTileRecord) <= img.imageSize) {
+    CamTileRecord record;
+    memcpy(&record, img.imageData + pos, sizeof(record));
+    pos += sizeof(record);
+    if (record.length == 0 || pos + record.length > img.imageSize) break;
+    
+    int16_t x = drawX + record.col * CAM_TILE_SIZE / drawScale;
+    int16_t y = drawY + record.row * CAM_TILE_SIZE / drawScale;
+    if (strips.ready()) {
+      strips.startFrame(x, y, CAM_TILE_SIZE / drawScale, CAM_TILE_SIZE / drawScale,
+                        areaX, areaY, areaWidth, areaHeight);
+    }
+    JRESULT result = TJpgDec.drawJpg(x, y, img.imageData + pos, record.length);
+    if (strips.ready()) {
+      strips.endFrame();
+    }
+    if (result != JDR_OK) {
+      break;
+    }
+    pos += record.length;
+    tiles++;
+  }
+  
+  if (sprite.created()) {
+    sprite.resetViewport();
+  }
+  if (areaCell >= 0) {
+    labelCell();
+  }
+  if (pos != img.imageSize) {
+    Serial.printf("Tile frame #%u corrupt after %d tiles\n", img.frameId, tiles);
+  }
+  
+  present();
+  
+  framesDisplayed++;
+  unsigned long displayTime = millis() - startTime;
+  updateFPS();
+  
+  Serial.printf("Tiles displayed: %d tiles, %lu bytes, %lu ms\n", tiles, (unsigned long)img.imageSize, displayTime);
+  
+  return tiles > 0;
+}
+
+// Decodes a frame while its packets are still arriving, overlapping decode
+// with reception. Returns false if the frame was dropped or is corrupt.
+bool DisplayManager::displayStream(StreamingImage& stream) {
+  JDEC jdec;
+  
+  streamSource = &stream;
+  streamPos = 0;
+  firstBlockShown = false;
+  placeFrame(stream.width, stream.height);
+  
+  // tjpgd takes the scale as a power of two
+  uint8_t scaleShift = 0;
+  while ((1 << scaleShift) < drawScale) scaleShift++;
+  
+  tft.setSwapBytes(true);
+  JRESULT result = jd_prepare(&jdec, streamInput, streamWork, sizeof(streamWork), this);
+  if (result == JDR_OK) {
+    result = jd_decomp(&jdec, streamOutput, scaleShift);
+  }
+  tft.setSwapBytes(false);
+  streamSource = nullptr;
+  if (result == JDR_INTR && drawClipped) {
+    result = JDR_OK;
+  }
+  
+  if (result != JDR_OK) {
+    Serial.printf("Frame #%u: streamed decode stopped (%d) after %lu bytes\n",
+                  stream.frameId, result, (unsigned long)streamPos);
+    return false;
+  }
+  
+  framesDisplayed++;
+  updateFPS();
+  
+  firstBlockLatency = firstBlockTime - stream.startTime;
+  frameLatency = millis() - stream.startTime;
+  Serial.printf("Frame #%u streamed: %dx%d, %lu bytes, first MCU %lu ms, complete %lu ms after header\n",
+                stream.frameId, stream.width, stream.height, (unsigned long)stream.imageSize,
+                firstBlockLatency, frameLatency);
+  
+  return true;
+}
+
+void DisplayManager::updateFPS() {
   if (millis() - lastDisplayTime > 1000) {
     currentFPS = framesDisplayed / ((millis() - lastDisplayTime) / 1000.0);
     lastDisplayTime = millis();
     framesDisplayed = 0;
   }
-  
-  Serial.printf("Image displayed: %dx%d, %d bytes, %lu ms\n", 
-                img.width, img.height, img.imageSize, displayTime);
-  
-  return true;
 }
 
 void DisplayManager::displayStats(int received, int displayed, float fps) {
@@ -5,6 +5,37 @@
 #include <TFT_eSPI.h>
 #include <TJpg_Decoder.h>
 #include "DataStructures.h"
+#include "CameraWindow.h"
+#include "JpegConceal.h"
+#include "JpegSplit.h"
+#include "StripRenderer.h"
+#include "ClipPlayer.h"
+
+// Panel in its native orientation, drawn in landscape (320x240).
+// Announced to the camera, which captures only what fits.
+#define PANEL_WIDTH    240
+#define PANEL_HEIGHT   320
+#define PANEL_ROTATION 3
+
+// Decode straight to the panel through two DMA strips instead of a
+// 320x240 sprite (150 KB). Overlaps SPI with decode; parallel decode needs
+// the sprite and is unavailable in this mode.
+#define STRIP_RENDER 0
+
+// Mosaic: one camera per quarter of the view, decoded at half scale
+#define MOSAIC_COLUMNS 2
+#define MOSAIC_ROWS    2
+
+class DisplayManager;
+
+// One half of a frame decoded in parallel
+struct SplitJob {
+  DisplayManager* display;
+  JpegSplitPart part;
+  int16_t top;        // First row of this half in decoded (scaled) pixels
+  bool clipped;       // Stopped below the visible area
+  JRESULT result;
+};
 
 class DisplayManager {
 private:
@@ -15,8 +46,66 @@ private:
   int framesDisplayed;
   float currentFPS;
   
+  // Concealed frame being drawn: rows left showing the previous frame
+  uint64_t concealedRows;
+  uint8_t mcuHeight;
+  int16_t drawX;               // Frame origin on the sprite (negative when
+  int16_t drawY;               // a larger frame is cropped to its centre)
+  uint8_t drawScale;           // JPEG decode scale of the frame being drawn
+  uint8_t drawZoom;            // Clip preview: blocks blown up this much
+  bool drawClipped;            // Decode stopped below the visible area
+  uint16_t viewWidth;
+  uint16_t viewHeight;
+  
+  // Part of the view the frame is drawn into: all of it, or one mosaic cell
+  bool mosaic;
+  int8_t areaCell;             // -1 for the whole view
+  int16_t areaX;
+  int16_t areaY;
+  uint16_t areaWidth;
+  uint16_t areaHeight;
+  
+  // Strip rendering (STRIP_RENDER): the panel shows the last frame drawn
+  StripRenderer strips;
+  uint16_t shownWidth;         // Frame size on the panel, 0 after a message
+  uint16_t shownHeight;
+  
+  // Stage timings of the last frame
+  uint32_t decodeUs;
+  uint32_t pushUs;             // pushSprite, or time waiting for strip DMA
+  
+  // Progressive display of a frame that is still arriving
+  StreamingImage* streamSource;
+  uint32_t streamPos;
+  bool firstBlockShown;
+  unsigned long firstBlockTime;
+  unsigned long firstBlockLatency;   // Header arrival -> first MCU on screen
+  unsigned long frameLatency;        // Header arrival -> last MCU on screen
+  
+  // Parallel decode: the bottom half of a frame is decoded on core 0
+  bool parallelDecode;
+  SplitJob splitJobs[2];
+  TaskHandle_t decodeTaskHandle;
+  TaskHandle_t decodeWaiter;
+  uint32_t parallelFrames;
+  
   static DisplayManager* instance;
   static bool jpegCallback(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap);
+  static size_t streamInput(JDEC* jd, uint8_t* buf, size_t len);
+  static int streamOutput(JDEC* jd, void* bitmap, JRECT* rect);
+  static size_t splitInput(JDEC* jd, uint8_t* buf, size_t len);
+  static int splitOutput(JDEC* jd, void* bitmap, JRECT* rect);
+  static void decodeTask(void* parameter);
+  void decodeHalf(SplitJob& job, uint8_t* work);
+  bool decodeParallel(const CompleteImage& img);
+  bool displayTiles(const CompleteImage& img);
+  bool drawFrame(const CompleteImage& img);
+  void placeFrame(uint16_t width, uint16_t height);
+  void setArea(int8_t cell);
+  void labelCell();
+  TFT_eSPI& canvas();
+  void present();
+  void updateFPS();
   
 public:
   DisplayManager();
@@ -25,9 +114,22 @@ public:
   void showWaiting();
   void showError(const char* message);
   bool displayImage(const CompleteImage& img);
+  bool displayCell(const CompleteImage& img, int8_t cell);
+  void setMosaic(bool enabled);
+  bool isMosaic() { return mosaic; }
+  bool displayStream(StreamingImage& stream);
+  bool displayClipFrame(const uint8_t* data, uint32_t size, uint16_t width, uint16_t height, bool preview);
   void displayStats(int received, int displayed, float fps);
   float getFPS() { return currentFPS; }
   int getFramesDisplayed() { return framesDisplayed; }
+  unsigned long getFirstBlockLatency() { return firstBlockLatency; }
+  unsigned long getFrameLatency() { return frameLatency; }
+  void setParallelDecode(bool enabled) { parallelDecode = enabled; }
+  bool isParallelDecode() { return parallelDecode; }
+  uint32_t getParallelFrames() { return parallelFrames; }
+  bool isStripRender() { return strips.ready(); }
+  uint32_t getDecodeUs() { return decodeUs; }
+  uint32_t getPushUs() { return pushUs; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,257 @@
+// EventRecorder.cpp
+#include "EventRecorder.h"
+#include "CommunicationManager.h"   // FramePool with the receiver's slot count
+#include "esp_heap_caps.h"
+
+EventRecorder::EventRecorder() {
+  pool = nullptr;
+  ready = false;
+  head = 0;
+  count = 0;
+  eventFrames = 0;
+  eventHeld = 0;
+  eventReason[0] = '\0';
+  writing = false;
+  mutex = nullptr;
+  writerTask = nullptr;
+  block = nullptr;
+  blockUsed = 0;
+  nextFile = 1;
+  eventsSaved = 0;
+  eventsIgnored = 0;
+  framesSaved = 0;
+  lastWriteMs = 0;
+  lastFileBytes = 0;
+  lastFile[0] = '\0';
+}
+
+bool EventRecorder::begin(FramePool* framePool) {
+  pool = framePool;
+
+  if (!FFat.begin(true)) {
+    Serial.println("[Recorder] FFat mount failed, event recording off");
+    return false;
+  }
+
+  block = (uint8_t*)heap_caps_malloc(RECORD_BLOCK_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  mutex = xSemaphoreCreateMutex();
+  if (!block || !mutex) {
+    Serial.println("[Recorder] Out of memory, event recording off");
+    return false;
+  }
+
+  // Below the packet task on core 0: files are written in the gaps
+  xTaskCreatePinnedToCore(writerTaskFunc, "EventWriter", 4096, this, 1, &writerTask, 0);
+  if (!writerTask) {
+    Serial.println("[Recorder] Failed to start writer task!");
+    return false;
+  }
+
+  ready = true;
+  Serial.printf("[Recorder] Pre-roll up to %d frames / %d ms, FFat %lu KB free\n",
+                PREROLL_FRAMES, PREROLL_MS,
+                (unsigned long)((FFat.totalBytes() - FFat.usedBytes()) / 1024));
+  return true;
+}
+
+// Frame pool slot given back by the oldest pre-roll frame (caller holds mutex)
+void EventRecorder::releaseOldest() {
+  pool->release(ring[head].slot);
+  head = (head + 1) % PREROLL_FRAMES;
+  count--;
+}
+
+// Takes a displayed frame into the pre-roll. Returns false when the caller
+// keeps the slot (recorder off, or every recorder slot is being written).
+bool EventRecorder::keep(int8_t slot, uint8_t* data, uint32_t size, uint16_t width, uint16_t height,
+                         uint32_t captureMs) {
+  if (!ready) return false;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  uint32_t now = millis();
+  while (count && now - ring[head].shownMs > PREROLL_MS) releaseOldest();
+
+  // The pre-roll and the event being written share PREROLL_FRAMES slots
+  while (count && count + eventHeld >= PREROLL_FRAMES) releaseOldest();
+  bool kept = (count + eventHeld < PREROLL_FRAMES);
+  if (kept) {
+    RecordedFrame& f = ring[(head + count) % PREROLL_FRAMES];
+    f.slot = slot;
+    f.data = data;
+    f.size = size;
+    f.width = width;
+    f.height = height;
+    f.shownMs = now;
+    f.captureMs = captureMs;
+    count++;
+  }
+  xSemaphoreGive(mutex);
+  return kept;
+}
+
+// Saves the pre-roll (doorbell, emergency, CAPTURE). The frames move to the
+// writer task as they are; nothing is copied here.
+void EventRecorder::trigger(const char* reason) {
+  if (!ready) return;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  uint32_t now = millis();
+  while (count && now - ring[head].shownMs > PREROLL_MS) releaseOldest();
+
+  if (writing || !count) {
+    if (writing) eventsIgnored++;
+    xSemaphoreGive(mutex);
+    Serial.printf("[Recorder] %s: %s\n", reason, writing ? "still saving the last event" : "no recent frames");
+    return;
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    event[i] = ring[(head + i) % PREROLL_FRAMES];
+  }
+  eventFrames = count;
+  eventHeld = count;
+  head = 0;
+  count = 0;
+  strncpy(eventReason, reason, sizeof(eventReason) - 1);
+  eventReason[sizeof(eventReason) - 1] = '\0';
+  writing = true;
+  xSemaphoreGive(mutex);
+
+  Serial.printf("[Recorder] %s: saving %d frames of pre-roll\n", reason, eventFrames);
+  xTaskNotifyGive(writerTask);
+}
+
+void EventRecorder::writerTaskFunc(void* param) {
+  EventRecorder* self = (EventRecorder*)param;
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (!self->writing) continue;
+
+    self->writeEvent();
+
+    // Slots not released on the way (write failed)
+    xSemaphoreTake(self->mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < self->eventFrames; i++) {
+      if (self->event[i].slot >= 0) self->pool->release(self->event[i].slot);
+    }
+    self->eventFrames = 0;
+    self->eventHeld = 0;
+    self->writing = false;
+    xSemaphoreGive(self->mutex);
+  }
+}
+
+// Stages bytes and writes them out in whole RECORD_BLOCK_SIZE blocks, so
+// every FFat write starts on a sector boundary
+bool EventRecorder::put(const uint8_t* data, uint32_t len) {
+  while (len) {
+    uint32_t n = min(len, (uint32_t)RECORD_BLOCK_SIZE - blockUsed);
+    memcpy(block + blockUsed, data, n);
+    blockUsed += n;
+    data += n;
+    len -= n;
+    if (blockUsed == RECORD_BLOCK_SIZE && !flush()) return false;
+  }
+  return true;
+}
+
+bool EventRecorder::flush() {
+  if (!blockUsed) return true;
+  bool ok = (file.write(block, blockUsed) == blockUsed);
+  blockUsed = 0;
+  return ok;
+}
+
+// Writes the event as /event_NNNN.avi; runs in the writer task
+bool EventRecorder::writeEvent() {
+  unsigned long start = millis();
+
+  uint32_t chunkBytes = 0;
+  uint32_t largest = 0;
+  for (uint8_t i = 0; i < eventFrames; i++) {
+    chunkBytes += aviChunkSize(event[i].size);
+    if (event[i].size > largest) largest = event[i].size;
+  }
+  uint32_t fileSize = aviFileSize(eventFrames, chunkBytes);
+
+  if (FFat.totalBytes() - FFat.usedBytes() < fileSize + RECORD_BLOCK_SIZE) {
+    Serial.printf("[Recorder] FFat full, %lu bytes needed\n", (unsigned long)fileSize);
+    return false;
+  }
+
+  char name[20];
+  for (; nextFile <= RECORD_MAX_FILES; nextFile++) {
+    snprintf(name, sizeof(name), "/event_%04u.avi", nextFile);
+    if (!FFat.exists(name)) break;
+  }
+  if (nextFile > RECORD_MAX_FILES) {
+    Serial.println("[Recorder] No free file name!");
+    return false;
+  }
+
+  file = FFat.open(name, FILE_WRITE);
+  if (!file) {
+    Serial.printf("[Recorder] Cannot create %s\n", name);
+    return false;
+  }
+
+  // Preallocate: the cluster chain is built once, not while frames are written
+  bool ok = file.seek(fileSize - 1) && file.write((uint8_t)0) == 1 && file.seek(0);
+
+  // Frame rate from the sender's capture times
+  uint32_t usPerFrame = 200000;
+  if (eventFrames > 1) {
+    usPerFrame = (uint32_t)((uint64_t)(event[eventFrames - 1].captureMs - event[0].captureMs) * 1000 /
+                            (eventFrames - 1));
+  }
+
+  uint8_t header[AVI_HEADER_SIZE];
+  aviHeader(header, event[0].width, event[0].height, eventFrames, chunkBytes, usPerFrame, largest);
+  blockUsed = 0;
+  ok = ok && put(header, sizeof(header));
+
+  // Frames, each slot given back as soon as its bytes are staged
+  static const uint8_t pad = 0;
+  for (uint8_t i = 0; i < eventFrames && ok; i++) {
+    RecordedFrame& f = event[i];
+    uint8_t chunk[AVI_CHUNK_HEADER];
+    aviChunk(chunk, f.size);
+    ok = put(chunk, sizeof(chunk)) && put(f.data, f.size) && (!(f.size & 1) || put(&pad, 1));
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    pool->release(f.slot);
+    f.slot = -1;
+    eventHeld--;
+    xSemaphoreGive(mutex);
+  }
+
+  uint8_t entry[AVI_INDEX_ENTRY];
+  aviIndexHeader(entry, eventFrames);
+  ok = ok && put(entry, AVI_CHUNK_HEADER);
+  uint32_t offset = 4;
+  for (uint8_t i = 0; i < eventFrames && ok; i++) {
+    aviIndexEntry(entry, offset, event[i].size);
+    ok = put(entry, sizeof(entry));
+    offset += aviChunkSize(event[i].size);
+  }
+
+  ok = ok && flush();
+  file.close();
+
+  if (!ok) {
+    FFat.remove(name);
+    Serial.printf("[Recorder] Writing %s failed\n", name);
+    return false;
+  }
+
+  nextFile++;
+  eventsSaved++;
+  framesSaved += eventFrames;
+  lastWriteMs = millis() - start;
+  lastFileBytes = fileSize;
+  strncpy(lastFile, name, sizeof(lastFile));
+  Serial.printf("[Recorder] %s saved (%s): %d frames, %lu KB in %lu ms\n", name, eventReason,
+                eventFrames, (unsigned long)(fileSize / 1024), (unsigned long)lastWriteMs);
+  return true;
+}
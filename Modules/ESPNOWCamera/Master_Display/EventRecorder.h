@@ -0,0 +1,85 @@
+// EventRecorder.h
+#ifndef EVENT_RECORDER_H
+#define EVENT_RECORDER_H
+
+#include <Arduino.h>
+#include <FFat.h>
+#include "DataStructures.h"
+#include "AviWriter.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Pre-roll: the last displayed frames stay in their frame pool slots, and a
+// trigger saves them to FFat as one MJPEG AVI
+#define PREROLL_FRAMES     16       // Pool slots the recorder may hold (pre-roll + file being written)
+#define PREROLL_MS         5000     // Frames older than this fall out of the pre-roll
+#define RECORD_BLOCK_SIZE  16384    // FFat writes, whole 4 KB sectors
+#define RECORD_MAX_FILES   9999     // /event_0001.avi ...
+
+class FramePool;   // Sized by CommunicationManager.h
+
+// A frame held for the recorder, still in its pool slot
+typedef struct {
+  int8_t slot;
+  uint8_t* data;
+  uint32_t size;
+  uint16_t width;
+  uint16_t height;
+  uint32_t shownMs;      // Local time it was displayed (pre-roll age)
+  uint32_t captureMs;    // Sender clock (frame timing in the file)
+} RecordedFrame;
+
+class EventRecorder {
+private:
+  FramePool* pool;
+  bool ready;
+
+  // Pre-roll, oldest first; the frames of a trigger move to `event`
+  RecordedFrame ring[PREROLL_FRAMES];
+  uint8_t head;
+  uint8_t count;
+  RecordedFrame event[PREROLL_FRAMES];
+  uint8_t eventFrames;             // Handed to the writer task
+  uint8_t eventHeld;               // Of those, slots not yet given back
+  char eventReason[16];
+  volatile bool writing;
+
+  SemaphoreHandle_t mutex;
+  TaskHandle_t writerTask;
+  uint8_t* block;                  // Staging for sector-aligned FFat writes
+  uint32_t blockUsed;
+  File file;
+  uint16_t nextFile;
+
+  // Statistics
+  int eventsSaved;
+  int eventsIgnored;
+  uint32_t framesSaved;
+  uint32_t lastWriteMs;
+  uint32_t lastFileBytes;
+  char lastFile[20];
+
+  static void writerTaskFunc(void* param);
+  void releaseOldest();
+  bool writeEvent();
+  bool put(const uint8_t* data, uint32_t len);
+  bool flush();
+
+public:
+  EventRecorder();
+  bool begin(FramePool* framePool);
+  bool keep(int8_t slot, uint8_t* data, uint32_t size, uint16_t width, uint16_t height, uint32_t captureMs);
+  void trigger(const char* reason);
+  bool isReady() { return ready; }
+  bool isWriting() { return writing; }
+  int getBuffered() { return count; }
+  int getEventsSaved() { return eventsSaved; }
+  int getEventsIgnored() { return eventsIgnored; }
+  uint32_t getFramesSaved() { return framesSaved; }
+  uint32_t getLastWriteMs() { return lastWriteMs; }
+  uint32_t getLastFileBytes() { return lastFileBytes; }
+  const char* getLastFile() { return lastFile; }
+};
+
+#endif
@@ -0,0 +1,130 @@
+// FramePool.h
+#pragma once
+//
+// Fixed pool of frame reassembly buffers for the ESP-NOW camera receivers.
+//
+// All buffers are allocated once in begin() (PSRAM when available). A frame
+// is assembled directly into a pool slot and the slot index travels with the
+// CompleteImage to the display side, which releases it after drawing, so no
+// frame is allocated or copied while streaming.
+//
+// Received packets are tracked in a bitset of 64-bit words instead of a
+// bool per packet.
+//
+// Place this file alongside your .ino files and #include "FramePool.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <stdlib.h>
+  #include <string.h>
+#endif
+#include <atomic>
+
+// Frames being received + waiting for display + on screen.
+// A sketch may define its own count before including this file.
+#ifndef FRAME_POOL_SLOTS
+  #define FRAME_POOL_SLOTS 5
+#endif
+
+// -------- Packet bitset --------
+inline uint16_t bitsetWords(uint16_t bits) {
+  return (bits + 63) / 64;
+}
+
+inline void bitsetClear(uint64_t* set, uint16_t bits) {
+  memset(set, 0, bitsetWords(bits) * sizeof(uint64_t));
+}
+
+inline void bitsetSet(uint64_t* set, uint16_t i) {
+  set[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+inline bool bitsetTest(const uint64_t* set, uint16_t i) {
+  return (set[i >> 6] >> (i & 63)) & 1;
+}
+
+// -------- Frame slots --------
+class FramePool {
+private:
+  uint8_t* slots[FRAME_POOL_SLOTS];
+  uint32_t slotSize;
+  std::atomic<uint32_t> busy;   // One bit per slot; released from another task
+  uint32_t allocations;         // Heap allocations made through the pool
+  uint32_t framesServed;
+
+public:
+  FramePool() : slotSize(0), busy(0), allocations(0), framesServed(0) {
+    for (int i = 0; i < FRAME_POOL_SLOTS; i++) {
+      slots[i] = nullptr;
+    }
+  }
+
+  // One-time buffer allocation, preferring PSRAM
+  void* allocate(size_t size) {
+    void* buffer;
+#if __has_include(<Arduino.h>)
+    if (psramFound()) {
+      buffer = ps_malloc(size);
+    } else {
+      buffer = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+#else
+    buffer = malloc(size);
+#endif
+    if (buffer) {
+      allocations++;
+    }
+    return buffer;
+  }
+
+  bool begin(uint32_t size) {
+    slotSize = size;
+    for (int i = 0; i < FRAME_POOL_SLOTS; i++) {
+      slots[i] = (uint8_t*)allocate(size);
+      if (!slots[i]) return false;
+    }
+    return true;
+  }
+
+  // Index of a free slot, or -1 when every slot is in use
+  int acquire() {
+    uint32_t current = busy.load(std::memory_order_relaxed);
+    for (;;) {
+      int slot = 0;
+      while (slot < FRAME_POOL_SLOTS && (current & (1u << slot))) slot++;
+      if (slot == FRAME_POOL_SLOTS) return -1;
+
+      if (busy.compare_exchange_weak(current, current | (1u << slot), std::memory_order_acquire)) {
+        framesServed++;
+        return slot;
+      }
+    }
+  }
+
+  void release(int slot) {
+    if (slot < 0 || slot >= FRAME_POOL_SLOTS) return;
+    busy.fetch_and(~(1u << slot), std::memory_order_release);
+  }
+
+  uint8_t* data(int slot) { return slots[slot]; }
+  uint32_t getSlotSize() { return slotSize; }
+  uint16_t getMaxPackets(uint16_t payload) { return (slotSize + payload - 1) / payload; }
+
+  int getInUse() {
+    uint32_t current = busy.load(std::memory_order_relaxed);
+    int count = 0;
+    for (int i = 0; i < FRAME_POOL_SLOTS; i++) {
+      if (current & (1u << i)) count++;
+    }
+    return count;
+  }
+
+  uint32_t getAllocations() { return allocations; }
+  uint32_t getFramesServed() { return framesServed; }
+};
+
+static_assert(FRAME_POOL_SLOTS <= 32, "FramePool tracks slots in a 32-bit mask");
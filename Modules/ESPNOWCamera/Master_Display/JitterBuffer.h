@@ -0,0 +1,207 @@
+// JitterBuffer.h
+#pragma once
+//
+// Receiver-side jitter buffer: constant-rate playout of camera frames.
+//
+// Frames finish reassembly in bursts (repairs, FEC, radio contention), so
+// drawing each one as soon as it is complete makes motion stutter. The
+// display task instead push()es every finished frame with the sensor
+// capture time from its ImageHeader and draws it when takeDue() says so.
+//
+// Each frame is scheduled at captureMs + base + delay on the local clock:
+// - base is the smallest transit seen lately (arrival - capture over the
+//   last JITTER_WINDOW frames). It absorbs the clock offset between the
+//   two boards and follows drift.
+// - delay covers the transit jitter: it jumps up to the largest excess
+//   over base at once and decays by 1/JITTER_DECAY per frame, capped at
+//   the configured depth (frames at the smoothed interval, and ms).
+// Presentation times are then pulled towards the previous one plus the
+// smoothed capture interval, so small capture-time wobble does not show.
+//
+// When the display falls behind, takeLate() hands back frames whose
+// successor is already due, and push() drops the oldest frame when the
+// buffer is full: latency never builds up beyond the configured depth.
+//
+// Frames are identified by a caller's reference (the frame pool slot).
+// Time is passed in and there are no Arduino dependencies, so recorded
+// arrival traces can be replayed on a desktop compiler.
+//
+// Place this file alongside your .ino files and #include "JitterBuffer.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+#endif
+
+#define JITTER_MAX_FRAMES 8      // Largest configurable depth
+#define JITTER_WINDOW     32     // Frames per transit minimum window
+#define JITTER_DECAY      16     // Delay decays by 1/16 per frame
+#define JITTER_RESYNC_MS  2000   // Transit jump treated as a sender restart
+#define JITTER_IDLE       0xFFFFFFFF
+
+class JitterBuffer {
+private:
+  struct Entry {
+    int16_t ref;
+    uint32_t playoutMs;
+  };
+
+  Entry entries[JITTER_MAX_FRAMES];
+  uint8_t head;
+  uint8_t count;
+  uint8_t depthFrames;
+  uint32_t maxDelayMs;
+
+  bool synced;
+  int32_t base;              // Smallest transit (local - capture), both windows
+  int32_t windowMin;         // Smallest transit in the current window
+  int32_t lastWindowMin;
+  uint8_t windowFrames;
+  uint32_t delay;            // Jitter allowance on top of base
+  uint32_t intervalMs;       // Smoothed capture interval
+  uint32_t lastCaptureMs;
+  uint32_t lastPlayoutMs;
+
+  uint32_t framesLate;
+  uint32_t framesOverflow;
+
+  static bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+  void resync(int32_t transit) {
+    synced = true;
+    base = windowMin = lastWindowMin = transit;
+    windowFrames = 0;
+    delay = 0;
+  }
+
+public:
+  JitterBuffer() : head(0), count(0), depthFrames(2), maxDelayMs(200), synced(false), base(0),
+                   windowMin(0), lastWindowMin(0), windowFrames(0), delay(0), intervalMs(200),
+                   lastCaptureMs(0), lastPlayoutMs(0), framesLate(0), framesOverflow(0) {}
+
+  // Depth in frames (1 = no smoothing) and the most delay it may add
+  void begin(uint8_t frames, uint32_t maxMs) {
+    depthFrames = frames < 1 ? 1 : (frames > JITTER_MAX_FRAMES ? JITTER_MAX_FRAMES : frames);
+    maxDelayMs = maxMs;
+  }
+
+  // Forgets the sender's clock, for frames from a different sender. Take
+  // every held frame out first.
+  void restart() {
+    synced = false;
+    count = 0;
+  }
+
+  // Adds a finished frame. Returns the reference of a frame to release
+  // without drawing it, -1 if none: the oldest one when the buffer is full,
+  // or this one when a newer frame overtook it.
+  int16_t push(int16_t ref, uint32_t captureMs, uint32_t now) {
+    int32_t transit = (int32_t)(now - captureMs);
+
+    if (synced && before(captureMs, lastCaptureMs) && lastCaptureMs - captureMs < JITTER_RESYNC_MS) {
+      framesLate++;
+      return ref;
+    }
+
+    if (!synced || before(captureMs, lastCaptureMs) || transit - base > JITTER_RESYNC_MS) {
+      resync(transit);   // First frame, or the sender restarted
+    } else {
+      uint32_t step = captureMs - lastCaptureMs;
+      if (step > 0 && step < JITTER_RESYNC_MS) {
+        intervalMs += ((int32_t)step - (int32_t)intervalMs) / 8;
+      }
+    }
+    lastCaptureMs = captureMs;
+
+    // Transit floor over the last one to two windows
+    if (transit < windowMin) windowMin = transit;
+    if (++windowFrames >= JITTER_WINDOW) {
+      lastWindowMin = windowMin;
+      windowMin = transit;
+      windowFrames = 0;
+    }
+    base = windowMin < lastWindowMin ? windowMin : lastWindowMin;
+
+    // Jitter allowance: fast up, slow down, within the configured depth
+    uint32_t excess = (uint32_t)(transit - base);
+    uint32_t limit = (uint32_t)(depthFrames - 1) * intervalMs;
+    if (limit > maxDelayMs) limit = maxDelayMs;
+    delay -= delay / JITTER_DECAY;
+    if (excess > delay) delay = excess;
+    if (delay > limit) delay = limit;
+
+    // Presentation time, smoothed towards a steady interval
+    uint32_t target = captureMs + base + delay;
+    uint32_t playout = target;
+    if (count || !before(lastPlayoutMs + intervalMs, now)) {
+      uint32_t predicted = lastPlayoutMs + intervalMs;
+      int32_t error = (int32_t)(target - predicted);
+      if (error > -(int32_t)intervalMs && error < (int32_t)intervalMs) {
+        playout = predicted + error / 4;
+      }
+    }
+    if (before(playout, lastPlayoutMs)) playout = lastPlayoutMs;
+    lastPlayoutMs = playout;
+
+    // Full: the oldest frame gives way
+    int16_t dropped = -1;
+    if (count >= depthFrames) {
+      dropped = entries[head].ref;
+      head = (head + 1) % JITTER_MAX_FRAMES;
+      count--;
+      framesOverflow++;
+    }
+
+    Entry& e = entries[(head + count) % JITTER_MAX_FRAMES];
+    e.ref = ref;
+    e.playoutMs = playout;
+    count++;
+    return dropped;
+  }
+
+  // A frame whose successor is already due: the display fell behind, skip
+  // it. Returns its reference, -1 if none.
+  int16_t takeLate(uint32_t now) {
+    if (count < 2 || before(now, entries[(head + 1) % JITTER_MAX_FRAMES].playoutMs)) return -1;
+    int16_t ref = entries[head].ref;
+    head = (head + 1) % JITTER_MAX_FRAMES;
+    count--;
+    framesLate++;
+    return ref;
+  }
+
+  // The frame to draw now, -1 if none is due yet
+  int16_t takeDue(uint32_t now) {
+    if (!count || before(now, entries[head].playoutMs)) return -1;
+    int16_t ref = entries[head].ref;
+    head = (head + 1) % JITTER_MAX_FRAMES;
+    count--;
+    return ref;
+  }
+
+  // Milliseconds until the next frame is due; JITTER_IDLE when empty
+  uint32_t timeToNext(uint32_t now) {
+    if (!count) return JITTER_IDLE;
+    uint32_t due = entries[head].playoutMs;
+    return before(now, due) ? due - now : 0;
+  }
+
+  // Frames still held, e.g. to release them when the stream stops
+  int16_t takeAny() {
+    if (!count) return -1;
+    int16_t ref = entries[head].ref;
+    head = (head + 1) % JITTER_MAX_FRAMES;
+    count--;
+    return ref;
+  }
+
+  uint8_t getCount() { return count; }
+  uint8_t getDepth() { return depthFrames; }
+  uint32_t getDelayMs() { return delay; }
+  uint32_t getIntervalMs() { return intervalMs; }
+  uint32_t getFramesLate() { return framesLate; }
+  uint32_t getFramesOverflow() { return framesOverflow; }
+};
@@ -0,0 +1,283 @@
+// JpegConceal.h
+#pragma once
+//
+// Loss concealment for camera JPEGs that carry restart markers.
+//
+// A baseline JPEG with a DRI segment is split into restart intervals that
+// decode independently of each other. When packets of a frame are lost for
+// good, jpegConceal() copies the intact intervals unchanged and replaces
+// every interval touched by a gap with a minimal valid one (each block
+// coded as DC 0 + EOB). It reports the MCU rows it patched, so the display
+// callback can skip them and keep the previous frame there: a lost packet
+// costs a briefly stale band instead of the whole frame.
+//
+// Frames without a DRI segment, with a lost header packet or with more
+// than CONCEAL_MAX_ROWS MCU rows are not concealed (returns 0).
+//
+// Place this file alongside your .ino files and #include "JpegConceal.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <string.h>
+#endif
+
+#define CONCEAL_MAX_ROWS 64   // MCU rows tracked in JpegConcealInfo::rows
+
+typedef struct {
+  uint64_t rows;        // Bit r set = MCU row r was patched, do not draw it
+  uint8_t  mcuHeight;   // Pixels per MCU row
+  uint16_t intervals;   // Restart intervals in the frame
+  uint16_t damaged;     // Intervals replaced
+} JpegConcealInfo;
+
+// True when output row y of a frame decoded at 1/scale lies in a patched
+// MCU row. Rows past CONCEAL_MAX_ROWS are never patched, and are checked
+// here rather than shifted out of range.
+inline bool jpegConcealRowLost(uint64_t rows, int32_t y, uint8_t scale, uint8_t mcuHeight) {
+  if (!rows || y < 0 || !mcuHeight) return false;
+  uint32_t row = (uint32_t)y * scale / mcuHeight;
+  return row < CONCEAL_MAX_ROWS && ((rows >> row) & 1);
+}
+
+// True when bytes [from, to) of the frame arrived; `received` has one bit
+// per packet of `packetSize` bytes
+inline bool jpegConcealHave(const uint64_t* received, uint16_t packetSize, uint32_t from, uint32_t to) {
+  if (to <= from) return true;
+  for (uint32_t p = from / packetSize; p <= (to - 1) / packetSize; p++) {
+    if (!((received[p >> 6] >> (p & 63)) & 1)) return false;
+  }
+  return true;
+}
+
+// Byte / entropy-coded bit output with 0xFF stuffing
+struct JpegConcealWriter {
+  uint8_t* out;
+  uint32_t size;
+  uint32_t pos;
+  uint32_t acc;
+  uint8_t  bits;
+  bool     overflow;
+
+  void byte(uint8_t b) {
+    if (pos < size) out[pos++] = b;
+    else overflow = true;
+  }
+
+  void copy(const uint8_t* src, uint32_t len) {
+    if (pos + len > size) {
+      overflow = true;
+      return;
+    }
+    memcpy(out + pos, src, len);
+    pos += len;
+  }
+
+  void code(uint16_t value, uint8_t len) {
+    acc = (acc << len) | value;
+    bits += len;
+    while (bits >= 8) {
+      bits -= 8;
+      uint8_t b = acc >> bits;
+      byte(b);
+      if (b == 0xFF) byte(0x00);
+    }
+    acc &= (1u << bits) - 1;
+  }
+
+  // Pads the last byte with 1 bits before a marker
+  void flush() {
+    if (bits) code((1u << (8 - bits)) - 1, 8 - bits);
+  }
+};
+
+// Writes a concealed copy of `jpeg` to `out`. Returns its length, or 0 when
+// the frame cannot be concealed or does not fit in outSize bytes.
+inline uint32_t jpegConceal(const uint8_t* jpeg, uint32_t size, const uint64_t* received, uint16_t packetSize,
+                            uint8_t* out, uint32_t outSize, JpegConcealInfo& info) {
+  memset(&info, 0, sizeof(info));
+
+  uint16_t width = 0, height = 0, nrst = 0;
+  uint8_t ncomp = 0;
+  uint8_t compId[3], compH[3], compV[3], compDc[3], compAc[3];
+  uint16_t huffCode[2][4];   // Code of symbol 0x00 (DC size 0 / AC EOB)
+  uint8_t huffLen[2][4];     // 0 = table or symbol missing
+  memset(huffLen, 0, sizeof(huffLen));
+
+  // -------- Header: everything before the scan data must have arrived --------
+  if (size < 4 || !jpegConcealHave(received, packetSize, 0, 2) || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return 0;
+
+  uint32_t pos = 2;
+  uint32_t scanStart = 0;
+  while (!scanStart) {
+    if (pos + 4 > size || !jpegConcealHave(received, packetSize, pos, pos + 4) || jpeg[pos] != 0xFF) return 0;
+
+    uint8_t marker = jpeg[pos + 1];
+    uint16_t len = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+    uint32_t seg = pos + 4;
+    uint32_t end = pos + 2 + len;
+    if (len < 2 || end > size || !jpegConcealHave(received, packetSize, pos, end)) return 0;
+
+    switch (marker) {
+      case 0xC0:    // Baseline
+      case 0xC1: {  // Extended sequential, Huffman
+        if (len < 8) return 0;
+        height = (jpeg[seg + 1] << 8) | jpeg[seg + 2];
+        width = (jpeg[seg + 3] << 8) | jpeg[seg + 4];
+        ncomp = jpeg[seg + 5];
+        if ((ncomp != 1 && ncomp != 3) || len < 8 + 3 * ncomp) return 0;
+        for (uint8_t c = 0; c < ncomp; c++) {
+          compId[c] = jpeg[seg + 6 + 3 * c];
+          compH[c] = jpeg[seg + 7 + 3 * c] >> 4;
+          compV[c] = jpeg[seg + 7 + 3 * c] & 0x0F;
+          if (!compH[c] || !compV[c]) return 0;
+        }
+        break;
+      }
+
+      case 0xC4: {  // Huffman tables: canonical code of symbol 0x00
+        uint32_t p = seg;
+        while (p < end) {
+          uint8_t tc = jpeg[p] >> 4;
+          uint8_t th = jpeg[p] & 0x0F;
+          if (tc > 1 || th > 3 || p + 17 > end) return 0;
+
+          uint32_t sym = p + 17;
+          uint16_t code = 0;
+          huffLen[tc][th] = 0;
+          for (uint8_t bitLen = 1; bitLen <= 16; bitLen++) {
+            for (uint8_t k = 0; k < jpeg[p + bitLen]; k++, sym++, code++) {
+              if (sym >= end) return 0;
+              if (jpeg[sym] == 0x00 && !huffLen[tc][th]) {
+                huffCode[tc][th] = code;
+                huffLen[tc][th] = bitLen;
+              }
+            }
+            code <<= 1;
+          }
+          p = sym;
+        }
+        break;
+      }
+
+      case 0xDD:    // Restart interval
+        if (len < 4) return 0;
+        nrst = (jpeg[seg] << 8) | jpeg[seg + 1];
+        break;
+
+      case 0xDA: {  // Start of scan
+        if (!ncomp || jpeg[seg] != ncomp || len < 6 + 2 * ncomp) return 0;
+        for (uint8_t s = 0; s < ncomp; s++) {
+          uint8_t c = 0;
+          while (c < ncomp && compId[c] != jpeg[seg + 1 + 2 * s]) c++;
+          if (c == ncomp) return 0;
+          compDc[c] = jpeg[seg + 2 + 2 * s] >> 4;
+          compAc[c] = jpeg[seg + 2 + 2 * s] & 0x0F;
+          if (compDc[c] > 3 || compAc[c] > 3) return 0;
+        }
+        scanStart = end;
+        break;
+      }
+
+      default:
+        // Progressive, lossless and arithmetic-coded frames are not supported
+        if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC8 && marker != 0xCC) return 0;
+        break;
+    }
+    pos = end;
+  }
+
+  if (!width || !height || !nrst) return 0;
+
+  // -------- MCU geometry --------
+  uint8_t hmax = 1, vmax = 1;
+  if (ncomp == 3) {
+    for (uint8_t c = 0; c < 3; c++) {
+      if (compH[c] > hmax) hmax = compH[c];
+      if (compV[c] > vmax) vmax = compV[c];
+    }
+  }
+  for (uint8_t c = 0; c < ncomp; c++) {
+    if (!huffLen[0][compDc[c]] || !huffLen[1][compAc[c]]) return 0;
+  }
+
+  uint16_t mcuWidth = 8 * hmax;
+  uint16_t mcuHeight = 8 * vmax;
+  uint16_t mcusPerRow = (width + mcuWidth - 1) / mcuWidth;
+  uint16_t mcuRows = (height + mcuHeight - 1) / mcuHeight;
+  if (mcuRows > CONCEAL_MAX_ROWS) return 0;
+
+  uint32_t totalMcus = (uint32_t)mcusPerRow * mcuRows;
+  uint16_t intervals = (totalMcus + nrst - 1) / nrst;
+
+  info.mcuHeight = mcuHeight;
+  info.intervals = intervals;
+
+  // -------- Scan: copy intact intervals, rebuild damaged ones --------
+  JpegConcealWriter w = { out, outSize, 0, 0, 0, false };
+  w.copy(jpeg, scanStart);
+
+  uint16_t interval = 0;
+  uint32_t start = scanStart;
+  while (interval < intervals && !w.overflow) {
+    // Next marker in the bytes that did arrive
+    uint32_t p = start;
+    bool found = false;
+    uint8_t marker = 0;
+    for (; p + 1 < size; p++) {
+      if (jpeg[p] != 0xFF || !jpegConcealHave(received, packetSize, p, p + 2)) continue;
+      marker = jpeg[p + 1];
+      if ((marker >= 0xD0 && marker <= 0xD7) || marker == 0xD9) {
+        found = true;
+        break;
+      }
+    }
+
+    // Interval closed by that marker (RSTn numbers repeat every 8)
+    uint16_t last = intervals - 1;
+    if (found && marker != 0xD9) {
+      last = interval + (((marker - 0xD0) - (interval & 7)) & 7);
+      if (last >= intervals) return 0;
+    }
+    uint32_t end = found ? p : size;
+
+    if (found && last == interval && jpegConcealHave(received, packetSize, start, end)) {
+      w.copy(jpeg + start, end - start);
+    } else {
+      for (uint16_t i = interval; i <= last; i++) {
+        uint32_t first = (uint32_t)i * nrst;
+        uint32_t count = (i == intervals - 1) ? totalMcus - first : nrst;
+        for (uint32_t m = 0; m < count; m++) {
+          for (uint8_t c = 0; c < ncomp; c++) {
+            uint8_t blocks = (ncomp == 1) ? 1 : compH[c] * compV[c];
+            for (uint8_t b = 0; b < blocks; b++) {
+              w.code(huffCode[0][compDc[c]], huffLen[0][compDc[c]]);
+              w.code(huffCode[1][compAc[c]], huffLen[1][compAc[c]]);
+            }
+          }
+        }
+        w.flush();
+        if (i < last) {
+          w.byte(0xFF);
+          w.byte(0xD0 + (i & 7));
+        }
+
+        for (uint32_t row = first / mcusPerRow; row <= (first + count - 1) / mcusPerRow; row++) {
+          info.rows |= (uint64_t)1 << row;
+        }
+        info.damaged++;
+      }
+    }
+
+    w.byte(0xFF);
+    w.byte(last < intervals - 1 ? 0xD0 + (last & 7) : 0xD9);
+
+    interval = last + 1;
+    start = end + 2;
+  }
+
+  return w.overflow ? 0 : w.pos;
+}
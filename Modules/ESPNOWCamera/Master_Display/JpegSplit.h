@@ -0,0 +1,179 @@
+// JpegSplit.h
+#pragma once
+//
+// Splits a camera JPEG with restart markers into a top and a bottom half
+// that decode independently, so two cores can share one frame.
+//
+// A restart interval that ends on an MCU row boundary is a clean cut: the
+// DC predictors reset there and the entropy data starts on a byte. Each
+// half is presented to tjpgd as a JPEG of its own: the original header
+// with the SOF height patched, the scan data of its intervals, and an EOI.
+// The bottom half's RSTn markers are renumbered on the fly so they start
+// at RST0 again. Nothing is copied; JpegSplitPart::read() assembles the
+// bytes as the decoder asks for them.
+//
+// Frames without a DRI segment, or whose intervals never end on a row
+// boundary, cannot be split (jpegSplit() returns false).
+//
+// Place this file alongside your .ino files and #include "JpegSplit.h".
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <stddef.h>
+#endif
+
+// One half of a split frame, read as a stand-alone JPEG
+struct JpegSplitPart {
+  const uint8_t* jpeg;
+  uint32_t headerLen;   // Header bytes, SOI up to the end of the SOS segment
+  uint32_t sofPos;      // Height field of the SOF segment
+  uint16_t height;      // Pixel rows in this half
+  uint32_t dataStart;   // Scan data of this half in `jpeg`
+  uint32_t dataEnd;
+  uint8_t  rstOffset;   // Subtracted from every RSTn number
+  uint32_t pos;         // Read position in the assembled stream
+
+  uint32_t length() const { return headerLen + (dataEnd - dataStart) + 2; }
+
+  // tjpgd input: copies (or skips, when buf is null) up to len bytes
+  uint32_t read(uint8_t* buf, uint32_t len) {
+    uint32_t n = 0;
+    uint32_t dataLen = dataEnd - dataStart;
+    for (; n < len && pos < headerLen + dataLen + 2; n++, pos++) {
+      uint8_t b;
+      if (pos < headerLen) {
+        b = jpeg[pos];
+        if (pos == sofPos) b = height >> 8;
+        else if (pos == sofPos + 1) b = height & 0xFF;
+      } else if (pos < headerLen + dataLen) {
+        uint32_t src = dataStart + (pos - headerLen);
+        b = jpeg[src];
+        // Scan data never has 0xFF before anything but 0x00 or a marker
+        if (b >= 0xD0 && b <= 0xD7 && src > dataStart && jpeg[src - 1] == 0xFF) {
+          b = 0xD0 + ((b - 0xD0 - rstOffset) & 7);
+        }
+      } else {
+        b = (pos == headerLen + dataLen) ? 0xFF : 0xD9;
+      }
+      if (buf) buf[n] = b;
+    }
+    return n;
+  }
+};
+
+// Splits `jpeg` at the row-aligned restart interval closest to its middle.
+// Returns false when the frame has to be decoded in one piece.
+inline bool jpegSplit(const uint8_t* jpeg, uint32_t size, JpegSplitPart& top, JpegSplitPart& bottom) {
+  if (size < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return false;
+
+  uint16_t width = 0, height = 0, nrst = 0;
+  uint32_t sofPos = 0;
+  uint8_t hmax = 1, vmax = 1;
+
+  // -------- Header --------
+  uint32_t pos = 2;
+  uint32_t scanStart = 0;
+  while (!scanStart) {
+    if (pos + 4 > size || jpeg[pos] != 0xFF) return false;
+
+    uint8_t marker = jpeg[pos + 1];
+    uint16_t len = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+    uint32_t seg = pos + 4;
+    uint32_t end = pos + 2 + len;
+    if (len < 2 || end > size) return false;
+
+    switch (marker) {
+      case 0xC0:    // Baseline
+      case 0xC1: {  // Extended sequential, Huffman
+        if (len < 8) return false;
+        sofPos = seg + 1;
+        height = (jpeg[seg + 1] << 8) | jpeg[seg + 2];
+        width = (jpeg[seg + 3] << 8) | jpeg[seg + 4];
+        uint8_t ncomp = jpeg[seg + 5];
+        if ((ncomp != 1 && ncomp != 3) || len < 8 + 3 * ncomp) return false;
+        for (uint8_t c = 0; ncomp == 3 && c < 3; c++) {
+          uint8_t h = jpeg[seg + 7 + 3 * c] >> 4;
+          uint8_t v = jpeg[seg + 7 + 3 * c] & 0x0F;
+          if (h > hmax) hmax = h;
+          if (v > vmax) vmax = v;
+        }
+        break;
+      }
+
+      case 0xDD:    // Restart interval
+        if (len < 4) return false;
+        nrst = (jpeg[seg] << 8) | jpeg[seg + 1];
+        break;
+
+      case 0xDA:    // Start of scan
+        scanStart = end;
+        break;
+
+      default:
+        // Progressive, lossless and arithmetic-coded frames are not supported
+        if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) return false;
+        break;
+    }
+    pos = end;
+  }
+
+  if (!width || !height || !nrst || !sofPos) return false;
+
+  // -------- Row-aligned interval boundary nearest the middle --------
+  uint16_t mcuWidth = 8 * hmax;
+  uint16_t mcuHeight = 8 * vmax;
+  uint32_t mcusPerRow = (width + mcuWidth - 1) / mcuWidth;
+  uint32_t totalMcus = mcusPerRow * ((height + mcuHeight - 1) / mcuHeight);
+  uint32_t intervals = (totalMcus + nrst - 1) / nrst;
+
+  uint32_t split = 0;
+  uint32_t bestDistance = totalMcus;
+  for (uint32_t k = 1; k < intervals; k++) {
+    uint32_t mcus = k * nrst;
+    if (mcus % mcusPerRow) continue;
+    uint32_t distance = mcus * 2 > totalMcus ? mcus * 2 - totalMcus : totalMcus - mcus * 2;
+    if (distance < bestDistance) {
+      bestDistance = distance;
+      split = k;
+    }
+  }
+  if (!split) return false;
+
+  // -------- Marker that ends interval split - 1 --------
+  uint32_t marker = 0;
+  uint32_t seen = 0;
+  for (uint32_t p = scanStart; p + 1 < size; p++) {
+    if (jpeg[p] != 0xFF || jpeg[p + 1] < 0xD0 || jpeg[p + 1] > 0xD7) continue;
+    if (++seen == split) {
+      marker = p;
+      break;
+    }
+  }
+  if (!marker) return false;
+
+  uint32_t dataEnd = size;
+  while (dataEnd >= marker + 4 && !(jpeg[dataEnd - 2] == 0xFF && jpeg[dataEnd - 1] == 0xD9)) dataEnd--;
+  if (dataEnd >= marker + 4) dataEnd -= 2;
+  else dataEnd = size;
+
+  uint16_t splitRow = split * nrst / mcusPerRow;
+
+  top.jpeg = jpeg;
+  top.headerLen = scanStart;
+  top.sofPos = sofPos;
+  top.height = splitRow * mcuHeight;
+  top.dataStart = scanStart;
+  top.dataEnd = marker;
+  top.rstOffset = 0;
+  top.pos = 0;
+
+  bottom = top;
+  bottom.height = height - top.height;
+  bottom.dataStart = marker + 2;
+  bottom.dataEnd = dataEnd;
+  bottom.rstOffset = split & 7;
+  return true;
+}
@@ -3,9 +3,21 @@
 #include "CommunicationManager.h"
 #include "CommandHandler.h"
 
+// Optional rotary encoder for scrubbing clips (-1 = none, STEP does the same)
+#define CLIP_ENC_A   -1
+#define CLIP_ENC_B   -1
+#define CLIP_ENC_SW  -1
+
+#if CLIP_ENC_A >= 0
+#include <AiEsp32RotaryEncoder.h>
+AiEsp32RotaryEncoder clipEncoder(CLIP_ENC_A, CLIP_ENC_B, CLIP_ENC_SW, -1, 4);
+void IRAM_ATTR clipEncoderISR() { clipEncoder.readEncoder_ISR(); }
+#endif
+
 DisplayManager displayMgr;
 CommunicationManager commMgr;
 CommandHandler cmdHandler;
+ClipPlayer clipPlayer;
 
 void setup() {
   Serial.begin(115200);
@@ -23,33 +35,94 @@ void setup() {
     while(1) delay(1000);
   }
   
+  // Let the camera capture only what the panel shows
+  commMgr.setPanel(PANEL_WIDTH, PANEL_HEIGHT, PANEL_ROTATION);
+  
   // Link modules
   cmdHandler.setDisplayManager(&displayMgr);
   cmdHandler.setCommunicationManager(&commMgr);
+  cmdHandler.setClipPlayer(&clipPlayer);
+  
+#if CLIP_ENC_A >= 0
+  clipEncoder.begin();
+  clipEncoder.setup(clipEncoderISR);
+  clipEncoder.setBoundaries(-100000, 100000, false);
+  clipEncoder.setAcceleration(50);
+#endif
   
   Serial.println("\n=== Commands Available ===");
   Serial.println("CAPTURE       - Request single frame");
   Serial.println("START_STREAM  - Start continuous streaming (2 FPS)");
   Serial.println("STOP_STREAM   - Stop streaming");
   Serial.println("STATUS        - Show system status");
+  Serial.println("PROGRESSIVE ON|OFF - Draw frames while they arrive");
+  Serial.println("PARALLEL ON|OFF - Decode each frame on both cores");
+  Serial.println("JITTER <frames> <ms> - Playout buffer depth");
+  Serial.println("CLIPS / PLAY [n] - List and play recorded event clips");
+  Serial.println("VIEW ALL|<1-4> - Camera mosaic or one camera full screen");
   Serial.println("MSG: <text>   - Send text message to slave");
   Serial.println("==========================\n");
   
   displayMgr.showReady();
 }
 
+// Scrubs with the encoder (if fitted) and draws the clip frame that is due:
+// a quick preview while the position moves, full resolution once it rests
+void showClip() {
+#if CLIP_ENC_A >= 0
+  static long lastTurn = 0;
+  long turn = clipEncoder.readEncoder();
+  if (turn != lastTurn) {
+    clipPlayer.step(turn - lastTurn);
+    lastTurn = turn;
+  }
+  if (clipEncoder.isEncoderButtonClicked()) {
+    if (clipPlayer.isPlaying()) clipPlayer.pause();
+    else clipPlayer.play();
+  }
+#endif
+  
+  int32_t frame;
+  bool preview;
+  if (clipPlayer.update(millis(), frame, preview)) {
+    uint32_t size;
+    const uint8_t* data = clipPlayer.frameData(frame, size);
+    if (data) {
+      displayMgr.displayClipFrame(data, size, clipPlayer.getWidth(), clipPlayer.getHeight(), preview);
+    }
+  }
+}
+
 void loop() {
   // Process incoming serial commands
   cmdHandler.processSerialCommands();
   
-  // Process received image data
-  commMgr.processIncomingData();
+  // An open clip (PLAY) has the panel until CLOSE
+  bool clipOpen = clipPlayer.isOpen();
+  if (clipOpen) {
+    showClip();
+  }
   
-  // Check for complete images and display them
-  if (commMgr.hasCompleteImage()) {
-    CompleteImage img = commMgr.getCompleteImage();
-    displayMgr.displayImage(img);
-    commMgr.freeImage(img);
+  // A second camera turns the screen into a mosaic until VIEW picks one
+  if (!clipOpen && commMgr.isMosaic() != displayMgr.isMosaic()) {
+    displayMgr.setMosaic(commMgr.isMosaic());
+  }
+  
+  // Display complete images when the jitter buffer says they are due (in
+  // the mosaic, as they come, each in its camera's cell); they move on to
+  // the pre-roll recorder, drawn or not
+  CompleteImage img;
+  if (commMgr.nextImage(img)) {
+    if (!clipOpen) {
+      if (displayMgr.isMosaic()) displayMgr.displayCell(img, img.source);
+      else displayMgr.displayImage(img);
+    }
+    commMgr.retireImage(img);
+  }
+  // Progressive mode: decode the frame that is arriving right now
+  else if (commMgr.hasStreamingImage()) {
+    if (!clipOpen) displayMgr.displayStream(commMgr.getStreamingImage());
+    commMgr.finishStream();
   }
   
   // Periodic status update
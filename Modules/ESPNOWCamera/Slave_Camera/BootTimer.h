@@ -0,0 +1,57 @@
+// BootTimer.h
+// Boot phase timestamps for tracking wake-to-first-packet latency.
+// Every module marks the phases it completes; bootReport() prints them as
+// ms since the chip started (esp_timer, so ROM and bootloader time before
+// the app are not included) and as a BOOT,... line for log scraping.
+#ifndef BOOT_TIMER_H
+#define BOOT_TIMER_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+
+enum BootPhase : uint8_t {
+  BOOT_SETUP,          // setup() entered
+  BOOT_CAMERA_INIT,    // esp_camera_init done
+  BOOT_SENSOR,         // Sensor registers and saved viewport applied
+  BOOT_WIFI,           // Wi-Fi started in station mode
+  BOOT_ESPNOW,         // esp_now_init done
+  BOOT_PEER,           // Master registered as peer
+  BOOT_READY,          // Camera and radio both up
+  BOOT_FIRST_FRAME,    // First frame out of the sensor
+  BOOT_FIRST_PACKET,   // First message handed to ESP-NOW
+  BOOT_THUMBNAIL,      // Wake thumbnail sent
+  BOOT_FULL_FRAME,     // Wake full-quality frame sent
+  BOOT_PHASES
+};
+
+inline int64_t* bootTimes() {
+  static int64_t times[BOOT_PHASES] = {0};
+  return times;
+}
+
+// Records the first time a phase is reached
+inline void bootMark(BootPhase phase) {
+  if (!bootTimes()[phase]) bootTimes()[phase] = esp_timer_get_time();
+}
+
+inline void bootReport(const char* kind) {
+  static const char* const names[BOOT_PHASES] = {
+    "setup", "camera", "sensor", "wifi", "espnow", "peer", "ready",
+    "frame", "packet", "thumb", "full"
+  };
+  const int64_t* times = bootTimes();
+
+  Serial.printf("[Boot] %s:", kind);
+  for (int i = 0; i < BOOT_PHASES; i++) {
+    if (times[i]) Serial.printf(" %s %lu", names[i], (unsigned long)(times[i] / 1000));
+  }
+  Serial.println(" ms");
+
+  Serial.printf("BOOT,%s", kind);
+  for (int i = 0; i < BOOT_PHASES; i++) {
+    Serial.printf(",%lu", (unsigned long)(times[i] / 1000));
+  }
+  Serial.println();
+}
+
+#endif
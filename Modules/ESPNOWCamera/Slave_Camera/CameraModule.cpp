@@ -1,7 +1,14 @@
 // CameraModule.cpp
 #include "CameraModule.h"
 
+// Last viewport announced by the master, kept across deep sleep so a wake
+// captures the right window from the first frame (reset on power-on)
+RTC_DATA_ATTR static uint16_t savedViewWidth = 0;
+RTC_DATA_ATTR static uint16_t savedViewHeight = 0;
+
 CameraModule::CameraModule() {
+  viewWidth = 0;
+  viewHeight = 0;
   framesCaptured = 0;
   lastCaptureTime = 0;
 }
@@ -36,13 +43,14 @@ bool CameraModule::begin() {
   config.grab_mode = CAMERA_GRAB_LATEST;
   config.fb_location = CAMERA_FB_IN_PSRAM;
   config.jpeg_quality = 4;  // High quality
-  config.fb_count = 1;
+  config.fb_count = 2;      // The sensor fills one while the other is sent
   
   esp_err_t err = esp_camera_init(&config);
   if (err != ESP_OK) {
     Serial.printf("Camera init failed: 0x%x\n", err);
     return false;
   }
+  bootMark(BOOT_CAMERA_INIT);
   
   // Configure sensor settings
   sensor_t* s = esp_camera_sensor_get();
@@ -67,7 +75,12 @@ bool CameraModule::begin() {
     s->set_special_effect(s, 0);
   }
   
-  Serial.println("Camera initialized: QVGA 320x240, Quality 4");
+  if (savedViewWidth && savedViewHeight) {
+    setViewport(savedViewWidth, savedViewHeight);
+  }
+  bootMark(BOOT_SENSOR);
+  
+  Serial.println("Camera initialized: QVGA 320x240, Quality 4, 2 frame buffers");
   return true;
 }
 
@@ -75,6 +88,12 @@ camera_fb_t* CameraModule::captureFrame() {
   camera_fb_t* fb = esp_camera_fb_get();
   
   if (fb) {
+    // The frame buffer keeps the nominal size; a windowed JPEG is smaller
+    uint16_t width, height;
+    if (camJpegSize(fb->buf, fb->len, width, height)) {
+      fb->width = width;
+      fb->height = height;
+    }
     framesCaptured++;
     lastCaptureTime = millis();
     Serial.printf("Frame captured: %d bytes\n", fb->len);
@@ -91,6 +110,33 @@ void CameraModule::returnFrame(camera_fb_t* fb) {
   }
 }
 
+// Captures only the part of the frame the master's panel can show.
+// Returns true when the viewport changed.
+bool CameraModule::setViewport(uint16_t width, uint16_t height) {
+  if (width == viewWidth && height == viewHeight) return false;  // Periodic repeat
+  viewWidth = width;
+  viewHeight = height;
+  savedViewWidth = width;
+  savedViewHeight = height;
+  
+  sensor_t* s = esp_camera_sensor_get();
+  if (!s) return true;
+  
+  // Back to the full frame first; this also clears an earlier window
+  s->set_framesize(s, FRAMESIZE_QVGA);
+  
+  CamWindow win;
+  if (s->id.PID != OV2640_PID || !camViewportWindow(FRAME_WIDTH, FRAME_HEIGHT, width, height, win)) {
+    Serial.printf("[Slave] Viewport %ux%u: full %ux%u frame\n", width, height, FRAME_WIDTH, FRAME_HEIGHT);
+    return true;
+  }
+  
+  s->set_res_raw(s, win.mode, 0, 0, 0, win.offsetX, win.offsetY, win.windowWidth, win.windowHeight,
+                 win.outputWidth, win.outputHeight, false, false);
+  Serial.printf("[Slave] Viewport %ux%u: capturing %ux%u\n", width, height, win.outputWidth, win.outputHeight);
+  return true;
+}
+
 void CameraModule::resetStats() {
   framesCaptured = 0;
   lastCaptureTime = millis();
@@ -4,6 +4,8 @@
 
 #include "esp_camera.h"
 #include <Arduino.h>
+#include "CameraWindow.h"
+#include "BootTimer.h"
 
 class CameraModule {
 private:
@@ -25,6 +27,12 @@ private:
   static constexpr int HREF_GPIO_NUM = 7;
   static constexpr int PCLK_GPIO_NUM = 13;
   
+  // Nominal frame (FRAMESIZE_QVGA); a viewport may window it smaller
+  static constexpr uint16_t FRAME_WIDTH = 320;
+  static constexpr uint16_t FRAME_HEIGHT = 240;
+  uint16_t viewWidth;
+  uint16_t viewHeight;
+  
   int framesCaptured;
   unsigned long lastCaptureTime;
   
@@ -33,6 +41,7 @@ public:
   bool begin();
   camera_fb_t* captureFrame();
   void returnFrame(camera_fb_t* fb);
+  bool setViewport(uint16_t width, uint16_t height);
   int getFramesCaptured() { return framesCaptured; }
   void resetStats();
 };
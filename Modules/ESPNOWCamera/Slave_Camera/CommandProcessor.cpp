@@ -8,9 +8,40 @@ CommandProcessor::CommandProcessor() {
   camera = nullptr;
   transmit = nullptr;
   streamingMode = false;
+  captureRequested = false;
+  requestTime = 0;
+  wakeShot = false;
+  lastCommandTime = 0;
   lastStreamTime = 0;
-  streamInterval = 500;  // 500ms = 2 FPS
+  airtimeShare = 1;
+  lastSendMs = 0;
   commandQueue = nullptr;
+  capsQueue = nullptr;
+  requestQueue = nullptr;
+  frameQueue = nullptr;
+  captureTaskHandle = nullptr;
+  transmitTaskHandle = nullptr;
+  motionMode = false;
+  motionActive = false;
+  lastMotionTime = 0;
+  lastKeepaliveTime = 0;
+  thumbBuffer = nullptr;
+  lumaBuffer = nullptr;
+  thumbWidth = 0;
+  thumbHeight = 0;
+  motionEvents = 0;
+  framesGated = 0;
+  keepalivesSent = 0;
+  tileMode = false;
+  keyframeDue = false;
+  framesCaptured = 0;
+  framesTransmitted = 0;
+  captureUs = 0;
+  checkUs = 0;
+  handoffUs = 0;
+  sendUs = 0;
+  lastStatusFrames = 0;
+  lastStatusTime = 0;
 }
 
 String serialInputBuffer = "";  // For serial text message input
@@ -20,11 +51,35 @@ bool CommandProcessor::begin() {
   
   // Create command queue
   commandQueue = xQueueCreate(5, sizeof(CommandPacket));
-  if (!commandQueue) {
+  capsQueue = xQueueCreate(1, sizeof(CapsPacket));
+  requestQueue = xQueueCreate(8, sizeof(CaptureRequest));
+  frameQueue = xQueueCreate(1, sizeof(CaptureJob));
+  if (!commandQueue || !capsQueue || !requestQueue || !frameQueue) {
     Serial.println("Failed to create command queue!");
     return false;
   }
   
+  // Motion detection buffers (1/4 scale of the largest frame, 640x480)
+  size_t thumbPixels = (640 / 4) * (480 / 4);
+  thumbBuffer = (uint8_t*)(psramFound() ? ps_malloc(thumbPixels * 2) : malloc(thumbPixels * 2));
+  lumaBuffer = (uint8_t*)malloc(thumbPixels);
+  if (!thumbBuffer || !lumaBuffer) {
+    Serial.println("Failed to allocate motion buffers!");
+    return false;
+  }
+  
+  if (!tiles.begin()) {
+    return false;
+  }
+  
+  // Capture and transmit run side by side on both cores
+  xTaskCreatePinnedToCore(captureTask, "Capture", 8192, this, 2, &captureTaskHandle, CAPTURE_TASK_CORE);
+  xTaskCreatePinnedToCore(transmitTask, "Transmit", 6144, this, 2, &transmitTaskHandle, TRANSMIT_TASK_CORE);
+  if (!captureTaskHandle || !transmitTaskHandle) {
+    Serial.println("Failed to start capture/transmit tasks!");
+    return false;
+  }
+  
   // Register ESP-NOW receive callback
   esp_now_register_recv_cb(onCommandReceived);
   
@@ -32,26 +87,55 @@ bool CommandProcessor::begin() {
   return true;
 }
 
+// Dispatch table indexed by CamMsgType
+const CamMsgHandler CommandProcessor::handlers[CAM_MSG_TYPE_COUNT] = {
+  nullptr,                            // 0: invalid
+  nullptr,                            // CAM_MSG_HEADER (master side only)
+  nullptr,                            // CAM_MSG_DATA (master side only)
+  nullptr,                            // CAM_MSG_PARITY (master side only)
+  CommandProcessor::onNack,           // CAM_MSG_NACK
+  CommandProcessor::onCommand,        // CAM_MSG_COMMAND
+  CommandProcessor::onTextMessage,    // CAM_MSG_TEXT
+  nullptr,                            // CAM_MSG_REPORT (sent by ESPNOWCAMRECIEVER only)
+  CommandProcessor::onCaps            // CAM_MSG_CAPS
+};
+
 void CommandProcessor::onCommandReceived(const uint8_t* mac, const uint8_t* data, int len) {
   if (!instance || !instance->commandQueue) return;
   
-  if (len == sizeof(CommandPacket)) {
-    CommandPacket cmd = *(CommandPacket*)data;
-    xQueueSendFromISR(instance->commandQueue, &cmd, NULL);
-    Serial.printf("Command received: %s\n", cmd.command);
-    return;
+  uint8_t type = camCheck(data, len);
+  if (type && handlers[type]) {
+    handlers[type](mac, data, len);
   }
-  
-  // Check for text message
-  if (len == sizeof(TextMessagePacket)) {
-    TextMessagePacket* msg = (TextMessagePacket*)data;
-    if (msg->fromMaster == 1) {  // Message from master
-      Serial.printf("\n📨 [Message from Master]: %s\n\n", msg->message);
-    }
-    return;
+}
+
+void CommandProcessor::onCommand(const uint8_t* mac, const uint8_t* data, int len) {
+  CommandPacket cmd = *(const CommandPacket*)data;
+  cmd.command[sizeof(cmd.command) - 1] = '\0';
+  xQueueSendFromISR(instance->commandQueue, &cmd, NULL);
+  Serial.printf("Command received: %s\n", cmd.command);
+}
+
+// Missing-packet report / acknowledgement for the frame in flight
+void CommandProcessor::onNack(const uint8_t* mac, const uint8_t* data, int len) {
+  if (instance->transmit) {
+    instance->transmit->handleNack(*(const NackPacket*)data);
+  }
+}
+
+void CommandProcessor::onTextMessage(const uint8_t* mac, const uint8_t* data, int len) {
+  const TextMessagePacket* msg = (const TextMessagePacket*)data;
+  if (msg->fromMaster == 1) {  // Message from master
+    Serial.printf("\n📨 [Message from Master]: %.*s\n\n", (int)sizeof(msg->message), msg->message);
   }
 }
 
+// Master panel size: the capture task reconfigures the camera before its
+// next frame
+void CommandProcessor::onCaps(const uint8_t* mac, const uint8_t* data, int len) {
+  xQueueOverwrite(instance->capsQueue, data);
+}
+
 void CommandProcessor::processCommands() {
   CommandPacket cmd;
   
@@ -114,38 +198,55 @@ void CommandProcessor::executeCommand(const CommandPacket& cmd) {
   command.trim();
   
   Serial.printf("\n>>> Executing: %s\n", command.c_str());
+  lastCommandTime = millis();
   
   if (command == "CAPTURE") {
     Serial.println("[Slave] Single frame capture requested");
     streamingMode = false;
     
-    // Clear any old frames from camera buffer first
-    if (camera) {
-      Serial.println("[Slave] Clearing old frames from buffer...");
-      camera_fb_t* old_fb = esp_camera_fb_get();
-      if (old_fb) {
-        esp_camera_fb_return(old_fb);
-      }
-      delay(50); // Small delay to ensure fresh capture
-    }
-    
-    captureAndSend();
+    // Drop a streamed frame still waiting to go out; the capture task skips
+    // frames exposed before this request
+    flushFrames();
+    request(REQ_KEYFRAME);
+    requestTime = millis();
+    captureRequested = true;
+    xTaskNotifyGive(captureTaskHandle);
   }
   else if (command == "START_STREAM") {
-    Serial.println("[Slave] Starting continuous stream at 2 FPS");
+    Serial.println("[Slave] Starting continuous stream");
+    request(REQ_KEYFRAME);
     streamingMode = true;
-    lastStreamTime = millis();
+    xTaskNotifyGive(captureTaskHandle);
   }
   else if (command == "STOP_STREAM") {
     Serial.println("[Slave] Stopping stream");
     streamingMode = false;
-    
-    // Clear any pending frames
-    if (camera) {
-      camera_fb_t* old_fb = esp_camera_fb_get();
-      if (old_fb) {
-        esp_camera_fb_return(old_fb);
-      }
+    flushFrames();
+  }
+  else if (command == "MOTION_ON" || command == "MOTION_OFF") {
+    bool enable = (command == "MOTION_ON");
+    request(enable ? REQ_MOTION_ON : REQ_MOTION_OFF);
+    Serial.printf("[Slave] Motion-gated streaming %s\n", enable ? "enabled" : "disabled");
+  }
+  else if (command == "TILES_ON" || command == "TILES_OFF") {
+    bool enable = (command == "TILES_ON");
+    request(enable ? REQ_TILES_ON : REQ_TILES_OFF);
+    Serial.printf("[Slave] Tile delta streaming %s\n", enable ? "enabled" : "disabled");
+  }
+  else if (command == "REPAIR_ON" || command == "REPAIR_OFF") {
+    bool enable = (command == "REPAIR_ON");
+    Serial.printf("[Slave] Selective-repeat %s\n", enable ? "enabled" : "disabled");
+    if (transmit) {
+      transmit->setSelectiveRepeat(enable);
+    }
+  }
+  else if (command.startsWith("FEC:")) {
+    int group = 0, parity = 0;
+    sscanf(command.c_str(), "FEC:%d:%d", &group, &parity);
+    if (transmit && transmit->setFec(group, parity)) {
+      Serial.printf("[Slave] FEC set to %d parity per %d data packets\n", parity, group);
+    } else {
+      Serial.printf("[Slave] Invalid FEC setting: %s\n", command.c_str());
     }
   }
   else {
@@ -155,61 +256,377 @@ void CommandProcessor::executeCommand(const CommandPacket& cmd) {
   Serial.println();
 }
 
-void CommandProcessor::handleStreaming() {
-  if (!streamingMode) return;
-  
-  unsigned long currentTime = millis();
-  
-  if (currentTime - lastStreamTime >= streamInterval) {
-    captureAndSend();
-    lastStreamTime = currentTime;
+// Queues a settings change for the capture task
+void CommandProcessor::request(CaptureRequest req) {
+  if (xQueueSend(requestQueue, &req, 0) != pdTRUE) {
+    Serial.println("[Slave] Too many pending commands, dropped one!");
+  }
+}
+
+// Capture task, between frames: applies the changes commands asked for
+void CommandProcessor::applyRequests() {
+  CaptureRequest req;
+  while (xQueueReceive(requestQueue, &req, 0) == pdTRUE) {
+    switch (req) {
+      case REQ_KEYFRAME:
+        keyframeDue = true;
+        break;
+      case REQ_MOTION_ON:
+      case REQ_MOTION_OFF:
+        motionMode = (req == REQ_MOTION_ON);
+        motionActive = false;
+        lastKeepaliveTime = 0;
+        motion.reset();
+        break;
+      case REQ_TILES_ON:
+      case REQ_TILES_OFF:
+        tileMode = (req == REQ_TILES_ON);
+        keyframeDue = true;
+        break;
+    }
+  }
+}
+
+void CommandProcessor::captureTask(void* param) {
+  CommandProcessor* self = (CommandProcessor*)param;
+  for (;;) {
+    self->captureNext();
+  }
+}
+
+void CommandProcessor::transmitTask(void* param) {
+  CommandProcessor* self = (CommandProcessor*)param;
+  CaptureJob job;
+  for (;;) {
+    // Modem sleep stays off for a whole stream, so commands and NACKs are
+    // not lost between frames, and comes back on once it stops; the wait
+    // is bounded while streaming to notice the stop
+    bool streaming = self->streamingMode;
+    self->transmit->setPowerSave(!streaming);
+    TickType_t wait = streaming ? pdMS_TO_TICKS(100) : portMAX_DELAY;
+    if (xQueueReceive(self->frameQueue, &job, wait) == pdTRUE) {
+      xTaskNotifyGive(self->captureTaskHandle);  // Room for the next frame
+      self->transmit->setPowerSave(false);       // Until its repairs are done
+      self->sendJob(job);
+    }
   }
 }
 
-void CommandProcessor::captureAndSend() {
+// One step of the capture task: captures a frame while the previous one is
+// being sent and hands it over as soon as the transmit task is free
+void CommandProcessor::captureNext() {
   if (!camera || !transmit) {
-    Serial.println("[Slave] Camera or transmission not initialized!");
+    vTaskDelay(pdMS_TO_TICKS(100));
     return;
   }
   
-  unsigned long startTime = millis();
+  // Reconfigure the sensor here, never in the middle of a capture
+  CapsPacket caps;
+  if (xQueueReceive(capsQueue, &caps, 0) == pdTRUE) {
+    uint16_t width, height;
+    camViewportSize(caps.panelWidth, caps.panelHeight, caps.rotation, width, height);
+    if (camera->setViewport(width, height)) {
+      keyframeDue = true;
+    }
+    airtimeShare = caps.cameras ? caps.cameras : 1;
+  }
   
-  Serial.println("[Slave] Capturing fresh frame...");
+  // Idle until a command wakes the task
+  bool single = captureRequested;
+  if (!streamingMode && !single) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return;
+  }
   
-  // Capture frame
+  // A still scene is checked every MOTION_CHECK_MS; a stream runs as fast as
+  // the transmit task takes frames, or at STREAM_INTERVAL_MS. With other
+  // cameras on the master, each frame is followed by a pause that leaves
+  // the channel to them (n - 1 times the last send).
+  if (!single) {
+    unsigned long interval = (motionMode && !motionActive) ? MOTION_CHECK_MS : STREAM_INTERVAL_MS;
+    if (airtimeShare > 1 && !(motionMode && !motionActive)) {
+      interval = max(interval, (unsigned long)lastSendMs * airtimeShare);
+    }
+    unsigned long elapsed = millis() - lastStreamTime;
+    if (elapsed < interval) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(interval - elapsed));
+      return;
+    }
+  }
+  
+  // Grab the frame only once the transmit task can take it, so it is as
+  // fresh as possible when it goes on air
+  unsigned long t = micros();
+  while (uxQueueSpacesAvailable(frameQueue) == 0) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+  }
+  handoffUs += micros() - t;
+  if (!streamingMode && !captureRequested) return;  // Stopped meanwhile
+  lastStreamTime = millis();
+  
+  t = micros();
   camera_fb_t* fb = camera->captureFrame();
+  
+  // The driver may still hold a frame exposed before a CAPTURE request
+  if (fb && single &&
+      (int32_t)(fb->timestamp.tv_sec * 1000UL + fb->timestamp.tv_usec / 1000 - requestTime) < 0) {
+    camera->returnFrame(fb);
+    fb = camera->captureFrame();
+  }
+  captureUs += micros() - t;
+  applyRequests();
   if (!fb) {
-    Serial.println("[Slave] Frame capture failed!");
+    vTaskDelay(pdMS_TO_TICKS(10));
     return;
   }
+  if (single) captureRequested = false;
+  framesCaptured++;
+  bootMark(BOOT_FIRST_FRAME);
   
-  Serial.printf("[Slave] Frame captured: %d bytes\n", fb->len);
+  // After a wake a tiny thumbnail goes first, the full frame right after it
+  CaptureJob job = {};
+  if (single && wakeShot) {
+    wakeShot = false;
+    job.wake = true;
+    if (decodeThumbnail(fb) && makeThumbnail(job.thumb)) {
+      xQueueSend(frameQueue, &job, portMAX_DELAY);
+    }
+    job.thumb = {};
+  }
+  
+  if (motionMode && !single) {
+    t = micros();
+    bool send = gateMotion(fb, job);
+    checkUs += micros() - t;
+    if (!send) return;
+  } else {
+    job.fb = fb;
+  }
   
-  // Send frame
-  bool success = transmit->sendFrame(fb);
+  job.tiles = tileMode;
+  job.keyframe = keyframeDue;
+  keyframeDue = false;
+  xQueueSend(frameQueue, &job, portMAX_DELAY);
+}
+
+// Motion gating: full frames only while the scene moves, a small keepalive
+// thumbnail now and then while it is still. Returns false when there is
+// nothing to send (the frame has been returned to the driver).
+bool CommandProcessor::gateMotion(camera_fb_t* fb, CaptureJob& job) {
+  unsigned long now = millis();
   
-  // Return frame buffer
+  if (detectMotion(fb)) {
+    if (!motionActive) {
+      motionEvents++;
+      Serial.printf("[Slave] Motion detected (%d/%d blocks)\n",
+                    motion.getChangedBlocks(), motion.getBlockCount());
+    }
+    motionActive = true;
+    lastMotionTime = now;
+  } else if (motionActive && now - lastMotionTime > MOTION_HOLD_MS) {
+    motionActive = false;
+    lastKeepaliveTime = now;
+    Serial.println("[Slave] Scene still, pausing stream");
+  }
+  
+  if (motionActive) {
+    job.fb = fb;
+    return true;
+  }
+  
+  // The thumbnail comes from the decode detectMotion() left behind
   camera->returnFrame(fb);
+  if (lastKeepaliveTime != 0 && now - lastKeepaliveTime < MOTION_KEEPALIVE_MS) {
+    framesGated++;
+    return false;
+  }
+  lastKeepaliveTime = now;
+  return makeThumbnail(job.thumb);
+}
+
+// Decodes the JPEG at 1/4 scale (cheap: mostly DC coefficients) and runs
+// the block detector on its gray levels
+bool CommandProcessor::detectMotion(camera_fb_t* fb) {
+  if (!decodeThumbnail(fb)) return true;  // Cannot check: send
   
-  unsigned long totalTime = millis() - startTime;
+  uint32_t pixels = thumbWidth * thumbHeight;
+  for (uint32_t i = 0; i < pixels; i++) {
+    lumaBuffer[i] = motionLuma565(&thumbBuffer[i * 2]);
+  }
+  
+  return motion.update(lumaBuffer, thumbWidth, thumbHeight);
+}
+
+// 1/4 scale RGB565 decode of a frame into thumbBuffer
+bool CommandProcessor::decodeThumbnail(camera_fb_t* fb) {
+  thumbWidth = fb->width / 4;
+  thumbHeight = fb->height / 4;
+  if (thumbWidth * thumbHeight > (640 / 4) * (480 / 4)) return false;  // Too big
+  
+  return jpg2rgb565(fb->buf, fb->len, thumbBuffer, JPG_SCALE_4X);
+}
+
+// Re-encodes the last 1/4 scale decode as a small JPEG, a few packets instead
+// of a full frame
+bool CommandProcessor::makeThumbnail(camera_fb_t& thumb) {
+  uint8_t* jpg = nullptr;
+  size_t jpgLen = 0;
+  
+  if (!fmt2jpg(thumbBuffer, thumbWidth * thumbHeight * 2, thumbWidth, thumbHeight,
+               PIXFORMAT_RGB565, MOTION_THUMB_QUALITY, &jpg, &jpgLen)) {
+    Serial.println("[Slave] Thumbnail encode failed!");
+    return false;
+  }
+  
+  thumb = {};
+  thumb.buf = jpg;
+  thumb.len = jpgLen;
+  thumb.width = thumbWidth;
+  thumb.height = thumbHeight;
+  thumb.format = PIXFORMAT_JPEG;
+  return true;
+}
+
+// Transmit task: sends one frame and gives its buffer back
+void CommandProcessor::sendJob(CaptureJob& job) {
+  unsigned long start = micros();
+  bool success;
+  
+  if (job.fb) {
+    if (job.keyframe) tiles.forceKeyframe();
+    success = sendCaptured(job.fb, job.tiles);
+    camera->returnFrame(job.fb);
+  } else {
+    success = transmit->sendFrame(&job.thumb);
+    if (success) keepalivesSent++;
+    free(job.thumb.buf);
+    
+    // The thumbnail replaced the master's picture: tiles need a new base
+    tiles.forceKeyframe();
+  }
+  
+  unsigned long elapsed = micros() - start;
+  sendUs += elapsed;
+  lastSendMs = elapsed / 1000;
+  framesTransmitted++;
+  
+  if (job.wake) {
+    bootMark(job.fb ? BOOT_FULL_FRAME : BOOT_THUMBNAIL);
+    if (job.fb) bootReport("wake");
+  }
   
   if (success) {
-    Serial.printf("[Slave] ✓ Frame processed successfully in %lu ms\n\n", totalTime);
+    Serial.printf("[Slave] ✓ Frame processed successfully in %lu ms\n\n", elapsed / 1000);
   } else {
     Serial.println("[Slave] ✗ Frame transmission failed!\n");
   }
 }
 
+// Door camera wake: a thumbnail and then the full frame, without waiting for
+// a command from the master
+void CommandProcessor::sendWakeFrames() {
+  lastCommandTime = millis();
+  requestTime = 0;
+  wakeShot = true;
+  captureRequested = true;
+  xTaskNotifyGive(captureTaskHandle);
+}
+
+// Gives back a frame still waiting for the transmit task
+void CommandProcessor::flushFrames() {
+  CaptureJob job;
+  while (xQueueReceive(frameQueue, &job, 0) == pdTRUE) {
+    if (job.fb) {
+      camera->returnFrame(job.fb);
+    } else {
+      free(job.thumb.buf);
+    }
+    xTaskNotifyGive(captureTaskHandle);
+  }
+}
+
+// Sends a captured frame, as changed tiles when tile mode is on
+bool CommandProcessor::sendCaptured(camera_fb_t* fb, bool tiled) {
+  if (!tiled) {
+    return transmit->sendFrame(fb);
+  }
+  
+  camera_fb_t delta;
+  switch (tiles.encode(fb, delta)) {
+    case TILE_SKIP:
+      return true;
+    case TILE_DELTA:
+      if (transmit->sendFrame(&delta, CAM_FORMAT_TILES)) return true;
+      break;
+    default:
+      if (transmit->sendFrame(fb)) return true;
+      break;
+  }
+  
+  // The master may have missed part of the picture: resync with a full frame
+  tiles.forceKeyframe();
+  return false;
+}
+
 void CommandProcessor::printStatus() {
+  // Frame rate since the last report
+  unsigned long now = millis();
+  uint32_t frames = framesTransmitted;
+  float fps = (now > lastStatusTime) ? (frames - lastStatusFrames) * 1000.0f / (now - lastStatusTime) : 0;
+  lastStatusFrames = frames;
+  lastStatusTime = now;
+  
   Serial.println("\n=== SLAVE STATUS ===");
-  Serial.printf("Streaming: %s\n", streamingMode ? "ACTIVE (2 FPS)" : "STOPPED");
+  Serial.printf("Streaming: %s (%.1f FPS)\n", streamingMode ? "ACTIVE" : "STOPPED", fps);
+  Serial.printf("Airtime Share: 1/%d (last frame on air %lu ms)\n", airtimeShare, (unsigned long)lastSendMs);
   Serial.printf("Frames Captured: %d\n", camera ? camera->getFramesCaptured() : 0);
+  if (framesCaptured && framesTransmitted) {
+    // Capture is the bottleneck when the transmit task waits, the link when
+    // the capture task waits for the handoff
+    Serial.printf("Pipeline (avg ms/frame): capture %.1f, motion check %.1f, handoff wait %.1f | send %.1f\n",
+                  captureUs / 1000.0f / framesCaptured, checkUs / 1000.0f / framesCaptured,
+                  handoffUs / 1000.0f / framesCaptured, sendUs / 1000.0f / framesTransmitted);
+  }
+  Serial.printf("Motion Gating: %s (%s, %d events, %d frames held back, %d keepalives)\n",
+                motionMode ? "ON" : "OFF", motionActive ? "moving" : "still",
+                motionEvents, framesGated, keepalivesSent);
+  if (tileMode) {
+    uint32_t replaced = tiles.getReplacedBytes();
+    Serial.printf("Tile Delta: ON (%d keyframes, %d deltas, %d unchanged, %lu tiles, %lu%% of full-frame bytes)\n",
+                  tiles.getKeyframes(), tiles.getDeltaFrames(), tiles.getSkippedFrames(),
+                  (unsigned long)tiles.getTilesSent(),
+                  replaced ? (unsigned long)((uint64_t)tiles.getDeltaBytes() * 100 / replaced) : 100UL);
+  } else {
+    Serial.println("Tile Delta: OFF");
+  }
   Serial.printf("Frames Sent: %d\n", transmit ? transmit->getFramesSent() : 0);
   Serial.printf("Send Failures: %d\n", transmit ? transmit->getFailures() : 0);
+  if (transmit) {
+    Serial.printf("Send Window: %d packets, %lu pkt/s (%lu backoffs)\n",
+                  transmit->getWindow(), (unsigned long)transmit->getSendRate(),
+                  (unsigned long)transmit->getBackoffs());
+  }
+  
+  if (transmit) {
+    Serial.printf("Selective Repeat: %s (%d frames acked, %d packets resent)\n",
+                  transmit->isSelectiveRepeat() ? "ON" : "OFF",
+                  transmit->getFramesAcked(), transmit->getRetransmitted());
+    if (transmit->getFecGroup() > 0) {
+      Serial.printf("FEC: %d parity per %d data packets\n",
+                    transmit->getFecParity(), transmit->getFecGroup());
+    } else {
+      Serial.println("FEC: OFF");
+    }
+  }
   
   if (transmit && transmit->getFramesSent() > 0) {
     Serial.printf("Avg Transmit Time: %lu ms\n", transmit->getAvgTransmitTime());
   }
+  if (bootTimes()[BOOT_FIRST_PACKET]) {
+    bool woke = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0;
+    Serial.printf("%s to First Packet: %lu ms\n", woke ? "Wake" : "Boot",
+                  (unsigned long)(bootTimes()[BOOT_FIRST_PACKET] / 1000));
+  }
   
   Serial.printf("Free Heap: %d bytes\n", esp_get_free_heap_size());
   Serial.printf("Uptime: %lu seconds\n", millis() / 1000);
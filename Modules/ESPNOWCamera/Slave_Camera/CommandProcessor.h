@@ -4,11 +4,48 @@
 
 #include <Arduino.h>
 #include <esp_now.h>
+#include "esp_sleep.h"
+#include "img_converters.h"
 #include "CameraModule.h"
 #include "TransmissionManager.h"
 #include "DataStructures.h"
+#include "MotionDetector.h"
+#include "TileEncoder.h"
+#include "BootTimer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/task.h"
+
+// Capture/transmit pipeline: the sensor reads out frame N+1 while frame N
+// is on air (CameraModule uses two frame buffers)
+#define CAPTURE_TASK_CORE   1      // With loop(): sensor, motion checks
+#define TRANSMIT_TASK_CORE  0      // With the Wi-Fi stack: packets, repairs
+#define STREAM_INTERVAL_MS  0      // Least time between streamed frames (0 = as fast as the link takes them)
+
+// Motion-gated streaming
+#define MOTION_CHECK_MS      250     // Scene check interval while streaming
+#define MOTION_HOLD_MS       3000    // Keep sending this long after the last motion
+#define MOTION_KEEPALIVE_MS  10000   // Thumbnail interval while the scene is still
+#define MOTION_THUMB_QUALITY 60      // fmt2jpg quality (0-100) of keepalive thumbnails
+
+// A frame on its way from the capture task to the transmit task
+typedef struct {
+  camera_fb_t* fb;             // Driver frame buffer, returned once sent
+  camera_fb_t thumb;           // Keepalive thumbnail when fb is null (fmt2jpg buffer, freed once sent)
+  bool wake;                   // First pictures after a deep-sleep wake
+  bool tiles;                  // Send as changed tiles (TILES ON when captured)
+  bool keyframe;               // Start the tiles over: this frame goes whole
+} CaptureJob;
+
+// Stream settings a command changes. Commands run in loop(): the capture
+// task applies them between frames, so a frame never sees half a change.
+enum CaptureRequest : uint8_t {
+  REQ_KEYFRAME,
+  REQ_MOTION_ON,
+  REQ_MOTION_OFF,
+  REQ_TILES_ON,
+  REQ_TILES_OFF
+};
 
 class CommandProcessor {
 private:
@@ -16,16 +53,79 @@ private:
   TransmissionManager* transmit;
   
   QueueHandle_t commandQueue;
+  QueueHandle_t capsQueue;       // Latest master panel announcement
+  QueueHandle_t requestQueue;    // CaptureRequest from commands
   
-  bool streamingMode;
+  // Pipeline: the capture task hands one frame at a time to the transmit task
+  QueueHandle_t frameQueue;
+  TaskHandle_t captureTaskHandle;
+  TaskHandle_t transmitTaskHandle;
+  
+  volatile bool streamingMode;
+  volatile bool captureRequested;   // Single frame (CAPTURE)
+  volatile uint32_t requestTime;    // Frames exposed before this are stale
+  volatile bool wakeShot;           // Next single frame is preceded by a thumbnail
+  unsigned long lastCommandTime;
   unsigned long lastStreamTime;
-  unsigned long streamInterval;  // 500ms = 2 FPS
+  
+  // Cameras sharing the master (CAPS): each keeps the channel busy at most
+  // 1/airtimeShare of the time
+  uint8_t airtimeShare;
+  volatile uint32_t lastSendMs;     // Time the last frame took to send
+  
+  // Motion gating: full frames only while something moves. The capture
+  // task owns the motion and tile settings below.
+  MotionDetector motion;
+  bool motionMode;
+  bool motionActive;
+  unsigned long lastMotionTime;
+  unsigned long lastKeepaliveTime;
+  uint8_t* thumbBuffer;        // 1/4 scale RGB565 decode of the last frame
+  uint8_t* lumaBuffer;
+  uint16_t thumbWidth;
+  uint16_t thumbHeight;
+  int motionEvents;
+  int framesGated;
+  int keepalivesSent;
+  
+  // Tile delta: only the tiles that changed since the last frame are sent.
+  // The encoder belongs to the transmit task; keyframes reach it with the
+  // next frame (CaptureJob::keyframe).
+  TileEncoder tiles;
+  bool tileMode;
+  bool keyframeDue;
+  
+  // Per-stage timing, summed over the frames that went through each stage
+  uint32_t framesCaptured;
+  uint32_t framesTransmitted;
+  uint64_t captureUs;          // Waiting for the sensor (esp_camera_fb_get)
+  uint64_t checkUs;            // Motion checks and thumbnails
+  uint64_t handoffUs;          // Capture task held up by the transmit task
+  uint64_t sendUs;             // Tiles, packets, parity and repairs
+  uint32_t lastStatusFrames;
+  unsigned long lastStatusTime;
   
   static CommandProcessor* instance;
+  static const CamMsgHandler handlers[CAM_MSG_TYPE_COUNT];
   static void onCommandReceived(const uint8_t* mac, const uint8_t* data, int len);
+  static void onCommand(const uint8_t* mac, const uint8_t* data, int len);
+  static void onNack(const uint8_t* mac, const uint8_t* data, int len);
+  static void onTextMessage(const uint8_t* mac, const uint8_t* data, int len);
+  static void onCaps(const uint8_t* mac, const uint8_t* data, int len);
+  static void captureTask(void* param);
+  static void transmitTask(void* param);
   
   void executeCommand(const CommandPacket& cmd);
-  void captureAndSend();
+  void request(CaptureRequest req);
+  void applyRequests();
+  void captureNext();
+  bool gateMotion(camera_fb_t* fb, CaptureJob& job);
+  bool detectMotion(camera_fb_t* fb);
+  bool decodeThumbnail(camera_fb_t* fb);
+  bool makeThumbnail(camera_fb_t& thumb);
+  void sendJob(CaptureJob& job);
+  bool sendCaptured(camera_fb_t* fb, bool tiled);
+  void flushFrames();
   void processSerialInput();
   
 public:
@@ -34,9 +134,10 @@ public:
   void setTransmissionManager(TransmissionManager* trans) { transmit = trans; }
   bool begin();
   void processCommands();
-  void handleStreaming();
+  void sendWakeFrames();
   void printStatus();
   bool isStreaming() { return streamingMode; }
+  unsigned long getLastCommandTime() { return lastCommandTime; }
 };
 
 #endif
\ No newline at end of file
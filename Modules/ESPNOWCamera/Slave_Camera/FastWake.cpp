@@ -0,0 +1,69 @@
+// FastWake.cpp
+#include "FastWake.h"
+
+// Kept across deep sleep (reset on power-on)
+RTC_DATA_ATTR static uint32_t wakeCount = 0;
+
+FastWake::FastWake() {
+  woke = false;
+  radio = nullptr;
+  radioWaiter = nullptr;
+  radioReady = false;
+}
+
+// Returns true when WAKE_PIN woke the camera from deep sleep
+bool FastWake::begin() {
+  bootMark(BOOT_SETUP);
+
+  woke = (WAKE_PIN >= 0 && esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0);
+  if (woke) {
+    wakeCount++;
+    Serial.printf("[Slave] Woken by pin %d (wake #%lu)\n", WAKE_PIN, (unsigned long)wakeCount);
+  }
+  return woke;
+}
+
+uint32_t FastWake::getWakeCount() {
+  return wakeCount;
+}
+
+// Starts Wi-Fi and ESP-NOW on core 0; the caller initializes the camera in
+// the meantime and then calls waitRadio()
+void FastWake::startRadio(TransmissionManager* transmit) {
+  radio = transmit;
+  radioWaiter = xTaskGetCurrentTaskHandle();
+  radioReady = false;
+
+  if (xTaskCreatePinnedToCore(radioTask, "RadioUp", 4096, this, 2, nullptr, 0) != pdPASS) {
+    radioReady = radio->begin();  // No task: bring it up here
+    xTaskNotifyGive(radioWaiter);
+  }
+}
+
+void FastWake::radioTask(void* param) {
+  FastWake* self = (FastWake*)param;
+  self->radioReady = self->radio->begin();
+  xTaskNotifyGive(self->radioWaiter);
+  vTaskDelete(nullptr);
+}
+
+bool FastWake::waitRadio() {
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  return radioReady;
+}
+
+bool FastWake::sleepDue(bool streaming, unsigned long lastCommandTime) {
+  if (WAKE_PIN < 0 || streaming) return false;
+  return millis() - lastCommandTime > WAKE_AWAKE_MS;
+}
+
+// Deep sleep until WAKE_PIN reaches WAKE_LEVEL. The camera, viewport and
+// radio channel come back from RTC memory on the next wake.
+void FastWake::sleep() {
+  Serial.printf("[Slave] No commands for %d s, sleeping until pin %d wakes us\n",
+                WAKE_AWAKE_MS / 1000, WAKE_PIN);
+  Serial.flush();
+
+  esp_sleep_enable_ext0_wakeup((gpio_num_t)WAKE_PIN, WAKE_LEVEL);
+  esp_deep_sleep_start();
+}
@@ -0,0 +1,39 @@
+// FastWake.h
+// Battery door camera: deep sleep between visitors, and a wake path that
+// gets a picture to the master as early as possible
+#ifndef FAST_WAKE_H
+#define FAST_WAKE_H
+
+#include <Arduino.h>
+#include "esp_sleep.h"
+#include "TransmissionManager.h"
+#include "BootTimer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define WAKE_PIN        -1       // Doorbell/PIR input (RTC GPIO) that wakes the camera; -1 = never sleep
+#define WAKE_LEVEL      0        // Level on WAKE_PIN that wakes it
+#define WAKE_AWAKE_MS   30000    // Back to sleep this long after the last command
+
+class FastWake {
+private:
+  bool woke;                     // Started by WAKE_PIN rather than a power-on
+
+  // Radio bring-up on core 0 while setup() initializes the camera
+  TransmissionManager* radio;
+  TaskHandle_t radioWaiter;
+  volatile bool radioReady;
+  static void radioTask(void* param);
+
+public:
+  FastWake();
+  bool begin();
+  bool isWake() { return woke; }
+  uint32_t getWakeCount();
+  void startRadio(TransmissionManager* transmit);
+  bool waitRadio();
+  bool sleepDue(bool streaming, unsigned long lastCommandTime);
+  void sleep();
+};
+
+#endif
@@ -0,0 +1,280 @@
+// FrameSender.h
+#pragma once
+//
+// Sending side of the selective-repeat image stream, shared by the camera
+// sketches and the simulated link in sim/.
+//
+// Every frame in flight has a CamTxFrame slot. start() sends a frame as its
+// header (unicast to each receiver, even for a broadcast frame: broadcast
+// gets no MAC retries, and a display that misses the header drops the whole
+// frame), its data packets and the FEC parity packets of each block, once
+// by broadcast or to each receiver. The frame is then held until every
+// receiver it went to has acknowledged it. onNack() applies one receiver's
+// report: the packets it lists are resent to that receiver, or, for a
+// broadcast frame, merged with the other receivers' reports (NackMerge.h)
+// and resent by repair() once the round is complete. expire() gives up on
+// frames whose reports stopped or whose repair rounds ran out.
+//
+// Messages leave through the CamTxSendFunc given to begin(), tagged with a
+// CamTxKind, so the caller decides how each goes out: sent right away, or
+// queued for a packet task with repairs at the front of the queue so they
+// do not wait behind the next frame. A finished frame (acknowledged or
+// given up) frees its slot and is passed to the CamTxDoneFunc, which
+// returns the caller's buffer. Time is passed in.
+//
+// Place this file alongside your .ino files and #include "FrameSender.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <string.h>
+#endif
+#include "CameraProtocol.h"
+#include "PacketFec.h"
+#include "NackMerge.h"
+
+#define CAM_TX_BROADCAST -1   // dest of a message for every receiver
+
+enum CamTxKind : uint8_t {
+  CAM_TX_HEADER,   // ImageHeader of a frame, sent before its packets
+  CAM_TX_PACKET,   // Data or parity packet of the first pass
+  CAM_TX_REPAIR    // Data packet resent after a NACK
+};
+
+typedef struct {
+  const uint8_t* data;          // nullptr = free
+  uint32_t len;
+  void* owner;                  // The caller's buffer, returned once done
+  uint16_t frameId;
+  uint16_t totalPackets;
+  uint8_t layer;                // CamLayer
+  uint8_t waiting;              // Receivers (bits) that have not acknowledged it
+  bool broadcast;               // Sent once for all its receivers
+  NackMerge merge;              // Repair requests of this round (broadcast only)
+  uint8_t rounds;               // Repair rounds served
+  uint32_t lastActivity;        // Last send or report
+} CamTxFrame;
+
+// dest is a receiver index or CAM_TX_BROADCAST; msg is sealed
+typedef void (*CamTxSendFunc)(void* ctx, int8_t dest, const void* msg, uint16_t len, CamTxKind kind);
+typedef void (*CamTxDoneFunc)(void* ctx, CamTxFrame& frame, bool acked);
+
+class FrameSender {
+private:
+  CamTxFrame* frames;
+  uint8_t count;
+  uint8_t fecGroup;
+  uint8_t fecParity;
+  bool repairsToFront;          // Repairs are queued at the front: emit them last first
+  CamTxSendFunc sendFunc;
+  CamTxDoneFunc doneFunc;
+  void* ctx;
+
+  void sendPacket(const CamTxFrame& frame, uint16_t packetNum, int8_t dest, CamTxKind kind) {
+    ImagePacket packet;
+    camInitHeader(packet.hdr, CAM_MSG_DATA, frame.frameId, packetNum);
+    packet.totalPackets = frame.totalPackets;
+
+    uint16_t dataSize = fecPacketSize(frame.len, packetNum);
+    memcpy(packet.data, frame.data + (uint32_t)packetNum * CAM_PACKET_PAYLOAD, dataSize);
+
+    // Only the used part of the payload goes on air
+    uint16_t len = CAM_PACKET_HEADER_SIZE + dataSize;
+    camSeal(&packet, len);
+    sendFunc(ctx, dest, &packet, len, kind);
+  }
+
+  void sendParity(const CamTxFrame& frame, uint16_t block, int8_t dest) {
+    ImagePacket packet;
+    packet.totalPackets = frame.totalPackets;
+
+    for (uint8_t cls = 0; cls < fecParity; cls++) {
+      camInitHeader(packet.hdr, CAM_MSG_PARITY, frame.frameId, block * fecParity + cls);
+      fecEncode(frame.data, frame.len, frame.totalPackets, fecGroup, fecParity, block, cls, packet.data);
+      camSeal(&packet, sizeof(packet));
+      sendFunc(ctx, dest, &packet, sizeof(packet), CAM_TX_PACKET);
+    }
+  }
+
+public:
+  FrameSender() : frames(nullptr), count(0), fecGroup(0), fecParity(0), repairsToFront(false),
+                  sendFunc(nullptr), doneFunc(nullptr), ctx(nullptr) {}
+
+  void begin(CamTxFrame* slots, uint8_t slotCount, CamTxSendFunc send, CamTxDoneFunc done, void* context,
+             bool toFront) {
+    frames = slots;
+    count = slotCount;
+    sendFunc = send;
+    doneFunc = done;
+    ctx = context;
+    repairsToFront = toFront;
+    for (uint8_t i = 0; i < count; i++) {
+      frames[i].data = nullptr;
+    }
+  }
+
+  // parity packets after every group data packets; group 0 turns FEC off
+  bool setFec(uint8_t group, uint8_t parity) {
+    if (group == 0) {
+      fecGroup = 0;
+      fecParity = 0;
+      return true;
+    }
+    if (group < 2 || group > FEC_MAX_GROUP || parity < 1 || parity > FEC_MAX_PARITY || parity > group) {
+      return false;
+    }
+    fecGroup = group;
+    fecParity = parity;
+    return true;
+  }
+
+  uint8_t getFecGroup() const { return fecGroup; }
+  uint8_t getFecParity() const { return fecParity; }
+
+  CamTxFrame* freeSlot() {
+    for (uint8_t i = 0; i < count; i++) {
+      if (!frames[i].data) return &frames[i];
+    }
+    return nullptr;
+  }
+
+  bool busy() const {
+    for (uint8_t i = 0; i < count; i++) {
+      if (frames[i].data) return true;
+    }
+    return false;
+  }
+
+  // Takes a free slot for len bytes of data and sends them to the receivers
+  // (bits) in waiting. header carries the caller's fields (size, format,
+  // quality, capture time, layer); the rest is filled in here.
+  void start(CamTxFrame& frame, const uint8_t* data, uint32_t len, void* owner, uint16_t id,
+             ImageHeader& header, uint8_t waiting, bool broadcast, uint32_t now) {
+    frame.data = data;
+    frame.len = len;
+    frame.owner = owner;
+    frame.frameId = id;
+    frame.totalPackets = (len + CAM_PACKET_PAYLOAD - 1) / CAM_PACKET_PAYLOAD;
+    frame.layer = header.layer;
+    frame.waiting = waiting;
+    frame.broadcast = broadcast;
+    frame.merge.begin(waiting);
+    frame.rounds = 0;
+
+    camInitHeader(header.hdr, CAM_MSG_HEADER, id, 0);
+    header.imageSize = len;
+    header.totalPackets = frame.totalPackets;
+    header.fecGroup = fecGroup;
+    header.fecParity = fecParity;
+    camSeal(&header, sizeof(header));
+    for (int8_t i = 0; i < 8; i++) {
+      if (waiting & (1 << i)) sendFunc(ctx, i, &header, sizeof(header), CAM_TX_HEADER);
+    }
+
+    // The packets once by broadcast, or to each receiver
+    int8_t dests[8];
+    int destCount = 0;
+    if (broadcast) {
+      dests[destCount++] = CAM_TX_BROADCAST;
+    } else {
+      for (int8_t i = 0; i < 8; i++) {
+        if (waiting & (1 << i)) dests[destCount++] = i;
+      }
+    }
+
+    for (uint16_t i = 0; i < frame.totalPackets; i++) {
+      for (int d = 0; d < destCount; d++) {
+        sendPacket(frame, i, dests[d], CAM_TX_PACKET);
+      }
+
+      // Close each FEC block with its parity packets
+      if (fecGroup > 0 && ((i + 1) % fecGroup == 0 || i == frame.totalPackets - 1)) {
+        for (int d = 0; d < destCount; d++) {
+          sendParity(frame, i / fecGroup, dests[d]);
+        }
+      }
+    }
+    frame.lastActivity = now;
+  }
+
+  // Frees the slot and hands the frame back to the caller
+  void finish(CamTxFrame& frame, bool acked) {
+    frame.data = nullptr;
+    if (doneFunc) doneFunc(ctx, frame, acked);
+  }
+
+  // Applies one receiver report to the frame it names; the ID keeps reports
+  // for different frames in flight apart. A frame is done once every
+  // receiver it went to has acknowledged it.
+  void onNack(uint8_t peer, const NackPacket& nack, uint32_t now) {
+    uint8_t peerBit = 1 << peer;
+    for (uint8_t i = 0; i < count; i++) {
+      CamTxFrame& frame = frames[i];
+      if (!frame.data || frame.frameId != nack.hdr.frameId || frame.totalPackets != nack.totalPackets) continue;
+      if (!(frame.waiting & peerBit)) return;
+
+      if (nack.missingCount == 0) {
+        frame.waiting &= ~peerBit;
+        frame.merge.ack(peer);
+        if (!frame.waiting) finish(frame, true);
+        return;
+      }
+      if (frame.rounds >= NACK_MAX_ROUNDS) return;
+
+      if (frame.broadcast) {
+        frame.merge.add(peer, nack, now);
+        frame.lastActivity = now;
+        return;
+      }
+
+      for (int n = 0; n < NACK_BITMAP_BYTES * 8; n++) {
+        int bit = repairsToFront ? NACK_BITMAP_BYTES * 8 - 1 - n : n;
+        if (!(nack.bitmap[bit >> 3] & (1 << (bit & 7)))) continue;
+
+        uint16_t packetNum = nack.firstPacket + bit;
+        if (packetNum < frame.totalPackets) sendPacket(frame, packetNum, peer, CAM_TX_REPAIR);
+      }
+      frame.rounds++;
+      frame.lastActivity = now;
+      return;
+    }
+  }
+
+  // Serves the merged repair round of each broadcast frame once all its
+  // receivers have reported: one rebroadcast per packet however many lost
+  // it, or a unicast when only one receiver asked
+  void repair(uint32_t now) {
+    for (uint8_t i = 0; i < count; i++) {
+      CamTxFrame& frame = frames[i];
+      if (!frame.data || !frame.broadcast || !frame.merge.ready(now)) continue;
+
+      uint8_t requesters = frame.merge.getRequesters();
+      int8_t dest = (requesters & (requesters - 1)) ? CAM_TX_BROADCAST : __builtin_ctz(requesters);
+      for (uint16_t n = 0; n < frame.totalPackets; n++) {
+        uint16_t packetNum = repairsToFront ? frame.totalPackets - 1 - n : n;
+        if (frame.merge.isMissing(packetNum)) sendPacket(frame, packetNum, dest, CAM_TX_REPAIR);
+      }
+      frame.merge.begin(frame.waiting);
+      frame.rounds++;
+      frame.lastActivity = now;
+    }
+  }
+
+  // Gives up on frames whose reports stopped or whose repair rounds ran
+  // out. Call it only while none of the frames' own packets are still
+  // waiting to go out, or they count as idle.
+  void expire(uint32_t now) {
+    for (uint8_t i = 0; i < count; i++) {
+      CamTxFrame& frame = frames[i];
+      if (!frame.data) continue;
+
+      uint32_t idle = now - frame.lastActivity;
+      if (idle > NACK_WAIT_MS * NACK_MAX_ROUNDS || (frame.rounds >= NACK_MAX_ROUNDS && idle > NACK_WAIT_MS)) {
+        finish(frame, false);
+      }
+    }
+  }
+};
@@ -0,0 +1,128 @@
+// MotionDetector.h
+#pragma once
+//
+// Fixed-point block-difference motion detector for the door camera.
+//
+// Works on a small grayscale thumbnail (the slave decodes its JPEG at 1/4
+// scale). The thumbnail is split into MOTION_BLOCK x MOTION_BLOCK blocks
+// and each block mean is compared with a slowly adapting reference. The
+// average change over all blocks is removed first, so auto-exposure steps
+// do not count as motion. A block near white or black follows such a step
+// only part of the way (its true level is hidden by the clipping), so it
+// may move anywhere between not at all and the average, and clipped blocks
+// are left out of the average. Motion is reported when at least
+// `minBlocks` blocks moved by more than `threshold` gray levels.
+//
+// Integer only, no Arduino dependencies: builds on a desktop compiler.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <stdlib.h>
+#endif
+
+#define MOTION_BLOCK         4      // Thumbnail pixels per block side
+#define MOTION_MAX_BLOCKS    1200   // 160x120 thumbnail at 4x4 blocks
+#define MOTION_THRESHOLD     12     // Gray levels a block mean must move
+#define MOTION_MIN_BLOCKS    3      // Blocks that must move at once
+#define MOTION_LEARN_SHIFT   3      // Reference follows the scene by 1/8 per check
+#define MOTION_CLIP_LOW      8      // Block means at or beyond these are clipped
+#define MOTION_CLIP_HIGH     247
+
+// Gray value of a big-endian RGB565 pixel (esp32-camera byte order)
+inline uint8_t motionLuma565(const uint8_t* px) {
+  uint16_t r = px[0] & 0xF8;
+  uint16_t g = ((px[0] & 0x07) << 5) | ((px[1] & 0xE0) >> 3);
+  uint16_t b = (px[1] & 0x1F) << 3;
+  return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+class MotionDetector {
+private:
+  uint16_t reference[MOTION_MAX_BLOCKS];   // Block means, 1/16 gray level units
+  uint16_t current[MOTION_MAX_BLOCKS];
+  uint16_t blocksX;
+  uint16_t blocksY;
+  bool primed;
+  uint8_t threshold;
+  uint16_t minBlocks;
+  uint16_t changedBlocks;
+
+  static bool clipped(uint16_t mean) {
+    return mean <= (MOTION_CLIP_LOW << 4) || mean >= (MOTION_CLIP_HIGH << 4);
+  }
+
+public:
+  MotionDetector() : blocksX(0), blocksY(0), primed(false), threshold(MOTION_THRESHOLD),
+                     minBlocks(MOTION_MIN_BLOCKS), changedBlocks(0) {}
+
+  void setSensitivity(uint8_t levels, uint16_t blocks) {
+    threshold = levels;
+    minBlocks = blocks ? blocks : 1;
+  }
+
+  // Next update() only learns the scene
+  void reset() { primed = false; }
+
+  // luma: width * height gray pixels. Returns true when the scene moved.
+  bool update(const uint8_t* luma, uint16_t width, uint16_t height) {
+    uint16_t bx = width / MOTION_BLOCK;
+    uint16_t by = height / MOTION_BLOCK;
+    while (bx * by > MOTION_MAX_BLOCKS) by--;
+    uint16_t count = bx * by;
+    if (count == 0) return false;
+
+    for (uint16_t y = 0; y < by; y++) {
+      for (uint16_t x = 0; x < bx; x++) {
+        const uint8_t* p = luma + (uint32_t)y * MOTION_BLOCK * width + x * MOTION_BLOCK;
+        uint32_t sum = 0;
+        for (uint8_t row = 0; row < MOTION_BLOCK; row++, p += width) {
+          for (uint8_t col = 0; col < MOTION_BLOCK; col++) {
+            sum += p[col];
+          }
+        }
+        current[y * bx + x] = (sum << 4) / (MOTION_BLOCK * MOTION_BLOCK);
+      }
+    }
+
+    if (!primed || bx != blocksX || by != blocksY) {
+      for (uint16_t i = 0; i < count; i++) reference[i] = current[i];
+      blocksX = bx;
+      blocksY = by;
+      primed = true;
+      changedBlocks = 0;
+      return false;
+    }
+
+    // Global brightness shift (exposure / gain change)
+    int32_t shift = 0;
+    uint16_t tracking = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      if (clipped(current[i]) && clipped(reference[i])) continue;
+      shift += (int32_t)current[i] - reference[i];
+      tracking++;
+    }
+    if (tracking) shift /= tracking;
+
+    changedBlocks = 0;
+    int32_t limit = (int32_t)threshold << 4;
+    for (uint16_t i = 0; i < count; i++) {
+      int32_t diff = (int32_t)current[i] - reference[i];
+      int32_t low = shift, high = shift;
+      if (clipped(reference[i]) || clipped(current[i])) {
+        if (low > 0) low = 0;
+        if (high < 0) high = 0;
+      }
+      int32_t off = diff < low ? low - diff : diff > high ? diff - high : 0;
+      if (off > limit) changedBlocks++;
+      reference[i] += diff / (1 << MOTION_LEARN_SHIFT);
+    }
+
+    return changedBlocks >= minBlocks;
+  }
+
+  uint16_t getChangedBlocks() { return changedBlocks; }
+  uint16_t getBlockCount() { return blocksX * blocksY; }
+};
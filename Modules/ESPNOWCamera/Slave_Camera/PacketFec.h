@@ -0,0 +1,98 @@
+// PacketFec.h
+#pragma once
+//
+// XOR parity forward error correction for the ESP-NOW image stream.
+//
+// Data packets are grouped in blocks of `group` packets and every block is
+// followed by `parity` parity packets. Parity packet `cls` of a block is the
+// XOR of the block's data packets whose position in the block is `cls`
+// modulo `parity`, so each block can rebuild one lost packet per class
+// (a burst of up to `parity` consecutive losses) without a round trip.
+// Parity packets travel as CAM_MSG_PARITY messages whose seq is
+// block * parity + class (see CameraProtocol.h).
+//
+// Keep this file identical in Master_Display, Slave_Camera and next to the
+// root ESPCAMSENDER / ESPNOWCAMRECIEVER sketches.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <string.h>
+#endif
+
+#define FEC_PAYLOAD_SIZE 240
+#define FEC_MAX_GROUP    32
+#define FEC_MAX_PARITY   4
+
+inline uint16_t fecBlockCount(uint16_t totalPackets, uint8_t group) {
+  return group ? (totalPackets + group - 1) / group : 0;
+}
+
+// Total parity packets sent for a frame (0 when FEC is off)
+inline uint16_t fecParityCount(uint16_t totalPackets, uint8_t group, uint8_t parity) {
+  return fecBlockCount(totalPackets, group) * parity;
+}
+
+// Bytes of the frame carried by data packet `packetNum`
+inline uint16_t fecPacketSize(uint32_t frameSize, uint16_t packetNum) {
+  uint32_t start = (uint32_t)packetNum * FEC_PAYLOAD_SIZE;
+  if (start >= frameSize) return 0;
+  uint32_t remaining = frameSize - start;
+  return remaining < FEC_PAYLOAD_SIZE ? remaining : FEC_PAYLOAD_SIZE;
+}
+
+inline void fecXor(uint8_t* dst, const uint8_t* src, uint16_t len) {
+  uint16_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    uint32_t a, b;
+    memcpy(&a, dst + i, 4);
+    memcpy(&b, src + i, 4);
+    a ^= b;
+    memcpy(dst + i, &a, 4);
+  }
+  for (; i < len; i++) {
+    dst[i] ^= src[i];
+  }
+}
+
+// Builds parity packet `cls` of `block` into out[FEC_PAYLOAD_SIZE].
+// Short final packets count as zero-padded to FEC_PAYLOAD_SIZE.
+inline void fecEncode(const uint8_t* frame, uint32_t frameSize, uint16_t totalPackets,
+                      uint8_t group, uint8_t parity, uint16_t block, uint8_t cls,
+                      uint8_t* out) {
+  memset(out, 0, FEC_PAYLOAD_SIZE);
+  uint16_t first = block * group;
+  for (uint16_t i = first + cls; i < first + group && i < totalPackets; i += parity) {
+    fecXor(out, frame + (uint32_t)i * FEC_PAYLOAD_SIZE, fecPacketSize(frameSize, i));
+  }
+}
+
+// Rebuilds the single missing data packet of (block, cls) from its parity
+// packet. `received` is a bitset with one bit per data packet (64 per word).
+// Returns the recovered packet number, or -1 if nothing is missing or more
+// than one packet of the class is lost.
+inline int fecRecover(uint8_t* frame, uint32_t frameSize, const uint64_t* received,
+                      uint16_t totalPackets, uint8_t group, uint8_t parity,
+                      uint16_t block, uint8_t cls, const uint8_t* parityData) {
+  uint16_t first = block * group;
+  int missing = -1;
+  for (uint16_t i = first + cls; i < first + group && i < totalPackets; i += parity) {
+    if (!((received[i >> 6] >> (i & 63)) & 1)) {
+      if (missing >= 0) return -1;
+      missing = i;
+    }
+  }
+  if (missing < 0) return -1;
+
+  uint8_t rebuilt[FEC_PAYLOAD_SIZE];
+  memcpy(rebuilt, parityData, FEC_PAYLOAD_SIZE);
+  for (uint16_t i = first + cls; i < first + group && i < totalPackets; i += parity) {
+    if (i != missing) {
+      fecXor(rebuilt, frame + (uint32_t)i * FEC_PAYLOAD_SIZE, fecPacketSize(frameSize, i));
+    }
+  }
+  memcpy(frame + (uint32_t)missing * FEC_PAYLOAD_SIZE, rebuilt, fecPacketSize(frameSize, missing));
+  return missing;
+}
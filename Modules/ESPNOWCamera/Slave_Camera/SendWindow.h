@@ -0,0 +1,136 @@
+// SendWindow.h
+#pragma once
+//
+// Completion-driven pacing for ESP-NOW senders.
+//
+// esp_now_send() only queues a frame; the send callback reports when the
+// MAC layer has delivered it (or given up). Instead of sleeping a fixed
+// time per packet, a sender keeps at most getWindow() packets between
+// esp_now_send() and their callback and sends the next one as soon as a
+// completion frees a place.
+//
+// The window grows by about one packet per window of successful sends and
+// is halved on ESP_NOW_SEND_FAIL (AIMD), so a clean channel runs at full
+// rate and a congested one backs off.
+//
+// Call onSent() right before esp_now_send(), onRejected() if the call
+// itself fails, and onComplete() from the send callback. Waiting for room
+// is left to the caller (see the sketches), so this file also builds on a
+// desktop compiler.
+//
+// Place this file alongside your .ino files and #include "SendWindow.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+#endif
+#include <atomic>
+
+#define SEND_WINDOW_MIN        1
+#define SEND_WINDOW_MAX        8     // ESP-NOW queues only a few frames internally
+#define SEND_WINDOW_INITIAL    4
+#define SEND_WINDOW_TIMEOUT_MS 50    // Completion overdue: assume it was lost
+#define SEND_WINDOW_RATE_MS    1000  // Rate measurement period
+
+class SendWindow {
+private:
+  std::atomic<uint16_t> inFlight;   // Sent, callback not seen yet
+  std::atomic<uint32_t> windowQ8;   // Window in 1/256 packets
+  std::atomic<uint32_t> backoffs;   // Both sides
+  uint32_t completed;               // Callback side counters
+  uint32_t failed;
+  uint32_t periodStart;
+  uint32_t periodCount;
+  uint32_t rate;                    // Packets per second, last full period
+
+  // The sender task (onRejected, expire) and the send callback both change
+  // the window, so every update is a compare-and-swap of the value it read
+  void decrease() {
+    uint32_t w = windowQ8.load(std::memory_order_relaxed);
+    uint32_t next;
+    do {
+      next = w / 2;
+      if (next < SEND_WINDOW_MIN * 256) next = SEND_WINDOW_MIN * 256;
+    } while (!windowQ8.compare_exchange_weak(w, next, std::memory_order_relaxed));
+    backoffs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void increase() {
+    uint32_t w = windowQ8.load(std::memory_order_relaxed);
+    uint32_t next;
+    do {
+      next = w + (256 * 256) / w;
+      if (next > SEND_WINDOW_MAX * 256) next = SEND_WINDOW_MAX * 256;
+    } while (!windowQ8.compare_exchange_weak(w, next, std::memory_order_relaxed));
+  }
+
+  void release() {
+    uint16_t n = inFlight.load(std::memory_order_relaxed);
+    while (n > 0 && !inFlight.compare_exchange_weak(n, n - 1, std::memory_order_release)) {}
+  }
+
+public:
+  SendWindow() : inFlight(0), windowQ8(SEND_WINDOW_INITIAL * 256), backoffs(0), completed(0), failed(0),
+                 periodStart(0), periodCount(0), rate(0) {}
+
+  // -------- Sender side --------
+
+  bool canSend() {
+    return inFlight.load(std::memory_order_acquire) < getWindow();
+  }
+
+  void onSent() {
+    inFlight.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // esp_now_send() refused the frame (usually ESP_ERR_ESPNOW_NO_MEM):
+  // no callback will follow, and the stack is full, so back off
+  void onRejected() {
+    release();
+    decrease();
+  }
+
+  // No callback for SEND_WINDOW_TIMEOUT_MS: forget the outstanding packets
+  // rather than stall the sender forever
+  void expire() {
+    inFlight.store(0, std::memory_order_release);
+    decrease();
+  }
+
+  // -------- Send callback side --------
+
+  void onComplete(bool success, uint32_t now) {
+    release();
+    completed++;
+
+    if (success) {
+      // Additive increase: +1 packet per window of successful sends
+      increase();
+    } else {
+      failed++;
+      decrease();
+    }
+
+    periodCount++;
+    if (now - periodStart >= SEND_WINDOW_RATE_MS) {
+      rate = (uint64_t)periodCount * 1000 / (now - periodStart);
+      periodStart = now;
+      periodCount = 0;
+    }
+  }
+
+  // -------- Stats --------
+
+  uint16_t getWindow() { return windowQ8.load(std::memory_order_relaxed) >> 8; }
+  uint16_t getInFlight() { return inFlight.load(std::memory_order_relaxed); }
+  uint32_t getRate() { return rate; }
+  uint32_t getCompleted() { return completed; }
+  uint32_t getFailed() { return failed; }
+  uint32_t getBackoffs() { return backoffs.load(std::memory_order_relaxed); }
+};
+
+static_assert(SEND_WINDOW_MIN >= 1 && SEND_WINDOW_MIN <= SEND_WINDOW_INITIAL && SEND_WINDOW_INITIAL <= SEND_WINDOW_MAX,
+              "SendWindow limits out of order");
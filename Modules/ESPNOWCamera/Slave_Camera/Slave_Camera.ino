@@ -2,30 +2,35 @@
 #include "CameraModule.h"
 #include "TransmissionManager.h"
 #include "CommandProcessor.h"
+#include "FastWake.h"
 
 CameraModule camera;
 TransmissionManager transmit;
 CommandProcessor cmdProc;
+FastWake fastWake;
 
 void setup() {
   Serial.begin(115200);
+  bool woke = fastWake.begin();
   Serial.println("=== Slave Camera Module ===");
   
   // Turn off LED to reduce power/heat
   pinMode(48, OUTPUT);
   digitalWrite(48, LOW);
   
-  // Initialize camera
+  // Radio comes up on core 0 while the camera initializes here
+  fastWake.startRadio(&transmit);
+  
   if (!camera.begin()) {
     Serial.println("Camera init failed!");
     ESP.restart();
   }
   
-  // Initialize transmission
-  if (!transmit.begin()) {
+  if (!fastWake.waitRadio()) {
     Serial.println("Transmission init failed!");
     ESP.restart();
   }
+  bootMark(BOOT_READY);
   
   // Link modules
   cmdProc.setCameraModule(&camera);
@@ -37,17 +42,27 @@ void setup() {
     ESP.restart();
   }
   
+  // Door camera: get a picture to the master before anything else
+  if (woke) {
+    cmdProc.sendWakeFrames();
+    return;
+  }
+  bootReport("boot");
+  
   Serial.println("Slave camera ready!");
   Serial.println("Waiting for commands from master...");
   Serial.println("Type 'HELP' for messaging commands\n");
 }
 
 void loop() {
-  // Process incoming commands from master
+  // Process incoming commands from master; frames are captured and sent
+  // by the CommandProcessor's capture and transmit tasks
   cmdProc.processCommands();
   
-  // Handle streaming if active
-  cmdProc.handleStreaming();
+  // Door camera: back to deep sleep once the master stops asking for frames
+  if (fastWake.sleepDue(cmdProc.isStreaming(), cmdProc.getLastCommandTime())) {
+    fastWake.sleep();
+  }
   
   // Periodic status
   static unsigned long lastStatus = 0;
@@ -0,0 +1,171 @@
+// TileEncoder.cpp
+#include "TileEncoder.h"
+
+TileEncoder::TileEncoder() {
+  rgbBuffer = nullptr;
+  tileBuffer = nullptr;
+  deltaBuffer = nullptr;
+  haveReference = false;
+  framesSinceKey = 0;
+  keyframes = 0;
+  deltaFrames = 0;
+  skippedFrames = 0;
+  tilesSent = 0;
+  deltaBytes = 0;
+  replacedBytes = 0;
+}
+
+bool TileEncoder::begin() {
+  size_t rgbSize = TILE_MAX_WIDTH * TILE_MAX_HEIGHT * 2;
+  rgbBuffer = (uint8_t*)(psramFound() ? ps_malloc(rgbSize) : malloc(rgbSize));
+  tileBuffer = (uint8_t*)malloc(CAM_TILE_SIZE * CAM_TILE_SIZE * 2);
+  deltaBuffer = (uint8_t*)(psramFound() ? ps_malloc(TILE_FRAME_SIZE) : malloc(TILE_FRAME_SIZE));
+  if (!rgbBuffer || !tileBuffer || !deltaBuffer) {
+    Serial.println("Failed to allocate tile buffers!");
+    return false;
+  }
+  return true;
+}
+
+// Compares a tile's 8x8 block means with its stored signature and returns
+// true when any block moved by more than TILE_THRESHOLD. The signature is
+// replaced only then (or when `force` is set), so a slow drift still adds
+// up to a change instead of being learned away.
+bool TileEncoder::signTile(uint16_t col, uint16_t row, uint16_t width, uint16_t height, bool force) {
+  uint8_t* sig = signatures[row * TILE_COLS + col];
+  uint16_t x0 = col * CAM_TILE_SIZE;
+  uint16_t y0 = row * CAM_TILE_SIZE;
+  uint8_t current[TILE_SIG_SIZE];
+  bool changed = false;
+  uint8_t block = 0;
+
+  for (uint16_t by = y0; by < y0 + CAM_TILE_SIZE; by += TILE_SIG_BLOCK) {
+    for (uint16_t bx = x0; bx < x0 + CAM_TILE_SIZE; bx += TILE_SIG_BLOCK, block++) {
+      current[block] = sig[block];
+      if (bx + TILE_SIG_BLOCK > width || by + TILE_SIG_BLOCK > height) continue;  // Past the frame edge
+
+      uint32_t sum = 0;
+      for (uint16_t y = by; y < by + TILE_SIG_BLOCK; y++) {
+        const uint8_t* p = rgbBuffer + ((uint32_t)y * width + bx) * 2;
+        for (uint16_t x = 0; x < TILE_SIG_BLOCK; x++, p += 2) {
+          sum += motionLuma565(p);
+        }
+      }
+      current[block] = sum / (TILE_SIG_BLOCK * TILE_SIG_BLOCK);
+      if (abs((int)current[block] - sig[block]) > TILE_THRESHOLD) changed = true;
+    }
+  }
+
+  if (changed || force) {
+    memcpy(sig, current, TILE_SIG_SIZE);
+  }
+  return changed;
+}
+
+void TileEncoder::signAll(uint16_t width, uint16_t height) {
+  for (uint16_t row = 0; row * CAM_TILE_SIZE < height; row++) {
+    for (uint16_t col = 0; col * CAM_TILE_SIZE < width; col++) {
+      signTile(col, row, width, height, true);
+    }
+  }
+}
+
+// JPEG-encodes one tile of the decode into the delta frame at `pos`.
+// Returns the position after it, or 0 when it does not fit.
+uint32_t TileEncoder::appendTile(uint16_t col, uint16_t row, uint16_t width, uint16_t height, uint32_t pos) {
+  uint16_t x0 = col * CAM_TILE_SIZE;
+  uint16_t y0 = row * CAM_TILE_SIZE;
+  uint16_t w = min((uint16_t)CAM_TILE_SIZE, (uint16_t)(width - x0));
+  uint16_t h = min((uint16_t)CAM_TILE_SIZE, (uint16_t)(height - y0));
+
+  for (uint16_t y = 0; y < h; y++) {
+    memcpy(tileBuffer + (uint32_t)y * w * 2, rgbBuffer + ((uint32_t)(y0 + y) * width + x0) * 2, w * 2);
+  }
+
+  uint8_t* jpg = nullptr;
+  size_t jpgLen = 0;
+  if (!fmt2jpg(tileBuffer, w * h * 2, w, h, PIXFORMAT_RGB565, TILE_JPEG_QUALITY, &jpg, &jpgLen)) {
+    return 0;
+  }
+
+  uint32_t next = 0;
+  if (pos + sizeof(CamTileRecord) + jpgLen <= TILE_FRAME_SIZE) {
+    CamTileRecord record;
+    record.col = col;
+    record.row = row;
+    record.length = jpgLen;
+    memcpy(deltaBuffer + pos, &record, sizeof(record));
+    memcpy(deltaBuffer + pos + sizeof(record), jpg, jpgLen);
+    next = pos + sizeof(record) + jpgLen;
+  }
+  free(jpg);
+  return next;
+}
+
+// Decides how a captured frame goes out. For TILE_DELTA, `delta` describes
+// the tile frame to send instead of `fb`.
+TileResult TileEncoder::encode(camera_fb_t* fb, camera_fb_t& delta) {
+  uint16_t width = fb->width;
+  uint16_t height = fb->height;
+
+  // Frames larger than the decode buffer are always sent whole
+  if (width > TILE_MAX_WIDTH || height > TILE_MAX_HEIGHT) {
+    haveReference = false;
+    keyframes++;
+    return TILE_KEYFRAME;
+  }
+
+  if (!jpg2rgb565(fb->buf, fb->len, rgbBuffer, JPG_SCALE_NONE)) {
+    haveReference = false;
+    keyframes++;
+    return TILE_KEYFRAME;
+  }
+
+  if (!haveReference || ++framesSinceKey >= TILE_KEYFRAME_FRAMES) {
+    signAll(width, height);
+    haveReference = true;
+    framesSinceKey = 0;
+    keyframes++;
+    return TILE_KEYFRAME;
+  }
+
+  uint32_t pos = 0;
+  uint16_t changed = 0;
+  bool tooBig = false;
+  for (uint16_t row = 0; row * CAM_TILE_SIZE < height && !tooBig; row++) {
+    for (uint16_t col = 0; col * CAM_TILE_SIZE < width && !tooBig; col++) {
+      if (!signTile(col, row, width, height, false)) continue;
+
+      pos = appendTile(col, row, width, height, pos);
+      changed++;
+      if (pos == 0 || pos >= fb->len / 2) tooBig = true;
+    }
+  }
+
+  // Most of the scene changed: the camera JPEG is smaller than the tiles
+  if (tooBig) {
+    signAll(width, height);
+    framesSinceKey = 0;
+    keyframes++;
+    return TILE_KEYFRAME;
+  }
+
+  if (changed == 0) {
+    skippedFrames++;
+    return TILE_SKIP;
+  }
+
+  delta = {};
+  delta.buf = deltaBuffer;
+  delta.len = pos;
+  delta.width = width;
+  delta.height = height;
+  delta.format = PIXFORMAT_JPEG;
+  delta.timestamp = fb->timestamp;
+
+  deltaFrames++;
+  tilesSent += changed;
+  deltaBytes += pos;
+  replacedBytes += fb->len;
+  return TILE_DELTA;
+}
@@ -0,0 +1,68 @@
+// TileEncoder.h
+#ifndef TILE_ENCODER_H
+#define TILE_ENCODER_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "DataStructures.h"
+#include "MotionDetector.h"
+
+// Changed-tile delta frames (see CAM_FORMAT_TILES in CameraProtocol.h)
+#define TILE_MAX_WIDTH        320     // Largest frame decoded for tiling (QVGA)
+#define TILE_MAX_HEIGHT       240
+#define TILE_COLS             (TILE_MAX_WIDTH / CAM_TILE_SIZE)
+#define TILE_ROWS             ((TILE_MAX_HEIGHT + CAM_TILE_SIZE - 1) / CAM_TILE_SIZE)
+#define TILE_SIG_BLOCK        8       // Signature: mean gray level per 8x8 block
+#define TILE_SIG_SIZE         ((CAM_TILE_SIZE / TILE_SIG_BLOCK) * (CAM_TILE_SIZE / TILE_SIG_BLOCK))
+#define TILE_THRESHOLD        8       // Gray levels a signature block must move
+#define TILE_KEYFRAME_FRAMES  20      // Full frame at least this often
+#define TILE_JPEG_QUALITY     80      // fmt2jpg quality (0-100) of changed tiles
+#define TILE_FRAME_SIZE       32768   // Delta frame buffer
+
+enum TileResult {
+  TILE_SKIP,       // Nothing changed: send nothing
+  TILE_KEYFRAME,   // Send the camera JPEG as it is
+  TILE_DELTA       // Send the delta frame
+};
+
+class TileEncoder {
+private:
+  uint8_t* rgbBuffer;      // Full-scale RGB565 decode of the frame
+  uint8_t* tileBuffer;     // One tile, rows packed for fmt2jpg
+  uint8_t* deltaBuffer;
+
+  // Signature of every tile as the master last received it
+  uint8_t signatures[TILE_ROWS * TILE_COLS][TILE_SIG_SIZE];
+  bool haveReference;
+  int framesSinceKey;
+
+  int keyframes;
+  int deltaFrames;
+  int skippedFrames;
+  uint32_t tilesSent;
+  uint32_t deltaBytes;     // Bytes sent as delta frames...
+  uint32_t replacedBytes;  // ...and the full frames they stood in for
+
+  bool signTile(uint16_t col, uint16_t row, uint16_t width, uint16_t height, bool force);
+  void signAll(uint16_t width, uint16_t height);
+  uint32_t appendTile(uint16_t col, uint16_t row, uint16_t width, uint16_t height, uint32_t pos);
+
+public:
+  TileEncoder();
+  bool begin();
+  TileResult encode(camera_fb_t* fb, camera_fb_t& delta);
+
+  // Next frame is sent whole (start of stream, or the master may have
+  // missed a delta)
+  void forceKeyframe() { haveReference = false; }
+
+  int getKeyframes() { return keyframes; }
+  int getDeltaFrames() { return deltaFrames; }
+  int getSkippedFrames() { return skippedFrames; }
+  uint32_t getTilesSent() { return tilesSent; }
+  uint32_t getDeltaBytes() { return deltaBytes; }
+  uint32_t getReplacedBytes() { return replacedBytes; }
+};
+
+#endif
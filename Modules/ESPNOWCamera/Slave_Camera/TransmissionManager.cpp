@@ -3,24 +3,54 @@
 
 TransmissionManager* TransmissionManager::instance = nullptr;
 
+// Link that last worked, kept across deep sleep so a wake skips straight to
+// it (reset on power-on)
+RTC_DATA_ATTR static uint8_t savedMasterMac[6] = {0};
+RTC_DATA_ATTR static uint8_t savedChannel = 0;
+
 TransmissionManager::TransmissionManager() {
   instance = this;
   framesSent = 0;
   sendFailures = 0;
+  frameId = 0;
   totalTransmitTime = 0;
+  selectiveRepeat = true;
+  nackQueue = nullptr;
+  packetsRetransmitted = 0;
+  framesAcked = 0;
+  frameAcked = false;
+  headerFailed = false;
+  failedPackets = 0;
+  windowWaiter = nullptr;
+  sendMutex = nullptr;
+  powerSave = false;
+  sender.begin(&frame, 1, onFrameMessage, onFrameDone, this, false);
 }
 
 bool TransmissionManager::begin() {
   Serial.println("Initializing transmission...");
   
+  nackQueue = xQueueCreate(4, sizeof(NackPacket));
+  sendMutex = xSemaphoreCreateMutex();
+  if (!nackQueue || !sendMutex) {
+    Serial.println("Failed to create NACK queue!");
+    return false;
+  }
+  
   WiFi.mode(WIFI_STA);
-  WiFi.setSleep(true);  // Enable WiFi sleep to reduce power
+  setPowerSave(true);  // Until something is sent
+  if (savedChannel) {
+    esp_wifi_set_channel(savedChannel, WIFI_SECOND_CHAN_NONE);
+    memcpy(masterMac, savedMasterMac, 6);
+  }
+  bootMark(BOOT_WIFI);
   Serial.printf("Slave MAC: %s\n", WiFi.macAddress().c_str());
   
   if (esp_now_init() != ESP_OK) {
     Serial.println("ESP-NOW init failed!");
     return false;
   }
+  bootMark(BOOT_ESPNOW);
   
   esp_now_register_send_cb(onDataSent);
   
@@ -35,79 +65,105 @@ bool TransmissionManager::begin() {
     Serial.println("Failed to add peer!");
     return false;
   }
+  bootMark(BOOT_PEER);
   
   Serial.println("Transmission initialized successfully");
   return true;
 }
 
+// Modem sleep switches the receiver off between beacon intervals, and
+// ESP-NOW frames arriving then are lost, such as the NACKs a frame's repair
+// waits on. The transmit task turns it off while a stream runs or a frame
+// is in flight, and back on once the camera is idle.
+void TransmissionManager::setPowerSave(bool enabled) {
+  if (enabled == powerSave) return;
+  WiFi.setSleep(enabled);
+  powerSave = enabled;
+}
+
 void TransmissionManager::setMasterMac(uint8_t* mac) {
   memcpy(masterMac, mac, 6);
+  savedChannel = 0;  // Learn the new link on its first acknowledged send
   Serial.printf("Master MAC set to: %02X:%02X:%02X:%02X:%02X:%02X\n",
                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 }
 
+// Runs in the Wi-Fi task: advance the window and wake the sender
 void TransmissionManager::onDataSent(const uint8_t* mac, esp_now_send_status_t status) {
-  if (status == ESP_NOW_SEND_SUCCESS) {
-    // Packet sent successfully (comment out to reduce serial spam)
-    // Serial.print(".");
-  } else {
-    Serial.println("\n[Slave] Packet send FAILED!");
-    if (instance) {
-      instance->sendFailures++;
-    }
+  if (!instance) return;
+  
+  instance->window.onComplete(status == ESP_NOW_SEND_SUCCESS, millis());
+  if (status != ESP_NOW_SEND_SUCCESS) {
+    instance->sendFailures++;
+  } else if (!savedChannel) {
+    saveLink(mac);
+  }
+  if (instance->windowWaiter) {
+    xTaskNotifyGive(instance->windowWaiter);
   }
 }
 
-bool TransmissionManager::sendFrame(camera_fb_t* fb) {
+// Remembers the master and the channel of the first acknowledged send
+void TransmissionManager::saveLink(const uint8_t* mac) {
+  uint8_t primary;
+  wifi_second_chan_t second;
+  if (esp_wifi_get_channel(&primary, &second) == ESP_OK && primary) {
+    memcpy(savedMasterMac, mac, 6);
+    savedChannel = primary;
+  }
+}
+
+bool TransmissionManager::sendFrame(camera_fb_t* fb, uint8_t format) {
   if (!fb) {
     Serial.println("[Slave] Cannot send null frame!");
     return false;
   }
   
   unsigned long startTime = millis();
+  frameId++;
+  
+  uint16_t totalPackets = (fb->len + CAM_PACKET_PAYLOAD - 1) / CAM_PACKET_PAYLOAD;
+  Serial.printf("[Slave] Sending frame #%u: %d bytes, %d packets\n", frameId, fb->len, totalPackets);
   
-  Serial.printf("[Slave] Sending frame: %d bytes, %d packets\n", 
-                fb->len, (fb->len + 239) / 240);
+  // Drop reports that belong to earlier frames
+  xQueueReset(nackQueue);
   
-  // Send header first
   ImageHeader header;
-  header.imageSize = fb->len;
   header.width = fb->width;
   header.height = fb->height;
-  header.format = 0;
+  header.format = format;
   header.quality = 4;
   header.resolutionMode = 1;
+  header.layer = CAM_LAYER_FULL;
+  header.layers = 1;
+  // Re-encoded frames (thumbnails) carry no sensor time: stamp them now
+  if (fb->timestamp.tv_sec || fb->timestamp.tv_usec) {
+    header.captureMs = fb->timestamp.tv_sec * 1000UL + fb->timestamp.tv_usec / 1000;
+  } else {
+    header.captureMs = millis();
+  }
+  
+  // Header, data packets and each FEC block's parity packets, all sent
+  // before start() returns
+  failedPackets = 0;
+  headerFailed = false;
+  sender.start(frame, fb->buf, fb->len, fb, frameId, header, 1, false, millis());
   
-  esp_err_t result = esp_now_send(masterMac, (uint8_t*)&header, sizeof(header));
-  if (result != ESP_OK) {
+  if (headerFailed) {
     Serial.println("[Slave] Header send failed!");
+    sender.finish(frame, false);
     sendFailures++;
     return false;
   }
   
-  delay(10);  // Increased delay for header to be processed
-  
-  // Send image data in packets
-  uint16_t totalPackets = (fb->len + 239) / 240;
-  int failedPackets = 0;
-  
-  for (uint16_t i = 0; i < totalPackets; i++) {
-    ImagePacket packet;
-    packet.packetNum = i;
-    packet.totalPackets = totalPackets;
-    
-    uint32_t startIdx = i * 240;
-    uint32_t endIdx = min(startIdx + 240, (uint32_t)fb->len);
-    packet.dataSize = endIdx - startIdx;
-    
-    memcpy(packet.data, &fb->buf[startIdx], packet.dataSize);
-    
-    result = esp_now_send(masterMac, (uint8_t*)&packet, sizeof(packet));
-    if (result != ESP_OK) {
-      failedPackets++;
-    }
-    
-    delay(2);  // Small delay between packets
+  // Hold the frame until the master confirms it, resending only the gaps
+  if (!selectiveRepeat) {
+    sender.finish(frame, true);
+  } else if (repairFrame()) {
+    framesAcked++;
+    failedPackets = 0;
+  } else {
+    Serial.println("[Slave] Frame not acknowledged by master");
   }
   
   unsigned long transmitTime = millis() - startTime;
@@ -126,16 +182,89 @@ bool TransmissionManager::sendFrame(camera_fb_t* fb) {
   return true;
 }
 
+// FrameSender output: every message goes straight to the master
+void TransmissionManager::onFrameMessage(void* ctx, int8_t dest, const void* msg, uint16_t len, CamTxKind kind) {
+  TransmissionManager* self = (TransmissionManager*)ctx;
+  bool sent = self->sendMessage(msg, len);
+  if (kind == CAM_TX_HEADER) {
+    self->headerFailed = !sent;
+  } else if (!sent) {
+    self->failedPackets++;
+  }
+  if (kind == CAM_TX_REPAIR) {
+    self->packetsRetransmitted++;
+  }
+}
+
+void TransmissionManager::onFrameDone(void* ctx, CamTxFrame& frame, bool acked) {
+  ((TransmissionManager*)ctx)->frameAcked = acked;
+}
+
+bool TransmissionManager::sendMessage(const void* msg, size_t len) {
+  camSeal((void*)msg, len);
+  xSemaphoreTake(sendMutex, portMAX_DELAY);
+  
+  // Wait for a completion to free a place in the window
+  windowWaiter = xTaskGetCurrentTaskHandle();
+  while (!window.canSend()) {
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SEND_WINDOW_TIMEOUT_MS)) == 0) {
+      window.expire();
+    }
+  }
+  
+  window.onSent();
+  bool sent = esp_now_send(masterMac, (const uint8_t*)msg, len) == ESP_OK;
+  if (sent) {
+    bootMark(BOOT_FIRST_PACKET);
+  } else {
+    window.onRejected();
+  }
+  xSemaphoreGive(sendMutex);
+  return sent;
+}
+
+// Waits for the master's reports until it acknowledges the frame or
+// FrameSender gives up on it (NACK_MAX_ROUNDS rounds, or no report for
+// NACK_MAX_ROUNDS * NACK_WAIT_MS)
+bool TransmissionManager::repairFrame() {
+  NackPacket nack;
+  
+  while (frame.data) {
+    // A missing report means the master is still waiting for stragglers or
+    // the report itself was lost; the master repeats it after NACK_IDLE_MS
+    if (xQueueReceive(nackQueue, &nack, pdMS_TO_TICKS(NACK_WAIT_MS)) == pdTRUE) {
+      if (nack.missingCount > 0 && nack.hdr.frameId == frameId) {
+        Serial.printf("[Slave] NACK: resending %d packets from #%d\n",
+                      nack.missingCount, nack.firstPacket);
+      }
+      sender.onNack(0, nack, millis());
+    }
+    sender.expire(millis());
+  }
+  
+  return frameAcked;
+}
+
+bool TransmissionManager::setFec(uint8_t group, uint8_t parity) {
+  return sender.setFec(group, parity);
+}
+
+void TransmissionManager::handleNack(const NackPacket& nack) {
+  if (nackQueue) {
+    xQueueSend(nackQueue, &nack, 0);
+  }
+}
+
 bool TransmissionManager::sendTextMessage(const char* message) {
   TextMessagePacket msg;
+  memset(&msg, 0, sizeof(msg));
+  camInitHeader(msg.hdr, CAM_MSG_TEXT, 0, 0);
   strncpy(msg.message, message, sizeof(msg.message) - 1);
   msg.message[sizeof(msg.message) - 1] = '\0';
   msg.timestamp = millis();
   msg.fromMaster = 0;  // From slave
   
-  esp_err_t result = esp_now_send(masterMac, (uint8_t*)&msg, sizeof(msg));
-  
-  if (result == ESP_OK) {
+  if (sendMessage(&msg, sizeof(msg))) {
     Serial.printf("📤 [Message sent to Master]: %s\n", message);
     return true;
   } else {
@@ -153,4 +282,6 @@ void TransmissionManager::resetStats() {
   framesSent = 0;
   sendFailures = 0;
   totalTransmitTime = 0;
+  packetsRetransmitted = 0;
+  framesAcked = 0;
 }
\ No newline at end of file
@@ -6,6 +6,14 @@
 #include <esp_now.h>
 #include "esp_camera.h"
 #include "DataStructures.h"
+#include "SendWindow.h"
+#include "FrameSender.h"
+#include "BootTimer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 class TransmissionManager {
 private:
@@ -14,17 +22,58 @@ private:
   
   int framesSent;
   int sendFailures;
+  uint16_t frameId;     // Incremented for every frame; wraps at 65535
   unsigned long totalTransmitTime;
   
+  // Selective-repeat: frame is held until the master acknowledges it
+  bool selectiveRepeat;
+  QueueHandle_t nackQueue;
+  int packetsRetransmitted;
+  int framesAcked;
+  
+  // The frame in flight, sent and repaired by FrameSender (FEC off until
+  // setFec()); the sends block, so there is only ever one
+  FrameSender sender;
+  CamTxFrame frame;
+  bool frameAcked;
+  bool headerFailed;
+  int failedPackets;
+  
+  // Pacing: packets in flight are limited by the window, which advances on
+  // send completions instead of fixed delays
+  SendWindow window;
+  TaskHandle_t volatile windowWaiter;
+  SemaphoreHandle_t sendMutex;   // Text messages from loop() vs. the transmit task
+  bool powerSave;                // Wi-Fi modem sleep on
+  
   static TransmissionManager* instance;
   static void onDataSent(const uint8_t* mac, esp_now_send_status_t status);
+  static void saveLink(const uint8_t* mac);
+  
+  static void onFrameMessage(void* ctx, int8_t dest, const void* msg, uint16_t len, CamTxKind kind);
+  static void onFrameDone(void* ctx, CamTxFrame& frame, bool acked);
+  
+  bool repairFrame();
+  bool sendMessage(const void* msg, size_t len);
   
 public:
   TransmissionManager();
   bool begin();
-  bool sendFrame(camera_fb_t* fb);
+  bool sendFrame(camera_fb_t* fb, uint8_t format = CAM_FORMAT_JPEG);
   bool sendTextMessage(const char* message);
+  void handleNack(const NackPacket& nack);
+  void setSelectiveRepeat(bool enabled) { selectiveRepeat = enabled; }
+  bool isSelectiveRepeat() { return selectiveRepeat; }
+  int getRetransmitted() { return packetsRetransmitted; }
+  int getFramesAcked() { return framesAcked; }
+  bool setFec(uint8_t group, uint8_t parity);
+  uint8_t getFecGroup() { return sender.getFecGroup(); }
+  uint8_t getFecParity() { return sender.getFecParity(); }
+  uint16_t getWindow() { return window.getWindow(); }
+  uint32_t getSendRate() { return window.getRate(); }
+  uint32_t getBackoffs() { return window.getBackoffs(); }
   void setMasterMac(uint8_t* mac);
+  void setPowerSave(bool enabled);
   int getFramesSent() { return framesSent; }
   int getFailures() { return sendFailures; }
   unsigned long getAvgTransmitTime();
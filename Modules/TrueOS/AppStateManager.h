@@ -16,6 +16,7 @@
 #include "AboutUI.h"
 #include "ClockSettingsUI.h"
 #include "WallpaperManager.h"
+#include "ClipPlayerUI.h"
 #include "AudioManager.h"
 #include "ButtonHandle.h"
 
@@ -47,6 +48,7 @@ private:
     AboutUI* aboutUI;
     ClockSettingsUI* clockSettingsUI;
     WallpaperManager* wallpaperMgr;
+    ClipPlayerUI* clipPlayerUI;
     ButtonHandle* buttons; // âœ… Added button handler
     
     SystemMode currentMode;
@@ -197,7 +199,7 @@ public:
           wifiScanner(nullptr), credsMgr(nullptr), displayMgr(nullptr),
           keyboard(nullptr), aiAssistant(nullptr), aiChatUI(nullptr),
           menu(nullptr), settings(nullptr), aboutUI(nullptr), 
-          clockSettingsUI(nullptr), wallpaperMgr(nullptr), buttons(nullptr),
+          clockSettingsUI(nullptr), wallpaperMgr(nullptr), clipPlayerUI(nullptr), buttons(nullptr),
           currentMode(MODE_WATCH), previousMode(MODE_WATCH),
           selectedNetwork(0), scrollOffset(0), isScanning(false) {}
     
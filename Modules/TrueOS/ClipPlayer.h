@@ -0,0 +1,330 @@
+// ClipPlayer.h
+#pragma once
+//
+// Plays and scrubs recorded MJPEG AVI clips (ClipIndex.h) from FFat.
+//
+// Frames are read into a cache of CLIP_CACHE_FRAMES slots in PSRAM. A
+// reader task on core 0 fetches the frames just ahead of the position, in
+// the direction it last moved, so scrubbing and playback decode from memory
+// instead of waiting on flash. When the cache is full the frame farthest
+// from the position is replaced.
+//
+// update() says which frame to draw and how: while the position keeps
+// moving a frame is a preview, decoded at CLIP_PREVIEW_SCALE times the
+// normal reduction and blown up with clipZoomBlock(); once the position
+// rests for CLIP_SETTLE_MS the same frame is drawn again at full resolution.
+// Drawing is left to the device (DisplayManager on Master_Display,
+// ClipPlayerUI on TrueOS).
+//
+// Place this file alongside your .ino files and #include "ClipPlayer.h".
+// Keep every copy identical.
+//
+
+#include <Arduino.h>
+#include <FS.h>
+#include "ClipIndex.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define CLIP_CACHE_FRAMES   12    // Frames held in PSRAM
+#define CLIP_READ_AHEAD     6     // Fetched past the position, in the direction of travel
+#define CLIP_PREVIEW_SCALE  4     // Extra JPEG reduction while scrubbing
+#define CLIP_SETTLE_MS      150   // Position at rest this long: redraw at full resolution
+
+// Decode scale of a preview for a frame normally decoded at `scale`
+inline uint8_t clipPreviewScale(uint8_t scale) {
+  return scale * CLIP_PREVIEW_SCALE < 8 ? scale * CLIP_PREVIEW_SCALE : 8;
+}
+
+class ClipPlayer {
+private:
+  ClipIndex index;
+  File file;
+  bool opened;
+  char path[32];
+
+  // Cache: frame held by each slot, -1 when empty
+  uint8_t* slotData[CLIP_CACHE_FRAMES];
+  int32_t slotFrame[CLIP_CACHE_FRAMES];
+  uint32_t slotSize;
+  int8_t pinned;                   // Slot handed out by frameData(), never replaced
+
+  SemaphoreHandle_t lock;          // Cache table and file
+  TaskHandle_t readerTask;
+
+  // Position
+  volatile int32_t position;
+  volatile int8_t direction;
+  bool playing;
+  uint32_t playStartMs;
+  int32_t playStartFrame;
+  uint32_t lastMoveMs;             // Last seek or step
+  int32_t shownFrame;              // -1 until the first frame is drawn
+  bool shownPreview;
+
+  // Statistics
+  uint32_t cacheHits;
+  uint32_t cacheMisses;
+  uint32_t framesFetched;
+
+  static bool readAt(void* ctx, uint32_t offset, uint8_t* buf, uint32_t len) {
+    File* f = (File*)ctx;
+    return f->seek(offset) && f->read(buf, len) == len;
+  }
+
+  // Cache slots sized for the largest frame of the clip (PSRAM when present)
+  bool reserveCache(uint32_t size) {
+    if (size <= slotSize) return true;
+    size = (size + 4095) & ~4095u;
+    for (int i = 0; i < CLIP_CACHE_FRAMES; i++) {
+      free(slotData[i]);
+      slotData[i] = (uint8_t*)(psramFound() ? ps_malloc(size) : heap_caps_malloc(size, MALLOC_CAP_8BIT));
+      if (!slotData[i]) {
+        slotSize = 0;
+        return false;
+      }
+    }
+    slotSize = size;
+    return true;
+  }
+
+  int findSlot(int32_t frame) {
+    for (int i = 0; i < CLIP_CACHE_FRAMES; i++) {
+      if (slotFrame[i] == frame) return i;
+    }
+    return -1;
+  }
+
+  // Slot to overwrite: an empty one, else the frame farthest from the
+  // position (distance UINT32_MAX for an empty slot)
+  int victimSlot(uint32_t& distance) {
+    int victim = -1;
+    distance = 0;
+    for (int i = 0; i < CLIP_CACHE_FRAMES; i++) {
+      if (i == pinned) continue;
+      if (slotFrame[i] < 0) {
+        distance = UINT32_MAX;
+        return i;
+      }
+      uint32_t d = abs(slotFrame[i] - position);
+      if (victim < 0 || d > distance) {
+        victim = i;
+        distance = d;
+      }
+    }
+    return victim;
+  }
+
+  // Reads a frame into the cache unless it is there already and returns its
+  // slot, or -1. Read-ahead (required = false) never replaces a frame nearer
+  // to the position than the one it brings in. Caller holds lock.
+  int load(int32_t frame, bool required) {
+    int slot = findSlot(frame);
+    if (slot >= 0) return slot;
+
+    uint32_t distance;
+    slot = victimSlot(distance);
+    if (slot < 0) return -1;
+    if (!required && distance != UINT32_MAX && distance <= (uint32_t)abs(frame - position)) return -1;
+
+    const ClipFrame& f = index.frame(frame);
+    slotFrame[slot] = -1;
+    if (f.size > slotSize || !readAt(&file, f.offset, slotData[slot], f.size)) return -1;
+    slotFrame[slot] = frame;
+    framesFetched++;
+    return slot;
+  }
+
+  static void readerTaskFunc(void* param) {
+    ClipPlayer* self = (ClipPlayer*)param;
+
+    for (;;) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+      // Nearest first, then one frame behind; a new position (which
+      // notifies again) restarts the pass
+      int32_t start = self->position;
+      int8_t dir = self->direction;
+      for (int k = 1; k <= CLIP_READ_AHEAD + 1 && self->position == start; k++) {
+        int32_t frame = k <= CLIP_READ_AHEAD ? start + dir * k : start - dir;
+
+        xSemaphoreTake(self->lock, portMAX_DELAY);
+        if (self->opened && frame >= 0 && frame < (int32_t)self->index.getCount()) {
+          self->load(frame, false);
+        }
+        xSemaphoreGive(self->lock);
+      }
+    }
+  }
+
+  // Moves the position and wakes the reader
+  void moveTo(int32_t frame) {
+    int32_t last = (int32_t)index.getCount() - 1;
+    if (frame < 0) frame = 0;
+    if (frame > last) frame = last;
+    if (frame != position) direction = frame > position ? 1 : -1;
+    position = frame;
+    xTaskNotifyGive(readerTask);
+  }
+
+public:
+  ClipPlayer() {
+    opened = false;
+    path[0] = '\0';
+    for (int i = 0; i < CLIP_CACHE_FRAMES; i++) {
+      slotData[i] = nullptr;
+      slotFrame[i] = -1;
+    }
+    slotSize = 0;
+    pinned = -1;
+    lock = nullptr;
+    readerTask = nullptr;
+    position = 0;
+    direction = 1;
+    playing = false;
+    playStartMs = 0;
+    playStartFrame = 0;
+    lastMoveMs = 0;
+    shownFrame = -1;
+    shownPreview = false;
+    cacheHits = 0;
+    cacheMisses = 0;
+    framesFetched = 0;
+  }
+
+  // Opens a clip, paused on its first frame
+  bool open(fs::FS& fs, const char* clipPath) {
+    close();
+
+    if (!lock) {
+      lock = xSemaphoreCreateMutex();
+      if (!lock) return false;
+      xTaskCreatePinnedToCore(readerTaskFunc, "ClipReader", 4096, this, 1, &readerTask, 0);
+      if (!readerTask) return false;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    file = fs.open(clipPath, FILE_READ);
+    bool ok = file && index.open(readAt, &file, file.size()) && reserveCache(index.getLargest());
+    if (ok) {
+      opened = true;
+      strncpy(path, clipPath, sizeof(path) - 1);
+      path[sizeof(path) - 1] = '\0';
+      position = 0;
+      direction = 1;
+      playing = false;
+      lastMoveMs = millis() - CLIP_SETTLE_MS;
+      shownFrame = -1;
+      cacheHits = 0;
+      cacheMisses = 0;
+      framesFetched = 0;
+    } else if (file) {
+      file.close();
+    }
+    xSemaphoreGive(lock);
+
+    if (ok) xTaskNotifyGive(readerTask);
+    return ok;
+  }
+
+  void close() {
+    if (!lock) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (opened) file.close();
+    opened = false;
+    playing = false;
+    pinned = -1;
+    for (int i = 0; i < CLIP_CACHE_FRAMES; i++) slotFrame[i] = -1;
+    xSemaphoreGive(lock);
+  }
+
+  // Playback at the clip's own frame rate from the current frame
+  void play() {
+    if (!opened) return;
+    if (position >= (int32_t)index.getCount() - 1) moveTo(0);
+    playing = true;
+    playStartMs = millis();
+    playStartFrame = position;
+    direction = 1;
+  }
+
+  void pause() { playing = false; }
+
+  // Scrubbing: pauses and moves by `frames` (negative goes back)
+  void step(int32_t frames) {
+    if (!opened) return;
+    playing = false;
+    lastMoveMs = millis();
+    moveTo(position + frames);
+  }
+
+  // O(1) through the index
+  void seekMs(uint32_t ms) {
+    if (!opened) return;
+    playing = false;
+    lastMoveMs = millis();
+    moveTo(index.frameAt(ms));
+  }
+
+  // Frame to draw now, if any, and whether as a preview. Call every pass
+  // of the display loop.
+  bool update(uint32_t now, int32_t& frame, bool& preview) {
+    if (!opened) return false;
+
+    if (playing) {
+      int32_t due = playStartFrame + (int32_t)((uint64_t)(now - playStartMs) * 1000 / index.getUsPerFrame());
+      if (due >= (int32_t)index.getCount() - 1) playing = false;
+      moveTo(due);
+      if (position == shownFrame && !shownPreview) return false;
+      preview = false;
+    } else if (position != shownFrame) {
+      preview = (now - lastMoveMs < CLIP_SETTLE_MS);
+    } else if (shownPreview && now - lastMoveMs >= CLIP_SETTLE_MS) {
+      preview = false;
+    } else {
+      return false;
+    }
+
+    frame = position;
+    shownFrame = frame;
+    shownPreview = preview;
+    return true;
+  }
+
+  // Bytes of a frame, valid until the next call; read now when the reader
+  // has not fetched it yet
+  const uint8_t* frameData(int32_t frame, uint32_t& size) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    pinned = -1;
+    int slot = -1;
+    if (opened) {
+      slot = findSlot(frame);
+      if (slot >= 0) {
+        cacheHits++;
+      } else {
+        cacheMisses++;
+        slot = load(frame, true);
+      }
+    }
+    pinned = slot;
+    xSemaphoreGive(lock);
+
+    if (slot < 0) return nullptr;
+    size = index.frame(frame).size;
+    return slotData[slot];
+  }
+
+  bool isOpen() { return opened; }
+  bool isPlaying() { return playing; }
+  const char* getPath() { return path; }
+  int32_t getPosition() { return position; }
+  uint32_t getFrameCount() { return index.getCount(); }
+  uint16_t getWidth() { return index.getWidth(); }
+  uint16_t getHeight() { return index.getHeight(); }
+  uint32_t getTimeMs() { return index.timeOf(position); }
+  uint32_t getDurationMs() { return index.timeOf(index.getCount()); }
+  uint32_t getCacheHits() { return cacheHits; }
+  uint32_t getCacheMisses() { return cacheMisses; }
+  uint32_t getFramesFetched() { return framesFetched; }
+};
@@ -0,0 +1,267 @@
+// ClipPlayerUI.h - Event clip playback with encoder scrubbing
+#ifndef CLIPPLAYERUI_H
+#define CLIPPLAYERUI_H
+
+#include <TFT_eSPI.h>
+#include <TJpg_Decoder.h>
+#include <FFat.h>
+#include <AiEsp32RotaryEncoder.h>
+#include "Config.h"
+#include "Colors.h"
+#include "UIHelper.h"
+#include "ClipPlayer.h"
+
+#define MAX_CLIPS 20
+#define CLIPS_DIR "/clips"    // event_NNNN.avi files copied from the door display
+
+// Global sprite pointer and placement for TJpg callback
+TFT_eSprite* g_clipSprite = nullptr;
+int16_t g_clipX = 0;
+int16_t g_clipY = 0;
+uint8_t g_clipZoom = 1;       // > 1 while a preview is decoded at a reduced scale
+uint16_t g_clipZoomBlock[16 * 16];
+
+// TJpg callback: blocks of a preview are blown back up to frame size
+bool tjpgClipCallback(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+    if (!g_clipSprite) return 0;
+
+    if (g_clipZoom > 1) {
+        clipZoomBlock(bitmap, w, h, g_clipZoom, g_clipZoomBlock);
+        x *= g_clipZoom;
+        y *= g_clipZoom;
+        w *= g_clipZoom;
+        h *= g_clipZoom;
+        bitmap = g_clipZoomBlock;
+    }
+
+    if (g_clipY + y >= SCREEN_HEIGHT) return 0;
+    g_clipSprite->pushImage(g_clipX + x, g_clipY + y, w, h, bitmap);
+    return 1;
+}
+
+class ClipPlayerUI {
+private:
+    TFT_eSprite* sprite;
+    TFT_eSPI* tft;
+    AiEsp32RotaryEncoder* encoder;
+    ClipPlayer player;
+    String clips[MAX_CLIPS];
+    int clipCount;
+    int selectedClip;
+
+    void scanClips() {
+        clipCount = 0;
+
+        File root = FFat.open(CLIPS_DIR);
+        if (!root || !root.isDirectory()) {
+            Serial.println("[Clips] " CLIPS_DIR " directory not found");
+            return;
+        }
+
+        File file = root.openNextFile();
+        while (file && clipCount < MAX_CLIPS) {
+            String filename = String(file.name());
+            if (!file.isDirectory() && filename.endsWith(".avi")) {
+                clips[clipCount] = filename;
+                clipCount++;
+            }
+            file = root.openNextFile();
+        }
+
+        Serial.printf("[Clips] Total found: %d\n", clipCount);
+    }
+
+    // Frame scaled down by a JPEG scale (1, 2, 4, 8) until it fits the
+    // screen; previews decode smaller still and are zoomed back up
+    void drawFrame(int32_t frame, bool preview) {
+        uint16_t w = player.getWidth();
+        uint16_t h = player.getHeight();
+        uint8_t fit = 1;
+        while (fit < 8 && (w / fit > SCREEN_WIDTH || h / fit > SCREEN_HEIGHT)) fit *= 2;
+        uint8_t scale = preview ? clipPreviewScale(fit) : fit;
+
+        sprite->fillSprite(TFT_BLACK);
+
+        uint32_t size = 0;
+        const uint8_t* data = player.frameData(frame, size);
+        if (data) {
+            g_clipSprite = sprite;
+            g_clipX = (SCREEN_WIDTH - w / fit) / 2;
+            g_clipY = (SCREEN_HEIGHT - h / fit) / 2;
+            g_clipZoom = scale / fit;
+
+            TJpgDec.setJpgScale(scale);
+            TJpgDec.setSwapBytes(true);
+            TJpgDec.setCallback(tjpgClipCallback);
+            TJpgDec.drawJpg(0, 0, data, size);
+            TJpgDec.setJpgScale(1);
+
+            g_clipZoom = 1;
+            g_clipSprite = nullptr;
+        } else {
+            UIHelper::drawMessage(sprite, "Cannot read frame", COLOR_ERROR);
+        }
+
+        drawOverlay(frame);
+        sprite->pushSprite(0, 0);
+    }
+
+    void drawOverlay(int32_t frame) {
+        int barY = SCREEN_HEIGHT - 24;
+        for (int i = 0; i < 24; i++) {
+            uint8_t alpha = i * 8;
+            sprite->drawFastHLine(0, barY + i, SCREEN_WIDTH, sprite->color565(alpha / 8, alpha / 8, alpha / 8));
+        }
+
+        // Progress bar
+        int count = player.getFrameCount();
+        int fill = count > 1 ? (frame * (SCREEN_WIDTH - 20)) / (count - 1) : SCREEN_WIDTH - 20;
+        sprite->fillRoundRect(10, barY, SCREEN_WIDTH - 20, 4, 2, COLOR_CARD);
+        sprite->fillRoundRect(10, barY, fill, 4, 2, COLOR_ACCENT);
+
+        char text[32];
+        snprintf(text, sizeof(text), "%lu.%lu / %lu.%lu s",
+                 (unsigned long)(player.getTimeMs() / 1000), (unsigned long)(player.getTimeMs() % 1000 / 100),
+                 (unsigned long)(player.getDurationMs() / 1000), (unsigned long)(player.getDurationMs() % 1000 / 100));
+        sprite->setTextColor(TFT_WHITE);
+        sprite->setTextDatum(ML_DATUM);
+        sprite->drawString(text, 10, barY + 15, 1);
+
+        snprintf(text, sizeof(text), "%s  %ld/%lu", player.isPlaying() ? "PLAY" : "PAUSE",
+                 (long)frame + 1, (unsigned long)count);
+        sprite->setTextColor(player.isPlaying() ? COLOR_SUCCESS : COLOR_TEXT_DIM);
+        sprite->setTextDatum(MR_DATUM);
+        sprite->drawString(text, SCREEN_WIDTH - 10, barY + 15, 1);
+    }
+
+    // Rotate: scrub one frame per detent  |  Press: play/pause  |  HOME: back
+    void playClip(const String& filename) {
+        String fullPath = String(CLIPS_DIR) + "/" + filename;
+        if (!player.open(FFat, fullPath.c_str())) {
+            sprite->fillSprite(COLOR_BG);
+            UIHelper::drawHeader(sprite, "Event Clips", nullptr);
+            UIHelper::drawMessage(sprite, "Not a playable clip", COLOR_ERROR);
+            sprite->pushSprite(0, 0);
+            delay(1500);
+            return;
+        }
+        Serial.printf("[Clips] %s: %lu frames, %ux%u\n", fullPath.c_str(),
+                      (unsigned long)player.getFrameCount(), player.getWidth(), player.getHeight());
+
+        encoder->reset();
+        encoder->setBoundaries(-100000, 100000, false);
+        encoder->setEncoderValue(0);
+        int lastEncoderVal = 0;
+
+        while (true) {
+            if (encoder->encoderChanged()) {
+                int val = encoder->readEncoder();
+                if (val != lastEncoderVal) {
+                    player.step(val - lastEncoderVal);
+                    lastEncoderVal = val;
+                }
+            }
+
+            if (encoder->isEncoderButtonClicked()) {
+                if (player.isPlaying()) player.pause();
+                else player.play();
+                drawFrame(player.getPosition(), false);
+            }
+
+            // Exit
+            if (digitalRead(BTN_SPECIAL) == LOW) {
+                delay(300);
+                break;
+            }
+
+            int32_t frame;
+            bool preview;
+            if (player.update(millis(), frame, preview)) {
+                drawFrame(frame, preview);
+            } else {
+                delay(5);
+            }
+        }
+
+        Serial.printf("[Clips] Cache hits %lu, misses %lu\n",
+                      (unsigned long)player.getCacheHits(), (unsigned long)player.getCacheMisses());
+        player.close();
+    }
+
+    void drawList() {
+        sprite->fillSprite(COLOR_BG);
+
+        char subtitle[20];
+        snprintf(subtitle, sizeof(subtitle), "%d/%d", selectedClip + 1, clipCount);
+        UIHelper::drawHeader(sprite, "Event Clips", subtitle);
+
+        const int rowHeight = 30;
+        const int visible = (SCREEN_HEIGHT - HEADER_HEIGHT - FOOTER_HEIGHT) / rowHeight;
+        int first = constrain(selectedClip - visible / 2, 0, max(0, clipCount - visible));
+
+        for (int i = 0; i < visible && first + i < clipCount; i++) {
+            int y = HEADER_HEIGHT + 4 + i * rowHeight;
+            bool selected = (first + i == selectedClip);
+            sprite->fillRoundRect(8, y, SCREEN_WIDTH - 20, rowHeight - 4, 6, selected ? COLOR_SELECTED : COLOR_CARD);
+            if (selected) sprite->drawRoundRect(8, y, SCREEN_WIDTH - 20, rowHeight - 4, 6, COLOR_ACCENT);
+            sprite->setTextColor(selected ? COLOR_TEXT : COLOR_TEXT_DIM);
+            sprite->setTextDatum(ML_DATUM);
+            sprite->drawString(clips[first + i], 18, y + (rowHeight - 4) / 2, 2);
+        }
+
+        UIHelper::drawScrollbar(sprite, first, clipCount, visible);
+        UIHelper::drawFooter(sprite, "Rotate: Browse  |  Press: Play  |  HOME: Back");
+        sprite->pushSprite(0, 0);
+    }
+
+public:
+    ClipPlayerUI(TFT_eSprite* spr, AiEsp32RotaryEncoder* enc, TFT_eSPI* tftRef)
+        : sprite(spr), tft(tftRef), encoder(enc), clipCount(0), selectedClip(0) {}
+
+    void show() {
+        scanClips();
+
+        if (clipCount == 0) {
+            sprite->fillSprite(COLOR_BG);
+            UIHelper::drawHeader(sprite, "Event Clips", nullptr);
+            UIHelper::drawMessage(sprite, "No clips in " CLIPS_DIR, COLOR_ERROR);
+            UIHelper::drawFooter(sprite, "Press HOME to exit");
+            sprite->pushSprite(0, 0);
+
+            while (digitalRead(BTN_SPECIAL) != LOW) delay(10);
+            delay(300);
+            return;
+        }
+
+        selectedClip = constrain(selectedClip, 0, clipCount - 1);
+        encoder->reset();
+        encoder->setBoundaries(0, clipCount - 1, true);
+        encoder->setEncoderValue(selectedClip);
+        drawList();
+
+        while (true) {
+            if (encoder->encoderChanged()) {
+                selectedClip = encoder->readEncoder();
+                drawList();
+            }
+
+            if (encoder->isEncoderButtonClicked()) {
+                playClip(clips[selectedClip]);
+
+                encoder->reset();
+                encoder->setBoundaries(0, clipCount - 1, true);
+                encoder->setEncoderValue(selectedClip);
+                drawList();
+            }
+
+            // Exit
+            if (digitalRead(BTN_SPECIAL) == LOW) {
+                delay(300);
+                break;
+            }
+            delay(10);
+        }
+    }
+};
+
+#endif
@@ -22,7 +22,8 @@ enum AppMode {
     APP_THEME_SELECTOR,
     APP_WALLPAPER_CHANGER,
     APP_RESTART,
-    APP_FACTORY_RESET
+    APP_FACTORY_RESET,
+    APP_EVENT_CLIPS
 };
 
 struct MenuItem {
@@ -151,7 +152,9 @@ public:
                     "/menu_icons/about.jpg", COLOR_WARNING, APP_ABOUT_CREDITS, false};
         items[4] = {"Settings", "App configuration", 
                     "/menu_icons/settings.jpg", COLOR_ACCENT, APP_SETTINGS, false};
-        itemCount = 5;
+        items[5] = {"Event Clips", "Play and scrub door camera clips", 
+                    "/menu_icons/clips.jpg", COLOR_WARNING, APP_EVENT_CLIPS, false};
+        itemCount = 6;
     }
     
     void showSettings() {
@@ -193,7 +196,9 @@ public:
                     "/menu_icons/about.jpg", COLOR_WARNING, APP_ABOUT_CREDITS, false};
         items[4] = {"Settings", "App configuration", 
                     "/menu_icons/settings.jpg", COLOR_ACCENT, APP_SETTINGS, false};
-        itemCount = 5;
+        items[5] = {"Event Clips", "Play and scrub door camera clips", 
+                    "/menu_icons/clips.jpg", COLOR_WARNING, APP_EVENT_CLIPS, false};
+        itemCount = 6;
     }
     
     void draw() {
@@ -341,6 +341,12 @@ void AppStateManager::handleMenuSelection(AppMode selectedApp) {
         encoder->reset();
         encoder->setBoundaries(0, menu->getItemCount() - 1, true);
         encoder->setEncoderValue(menu->getSelected());
+    } else if (selectedApp == APP_EVENT_CLIPS) {
+        if (!clipPlayerUI) clipPlayerUI = new ClipPlayerUI(sprite, encoder, tft);
+        clipPlayerUI->show();
+        encoder->reset();
+        encoder->setBoundaries(0, menu->getItemCount() - 1, true);
+        encoder->setEncoderValue(menu->getSelected());
     }
 }
 
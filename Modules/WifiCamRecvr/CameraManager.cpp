@@ -6,7 +6,8 @@ CameraManager::CameraManager()
       currentFPS(0), avgFPS(0), lastFPSUpdate(0), lastFrameTime(0),
       connectionStatus(false), lastConnectionAttempt(0), pulseAlpha(0),
       pulseDirection(true), lastPulse(0), connectionDots(0), lastDotUpdate(0),
-      fpsBarWidth(0), targetFpsBarWidth(0), lastStatusUpdate(0) {}
+      fpsBarWidth(0), targetFpsBarWidth(0), lastStatusUpdate(0), stripRender(false),
+      shownWidth(0), shownHeight(0), decodeUs(0), pushUs(0) {}
 
 CameraManager::~CameraManager() {
     if (jpegBuffer) {
@@ -29,6 +30,11 @@ bool CameraManager::begin() {
         return false;
     }
     
+    if (CAMERA_STRIP_RENDER && display) {
+        stripRender = display->beginStrips();
+        Serial.println(stripRender ? "Camera: Rendering in DMA strips" : "Camera: DMA strips unavailable, using sprite");
+    }
+    
     client.setNoDelay(true);
     client.setTimeout(10000);
     
@@ -118,10 +124,34 @@ bool CameraManager::receiveFrame() {
     
     frameCount++;
     
-    TFT_eSprite* sprite = display->getMainSprite();
-    sprite->fillSprite(COLOR_BG_DARK);
+    unsigned long decodeStart = micros();
+    JRESULT result;
+    if (stripRender) {
+        // Straight to the panel above the status bar; the panel keeps the
+        // last frame, so the background is cleared only when the size changes
+        uint16_t w = 0, h = 0;
+        TJpgDec.getJpgSize(&w, &h, jpegBuffer, totalReceived);
+        if (w != shownWidth || h != shownHeight) {
+            display->getTFT()->fillRect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT - STATUS_BAR_HEIGHT, COLOR_BG_DARK);
+            shownWidth = w;
+            shownHeight = h;
+        }
+        
+        display->startStripFrame(0, 0, w, h, DISPLAY_HEIGHT - STATUS_BAR_HEIGHT);
+        result = TJpgDec.drawJpg(0, 0, jpegBuffer, totalReceived);
+        display->endStripFrame();
+        if (result == JDR_INTR) result = JDR_OK;  // Stopped at the status bar
+        
+        decodeUs = display->getStrips().getDecodeUs();
+        pushUs = display->getStrips().getWaitUs();
+    } else {
+        TFT_eSprite* sprite = display->getMainSprite();
+        sprite->fillSprite(COLOR_BG_DARK);
+        result = TJpgDec.drawJpg(0, 0, jpegBuffer, totalReceived);
+        decodeUs = micros() - decodeStart;
+    }
     
-    if (TJpgDec.drawJpg(0, 0, jpegBuffer, totalReceived) == JDR_OK) {
+    if (result == JDR_OK) {
         return true;
     } else {
         droppedFrames++;
@@ -141,6 +171,8 @@ void CameraManager::updateStatusBar() {
         lastFrameTime = now;
         frameCount = 0;
         targetFpsBarWidth = min(1.0f, currentFPS / 30.0f);
+        Serial.printf("Camera: %.1f FPS, decode %lu us, %s %lu us\n", currentFPS,
+                      (unsigned long)decodeUs, stripRender ? "DMA wait" : "push", (unsigned long)pushUs);
     }
     
     fpsBarWidth += (targetFpsBarWidth - fpsBarWidth) * 0.2;
@@ -216,6 +248,8 @@ void CameraManager::updateStatusBar() {
 void CameraManager::showDisconnectedScreen() {
     TFT_eSprite* sprite = display->getMainSprite();
     sprite->fillSprite(COLOR_BG_DARK);
+    shownWidth = 0;
+    shownHeight = 0;
     
     unsigned long now = millis();
     if (now - lastDotUpdate > 500) {
@@ -258,7 +292,11 @@ void CameraManager::update() {
     
     if (connectToServer()) {
         if (receiveFrame()) {
-            display->pushSprite();
+            if (!stripRender) {
+                unsigned long pushStart = micros();
+                display->pushSprite();
+                pushUs = micros() - pushStart;
+            }
             
             if (millis() - lastStatusUpdate > 100) {
                 updateStatusBar();
@@ -33,6 +33,13 @@ public:
     
     unsigned long lastStatusUpdate;
     
+    // Rendering: DMA strips straight to the panel, or the main sprite
+    bool stripRender;
+    uint16_t shownWidth;        // Frame size on the panel (strip mode)
+    uint16_t shownHeight;
+    uint32_t decodeUs;          // Stage timings of the last frame
+    uint32_t pushUs;            // pushSprite, or time waiting for strip DMA
+    
     bool connectToServer();
     bool receiveFrame();
     void updateStatusBar();
@@ -33,6 +33,11 @@
 // Memory settings
 #define MAX_JPEG_SIZE 50000
 
+// Camera rendering: 1 = decode straight to the panel through two DMA strips
+// (SPI overlaps decode), 0 = decode into the main sprite and push it
+#define CAMERA_STRIP_RENDER 0
+#define STATUS_BAR_HEIGHT 30
+
 // Color palette
 #define COLOR_BG_DARK 0x0841
 #define COLOR_ACCENT 0x07FF
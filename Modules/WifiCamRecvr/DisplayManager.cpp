@@ -3,7 +3,7 @@
 
 DisplayManager* DisplayManager::instance = nullptr;
 
-DisplayManager::DisplayManager() : mainSprite(nullptr), statusBarSprite(nullptr) {
+DisplayManager::DisplayManager() : mainSprite(nullptr), statusBarSprite(nullptr), stripFrame(false) {
     instance = this;
 }
 
@@ -19,7 +19,9 @@ DisplayManager::~DisplayManager() {
 }
 
 bool DisplayManager::tftOutputCallback(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
-    if (!instance || !instance->mainSprite) return false;
+    if (!instance) return false;
+    if (instance->stripFrame) return instance->strips.block(x, y, w, h, bitmap);
+    if (!instance->mainSprite) return false;
     if (y >= DISPLAY_HEIGHT) return false;
     
     instance->mainSprite->pushImage(x, y, w, h, bitmap);
@@ -50,7 +52,7 @@ bool DisplayManager::begin() {
     // Create status bar sprite
     statusBarSprite = new TFT_eSprite(&tft);
     statusBarSprite->setColorDepth(16);
-    if (!statusBarSprite->createSprite(DISPLAY_WIDTH, 30)) {
+    if (!statusBarSprite->createSprite(DISPLAY_WIDTH, STATUS_BAR_HEIGHT)) {
         Serial.println("Failed to create status bar sprite!");
         return false;
     }
@@ -72,10 +74,20 @@ void DisplayManager::pushSprite() {
 
 void DisplayManager::pushStatusBar() {
     if (statusBarSprite) {
-        statusBarSprite->pushSprite(0, DISPLAY_HEIGHT - 30);
+        statusBarSprite->pushSprite(0, DISPLAY_HEIGHT - STATUS_BAR_HEIGHT);
     }
 }
 
+void DisplayManager::startStripFrame(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t clipHeight) {
+    strips.startFrame(x, y, w, h, 0, 0, DISPLAY_WIDTH, clipHeight);
+    stripFrame = true;
+}
+
+void DisplayManager::endStripFrame() {
+    strips.endFrame();
+    stripFrame = false;
+}
+
 void DisplayManager::drawJpegFromFile(const char* filename, int16_t x, int16_t y) {
     if (mainSprite) {
         TJpgDec.drawFsJpg(x, y, filename, FFat);
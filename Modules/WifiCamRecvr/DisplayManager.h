@@ -6,6 +6,7 @@
 #include <FFat.h>
 #include <TJpg_Decoder.h>
 #include "Config.h"
+#include "StripRenderer.h"
 
 class DisplayManager {
 private:
@@ -13,6 +14,10 @@ private:
     TFT_eSprite* mainSprite;
     TFT_eSprite* statusBarSprite;
     
+    // Camera frames rendered straight to the panel (CAMERA_STRIP_RENDER)
+    StripRenderer strips;
+    bool stripFrame;
+    
     static DisplayManager* instance;
     static bool tftOutputCallback(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap);
     
@@ -27,6 +32,13 @@ public:
     
     void pushSprite();
     void pushStatusBar();
+    
+    // Strip rendering: blocks decoded between these go to the panel by DMA
+    bool beginStrips() { return strips.begin(&tft); }
+    bool hasStrips() { return strips.ready(); }
+    void startStripFrame(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t clipHeight);
+    void endStripFrame();
+    StripRenderer& getStrips() { return strips; }
     void drawJpegFromFile(const char* filename, int16_t x, int16_t y);
     bool loadJpegToSprite(TFT_eSprite* sprite, const char* filename);
     
@@ -0,0 +1,88 @@
+// NackMerge.h
+#pragma once
+//
+// Merges the missing-packet reports of several receivers of one broadcast
+// frame, so a packet that many of them lost is repaired by one rebroadcast.
+//
+// The sender keeps one NackMerge per frame in flight. begin() starts a
+// round expecting a report from every receiver (bit) that still has to
+// acknowledge the frame. add() folds a NACK into the frame-wide bitmap,
+// ack() takes a receiver out of the round once it has the whole frame.
+// The round is ready() when every expected receiver has reported, or
+// NACK_MERGE_MS after the first report so one silent receiver cannot hold
+// the others back. The sender then resends every packet isMissing()
+// reports and calls begin() again for the next round.
+//
+// Receivers repeat a NACK every NACK_IDLE_MS until repairs arrive, so
+// NACK_MERGE_MS stays below it. Time is passed in, and there are no
+// Arduino dependencies, so a simulated link can drive the class on a
+// desktop compiler.
+//
+// Place this file alongside your .ino files and #include "NackMerge.h".
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <string.h>
+#endif
+#include "CameraProtocol.h"
+
+#define NACK_MERGE_MS      15                      // Wait for the other receivers' reports
+#define NACK_MERGE_PACKETS (NACK_BITMAP_BYTES * 8)  // Packets tracked per frame
+
+class NackMerge {
+private:
+  uint8_t missing[NACK_BITMAP_BYTES];   // Bit n = packet n missing somewhere
+  uint8_t expected;                     // Receivers that have not reported this round
+  uint8_t requesters;                   // Receivers that asked for repairs this round
+  uint16_t missingCount;
+  uint32_t firstReportMs;
+
+public:
+  NackMerge() { begin(0); }
+
+  void begin(uint8_t receivers) {
+    memset(missing, 0, sizeof(missing));
+    expected = receivers;
+    requesters = 0;
+    missingCount = 0;
+    firstReportMs = 0;
+  }
+
+  void add(uint8_t peer, const NackPacket& nack, uint32_t now) {
+    if (!requesters) firstReportMs = now;
+    requesters |= 1 << peer;
+    expected &= ~(1 << peer);
+
+    for (uint16_t bit = 0; bit < NACK_BITMAP_BYTES * 8; bit++) {
+      if (!(nack.bitmap[bit >> 3] & (1 << (bit & 7)))) continue;
+
+      // Beyond the tracked range: asked for again in a later round
+      uint32_t packetNum = (uint32_t)nack.firstPacket + bit;
+      if (packetNum >= NACK_MERGE_PACKETS || packetNum >= nack.totalPackets) break;
+
+      uint8_t mask = 1 << (packetNum & 7);
+      if (!(missing[packetNum >> 3] & mask)) {
+        missing[packetNum >> 3] |= mask;
+        missingCount++;
+      }
+    }
+  }
+
+  void ack(uint8_t peer) {
+    expected &= ~(1 << peer);
+  }
+
+  bool ready(uint32_t now) const {
+    return requesters && (!expected || now - firstReportMs >= NACK_MERGE_MS);
+  }
+
+  bool isMissing(uint16_t packetNum) const {
+    return packetNum < NACK_MERGE_PACKETS && (missing[packetNum >> 3] & (1 << (packetNum & 7)));
+  }
+
+  uint8_t getRequesters() const { return requesters; }
+  uint16_t getMissingCount() const { return missingCount; }
+};
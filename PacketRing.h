@@ -0,0 +1,98 @@
+// PacketRing.h
+#pragma once
+//
+// Lock-free single-producer / single-consumer ring between the ESP-NOW
+// receive callback (Wi-Fi task) and the packet processing task.
+//
+// The callback copies each message straight into a preallocated slot and
+// publishes it with one atomic store; it never allocates, locks or prints.
+// The processing task reads the slot in place and releases it afterwards,
+// so every packet is copied exactly once. When the ring is full the new
+// message is dropped and counted, the Wi-Fi task is never blocked.
+//
+// Place this file alongside your .ino files and #include "PacketRing.h".
+// Keep every copy identical.
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <string.h>
+#endif
+#include <atomic>
+#include "CameraProtocol.h"
+
+#define PACKET_RING_SLOTS 128   // Must be a power of two
+#define PACKET_RING_ALIGN 32    // ESP32 / ESP32-S3 data cache line
+
+// One received message; slots start on a cache line so the producer and
+// consumer never share a line for different slots
+struct alignas(PACKET_RING_ALIGN) PacketSlot {
+  uint16_t len;
+  uint8_t  mac[6];
+  uint8_t  data[CAM_MAX_MESSAGE];
+};
+
+class PacketRing {
+private:
+  PacketSlot slots[PACKET_RING_SLOTS];
+
+  // Written by the producer only / by the consumer only, on separate lines
+  alignas(PACKET_RING_ALIGN) std::atomic<uint32_t> head;
+  alignas(PACKET_RING_ALIGN) std::atomic<uint32_t> tail;
+  uint32_t drops;   // Producer side
+
+public:
+  PacketRing() : head(0), tail(0), drops(0) {}
+
+  // -------- Producer (receive callback) --------
+
+  // Next free slot, or nullptr when the ring is full
+  PacketSlot* claim() {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= PACKET_RING_SLOTS) {
+      drops++;
+      return nullptr;
+    }
+    return &slots[h & (PACKET_RING_SLOTS - 1)];
+  }
+
+  // Makes the claimed slot visible to the consumer
+  void publish() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  bool push(const uint8_t* mac, const uint8_t* data, int len) {
+    if (len <= 0 || len > CAM_MAX_MESSAGE) return false;
+    PacketSlot* slot = claim();
+    if (!slot) return false;
+    slot->len = len;
+    memcpy(slot->mac, mac, 6);
+    memcpy(slot->data, data, len);
+    publish();
+    return true;
+  }
+
+  // -------- Consumer (processing task) --------
+
+  // Oldest published slot, or nullptr when empty; stays valid until release()
+  PacketSlot* peek() {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return nullptr;
+    return &slots[t & (PACKET_RING_SLOTS - 1)];
+  }
+
+  void release() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  uint32_t count() {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  uint32_t getDrops() { return drops; }
+};
+
+static_assert((PACKET_RING_SLOTS & (PACKET_RING_SLOTS - 1)) == 0, "PACKET_RING_SLOTS must be a power of two");
+static_assert(sizeof(PacketSlot) % PACKET_RING_ALIGN == 0, "PacketSlot must fill whole cache lines");
@@ -0,0 +1,155 @@
+// RateController.h
+#pragma once
+//
+// Adaptive bitrate control for the ESP-NOW camera sender.
+//
+// The sender walks a ladder of (frame size, JPEG quality) rungs ordered
+// from the smallest to the largest frames. For every receiver report
+// (CAM_MSG_REPORT, see CameraProtocol.h) it calls update() with the
+// measured goodput, packet loss and display rate, and switches the sensor
+// to the rung it returns:
+//
+// - Down when the display rate stays under RATE_DOWN_FPS_PCT of the target
+//   or loss over RATE_LOSS_HIGH_PERMILLE for RATE_DOWN_REPORTS reports.
+//   It jumps straight to the largest rung whose frames fit the per-frame
+//   budget (goodput / target FPS), at least one rung.
+// - Up one rung when the display rate is on target, loss is under
+//   RATE_LOSS_LOW_PERMILLE and the next rung's frames fit the budget for
+//   RATE_UP_REPORTS reports, and RATE_HOLD_MS after the previous change.
+//
+// Needing several reports in a row, and probing up one rung at a time
+// while stepping down at once, keeps the controller from oscillating
+// between two rungs.
+//
+// Frame sizes per rung start from RateRung::expectedBytes and follow the
+// frames actually sent (onFrame()). Time is passed in, and there are no
+// Arduino dependencies, so recorded reports can be replayed through the
+// class on a desktop compiler.
+//
+// Place this file alongside your .ino files and #include "RateController.h".
+//
+
+#if __has_include(<Arduino.h>)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+#endif
+
+#define RATE_MAX_RUNGS          16
+#define RATE_DOWN_FPS_PCT       80     // Display rate below this % of target: congested
+#define RATE_LOSS_HIGH_PERMILLE 100    // First-pass loss above 10%: congested
+#define RATE_LOSS_LOW_PERMILLE  20     // Loss below 2%: room to grow
+#define RATE_DOWN_REPORTS       2      // Congested reports in a row before stepping down
+#define RATE_UP_REPORTS         3      // Good reports in a row before stepping up
+#define RATE_HOLD_MS            5000   // Minimum time between two steps up
+#define RATE_SIZE_SHIFT         2      // Frame size estimate follows by 1/4 per frame
+
+typedef struct {
+  uint8_t  mode;            // Row of the sketch's resolution table
+  uint8_t  quality;         // Sensor JPEG quality (lower = better, larger)
+  uint16_t expectedBytes;   // Starting estimate of the frame size
+} RateRung;
+
+// One receiver report
+typedef struct {
+  uint16_t periodMs;
+  uint16_t framesDisplayed;
+  uint16_t framesLost;
+  uint16_t packetsExpected;
+  uint16_t packetsLost;     // Not there on the first pass (FEC, resent or never)
+  uint32_t bytesReceived;   // Image bytes of completed frames
+} RateSample;
+
+class RateController {
+private:
+  const RateRung* ladder;
+  uint8_t rungs;
+  uint8_t current;
+  uint32_t frameBytes[RATE_MAX_RUNGS];   // Learned frame size per rung
+  uint16_t targetFpsX10;
+  uint32_t maxFrameBytes;                // Receiver frame slot size
+  uint8_t goodReports;
+  uint8_t badReports;
+  uint32_t lastChange;
+  uint32_t budget;                       // Per-frame byte budget, last report
+  uint16_t fpsX10;                       // Display rate, last report
+  uint16_t lossPermille;                 // First-pass loss, last report
+  uint32_t stepsUp;
+  uint32_t stepsDown;
+
+  bool fits(uint8_t rung) {
+    return frameBytes[rung] <= budget && frameBytes[rung] <= maxFrameBytes;
+  }
+
+public:
+  RateController() : ladder(nullptr), rungs(0), current(0), targetFpsX10(50), maxFrameBytes(0),
+                     goodReports(0), badReports(0), lastChange(0), budget(0), fpsX10(0),
+                     lossPermille(0), stepsUp(0), stepsDown(0) {}
+
+  void begin(const RateRung* table, uint8_t count, uint8_t start, uint16_t targetFpsTenths, uint32_t maxBytes) {
+    ladder = table;
+    rungs = count < RATE_MAX_RUNGS ? count : RATE_MAX_RUNGS;
+    current = start < rungs ? start : 0;
+    targetFpsX10 = targetFpsTenths ? targetFpsTenths : 1;
+    maxFrameBytes = maxBytes;
+    for (uint8_t i = 0; i < rungs; i++) {
+      frameBytes[i] = ladder[i].expectedBytes;
+    }
+  }
+
+  // Size of a frame sent at the current rung
+  void onFrame(uint32_t bytes) {
+    if (!rungs) return;
+    int32_t diff = (int32_t)bytes - (int32_t)frameBytes[current];
+    frameBytes[current] += diff / (1 << RATE_SIZE_SHIFT);
+  }
+
+  // Returns the rung to use from now on
+  uint8_t update(const RateSample& s, uint32_t now) {
+    if (!rungs || s.periodMs == 0) return current;
+
+    fpsX10 = (uint32_t)s.framesDisplayed * 10000 / s.periodMs;
+    lossPermille = s.packetsExpected ? (uint32_t)s.packetsLost * 1000 / s.packetsExpected : 0;
+    uint32_t goodput = (uint64_t)s.bytesReceived * 1000 / s.periodMs;
+    budget = (uint64_t)goodput * 10 / targetFpsX10;
+
+    bool congested = fpsX10 * 100 < (uint32_t)targetFpsX10 * RATE_DOWN_FPS_PCT ||
+                     lossPermille > RATE_LOSS_HIGH_PERMILLE;
+    bool headroom = current + 1 < rungs && fpsX10 >= targetFpsX10 &&
+                    lossPermille < RATE_LOSS_LOW_PERMILLE && fits(current + 1);
+
+    if (congested) {
+      goodReports = 0;
+      if (++badReports >= RATE_DOWN_REPORTS && current > 0) {
+        uint8_t rung = current - 1;
+        while (rung > 0 && !fits(rung)) rung--;
+        current = rung;
+        badReports = 0;
+        lastChange = now;
+        stepsDown++;
+      }
+    } else if (headroom) {
+      badReports = 0;
+      if (++goodReports >= RATE_UP_REPORTS && now - lastChange >= RATE_HOLD_MS) {
+        current++;
+        goodReports = 0;
+        lastChange = now;
+        stepsUp++;
+      }
+    } else {
+      goodReports = 0;
+      badReports = 0;
+    }
+
+    return current;
+  }
+
+  const RateRung& getRung() { return ladder[current]; }
+  uint8_t getRungIndex() { return current; }
+  uint32_t getBudget() { return budget; }
+  uint32_t getFrameBytes() { return rungs ? frameBytes[current] : 0; }
+  uint16_t getFpsX10() { return fpsX10; }
+  uint16_t getLossPermille() { return lossPermille; }
+  uint32_t getStepsUp() { return stepsUp; }
+  uint32_t getStepsDown() { return stepsDown; }
+};
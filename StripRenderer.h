@@ -0,0 +1,147 @@
+// StripRenderer.h
+#pragma once
+//
+// Direct-to-panel rendering of camera JPEGs through two DMA strip buffers.
+//
+// Instead of decoding into a full-frame sprite and pushing it afterwards,
+// the JPEG output callback hands each decoded block to block(), which
+// collects one MCU row into a strip in internal SRAM. When the next row
+// starts, the finished strip goes out with TFT_eSPI DMA while the decoder
+// fills the other strip, so the SPI transfer overlaps the decode and no
+// frame-sized buffer is needed.
+//
+// Blocks must already be in panel byte order (TJpgDec.setSwapBytes(true)).
+// The panel is held (startWrite) from startFrame() to endFrame(), so
+// nothing else may draw in between.
+//
+// Place this file alongside your .ino files and #include "StripRenderer.h".
+// Keep every copy identical.
+//
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "esp_heap_caps.h"
+
+#define STRIP_MAX_WIDTH 320
+#define STRIP_MAX_ROWS  16     // Tallest MCU row (4:2:0 sampling)
+
+class StripRenderer {
+private:
+  TFT_eSPI* tft;
+  uint16_t* strips[2];
+  uint8_t current;             // Strip being filled; the other may be in flight
+  bool dmaReady;
+
+  // Visible part of the frame on the panel
+  int16_t left, top, right, bottom;
+
+  // Strip being filled
+  bool filling;
+  int16_t rowY;                // Panel y of the block row it holds
+  int16_t stripY;              // First visible row
+  uint16_t stripRows;
+
+  // Timings of the frame being drawn and of the last one
+  unsigned long frameStart;
+  uint32_t waitUs;
+  uint16_t stripCount;
+  uint32_t lastRenderUs;
+  uint32_t lastWaitUs;
+  uint16_t lastStrips;
+
+  // Sends the filled strip; pushImageDMA first waits for the previous one,
+  // which frees the other buffer for the next row
+  void flush() {
+    if (!filling) return;
+    unsigned long t = micros();
+    tft->pushImageDMA(left, stripY, right - left, stripRows, strips[current]);
+    waitUs += micros() - t;
+    current ^= 1;
+    filling = false;
+    stripCount++;
+  }
+
+public:
+  StripRenderer() : tft(nullptr), current(0), dmaReady(false), left(0), top(0), right(0), bottom(0),
+                    filling(false), rowY(0), stripY(0), stripRows(0), frameStart(0), waitUs(0),
+                    stripCount(0), lastRenderUs(0), lastWaitUs(0), lastStrips(0) {
+    strips[0] = strips[1] = nullptr;
+  }
+
+  bool begin(TFT_eSPI* display) {
+    tft = display;
+    for (uint8_t i = 0; i < 2; i++) {
+      strips[i] = (uint16_t*)heap_caps_malloc(STRIP_MAX_WIDTH * STRIP_MAX_ROWS * sizeof(uint16_t),
+                                              MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+      if (!strips[i]) return false;
+    }
+    dmaReady = tft->initDMA();
+    return dmaReady;
+  }
+
+  bool ready() { return dmaReady; }
+
+  // A width x height frame (decoded pixels) with its origin at (x, y) on
+  // the panel; only the part inside the clip rectangle is drawn
+  void startFrame(int16_t x, int16_t y, uint16_t width, uint16_t height,
+                  int16_t clipX, int16_t clipY, uint16_t clipWidth, uint16_t clipHeight) {
+    left = max(x, clipX);
+    top = max(y, clipY);
+    right = min((int16_t)(x + width), (int16_t)(clipX + clipWidth));
+    bottom = min((int16_t)(y + height), (int16_t)(clipY + clipHeight));
+    if (right - left > STRIP_MAX_WIDTH) right = left + STRIP_MAX_WIDTH;
+
+    filling = false;
+    waitUs = 0;
+    stripCount = 0;
+    frameStart = micros();
+    tft->startWrite();
+  }
+
+  // One decoded block at panel position (x, y). Returns false once the
+  // decode has passed the bottom of the visible area.
+  bool block(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t* bitmap) {
+    if (y >= bottom) {
+      flush();
+      return false;
+    }
+    if (filling && y != rowY) flush();
+    if (y + h <= top || x >= right || x + w <= left || h > STRIP_MAX_ROWS) return true;
+
+    if (!filling) {
+      filling = true;
+      rowY = y;
+      stripY = max(y, top);
+      stripRows = min((int16_t)(y + h), bottom) - stripY;
+    }
+
+    int16_t from = max(x, left);
+    int16_t to = min((int16_t)(x + w), right);
+    uint16_t stride = right - left;
+    const uint16_t* src = bitmap + (stripY - y) * w + (from - x);
+    uint16_t* dst = strips[current] + (from - left);
+    for (uint16_t row = 0; row < stripRows; row++, src += w, dst += stride) {
+      memcpy(dst, src, (to - from) * sizeof(uint16_t));
+    }
+    return true;
+  }
+
+  void endFrame() {
+    flush();
+    unsigned long t = micros();
+    tft->dmaWait();
+    waitUs += micros() - t;
+    tft->endWrite();
+
+    lastRenderUs = micros() - frameStart;
+    lastWaitUs = waitUs;
+    lastStrips = stripCount;
+  }
+
+  // Last frame: decode + render time, and how much of it was spent waiting
+  // for the SPI transfer of an earlier strip
+  uint32_t getRenderUs() { return lastRenderUs; }
+  uint32_t getWaitUs() { return lastWaitUs; }
+  uint32_t getDecodeUs() { return lastRenderUs - lastWaitUs; }
+  uint16_t getStrips() { return lastStrips; }
+};
@@ -0,0 +1,254 @@
+// EspNowSim.cpp
+#include "EspNowSim.h"
+
+static EspNowSim* activeSim = nullptr;
+static SimDevice* activeDevice = nullptr;
+
+static const uint8_t broadcastMac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// Runs fn as `device`, restoring the device that was running before
+static void runAs(SimDevice* device, const std::function<void()>& fn) {
+  SimDevice* previous = activeDevice;
+  activeDevice = device;
+  fn();
+  activeDevice = previous;
+}
+
+EspNowSim::EspNowSim(const SimLinkConfig& cfg)
+    : config(cfg), rng(cfg.seed), channelBusy(false), now(0), order(0) {
+  activeSim = this;
+}
+
+EspNowSim::~EspNowSim() {
+  if (activeSim == this) activeSim = nullptr;
+}
+
+EspNowSim* EspNowSim::current() { return activeSim; }
+SimDevice* EspNowSim::currentDevice() { return activeDevice; }
+
+SimDevice* EspNowSim::addDevice(const uint8_t mac[6], void* user) {
+  devices.emplace_back();
+  SimDevice* device = &devices.back();
+  memcpy(device->mac, mac, 6);
+  device->user = user;
+  return device;
+}
+
+SimDevice* EspNowSim::findDevice(const uint8_t mac[6]) {
+  for (SimDevice& device : devices) {
+    if (memcmp(device.mac, mac, 6) == 0) return &device;
+  }
+  return nullptr;
+}
+
+void EspNowSim::at(uint64_t timeUs, SimDevice* device, std::function<void()> fn) {
+  events.push(Event{timeUs < now ? now : timeUs, order++, device, std::move(fn)});
+}
+
+void EspNowSim::every(uint64_t firstUs, uint32_t periodUs, SimDevice* device, std::function<void()> fn) {
+  at(firstUs, device, [this, periodUs, device, fn]() {
+    fn();
+    every(now + periodUs, periodUs, device, fn);
+  });
+}
+
+void EspNowSim::run(uint64_t untilUs) {
+  activeSim = this;
+  while (!events.empty() && events.top().timeUs <= untilUs) {
+    Event event = events.top();
+    events.pop();
+    now = event.timeUs;
+    runAs(event.device, event.fn);
+  }
+  now = untilUs;
+}
+
+bool EspNowSim::chance(double pct) {
+  if (pct <= 0) return false;
+  return std::uniform_real_distribution<double>(0, 100)(rng) < pct;
+}
+
+uint32_t EspNowSim::airtimeUs(size_t len, bool unicast) const {
+  uint64_t bits = (uint64_t)(len + SIM_MAC_OVERHEAD) * 8;
+  uint32_t us = SIM_DIFS_US + SIM_PREAMBLE_US + bits * 1000000 / config.bitRate;
+  if (unicast) {
+    us += SIM_SIFS_US + SIM_PREAMBLE_US + (uint64_t)SIM_ACK_BYTES * 8 * 1000000 / config.bitRate;
+  }
+  return us;
+}
+
+esp_err_t EspNowSim::send(SimDevice* src, const uint8_t* mac, const uint8_t* data, size_t len) {
+  if (!src || !src->initialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  if (!mac || !data || len == 0 || len > 250) return ESP_ERR_ESPNOW_ARG;
+
+  bool broadcast = memcmp(mac, broadcastMac, 6) == 0;
+  bool known = false;
+  for (const auto& peer : src->peers) {
+    if (memcmp(peer.data(), mac, 6) == 0) known = true;
+  }
+  if (!known) return ESP_ERR_ESPNOW_NOT_FOUND;
+
+  if (src->queued >= config.queueDepth) {
+    stats.rejected++;
+    return ESP_ERR_ESPNOW_NO_MEM;
+  }
+
+  AirFrame frame;
+  frame.src = src;
+  memcpy(frame.dst, mac, 6);
+  frame.broadcast = broadcast;
+  frame.data.assign(data, data + len);
+  frame.attempt = 0;
+  air.push_back(std::move(frame));
+  src->queued++;
+
+  if (!channelBusy) startNext();
+  return ESP_OK;
+}
+
+void EspNowSim::startNext() {
+  if (air.empty()) {
+    channelBusy = false;
+    return;
+  }
+  channelBusy = true;
+
+  AirFrame frame = std::move(air.front());
+  air.pop_front();
+
+  uint32_t us = airtimeUs(frame.data.size(), !frame.broadcast);
+  stats.transmissions++;
+  stats.bytesOnAir += frame.data.size() + SIM_MAC_OVERHEAD;
+  stats.airtimeUs += us;
+  frame.src->framesSent++;
+  frame.src->bytesSent += frame.data.size() + SIM_MAC_OVERHEAD;
+
+  events.push(Event{now + us, order++, nullptr, [this, frame]() { endOfAir(frame); }});
+}
+
+void EspNowSim::deliver(SimDevice* dst, const AirFrame& frame, uint64_t atUs) {
+  uint64_t t = atUs + config.latencyUs;
+  if (config.jitterUs) {
+    t += std::uniform_int_distribution<uint32_t>(0, config.jitterUs)(rng);
+  }
+  if (chance(config.reorderPct)) t += config.reorderUs;
+
+  int copies = chance(config.duplicatePct) ? 2 : 1;
+  for (int i = 0; i < copies; i++) {
+    uint8_t srcMac[6];
+    memcpy(srcMac, frame.src->mac, 6);
+    std::vector<uint8_t> data = frame.data;
+    at(t + i * config.latencyUs, dst, [this, dst, srcMac, data]() {
+      stats.delivered++;
+      if (dst->initialized && dst->recvCb) {
+        dst->recvCb(srcMac, data.data(), data.size());
+      }
+    });
+  }
+}
+
+void EspNowSim::endOfAir(AirFrame frame) {
+  esp_now_send_status_t status = ESP_NOW_SEND_SUCCESS;
+
+  if (frame.broadcast) {
+    for (SimDevice& device : devices) {
+      if (&device == frame.src) continue;
+      if (chance(config.lossPct)) {
+        stats.lost++;
+      } else {
+        deliver(&device, frame, now);
+      }
+    }
+  } else {
+    SimDevice* dst = findDevice(frame.dst);
+    if (!dst || chance(config.lossPct)) {
+      stats.lost++;
+      if (frame.attempt < config.retries) {
+        // The radio retries at once, ahead of anything queued after it
+        frame.attempt++;
+        stats.retries++;
+        air.push_front(std::move(frame));
+        startNext();
+        return;
+      }
+      stats.sendFailed++;
+      status = ESP_NOW_SEND_FAIL;
+    } else {
+      deliver(dst, frame, now);
+    }
+  }
+
+  SimDevice* src = frame.src;
+  src->queued--;
+  if (src->sendCb) {
+    uint8_t dst[6];
+    memcpy(dst, frame.dst, 6);
+    runAs(src, [src, dst, status]() { src->sendCb(dst, status); });
+  }
+  startNext();
+}
+
+// -------- esp_now_* on the device that is running --------
+
+esp_err_t esp_now_init() {
+  SimDevice* device = EspNowSim::currentDevice();
+  if (!device) return ESP_FAIL;
+  device->initialized = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_deinit() {
+  SimDevice* device = EspNowSim::currentDevice();
+  if (!device) return ESP_FAIL;
+  device->initialized = false;
+  device->peers.clear();
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb) {
+  SimDevice* device = EspNowSim::currentDevice();
+  if (!device || !device->initialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  device->sendCb = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+  SimDevice* device = EspNowSim::currentDevice();
+  if (!device || !device->initialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  device->recvCb = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer) {
+  SimDevice* device = EspNowSim::currentDevice();
+  if (!device || !device->initialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  if (!peer) return ESP_ERR_ESPNOW_ARG;
+  if (esp_now_is_peer_exist(peer->peer_addr)) return ESP_ERR_ESPNOW_EXIST;
+  device->peers.emplace_back(peer->peer_addr, peer->peer_addr + 6);
+  return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t* mac) {
+  SimDevice* device = EspNowSim::currentDevice();
+  if (!device || !device->initialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  for (auto it = device->peers.begin(); it != device->peers.end(); ++it) {
+    if (memcmp(it->data(), mac, 6) == 0) {
+      device->peers.erase(it);
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_ESPNOW_NOT_FOUND;
+}
+
+bool esp_now_is_peer_exist(const uint8_t* mac) {
+  SimDevice* device = EspNowSim::currentDevice();
+  if (!device) return false;
+  for (const auto& peer : device->peers) {
+    if (memcmp(peer.data(), mac, 6) == 0) return true;
+  }
+  return false;
+}
+
+esp_err_t esp_now_send(const uint8_t* mac, const uint8_t* data, size_t len) {
+  return EspNowSim::current()->send(EspNowSim::currentDevice(), mac, data, len);
+}
@@ -0,0 +1,186 @@
+// EspNowSim.h
+#pragma once
+//
+// Host emulation of the ESP-NOW link for the camera transport.
+//
+// Several simulated devices share one radio channel in a single process.
+// Code runs as one device at a time (EspNowSim::at() / every() callbacks,
+// and the receive and send callbacks), and the usual esp_now_* calls act
+// on that device, so transport code written against the ESP-NOW API runs
+// unchanged.
+//
+// esp_now_send() puts a frame on the shared air queue. Frames are sent one
+// after the other and take airtime from the bit rate. A lost unicast frame
+// is retried up to `retries` times, as the radio does, and the send
+// callback reports the outcome; broadcast frames are sent once and always
+// report success. Delivered frames reach the receive callback after the
+// latency (plus jitter), some of them held back to arrive out of order, or
+// twice. Each receiver of a broadcast loses frames independently.
+//
+// Time is simulated in microseconds: runs take no wall-clock time and the
+// same seed gives the same run.
+//
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <functional>
+#include <queue>
+#include <deque>
+#include <vector>
+#include <random>
+
+// -------- ESP-NOW API subset (esp_now.h, Arduino-ESP32 2.x signatures) --------
+typedef int esp_err_t;
+#define ESP_OK                    0
+#define ESP_FAIL                  -1
+#define ESP_ERR_ESPNOW_NOT_INIT   0x3065
+#define ESP_ERR_ESPNOW_ARG        0x3066
+#define ESP_ERR_ESPNOW_NO_MEM     0x3067
+#define ESP_ERR_ESPNOW_NOT_FOUND  0x3069
+#define ESP_ERR_ESPNOW_EXIST      0x306b
+
+typedef enum {
+  ESP_NOW_SEND_SUCCESS = 0,
+  ESP_NOW_SEND_FAIL
+} esp_now_send_status_t;
+
+typedef enum {
+  WIFI_IF_STA = 0,
+  WIFI_IF_AP
+} wifi_interface_t;
+
+typedef struct {
+  uint8_t peer_addr[6];
+  uint8_t lmk[16];
+  uint8_t channel;
+  wifi_interface_t ifidx;
+  bool encrypt;
+  void* priv;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_send_cb_t)(const uint8_t* mac, esp_now_send_status_t status);
+typedef void (*esp_now_recv_cb_t)(const uint8_t* mac, const uint8_t* data, int len);
+
+esp_err_t esp_now_init();
+esp_err_t esp_now_deinit();
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb);
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer);
+esp_err_t esp_now_del_peer(const uint8_t* mac);
+bool esp_now_is_peer_exist(const uint8_t* mac);
+esp_err_t esp_now_send(const uint8_t* mac, const uint8_t* data, size_t len);
+
+// -------- Link model --------
+#define SIM_MAC_OVERHEAD  43    // 802.11 action frame header, ESP-NOW vendor element, FCS
+#define SIM_PREAMBLE_US   192   // Long preamble + PLCP header at 1 Mbps
+#define SIM_DIFS_US       50
+#define SIM_SIFS_US       10
+#define SIM_ACK_BYTES     14
+
+struct SimLinkConfig {
+  double   lossPct = 0;          // Chance one transmission is lost, per receiver
+  double   reorderPct = 0;       // Chance a delivered frame is held back by reorderUs
+  uint32_t reorderUs = 3000;
+  double   duplicatePct = 0;     // Chance a delivered frame arrives twice
+  uint32_t latencyUs = 300;      // End of airtime to receive callback
+  uint32_t jitterUs = 0;         // Extra latency, uniform 0..jitterUs
+  uint32_t bitRate = 1000000;    // PHY rate in bit/s (ESP-NOW default 1 Mbps)
+  uint8_t  retries = 0;          // Extra attempts for a lost unicast frame
+  uint8_t  queueDepth = 8;       // Frames a device may have waiting for air
+  uint32_t seed = 1;
+};
+
+class EspNowSim;
+
+// One simulated radio: its MAC, callbacks and peer table
+struct SimDevice {
+  uint8_t mac[6];
+  bool initialized = false;
+  esp_now_send_cb_t sendCb = nullptr;
+  esp_now_recv_cb_t recvCb = nullptr;
+  std::vector<std::vector<uint8_t>> peers;
+  uint16_t queued = 0;           // Frames waiting for or on the air
+  void* user = nullptr;          // Owner object, for static callbacks
+
+  // Counters of what this device put on the air
+  uint64_t framesSent = 0;
+  uint64_t bytesSent = 0;
+};
+
+struct SimStats {
+  uint64_t transmissions = 0;    // Frames put on the air, retries included
+  uint64_t retries = 0;
+  uint64_t bytesOnAir = 0;       // MAC frame bytes of every transmission
+  uint64_t airtimeUs = 0;        // Channel time, gaps and ACKs included
+  uint64_t delivered = 0;        // Receive callbacks, duplicates included
+  uint64_t lost = 0;             // Transmissions lost at one receiver
+  uint64_t sendFailed = 0;       // Unicast frames lost after all retries
+  uint64_t rejected = 0;         // esp_now_send() refused: queue full
+};
+
+class EspNowSim {
+private:
+  struct Event {
+    uint64_t timeUs;
+    uint64_t order;
+    SimDevice* device;
+    std::function<void()> fn;
+    bool operator>(const Event& other) const {
+      return timeUs != other.timeUs ? timeUs > other.timeUs : order > other.order;
+    }
+  };
+
+  struct AirFrame {
+    SimDevice* src;
+    uint8_t dst[6];
+    bool broadcast;
+    std::vector<uint8_t> data;
+    uint8_t attempt;
+  };
+
+  SimLinkConfig config;
+  std::mt19937 rng;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  std::deque<AirFrame> air;
+  std::deque<SimDevice> devices;
+  bool channelBusy;
+  uint64_t now;
+  uint64_t order;
+  SimStats stats;
+
+  bool chance(double pct);
+  void startNext();
+  void endOfAir(AirFrame frame);
+  void deliver(SimDevice* dst, const AirFrame& frame, uint64_t atUs);
+
+public:
+  explicit EspNowSim(const SimLinkConfig& cfg);
+  ~EspNowSim();
+
+  SimDevice* addDevice(const uint8_t mac[6], void* user = nullptr);
+  SimDevice* findDevice(const uint8_t mac[6]);
+
+  // Runs fn as `device` at timeUs / every periodUs from firstUs on
+  void at(uint64_t timeUs, SimDevice* device, std::function<void()> fn);
+  void every(uint64_t firstUs, uint32_t periodUs, SimDevice* device, std::function<void()> fn);
+
+  // Processes events up to untilUs
+  void run(uint64_t untilUs);
+
+  uint64_t nowUs() const { return now; }
+  uint32_t nowMs() const { return now / 1000; }
+  const SimLinkConfig& getConfig() const { return config; }
+  const SimStats& getStats() const { return stats; }
+
+  // Used by the esp_now_* shim
+  esp_err_t send(SimDevice* src, const uint8_t* mac, const uint8_t* data, size_t len);
+  uint32_t airtimeUs(size_t len, bool unicast) const;
+
+  static EspNowSim* current();
+  static SimDevice* currentDevice();
+};
+
+// millis()/micros() of the device code under simulation
+inline uint32_t simMillis() { return EspNowSim::current()->nowMs(); }
+inline uint64_t simMicros() { return EspNowSim::current()->nowUs(); }
@@ -0,0 +1,470 @@
+// SimCamera.h
+#pragma once
+//
+// The ESPCAMSENDER / ESPNOWCAMRECIEVER transport running on EspNowSim.
+//
+// SimSender runs ESPCAMSENDER.ino's transmit side: FrameSender.h sends
+// each capture as a header, data packets and FEC parity packets, holds it
+// until every receiver has acknowledged it and resends only the reported
+// gaps, merged by NackMerge when a frame is broadcast to several receivers.
+// With baseReceivers set, each capture also goes out as a broadcast base
+// layer to those receivers (SIMULCAST). The packet task's queue and
+// SendWindow pacing are modelled here.
+//
+// SimReceiver runs ESPNOWCAMRECIEVER.ino's packet task: RX_FRAMES contexts
+// reassembled by FrameReassembly.h, a NACK once a frame has been idle for
+// NACK_IDLE_MS, superseded frames dropped and frames given up once their
+// repair rounds are spent.
+//
+// The state machines, wire format, FEC, pacing and NACK handling are the
+// shared headers themselves; only the FreeRTOS tasks and queues are
+// replaced by simulator timers. Every completed frame is compared byte for
+// byte with the frame that was sent.
+//
+
+#include <stdio.h>
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <vector>
+#include "EspNowSim.h"
+#include "SimJpeg.h"
+#include "CameraProtocol.h"
+#include "PacketFec.h"
+#include "SendWindow.h"
+#include "FrameSender.h"
+#include "FrameReassembly.h"
+#include "CameraWindow.h"
+
+#define SIM_RX_FRAMES      2       // RX_FRAMES in ESPNOWCAMRECIEVER.ino
+#define SIM_MAX_FRAME_SIZE 35000   // MAX_FRAME_SIZE in ESPNOWCAMRECIEVER.ino
+#define SIM_MAX_RECEIVERS  8
+#define SIM_TX_QUEUE       100     // transmitQueue depth in ESPCAMSENDER.ino
+
+typedef std::array<uint8_t, 6> SimMac;
+
+inline SimMac simMac(uint8_t last) {
+  return SimMac{{0x24, 0x0A, 0xC4, 0x00, 0x00, last}};
+}
+
+struct SimSenderConfig {
+  uint8_t  fecGroup = 8;             // FEC_GROUP_SIZE (0 = off)
+  uint8_t  fecParity = 1;            // FEC_PARITY_PACKETS
+  bool     selectiveRepeat = true;   // SELECTIVE_REPEAT
+  bool     fanout = false;           // FANOUT_BROADCAST
+  uint8_t  capturesInFlight = 2;     // CAPTURES_IN_FLIGHT
+  uint32_t sensorPeriodMs = 40;      // Sensor frame period; the newest frame is taken (CAMERA_GRAB_LATEST)
+  bool     repairsToFront = true;    // false: repairs queue behind the frame (TransmissionManager)
+  uint8_t  baseReceivers = 0;        // SIMULCAST: receivers (bits) sent the base layer
+  const std::vector<std::vector<uint8_t>>* baseFrames = nullptr;   // Base layer of each frame
+};
+
+struct SimSenderStats {
+  uint32_t framesSent = 0;
+  uint32_t framesAcked = 0;
+  uint32_t framesUnacked = 0;        // Given up on before every receiver acknowledged
+  uint32_t capturesSkipped = 0;      // Sensor frames never taken
+  uint32_t packetsResent = 0;
+  uint32_t packetsRejected = 0;      // esp_now_send() refused
+};
+
+class SimSender {
+private:
+  struct Queued {
+    int8_t dest;
+    uint16_t len;
+    uint8_t data[CAM_MAX_MESSAGE];
+  };
+
+  EspNowSim& sim;
+  SimDevice* device;
+  SimSenderConfig config;
+  std::vector<SimMac> receivers;
+  const std::vector<std::vector<uint8_t>>& frames;
+  size_t nextFrame;
+  uint16_t frameId;
+  uint32_t lastCaptureMs;
+  bool started;
+
+  SendWindow window;
+  uint32_t waitStartMs;                // Window full since (sendWindowed waiting)
+  std::deque<Queued> queue;
+  std::vector<CamTxFrame> inFlight;
+  FrameSender sender;
+  SimSenderStats stats;
+
+  uint8_t allReceivers() const { return (uint8_t)((1u << receivers.size()) - 1); }
+
+  int findReceiver(const uint8_t* mac) const {
+    for (size_t i = 0; i < receivers.size(); i++) {
+      if (memcmp(receivers[i].data(), mac, 6) == 0) return i;
+    }
+    return -1;
+  }
+
+  static SimSender* self() { return (SimSender*)EspNowSim::currentDevice()->user; }
+
+  static void onSent(const uint8_t*, esp_now_send_status_t status) {
+    SimSender* s = self();
+    s->window.onComplete(status == ESP_NOW_SEND_SUCCESS, simMillis());
+    s->waitStartMs = simMillis();
+    s->pump();
+  }
+
+  static void onRecv(const uint8_t* mac, const uint8_t* data, int len) {
+    SimSender* s = self();
+    if (camCheck(data, len) != CAM_MSG_NACK) return;
+    int peer = s->findReceiver(mac);
+    if (peer < 0) return;
+    s->sender.onNack(peer, *(const NackPacket*)data, simMillis());
+    s->pump();
+  }
+
+  // FrameSender output, sent by pump(); repairs go to the front of the
+  // queue (xQueueSendToFront in the sketch), or behind the frame's packets
+  // for TransmissionManager, which sends every message in place
+  static void sendMessage(void* ctx, int8_t dest, const void* msg, uint16_t len, CamTxKind kind) {
+    SimSender* s = (SimSender*)ctx;
+    Queued item;
+    item.dest = dest;
+    item.len = len;
+    memcpy(item.data, msg, len);
+    if (kind == CAM_TX_REPAIR) s->stats.packetsResent++;
+    if (kind == CAM_TX_REPAIR && s->config.repairsToFront) {
+      s->queue.push_front(item);
+    } else {
+      s->queue.push_back(item);
+    }
+  }
+
+  static void frameDone(void* ctx, CamTxFrame&, bool acked) {
+    SimSender* s = (SimSender*)ctx;
+    if (acked) s->stats.framesAcked++;
+    else s->stats.framesUnacked++;
+  }
+
+  // packetTransmissionTask / sendWindowed: a refused packet is dropped
+  void pump() {
+    while (!queue.empty() && window.canSend()) {
+      static const uint8_t broadcastMac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+      const Queued& item = queue.front();
+      const uint8_t* mac = item.dest == CAM_TX_BROADCAST ? broadcastMac : receivers[item.dest].data();
+
+      window.onSent();
+      if (esp_now_send(mac, item.data, item.len) != ESP_OK) {
+        window.onRejected();
+        stats.packetsRejected++;
+      }
+      queue.pop_front();
+      if (!window.canSend()) waitStartMs = simMillis();
+    }
+  }
+
+  // The camera keeps capturing; a free slot takes the newest sensor frame
+  void capture() {
+    // The transmit task blocks while its queue is full
+    if (queue.size() >= SIM_TX_QUEUE) return;
+
+    // A free slot for each layer of the capture
+    uint8_t layers = config.baseReceivers ? CAM_LAYER_COUNT : 1;
+    CamTxFrame* slots[CAM_LAYER_COUNT];
+    int freeSlots = 0;
+    for (CamTxFrame& frame : inFlight) {
+      if (!frame.data && freeSlots < layers) slots[freeSlots++] = &frame;
+    }
+    if (freeSlots < layers) return;
+
+    uint32_t now = simMillis();
+    uint32_t captureMs = now - now % config.sensorPeriodMs;
+    if (started && captureMs == lastCaptureMs) return;
+    if (started) stats.capturesSkipped += (captureMs - lastCaptureMs) / config.sensorPeriodMs - 1;
+    lastCaptureMs = captureMs;
+    started = true;
+
+    size_t index = nextFrame;
+    nextFrame = (nextFrame + 1) % frames.size();
+    const std::vector<uint8_t>& jpeg = frames[index];
+
+    ImageHeader header;
+    uint16_t width = 0, height = 0;
+    camJpegSize(jpeg.data(), jpeg.size(), width, height);
+    header.width = width;
+    header.height = height;
+    header.format = CAM_FORMAT_JPEG;
+    header.quality = 12;
+    header.resolutionMode = 0;
+    header.captureMs = captureMs;
+    header.layer = CAM_LAYER_FULL;
+    header.layers = layers;
+    ImageHeader baseHeader = header;
+
+    // Layers of one capture take consecutive frame IDs
+    uint16_t id = frameId + 1;
+    frameId += layers;
+    stats.framesSent++;
+
+    uint8_t fullMask = allReceivers() & ~config.baseReceivers;
+    if (fullMask) {
+      bool broadcast = config.fanout && (fullMask & (fullMask - 1)) && fullMask == allReceivers();
+      sender.start(*slots[CAM_LAYER_FULL], jpeg.data(), jpeg.size(), nullptr, id + CAM_LAYER_FULL, header,
+                   fullMask, broadcast, now);
+    }
+    if (config.baseReceivers) {
+      const std::vector<uint8_t>& base = (*config.baseFrames)[index];
+      camJpegSize(base.data(), base.size(), width, height);
+      baseHeader.width = width;
+      baseHeader.height = height;
+      baseHeader.layer = CAM_LAYER_BASE;
+      sender.start(*slots[CAM_LAYER_BASE], base.data(), base.size(), nullptr, id + CAM_LAYER_BASE, baseHeader,
+                   config.baseReceivers, true, now);
+    }
+    pump();
+
+    if (!config.selectiveRepeat) {
+      for (int i = 0; i < layers; i++) {
+        if (slots[i]->data) sender.finish(*slots[i], true);
+      }
+    }
+  }
+
+  void tick() {
+    // No completion for SEND_WINDOW_TIMEOUT_MS: forget the outstanding packets
+    if (!queue.empty() && !window.canSend() && simMillis() - waitStartMs > SEND_WINDOW_TIMEOUT_MS) {
+      window.expire();
+      waitStartMs = simMillis();
+    }
+    pump();
+    sender.repair(simMillis());
+    pump();
+    if (queue.empty()) sender.expire(simMillis());
+    capture();
+  }
+
+public:
+  SimSender(EspNowSim& s, const SimMac& mac, const std::vector<SimMac>& rx,
+            const std::vector<std::vector<uint8_t>>& jpegs, const SimSenderConfig& cfg)
+      : sim(s), config(cfg), receivers(rx), frames(jpegs), nextFrame(0), frameId(0),
+        lastCaptureMs(0), started(false), waitStartMs(0),
+        inFlight(cfg.capturesInFlight * (cfg.baseReceivers ? CAM_LAYER_COUNT : 1)) {
+    sender.begin(inFlight.data(), inFlight.size(), sendMessage, frameDone, this, cfg.repairsToFront);
+    sender.setFec(cfg.fecGroup, cfg.fecParity);
+    device = sim.addDevice(mac.data(), this);
+    sim.at(0, device, [this]() {
+      esp_now_init();
+      esp_now_register_send_cb(onSent);
+      esp_now_register_recv_cb(onRecv);
+      esp_now_peer_info_t peer = {};
+      for (const SimMac& mac : receivers) {
+        memcpy(peer.peer_addr, mac.data(), 6);
+        esp_now_add_peer(&peer);
+      }
+      memset(peer.peer_addr, 0xFF, 6);
+      esp_now_add_peer(&peer);
+    });
+    sim.every(1000, 1000, device, [this]() { tick(); });
+  }
+
+  const SimSenderStats& getStats() const { return stats; }
+  uint16_t getWindow() { return window.getWindow(); }
+  uint32_t getBackoffs() { return window.getBackoffs(); }
+};
+
+struct SimReceiverStats {
+  uint32_t framesCompleted = 0;
+  uint32_t framesCorrupt = 0;        // Completed but not what was sent
+  uint32_t framesSuperseded = 0;
+  uint32_t framesGivenUp = 0;        // Repairs spent, or silent for too long
+  uint32_t framesMissed = 0;         // Header never seen (frame ID gap)
+  uint32_t packetsRecovered = 0;     // Rebuilt from FEC parity
+  uint32_t packetsRepaired = 0;      // Arrived after a NACK
+  uint32_t nacksSent = 0;
+  std::vector<uint32_t> latencyMs;   // Capture to complete, per completed frame
+};
+
+class SimReceiver {
+private:
+  // A context and its buffers (framePool slot and allocations in the sketch)
+  struct Context : RxFrame {
+    std::vector<uint8_t> image;
+    std::vector<uint64_t> receivedStore;
+    std::vector<uint8_t> parityStore;
+    std::vector<uint64_t> parityBitStore;
+  };
+
+  EspNowSim& sim;
+  SimDevice* device;
+  bool selectiveRepeat;
+  const std::vector<std::vector<uint8_t>>& frames;   // What the sender cycles through
+  uint32_t maxFrameSize;
+  std::vector<Context> contexts;
+  uint8_t senderMac[6];
+  bool senderKnown;
+  RxSequence sequence;
+  uint32_t lastFullLayerMs;
+  SimReceiverStats stats;
+
+  static SimReceiver* self() { return (SimReceiver*)EspNowSim::currentDevice()->user; }
+
+  static void onRecv(const uint8_t* mac, const uint8_t* data, int len) {
+    SimReceiver* r = self();
+    switch (camCheck(data, len)) {
+      case CAM_MSG_HEADER: r->onHeader(mac, *(const ImageHeader*)data); break;
+      case CAM_MSG_DATA:
+      case CAM_MSG_PARITY: r->processPacket(*(const ImagePacket*)data, len); break;
+      default: break;
+    }
+  }
+
+  void sendNack(Context& c, bool giveUp) {
+    if (!senderKnown) return;
+    if (!esp_now_is_peer_exist(senderMac)) {
+      esp_now_peer_info_t peer = {};
+      memcpy(peer.peer_addr, senderMac, 6);
+      esp_now_add_peer(&peer);
+    }
+    NackPacket nack;
+    rxBuildNack(c, nack, giveUp, simMillis());
+    esp_now_send(senderMac, (const uint8_t*)&nack, sizeof(nack));
+    if (nack.missingCount) stats.nacksSent++;
+  }
+
+  void reset(Context& c) { c.active = false; }
+
+  // The sender cycles through `frames` in order, one capture per `layers`
+  // frame IDs starting with 1; a base layer receiver is given the base frames
+  bool intact(const Context& c) const {
+    uint8_t layers = c.header.layers ? c.header.layers : 1;
+    const std::vector<uint8_t>& sent = frames[(c.header.hdr.frameId - 1) / layers % frames.size()];
+    return sent.size() == c.header.imageSize && memcmp(sent.data(), c.image.data(), sent.size()) == 0;
+  }
+
+  void complete(Context& c) {
+    if (selectiveRepeat) sendNack(c, false);
+
+    if (intact(c)) {
+      stats.framesCompleted++;
+      stats.latencyMs.push_back(simMillis() - c.header.captureMs);
+    } else {
+      stats.framesCorrupt++;
+    }
+
+    for (Context& other : contexts) {
+      if (&other == &c || !other.active) continue;
+      if (rxNewer(c.header.hdr.frameId, other.header.hdr.frameId)) {
+        if (selectiveRepeat) sendNack(other, true);
+        stats.framesSuperseded++;
+        reset(other);
+      }
+    }
+    reset(c);
+  }
+
+  void processPacket(const ImagePacket& packet, int len) {
+    Context* c = rxFindFrame(contexts.data(), contexts.size(), packet.hdr.frameId);
+    if (!c) return;
+
+    uint8_t result = rxAddPacket(*c, packet, len, simMillis());
+    if (result & RX_PACKET_REPAIRED) stats.packetsRepaired++;
+    if (result & RX_PACKET_RECOVERED) stats.packetsRecovered++;
+    if (result & RX_FRAME_COMPLETE) complete(*c);
+  }
+
+  void onHeader(const uint8_t* mac, const ImageHeader& header) {
+    if (!rxHeaderValid(header, maxFrameSize)) return;
+    if (rxFindFrame(contexts.data(), contexts.size(), header.hdr.frameId)) return;
+    if (!camLayerWanted(header, lastFullLayerMs, simMillis())) return;
+
+    stats.framesMissed += rxMissedFrames(sequence, header);
+
+    Context* c = rxPickFrame(contexts.data(), contexts.size(), header.hdr.frameId);
+    if (c->active) stats.framesGivenUp++;
+
+    rxStartFrame(*c, header, c->image.data(), simMillis());
+    memcpy(senderMac, mac, 6);
+    senderKnown = true;
+  }
+
+  // checkRepair() and checkTimeout()
+  void tick() {
+    uint32_t now = simMillis();
+    for (Context& c : contexts) {
+      if (!c.active) continue;
+
+      if (selectiveRepeat && rxNackDue(c, now)) {
+        sendNack(c, false);
+        c.nackRounds++;
+      }
+
+      if (now - c.lastPacketTime > 3000 || rxSettled(c, selectiveRepeat, now)) {
+        stats.framesGivenUp++;
+        reset(c);
+      }
+    }
+  }
+
+public:
+  // rxFrames contexts for frames of up to maxFrameSize bytes; the defaults
+  // are ESPNOWCAMRECIEVER's, Master_Display has 3 x FRAME_SLOT_SIZE (40000)
+  SimReceiver(EspNowSim& s, const SimMac& mac, const std::vector<std::vector<uint8_t>>& sent, bool repeat,
+              int rxFrames = SIM_RX_FRAMES, uint32_t maxSize = SIM_MAX_FRAME_SIZE)
+      : sim(s), selectiveRepeat(repeat), frames(sent), maxFrameSize(maxSize), contexts(rxFrames),
+        senderKnown(false), sequence(), lastFullLayerMs(0) {
+    uint16_t maxPackets = (maxFrameSize + CAM_PACKET_PAYLOAD - 1) / CAM_PACKET_PAYLOAD;
+    uint16_t maxParity = maxPackets + FEC_MAX_PARITY;
+    for (Context& c : contexts) {
+      c.active = false;
+      c.image.assign(maxFrameSize, 0);
+      c.receivedStore.assign(bitsetWords(maxPackets), 0);
+      c.parityStore.assign((size_t)maxParity * FEC_PAYLOAD_SIZE, 0);
+      c.parityBitStore.assign(bitsetWords(maxParity), 0);
+      c.receivedBits = c.receivedStore.data();
+      c.parityBuffer = c.parityStore.data();
+      c.parityBits = c.parityBitStore.data();
+    }
+
+    device = sim.addDevice(mac.data(), this);
+    sim.at(0, device, []() {
+      esp_now_init();
+      esp_now_register_recv_cb(onRecv);
+    });
+    // The packet task wakes at least every 10 ms
+    sim.every(10000, 10000, device, [this]() { tick(); });
+  }
+
+  const SimReceiverStats& getStats() const { return stats; }
+};
+
+// -------- Reporting --------
+
+inline uint32_t simPercentile(std::vector<uint32_t> values, int pct) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t i = (values.size() - 1) * pct / 100;
+  return values[i];
+}
+
+// Recorded JPEG frames: the files given, or the sample images in the repo
+inline std::vector<std::vector<uint8_t>> simLoadFrames(int count, char** paths) {
+  static const char* samples[] = {
+    "../Signal/SignalMaster/Data/lena20k.jpg",
+    "../Signal/SignalMaster/Data/Baboon40.jpg",
+    "../Signal/SignalMaster/Data/EagleEye.jpg",
+    "../Signal/SignalMaster/Data/Mouse480.jpg",
+  };
+  std::vector<std::vector<uint8_t>> frames;
+  for (int i = 0; i < count; i++) {
+    std::vector<uint8_t> data = simReadFile(paths[i]);
+    if (data.empty() || data.size() > SIM_MAX_FRAME_SIZE) {
+      fprintf(stderr, "Skipping %s (missing or over %d bytes)\n", paths[i], SIM_MAX_FRAME_SIZE);
+      continue;
+    }
+    frames.push_back(data);
+  }
+  if (count == 0) {
+    for (const char* path : samples) {
+      std::vector<uint8_t> data = simReadFile(path);
+      if (!data.empty()) frames.push_back(data);
+    }
+  }
+  return frames;
+}
@@ -0,0 +1,92 @@
+// SimJpeg.h
+#pragma once
+//
+// File and libjpeg helpers for the host tools: read a recorded JPEG,
+// decode it to gray or RGB at 1/1..1/8 scale, encode RGB back to JPEG.
+//
+
+#include <stdio.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <vector>
+#include <jpeglib.h>
+
+// Reads a whole file; empty when it cannot be read
+inline std::vector<uint8_t> simReadFile(const char* path) {
+  std::vector<uint8_t> data;
+  FILE* f = fopen(path, "rb");
+  if (!f) return data;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  return data;
+}
+
+struct SimJpegError {
+  jpeg_error_mgr mgr;
+  jmp_buf jump;
+};
+
+inline void simJpegErrorExit(j_common_ptr cinfo) {
+  longjmp(((SimJpegError*)cinfo->err)->jump, 1);
+}
+
+// components: 1 = gray, 3 = RGB. scale: 1, 2, 4 or 8 (output = size / scale)
+inline bool simDecodeJpeg(const uint8_t* jpeg, size_t len, int components, int scale,
+                          std::vector<uint8_t>& pixels, int& width, int& height) {
+  jpeg_decompress_struct cinfo;
+  SimJpegError err;
+  cinfo.err = jpeg_std_error(&err.mgr);
+  err.mgr.error_exit = simJpegErrorExit;
+  if (setjmp(err.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, (unsigned char*)jpeg, len);
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = scale;
+  jpeg_start_decompress(&cinfo);
+
+  width = cinfo.output_width;
+  height = cinfo.output_height;
+  pixels.resize((size_t)width * height * components);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = &pixels[(size_t)cinfo.output_scanline * width * components];
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return true;
+}
+
+inline std::vector<uint8_t> simEncodeJpeg(const uint8_t* rgb, int width, int height, int quality) {
+  jpeg_compress_struct cinfo;
+  jpeg_error_mgr jerr;
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+
+  unsigned char* out = nullptr;
+  unsigned long outLen = 0;
+  jpeg_mem_dest(&cinfo, &out, &outLen);
+  cinfo.image_width = width;
+  cinfo.image_height = height;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW row = (JSAMPROW)&rgb[(size_t)cinfo.next_scanline * width * 3];
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+
+  std::vector<uint8_t> jpeg(out, out + outLen);
+  free(out);
+  return jpeg;
+}
@@ -0,0 +1,27 @@
+// SimTest.h
+#pragma once
+//
+// Minimal checks for the host tests: CHECK() reports the failing line and
+// carries on, simTestResult() is main()'s exit code.
+//
+
+#include <stdio.h>
+
+static int simTestFailures = 0;
+
+#define CHECK(cond)                                                        \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      simTestFailures++;                                                   \
+    }                                                                      \
+  } while (0)
+
+inline int simTestResult(const char* name) {
+  if (simTestFailures) {
+    printf("%s: %d check(s) failed\n", name, simTestFailures);
+    return 1;
+  }
+  printf("%s: OK\n", name);
+  return 0;
+}
@@ -0,0 +1,42 @@
+// conceal_test.cpp
+//
+// jpegConcealRowLost(), which the display callbacks use to leave patched
+// bands of a concealed frame on screen: the MCU row of a decoded pixel
+// row at each decode scale, and no out-of-range shift for rows past
+// CONCEAL_MAX_ROWS, above the frame or without a concealment.
+//
+
+#include "JpegConceal.h"
+#include "SimTest.h"
+
+int main() {
+  const uint64_t rows = (1ULL << 0) | (1ULL << 5) | (1ULL << 63);
+
+  // Nothing concealed, or rows outside the frame
+  CHECK(!jpegConcealRowLost(0, 0, 1, 8));
+  CHECK(!jpegConcealRowLost(0, 5 * 8, 1, 8));
+  CHECK(!jpegConcealRowLost(rows, -1, 1, 8));
+  CHECK(!jpegConcealRowLost(rows, 0, 1, 0));
+
+  // Full scale, 8- and 16-pixel MCU rows
+  CHECK(jpegConcealRowLost(rows, 0, 1, 8));
+  CHECK(jpegConcealRowLost(rows, 7, 1, 8));
+  CHECK(!jpegConcealRowLost(rows, 8, 1, 8));
+  CHECK(jpegConcealRowLost(rows, 5 * 8, 1, 8));
+  CHECK(jpegConcealRowLost(rows, 5 * 16 + 15, 1, 16));
+  CHECK(!jpegConcealRowLost(rows, 6 * 16, 1, 16));
+
+  // Scaled decodes: output row y covers source row y * scale
+  CHECK(jpegConcealRowLost(rows, 5 * 8 / 2, 2, 8));
+  CHECK(jpegConcealRowLost(rows, 5, 8, 8));
+  CHECK(!jpegConcealRowLost(rows, 6, 8, 8));
+
+  // The last tracked row, and the rows past it (a shift by 64 or more
+  // would be undefined)
+  CHECK(jpegConcealRowLost(rows, 63 * 8, 1, 8));
+  for (int32_t y = 64 * 8; y < 256 * 8; y += 8) CHECK(!jpegConcealRowLost(rows, y, 1, 8));
+  CHECK(!jpegConcealRowLost(~0ULL, 64 * 16, 1, 16));
+  CHECK(!jpegConcealRowLost(~0ULL, 400, 8, 8));
+
+  return simTestResult("conceal_test");
+}
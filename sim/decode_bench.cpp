@@ -0,0 +1,167 @@
+// decode_bench.cpp
+//
+// Receiver decode time for frames larger than the panel, before and after
+// decode-time scaling and clipping. Before: every MCU is decoded at full
+// size and the out-of-view blocks are dropped afterwards. After: the frame
+// is decoded at the camDecodeScale() reduction (CameraWindow.h), centred,
+// and the decode stops at the first MCU row below the viewport, as the
+// tft_output / jpegCallback clip does.
+//
+//   build/decode_bench                 sample images at CIF, SVGA and UXGA
+//   build/decode_bench f1.jpg f2.jpg   the files given, as they are
+//
+// The numbers are from libjpeg on the host, not TJpgDec on an ESP32: use
+// the before/after ratio, and the decode ms the receivers print for the
+// device.
+//
+
+#include <chrono>
+#include <string>
+#include "CameraWindow.h"
+#include "SimJpeg.h"
+
+#define VIEW_WIDTH      240   // 240x240 panel
+#define VIEW_HEIGHT     240
+#define CAMERA_QUALITY  80    // libjpeg quality standing in for the sensor's JPEG
+#define RUNS            20
+
+struct Decode {
+  double ms;
+  int rows;   // Output rows decoded
+};
+
+// Decodes at 1/scale and stops once `stopRow` output rows are done
+static Decode decode(const std::vector<uint8_t>& jpeg, int scale, int stopRow) {
+  jpeg_decompress_struct cinfo;
+  SimJpegError err;
+  cinfo.err = jpeg_std_error(&err.mgr);
+  err.mgr.error_exit = simJpegErrorExit;
+  Decode d = {0, 0};
+  if (setjmp(err.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return d;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, (unsigned char*)jpeg.data(), jpeg.size());
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = JCS_RGB;
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = scale;
+  jpeg_start_decompress(&cinfo);
+
+  std::vector<uint8_t> row(cinfo.output_width * 3);
+  JSAMPROW rows[1] = {row.data()};
+  while (cinfo.output_scanline < cinfo.output_height && (int)cinfo.output_scanline < stopRow) {
+    jpeg_read_scanlines(&cinfo, rows, 1);
+    d.rows++;
+  }
+  if (cinfo.output_scanline < cinfo.output_height) {
+    jpeg_abort_decompress(&cinfo);
+  } else {
+    jpeg_finish_decompress(&cinfo);
+  }
+  jpeg_destroy_decompress(&cinfo);
+  d.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return d;
+}
+
+static Decode best(const std::vector<uint8_t>& jpeg, int scale, int stopRow) {
+  Decode fastest = decode(jpeg, scale, stopRow);
+  for (int i = 1; i < RUNS; i++) {
+    Decode d = decode(jpeg, scale, stopRow);
+    if (d.ms < fastest.ms) fastest = d;
+  }
+  return fastest;
+}
+
+// Bilinear resize of an RGB image, standing in for a larger sensor mode
+static std::vector<uint8_t> resize(const std::vector<uint8_t>& src, int sw, int sh, int dw, int dh) {
+  std::vector<uint8_t> dst((size_t)dw * dh * 3);
+  for (int y = 0; y < dh; y++) {
+    float fy = (y + 0.5f) * sh / dh - 0.5f;
+    int y0 = fy < 0 ? 0 : (int)fy;
+    int y1 = y0 + 1 < sh ? y0 + 1 : sh - 1;
+    float wy = fy - y0 < 0 ? 0 : fy - y0;
+    for (int x = 0; x < dw; x++) {
+      float fx = (x + 0.5f) * sw / dw - 0.5f;
+      int x0 = fx < 0 ? 0 : (int)fx;
+      int x1 = x0 + 1 < sw ? x0 + 1 : sw - 1;
+      float wx = fx - x0 < 0 ? 0 : fx - x0;
+      for (int c = 0; c < 3; c++) {
+        float top = src[(y0 * sw + x0) * 3 + c] * (1 - wx) + src[(y0 * sw + x1) * 3 + c] * wx;
+        float bottom = src[(y1 * sw + x0) * 3 + c] * (1 - wx) + src[(y1 * sw + x1) * 3 + c] * wx;
+        dst[((size_t)y * dw + x) * 3 + c] = (uint8_t)(top * (1 - wy) + bottom * wy + 0.5f);
+      }
+    }
+  }
+  return dst;
+}
+
+static void run(const char* name, const std::vector<uint8_t>& jpeg) {
+  uint16_t width = 0, height = 0;
+  if (!camJpegSize(jpeg.data(), jpeg.size(), width, height)) {
+    fprintf(stderr, "%s: not a baseline JPEG\n", name);
+    return;
+  }
+
+  // Where the receivers put the frame: centred, cropped to the viewport
+  uint8_t scale = camDecodeScale(width, height, VIEW_WIDTH, VIEW_HEIGHT);
+  int top = ((int)VIEW_HEIGHT - (int)(height / scale)) / 2;
+  int stopRow = top < 0 ? VIEW_HEIGHT - top : height / scale;
+
+  Decode before = best(jpeg, 1, height);
+  Decode after = best(jpeg, scale, stopRow);
+  printf("%-16s %4ux%-4u %6.1f kB   1/%u  %4d/%-4u  %7.2f  %7.2f  %5.1fx\n", name, width, height,
+         jpeg.size() / 1000.0, scale, after.rows, height / scale, before.ms, after.ms,
+         after.ms > 0 ? before.ms / after.ms : 0.0);
+}
+
+int main(int argc, char** argv) {
+  printf("Viewport %dx%d, best of %d decodes (libjpeg on the host)\n", VIEW_WIDTH, VIEW_HEIGHT, RUNS);
+  printf("%-16s %9s  %9s  %5s  %9s  %7s  %7s  %6s\n", "frame", "size", "bytes", "scale", "rows", "before",
+         "after", "gain");
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      std::vector<uint8_t> jpeg = simReadFile(argv[i]);
+      if (jpeg.empty()) {
+        fprintf(stderr, "Cannot read %s\n", argv[i]);
+        return 1;
+      }
+      run(argv[i], jpeg);
+    }
+    return 0;
+  }
+
+  static const char* samples[] = {
+    "../Signal/SignalMaster/Data/lena20k.jpg",
+    "../Signal/SignalMaster/Data/Baboon40.jpg",
+    "../Signal/SignalMaster/Data/EagleEye.jpg",
+    "../Signal/SignalMaster/Data/Mouse480.jpg",
+  };
+  // Frame sizes the OV2640 sends when it cannot window to the panel
+  const struct { const char* name; int width; int height; } sizes[] = {
+    {"CIF", 400, 296}, {"SVGA", 800, 600}, {"UXGA", 1600, 1200},
+  };
+
+  for (const char* path : samples) {
+    std::vector<uint8_t> file = simReadFile(path);
+    std::vector<uint8_t> rgb;
+    int width, height;
+    if (file.empty() || !simDecodeJpeg(file.data(), file.size(), 3, 1, rgb, width, height)) {
+      fprintf(stderr, "Cannot read %s: run from sim/\n", path);
+      return 1;
+    }
+    std::string image = path;
+    image = image.substr(image.rfind('/') + 1, image.rfind('.') - image.rfind('/') - 1);
+
+    for (const auto& size : sizes) {
+      std::vector<uint8_t> frame = resize(rgb, width, height, size.width, size.height);
+      std::string name = image + " " + size.name;
+      run(name.c_str(), simEncodeJpeg(frame.data(), size.width, size.height, CAMERA_QUALITY));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,104 @@
+// fanout_bench.cpp
+//
+// One camera streaming to 1, 3 and 8 displays: unicast to each display
+// against one broadcast stream with merged repair rounds (NackMerge), on a
+// clean and a lossy link. Prints the frame rate the displays get, their
+// latency, and what each frame costs on the air.
+//
+//   build/fanout_bench [--loss=PCT] [--seconds=S] [frame.jpg ...]
+//
+// Unicast frames get MAC retries (3 here, as configured on the link);
+// broadcast frames get none and rely on FEC and the merged repairs. The
+// frame header is unicast to each display either way (ESPCAMSENDER.ino).
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include "SimCamera.h"
+
+#define MAC_RETRIES 3
+
+struct FanoutResult {
+  double meanFps;        // Per display
+  double minFps;
+  uint32_t p99Ms;        // Worst display's p99 latency
+  uint32_t missed;       // Frames whose header a display never got, all displays
+  double airBytesPerFrame;
+  double airtimePct;
+  bool corrupt;
+};
+
+static FanoutResult run(int receivers, bool broadcast, double loss, uint32_t seconds,
+                        const std::vector<std::vector<uint8_t>>& frames) {
+  SimLinkConfig link;
+  link.lossPct = loss;
+  link.retries = MAC_RETRIES;
+  SimSenderConfig config;
+  config.fanout = broadcast;
+
+  EspNowSim sim(link);
+  std::vector<SimMac> macs;
+  for (int i = 0; i < receivers; i++) macs.push_back(simMac(0x10 + i));
+  SimSender camera(sim, simMac(0x01), macs, frames, config);
+  std::vector<std::unique_ptr<SimReceiver>> displays;
+  for (const SimMac& mac : macs) displays.emplace_back(new SimReceiver(sim, mac, frames, true));
+  sim.run((uint64_t)seconds * 1000000);
+
+  FanoutResult r = {0, 1e9, 0, 0, 0, 0, false};
+  for (const auto& display : displays) {
+    const SimReceiverStats& rx = display->getStats();
+    double fps = rx.framesCompleted / (double)seconds;
+    r.meanFps += fps / receivers;
+    if (fps < r.minFps) r.minFps = fps;
+    r.p99Ms = std::max(r.p99Ms, simPercentile(rx.latencyMs, 99));
+    r.missed += rx.framesMissed;
+    if (rx.framesCorrupt) r.corrupt = true;
+  }
+  const SimStats& air = sim.getStats();
+  uint32_t sent = camera.getStats().framesSent;
+  r.airBytesPerFrame = sent ? (double)air.bytesOnAir / sent : 0;
+  r.airtimePct = air.airtimeUs * 100.0 / ((uint64_t)seconds * 1000000);
+  return r;
+}
+
+int main(int argc, char** argv) {
+  std::vector<double> losses = {0, 5};
+  uint32_t seconds = 20;
+  std::vector<char*> files;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--loss=", 7) == 0) losses = {atof(argv[i] + 7)};
+    else if (strncmp(argv[i], "--seconds=", 10) == 0) seconds = atoi(argv[i] + 10);
+    else if (argv[i][0] == '-') {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return 2;
+    }
+    else files.push_back(argv[i]);
+  }
+
+  std::vector<std::vector<uint8_t>> frames = simLoadFrames(files.size(), files.data());
+  if (frames.empty()) {
+    fprintf(stderr, "No frames: run from sim/ or pass JPEG files\n");
+    return 1;
+  }
+  uint32_t bytes = 0;
+  for (const auto& frame : frames) bytes += frame.size();
+  printf("%zu frames of %u bytes avg, %u s per run, %d MAC retries for unicast\n", frames.size(),
+         (unsigned)(bytes / frames.size()), seconds, MAC_RETRIES);
+  printf("loss  displays  stream     fps/display  (min)  p99 ms  missed  air kB/frame  busy\n");
+
+  bool corrupt = false;
+  for (double loss : losses) {
+    for (int receivers : {1, 3, 8}) {
+      for (bool broadcast : {false, true}) {
+        if (broadcast && receivers == 1) continue;
+        FanoutResult r = run(receivers, broadcast, loss, seconds, frames);
+        printf("%3.0f%%  %8d  %-9s  %11.2f  %5.2f  %6u  %6u  %12.1f  %3.0f%%\n", loss, receivers,
+               broadcast ? "broadcast" : "unicast", r.meanFps, r.minFps, r.p99Ms, r.missed,
+               r.airBytesPerFrame / 1000, r.airtimePct);
+        corrupt |= r.corrupt;
+      }
+    }
+  }
+  return corrupt ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+// fec_bench.cpp
+//
+// FEC cost and benefit. Times fecEncode / fecRecover per 240-byte packet
+// on a recorded-size frame, then streams the sample JPEGs over the
+// emulated link at several loss rates with each FEC setting to show the
+// air overhead against the frames shown and the repairs still needed.
+//
+//   build/fec_bench [loss% ...]
+//
+
+#include <stdlib.h>
+#include <chrono>
+#include "SimCamera.h"
+
+static double nsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void timeCodec(uint8_t group, uint8_t parity) {
+  const uint32_t size = 17811;   // Average of the sample frames
+  const int rounds = 2000;
+  std::vector<uint8_t> frame(size);
+  for (uint8_t& b : frame) b = rand();
+  uint16_t total = (size + FEC_PAYLOAD_SIZE - 1) / FEC_PAYLOAD_SIZE;
+  uint16_t blocks = fecBlockCount(total, group);
+  std::vector<uint8_t> parityData((size_t)blocks * parity * FEC_PAYLOAD_SIZE);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (uint16_t block = 0; block < blocks; block++) {
+      for (uint8_t cls = 0; cls < parity; cls++) {
+        fecEncode(frame.data(), size, total, group, parity, block, cls,
+                  &parityData[(block * parity + cls) * FEC_PAYLOAD_SIZE]);
+      }
+    }
+  }
+  double encodeNs = nsSince(start) / rounds / total;
+
+  // One loss in every block, recovered from its class
+  std::vector<uint64_t> bits(bitsetWords(total), ~0ULL);
+  for (uint16_t block = 0; block < blocks; block++) {
+    uint16_t lost = block * group;
+    bits[lost >> 6] &= ~(1ULL << (lost & 63));
+  }
+  uint32_t recovered = 0;
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (uint16_t block = 0; block < blocks; block++) {
+      recovered += fecRecover(frame.data(), size, bits.data(), total, group, parity, block, 0,
+                              &parityData[block * parity * FEC_PAYLOAD_SIZE]) >= 0;
+    }
+  }
+  double recoverNs = nsSince(start) / rounds / blocks;
+
+  printf("FEC %2u:%u  encode %6.0f ns per data packet   recover %6.0f ns per lost packet%s\n",
+         group, parity, encodeNs, recoverNs, recovered == (uint32_t)rounds * blocks ? "" : "  (MISMATCH)");
+}
+
+static void streamRun(double loss, uint8_t group, uint8_t parity, const std::vector<std::vector<uint8_t>>& frames) {
+  SimLinkConfig link;
+  link.lossPct = loss;
+  link.seed = 3;
+  SimSenderConfig config;
+  config.fecGroup = group;
+  config.fecParity = parity;
+
+  const uint32_t seconds = 30;
+  EspNowSim sim(link);
+  std::vector<SimMac> macs = {simMac(0x10)};
+  SimSender camera(sim, simMac(0x01), macs, frames, config);
+  SimReceiver display(sim, macs[0], frames, true);
+  sim.run((uint64_t)seconds * 1000000);
+
+  const SimReceiverStats& rx = display.getStats();
+  const SimSenderStats& tx = camera.getStats();
+  printf("%4.0f%%   %2u:%u   %5.2f   %6u  %5u  %6u   %7.1f   %4u\n", loss, group, parity,
+         rx.framesCompleted / (double)seconds, simPercentile(rx.latencyMs, 50), rx.packetsRecovered,
+         tx.packetsResent, sim.getStats().bytesOnAir / 1000.0 / (tx.framesSent ? tx.framesSent : 1),
+         simPercentile(rx.latencyMs, 99));
+}
+
+int main(int argc, char** argv) {
+  printf("Codec timing on this host\n");
+  timeCodec(4, 1);
+  timeCodec(8, 1);
+  timeCodec(8, 2);
+  timeCodec(16, 2);
+  timeCodec(32, 4);
+
+  std::vector<std::vector<uint8_t>> frames = simLoadFrames(0, nullptr);
+  if (frames.empty()) {
+    fprintf(stderr, "No sample frames: run from sim/\n");
+    return 1;
+  }
+
+  std::vector<double> losses;
+  for (int i = 1; i < argc; i++) losses.push_back(atof(argv[i]));
+  if (losses.empty()) losses = {0, 2, 5, 10};
+
+  const uint8_t settings[][2] = {{0, 1}, {16, 1}, {8, 1}, {8, 2}, {4, 1}};
+  printf("\nloss   FEC  frames/s  p50ms  FEC-fix  resent  kB/frame   p99ms\n");
+  for (double loss : losses) {
+    for (const auto& s : settings) streamRun(loss, s[0], s[1], frames);
+  }
+  return 0;
+}
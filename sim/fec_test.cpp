@@ -0,0 +1,125 @@
+// fec_test.cpp
+//
+// fecEncode / fecRecover round trips: every single lost packet of every
+// parity class is rebuilt exactly, for each group and parity setting and
+// frame sizes with a short last packet; two losses in one class are not.
+//
+
+#include <stdlib.h>
+#include <vector>
+#include "PacketFec.h"
+#include "FramePool.h"
+#include "SimTest.h"
+
+struct Coded {
+  std::vector<uint8_t> frame;
+  std::vector<uint8_t> parity;   // FEC_PAYLOAD_SIZE per parity packet
+  uint16_t totalPackets;
+};
+
+static Coded encode(uint32_t size, uint8_t group, uint8_t parity, uint32_t seed) {
+  Coded c;
+  c.frame.resize(size);
+  srand(seed);
+  for (uint8_t& b : c.frame) b = rand();
+  c.totalPackets = (size + FEC_PAYLOAD_SIZE - 1) / FEC_PAYLOAD_SIZE;
+
+  uint16_t blocks = fecBlockCount(c.totalPackets, group);
+  CHECK(fecParityCount(c.totalPackets, group, parity) == blocks * parity);
+  c.parity.resize((size_t)blocks * parity * FEC_PAYLOAD_SIZE);
+  for (uint16_t block = 0; block < blocks; block++) {
+    for (uint8_t cls = 0; cls < parity; cls++) {
+      fecEncode(c.frame.data(), size, c.totalPackets, group, parity, block, cls,
+                &c.parity[(block * parity + cls) * FEC_PAYLOAD_SIZE]);
+    }
+  }
+  return c;
+}
+
+// Drops `lost` from a copy of the frame and runs fecRecover on its class
+static int dropAndRecover(const Coded& c, uint8_t group, uint8_t parity, const std::vector<uint16_t>& lost,
+                          std::vector<uint8_t>& rx, std::vector<uint64_t>& bits) {
+  uint32_t size = c.frame.size();
+  rx = c.frame;
+  bits.assign(bitsetWords(c.totalPackets), 0);
+  for (uint16_t i = 0; i < c.totalPackets; i++) bitsetSet(bits.data(), i);
+  for (uint16_t i : lost) {
+    bits[i >> 6] &= ~(1ULL << (i & 63));
+    memset(&rx[(uint32_t)i * FEC_PAYLOAD_SIZE], 0xA5, fecPacketSize(size, i));
+  }
+  uint16_t block = lost[0] / group;
+  uint8_t cls = (lost[0] % group) % parity;
+  return fecRecover(rx.data(), size, bits.data(), c.totalPackets, group, parity, block, cls,
+                    &c.parity[(block * parity + cls) * FEC_PAYLOAD_SIZE]);
+}
+
+static void testSingleLoss() {
+  const uint8_t groups[] = {1, 2, 4, 8, 16, FEC_MAX_GROUP};
+  const uint32_t sizes[] = {1, FEC_PAYLOAD_SIZE, FEC_PAYLOAD_SIZE + 1, 5000, 17811, 34999};
+  uint32_t cases = 0;
+
+  for (uint8_t group : groups) {
+    for (uint8_t parity = 1; parity <= FEC_MAX_PARITY && parity <= group; parity++) {
+      for (uint32_t size : sizes) {
+        Coded c = encode(size, group, parity, size * 31 + group * 7 + parity);
+        std::vector<uint8_t> rx;
+        std::vector<uint64_t> bits;
+
+        for (uint16_t lost = 0; lost < c.totalPackets; lost++) {
+          int recovered = dropAndRecover(c, group, parity, {lost}, rx, bits);
+          CHECK(recovered == lost);
+          CHECK(rx == c.frame);
+          cases++;
+        }
+
+        // Nothing missing in the class: nothing to do
+        std::vector<uint64_t> all(bitsetWords(c.totalPackets), 0);
+        for (uint16_t i = 0; i < c.totalPackets; i++) bitsetSet(all.data(), i);
+        rx = c.frame;
+        CHECK(fecRecover(rx.data(), size, all.data(), c.totalPackets, group, parity, 0, 0, c.parity.data()) == -1);
+      }
+    }
+  }
+  printf("%u single-loss round trips\n", cases);
+}
+
+static void testDoubleLoss() {
+  for (uint8_t parity = 1; parity <= FEC_MAX_PARITY; parity++) {
+    const uint8_t group = 8;
+    Coded c = encode(17811, group, parity, parity);
+    std::vector<uint8_t> rx;
+    std::vector<uint64_t> bits;
+
+    // Two packets of one class: unrecoverable, and the frame is untouched
+    int recovered = dropAndRecover(c, group, parity, {8, (uint16_t)(8 + parity)}, rx, bits);
+    CHECK(recovered == -1);
+    CHECK(rx[8 * FEC_PAYLOAD_SIZE] == 0xA5);
+
+    // Neighbours in different classes (interleaved parity): both rebuilt
+    if (parity > 1) {
+      dropAndRecover(c, group, parity, {8, 9}, rx, bits);
+      CHECK(fecRecover(rx.data(), rx.size(), bits.data(), c.totalPackets, group, parity, 1, 0,
+                       &c.parity[(1 * parity + 0) * FEC_PAYLOAD_SIZE]) == 8);
+      bitsetSet(bits.data(), 8);
+      CHECK(fecRecover(rx.data(), rx.size(), bits.data(), c.totalPackets, group, parity, 1, 1,
+                       &c.parity[(1 * parity + 1) * FEC_PAYLOAD_SIZE]) == 9);
+      CHECK(rx == c.frame);
+    }
+  }
+}
+
+static void testCounts() {
+  CHECK(fecBlockCount(75, 8) == 10);
+  CHECK(fecBlockCount(80, 8) == 10);
+  CHECK(fecParityCount(75, 8, 2) == 20);
+  CHECK(fecParityCount(75, 0, 1) == 0);
+  CHECK(fecPacketSize(17811, 74) == 17811 - 74 * FEC_PAYLOAD_SIZE);
+  CHECK(fecPacketSize(480, 1) == FEC_PAYLOAD_SIZE);
+}
+
+int main() {
+  testCounts();
+  testSingleLoss();
+  testDoubleLoss();
+  return simTestResult("fec_test");
+}
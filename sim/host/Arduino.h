@@ -0,0 +1,32 @@
+// Arduino.h
+#pragma once
+//
+// The few Arduino-ESP32 calls the camera code needs, for host builds of
+// sources that include <Arduino.h> directly (see ../Makefile). Only on the
+// include path of those programs.
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+inline bool psramFound() { return false; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+
+struct HostSerial {
+  void println(const char* text) { fprintf(stderr, "%s\n", text); }
+  void printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+  }
+};
+
+inline HostSerial Serial;
@@ -0,0 +1,27 @@
+// esp_camera.h
+#pragma once
+//
+// camera_fb_t and pixformat_t as esp32-camera declares them, for host builds.
+//
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/time.h>
+
+typedef enum {
+  PIXFORMAT_RGB565,
+  PIXFORMAT_YUV422,
+  PIXFORMAT_YUV420,
+  PIXFORMAT_GRAYSCALE,
+  PIXFORMAT_JPEG,
+  PIXFORMAT_RGB888,
+} pixformat_t;
+
+typedef struct {
+  uint8_t* buf;
+  size_t len;
+  size_t width;
+  size_t height;
+  pixformat_t format;
+  struct timeval timestamp;
+} camera_fb_t;
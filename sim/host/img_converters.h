@@ -0,0 +1,50 @@
+// img_converters.h
+#pragma once
+//
+// jpg2rgb565() and fmt2jpg() from esp32-camera on top of libjpeg, for host
+// builds. RGB565 is big-endian, as the camera driver writes it. Sizes and
+// quality levels match; the compressed bytes of course differ from the
+// ESP32 encoder's.
+//
+
+#include <vector>
+#include "esp_camera.h"
+#include "SimJpeg.h"
+
+typedef enum {
+  JPG_SCALE_NONE,
+  JPG_SCALE_2X,
+  JPG_SCALE_4X,
+  JPG_SCALE_8X,
+} jpg_scale_t;
+
+inline bool jpg2rgb565(const uint8_t* src, size_t src_len, uint8_t* out, jpg_scale_t scale) {
+  std::vector<uint8_t> rgb;
+  int width, height;
+  if (!simDecodeJpeg(src, src_len, 3, 1 << scale, rgb, width, height)) return false;
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    const uint8_t* p = &rgb[i * 3];
+    uint16_t c = ((p[0] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[2] >> 3);
+    out[i * 2] = c >> 8;
+    out[i * 2 + 1] = c & 0xFF;
+  }
+  return true;
+}
+
+inline bool fmt2jpg(uint8_t* src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format,
+                    uint8_t quality, uint8_t** out, size_t* out_len) {
+  if (format != PIXFORMAT_RGB565 || src_len < (size_t)width * height * 2) return false;
+  std::vector<uint8_t> rgb((size_t)width * height * 3);
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    uint16_t c = (src[i * 2] << 8) | src[i * 2 + 1];
+    rgb[i * 3] = (c >> 8) & 0xF8;
+    rgb[i * 3 + 1] = (c >> 3) & 0xFC;
+    rgb[i * 3 + 2] = (c << 3) & 0xF8;
+  }
+  std::vector<uint8_t> jpeg = simEncodeJpeg(rgb.data(), width, height, quality);
+  *out = (uint8_t*)malloc(jpeg.size());
+  if (!*out) return false;
+  memcpy(*out, jpeg.data(), jpeg.size());
+  *out_len = jpeg.size();
+  return true;
+}
@@ -0,0 +1,130 @@
+// link_bench.cpp
+//
+// Streams recorded JPEG frames from one SimSender to SimReceivers over an
+// emulated ESP-NOW link and prints frames/s, capture-to-display latency
+// and the bytes that went on the air.
+//
+//   build/link_bench [options] [frame.jpg ...]
+//
+//   --loss=PCT       transmissions lost, per receiver      (0)
+//   --reorder=PCT    frames held back by 3 ms              (0)
+//   --dup=PCT        frames delivered twice                (0)
+//   --latency=US     end of airtime to receive callback    (300)
+//   --jitter=US      extra latency, uniform 0..US          (0)
+//   --rate=BPS       PHY bit rate                          (1000000)
+//   --retries=N      MAC retries for lost unicast frames   (0)
+//   --fec=G:P        FEC group and parity, 0 = off         (8:1)
+//   --no-repeat      selective repeat off
+//   --receivers=N    displays                              (1)
+//   --broadcast      one broadcast stream for all displays
+//   --seconds=S      simulated time                        (30)
+//   --seed=N         random seed                           (1)
+//
+// Without files the sample images in Signal/SignalMaster/Data are used.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include "SimCamera.h"
+
+static bool option(const char* arg, const char* name, const char** value) {
+  size_t n = strlen(name);
+  if (strncmp(arg, name, n) != 0 || arg[n] != '=') return false;
+  *value = arg + n + 1;
+  return true;
+}
+
+int main(int argc, char** argv) {
+  SimLinkConfig link;
+  SimSenderConfig sender;
+  int receiverCount = 1;
+  uint32_t seconds = 30;
+  std::vector<char*> files;
+
+  for (int i = 1; i < argc; i++) {
+    const char* v;
+    if (option(argv[i], "--loss", &v)) link.lossPct = atof(v);
+    else if (option(argv[i], "--reorder", &v)) link.reorderPct = atof(v);
+    else if (option(argv[i], "--dup", &v)) link.duplicatePct = atof(v);
+    else if (option(argv[i], "--latency", &v)) link.latencyUs = atoi(v);
+    else if (option(argv[i], "--jitter", &v)) link.jitterUs = atoi(v);
+    else if (option(argv[i], "--rate", &v)) link.bitRate = atoi(v);
+    else if (option(argv[i], "--retries", &v)) link.retries = atoi(v);
+    else if (option(argv[i], "--seconds", &v)) seconds = atoi(v);
+    else if (option(argv[i], "--seed", &v)) link.seed = atoi(v);
+    else if (option(argv[i], "--receivers", &v)) receiverCount = atoi(v);
+    else if (option(argv[i], "--fec", &v)) {
+      sender.fecGroup = atoi(v);
+      const char* colon = strchr(v, ':');
+      sender.fecParity = colon ? atoi(colon + 1) : 1;
+    }
+    else if (strcmp(argv[i], "--no-repeat") == 0) sender.selectiveRepeat = false;
+    else if (strcmp(argv[i], "--broadcast") == 0) sender.fanout = true;
+    else if (argv[i][0] == '-') {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return 2;
+    }
+    else files.push_back(argv[i]);
+  }
+
+  if (receiverCount < 1 || receiverCount > SIM_MAX_RECEIVERS) {
+    fprintf(stderr, "--receivers must be 1..%d\n", SIM_MAX_RECEIVERS);
+    return 2;
+  }
+  if (sender.fecGroup > FEC_MAX_GROUP || sender.fecParity < 1 || sender.fecParity > FEC_MAX_PARITY) {
+    fprintf(stderr, "--fec must be 0..%d:1..%d\n", FEC_MAX_GROUP, FEC_MAX_PARITY);
+    return 2;
+  }
+
+  std::vector<std::vector<uint8_t>> frames = simLoadFrames(files.size(), files.data());
+  if (frames.empty()) {
+    fprintf(stderr, "No frames: run from sim/ or pass JPEG files\n");
+    return 1;
+  }
+
+  EspNowSim sim(link);
+  std::vector<SimMac> macs;
+  for (int i = 0; i < receiverCount; i++) macs.push_back(simMac(0x10 + i));
+
+  SimSender camera(sim, simMac(0x01), macs, frames, sender);
+  std::vector<std::unique_ptr<SimReceiver>> displays;
+  for (const SimMac& mac : macs) {
+    displays.emplace_back(new SimReceiver(sim, mac, frames, sender.selectiveRepeat));
+  }
+  sim.run((uint64_t)seconds * 1000000);
+
+  uint32_t bytes = 0;
+  for (const auto& frame : frames) bytes += frame.size();
+  const SimStats& air = sim.getStats();
+  const SimSenderStats& tx = camera.getStats();
+
+  printf("Link: loss %.1f%% reorder %.1f%% dup %.1f%% latency %u+%u us, %u bit/s, %u retries\n",
+         link.lossPct, link.reorderPct, link.duplicatePct, link.latencyUs, link.jitterUs,
+         link.bitRate, link.retries);
+  printf("Stream: %zu frames of %u bytes avg, FEC %u:%u, repeat %s, %d receiver(s) %s, %us\n",
+         frames.size(), (unsigned)(bytes / frames.size()), sender.fecGroup, sender.fecParity,
+         sender.selectiveRepeat ? "on" : "off", receiverCount,
+         sender.fanout && receiverCount > 1 ? "broadcast" : "unicast", seconds);
+  printf("Sender: %u frames sent, %u acked, %u unacked, %u resent packets, %u rejected\n",
+         tx.framesSent, tx.framesAcked, tx.framesUnacked, tx.packetsResent, tx.packetsRejected);
+
+  for (size_t i = 0; i < displays.size(); i++) {
+    const SimReceiverStats& rx = displays[i]->getStats();
+    printf("Display %zu: %.2f frames/s, latency p50 %u ms p99 %u ms, %u missed %u given up %u superseded %u corrupt, "
+           "%u FEC %u repaired\n",
+           i, rx.framesCompleted / (double)seconds, simPercentile(rx.latencyMs, 50),
+           simPercentile(rx.latencyMs, 99), rx.framesMissed, rx.framesGivenUp, rx.framesSuperseded,
+           rx.framesCorrupt, rx.packetsRecovered, rx.packetsRepaired);
+  }
+
+  printf("Air: %llu bytes (%.1f kB/s), %llu transmissions, %llu retries, %.1f%% channel busy\n",
+         (unsigned long long)air.bytesOnAir, air.bytesOnAir / 1000.0 / seconds,
+         (unsigned long long)air.transmissions, (unsigned long long)air.retries,
+         air.airtimeUs * 100.0 / ((uint64_t)seconds * 1000000));
+
+  for (const auto& display : displays) {
+    if (display->getStats().framesCorrupt) return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,174 @@
+// motion_bench.cpp
+//
+// MotionDetector over frame sequences, as the door camera's motion mode
+// uses it: one check every MOTION_CHECK_MS on a 1/4-scale gray thumbnail,
+// streaming while motion is seen and for MOTION_HOLD_MS after.
+//
+//   build/motion_bench                  synthetic sequences from the samples
+//   build/motion_bench f1.jpg f2.jpg..  one recorded sequence, in order
+//
+// Each sample image becomes three 30 s sequences with sensor noise: a still
+// scene, the same scene through exposure steps and a slow ramp, and a
+// visitor (a dark figure) crossing the doorway. The first two should stay
+// quiet; the third should stream while the visitor is in view.
+//
+
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include "SimCamera.h"
+#include "SimJpeg.h"
+#include "Modules/ESPNOWCamera/Slave_Camera/MotionDetector.h"
+
+#define MOTION_CHECK_MS     250   // As in Slave_Camera/CommandProcessor.h
+#define MOTION_HOLD_MS      3000
+#define CHECKS_PER_SEQUENCE 120   // 30 s at MOTION_CHECK_MS
+#define VISITOR_IN          40
+#define VISITOR_OUT         80
+
+struct Gray {
+  std::vector<uint8_t> pixels;
+  int width;
+  int height;
+};
+
+struct SequenceResult {
+  int flagged;          // Checks that reported motion
+  int streamed;         // Checks inside a stream (motion + hold)
+  int flaggedInWindow;  // Of those, while the visitor was in view
+  double nsPerUpdate;
+};
+
+static uint32_t noiseState = 1;
+static int noise(int amplitude) {
+  noiseState = noiseState * 1103515245 + 12345;
+  return (int)((noiseState >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+static uint8_t clamp(int v) { return v < 0 ? 0 : v > 255 ? 255 : v; }
+
+enum Scene { STILL, EXPOSURE, VISITOR };
+
+static void renderFrame(const Gray& base, Scene scene, int check, std::vector<uint8_t>& out) {
+  int offset = 0;
+  if (scene == EXPOSURE) {
+    if (check >= 30) offset += 25;
+    if (check >= 60) offset -= 40;
+    if (check >= 60 && check < 90) offset += (check - 60);
+  }
+
+  out.resize(base.pixels.size());
+  for (size_t i = 0; i < out.size(); i++) out[i] = clamp(base.pixels[i] + offset + noise(4));
+
+  if (scene == VISITOR && check >= VISITOR_IN && check < VISITOR_OUT) {
+    int figureW = base.width / 5, figureH = base.height / 2;
+    int x0 = (check - VISITOR_IN) * (base.width - figureW) / (VISITOR_OUT - VISITOR_IN);
+    int y0 = base.height - figureH;
+    for (int y = y0; y < base.height; y++) {
+      for (int x = x0; x < x0 + figureW; x++) out[y * base.width + x] = clamp(30 + noise(4));
+    }
+  }
+}
+
+// Runs the detector the way CommandProcessor::gateMotion does
+static SequenceResult run(const std::vector<std::vector<uint8_t>>& frames, const Gray* size, int inFrom, int inTo) {
+  static MotionDetector detector;
+  detector.reset();
+  SequenceResult r = {0, 0, 0, 0};
+  uint32_t lastMotion = 0;
+  bool active = false;
+  double ns = 0;
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    uint32_t now = i * MOTION_CHECK_MS;
+    auto start = std::chrono::steady_clock::now();
+    bool moved = detector.update(frames[i].data(), size->width, size->height);
+    ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    if (moved) {
+      r.flagged++;
+      if ((int)i >= inFrom && (int)i < inTo) r.flaggedInWindow++;
+      lastMotion = now;
+      active = true;
+    } else if (active && now - lastMotion > MOTION_HOLD_MS) {
+      active = false;
+    }
+    if (active) r.streamed++;
+  }
+  r.nsPerUpdate = ns / frames.size();
+  return r;
+}
+
+static int runRecorded(int count, char** paths) {
+  std::vector<std::vector<uint8_t>> frames;
+  Gray size = {{}, 0, 0};
+  for (int i = 0; i < count; i++) {
+    std::vector<uint8_t> jpeg = simReadFile(paths[i]);
+    Gray g;
+    if (jpeg.empty() || !simDecodeJpeg(jpeg.data(), jpeg.size(), 1, 4, g.pixels, g.width, g.height)) {
+      fprintf(stderr, "Cannot decode %s\n", paths[i]);
+      return 1;
+    }
+    if (size.width && (g.width != size.width || g.height != size.height)) {
+      fprintf(stderr, "%s: frame size changes within the sequence\n", paths[i]);
+      return 1;
+    }
+    size = g;
+    frames.push_back(g.pixels);
+  }
+
+  MotionDetector detector;
+  for (size_t i = 0; i < frames.size(); i++) {
+    bool moved = detector.update(frames[i].data(), size.width, size.height);
+    printf("%-40s %4u/%u blocks %s\n", paths[i], detector.getChangedBlocks(), detector.getBlockCount(),
+           moved ? "MOTION" : "");
+  }
+  SequenceResult r = run(frames, &size, 0, 0);
+  printf("\n%d of %zu checks flagged, %d streamed (%.0f%%), %.0f ns per check at %dx%d\n", r.flagged,
+         frames.size(), r.streamed, 100.0 * r.streamed / frames.size(), r.nsPerUpdate, size.width, size.height);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) return runRecorded(argc - 1, argv + 1);
+
+  static const char* samples[] = {
+    "../Signal/SignalMaster/Data/lena20k.jpg",
+    "../Signal/SignalMaster/Data/Baboon40.jpg",
+    "../Signal/SignalMaster/Data/EagleEye.jpg",
+    "../Signal/SignalMaster/Data/Mouse480.jpg",
+  };
+
+  printf("%d checks per sequence (%d s), visitor in view for checks %d-%d\n", CHECKS_PER_SEQUENCE,
+         CHECKS_PER_SEQUENCE * MOTION_CHECK_MS / 1000, VISITOR_IN, VISITOR_OUT - 1);
+  printf("%-14s %-9s  thumb    flagged  streamed  in-view  ns/check\n", "image", "scene");
+
+  int falseStreams = 0, missedVisitors = 0;
+  for (const char* path : samples) {
+    std::vector<uint8_t> jpeg = simReadFile(path);
+    Gray base;
+    if (jpeg.empty() || !simDecodeJpeg(jpeg.data(), jpeg.size(), 1, 4, base.pixels, base.width, base.height)) {
+      fprintf(stderr, "Cannot read %s: run from sim/\n", path);
+      return 1;
+    }
+
+    const Scene scenes[] = {STILL, EXPOSURE, VISITOR};
+    const char* names[] = {"still", "exposure", "visitor"};
+    for (int s = 0; s < 3; s++) {
+      std::vector<std::vector<uint8_t>> frames(CHECKS_PER_SEQUENCE);
+      for (int i = 0; i < CHECKS_PER_SEQUENCE; i++) renderFrame(base, scenes[s], i, frames[i]);
+      SequenceResult r = run(frames, &base, VISITOR_IN, VISITOR_OUT);
+
+      std::string name = path;
+      name = name.substr(name.rfind('/') + 1);
+      printf("%-14s %-9s  %3dx%-3d  %7d  %8d  %7d  %8.0f\n", name.c_str(), names[s], base.width, base.height,
+             r.flagged, r.streamed, r.flaggedInWindow, r.nsPerUpdate);
+
+      if (scenes[s] != VISITOR && r.streamed) falseStreams++;
+      if (scenes[s] == VISITOR && r.flaggedInWindow < (VISITOR_OUT - VISITOR_IN) / 2) missedVisitors++;
+    }
+  }
+
+  printf("\n%d quiet sequences streamed, %d visitors mostly missed\n", falseStreams, missedVisitors);
+  return falseStreams || missedVisitors ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+// nack_loss_test.cpp
+//
+// Selective repeat under injected loss: the NACK names exactly the missing
+// packets, and over a lossy emulated link the repaired stream shows the
+// frames that a best-effort stream (the old behaviour) drops, intact, at a
+// frame rate close to the clean link's. Both the root sketches and the
+// modular Slave_Camera / Master_Display pair are run.
+//
+
+#include "SimCamera.h"
+#include "SimTest.h"
+
+static void setBit(uint64_t* bits, uint16_t i) { bits[i >> 6] |= 1ULL << (i & 63); }
+
+static bool nackHas(const NackPacket& nack, uint16_t packetNum) {
+  if (packetNum < nack.firstPacket) return false;
+  uint16_t bit = packetNum - nack.firstPacket;
+  return bit < NACK_BITMAP_BYTES * 8 && (nack.bitmap[bit >> 3] & (1 << (bit & 7)));
+}
+
+static void testBuildNack() {
+  uint64_t received[8] = {};
+  const uint16_t total = 300;
+  const uint16_t lost[] = {3, 64, 65, 199, 270, 299};
+  for (uint16_t i = 0; i < total; i++) setBit(received, i);
+  for (uint16_t i : lost) received[i >> 6] &= ~(1ULL << (i & 63));
+
+  NackPacket nack;
+  camBuildNack(nack, 7, received, total, false);
+  CHECK(nack.hdr.type == CAM_MSG_NACK);
+  CHECK(nack.hdr.frameId == 7);
+  CHECK(nack.totalPackets == total);
+  CHECK(nack.firstPacket == 3);
+  // 3..258 fit in the bitmap; 270 and 299 wait for a later round
+  CHECK(nack.missingCount == 4);
+  for (uint16_t i = 0; i < total; i++) {
+    bool missing = i == 3 || i == 64 || i == 65 || i == 199;
+    CHECK(nackHas(nack, i) == missing);
+  }
+
+  // Next round, once the first four are repaired
+  for (uint16_t i : {3, 64, 65, 199}) setBit(received, i);
+  camBuildNack(nack, 7, received, total, false);
+  CHECK(nack.firstPacket == 270);
+  CHECK(nack.missingCount == 2);
+  CHECK(nackHas(nack, 270) && nackHas(nack, 299));
+
+  // Complete, or given up: an empty report acknowledges the frame
+  setBit(received, 270);
+  setBit(received, 299);
+  camBuildNack(nack, 7, received, total, false);
+  CHECK(nack.missingCount == 0);
+  received[0] = 0;
+  camBuildNack(nack, 7, received, total, true);
+  CHECK(nack.missingCount == 0);
+  camSeal(&nack, sizeof(nack));
+  CHECK(camCheck((const uint8_t*)&nack, sizeof(nack)) == CAM_MSG_NACK);
+}
+
+struct LossRun {
+  uint32_t sent;
+  uint32_t shown;
+  uint32_t corrupt;
+  uint32_t repaired;
+  double fps;            // Frames completed per second of the emulated link clock
+};
+
+// The root sketches (ESPCAMSENDER -> ESPNOWCAMRECIEVER), or the modular
+// pair: Slave_Camera's TransmissionManager, one frame in flight with its
+// messages sent in place, to Master_Display's 3 x 40000 byte contexts
+static LossRun runLink(double lossPct, bool repeat, bool modular, const std::vector<std::vector<uint8_t>>& frames) {
+  SimLinkConfig link;
+  link.lossPct = lossPct;
+  link.seed = 7;
+  SimSenderConfig config;
+  config.fecGroup = 0;   // Repairs alone (also the modular slave's default)
+  config.selectiveRepeat = repeat;
+  if (modular) {
+    config.capturesInFlight = 1;
+    config.repairsToFront = false;
+  }
+
+  EspNowSim sim(link);
+  std::vector<SimMac> macs = {simMac(0x10)};
+  SimSender camera(sim, simMac(0x01), macs, frames, config);
+  SimReceiver display(sim, macs[0], frames, repeat, modular ? 3 : SIM_RX_FRAMES, modular ? 40000 : SIM_MAX_FRAME_SIZE);
+  sim.run(20 * 1000000ULL);
+
+  const SimReceiverStats& rx = display.getStats();
+  double seconds = sim.nowUs() / 1e6;
+  return LossRun{camera.getStats().framesSent, rx.framesCompleted, rx.framesCorrupt, rx.packetsRepaired,
+                 rx.framesCompleted / seconds};
+}
+
+static void testLossInjection(bool modular) {
+  std::vector<std::vector<uint8_t>> frames = simLoadFrames(0, nullptr);
+  CHECK(!frames.empty());
+  if (frames.empty()) return;
+
+  LossRun clean = runLink(0, true, modular, frames);
+  printf("%s: %.2f frames/s without loss\n", modular ? "Slave_Camera -> Master_Display" : "ESPCAMSENDER -> ESPNOWCAMRECIEVER",
+         clean.fps);
+  printf("loss  repeat: shown/sent  frames/s  best effort: shown/sent  frames/s\n");
+  for (double loss : {1.0, 5.0, 10.0}) {
+    LossRun sr = runLink(loss, true, modular, frames);
+    LossRun be = runLink(loss, false, modular, frames);
+    printf("%4.0f%%  %6u/%-4u     %6.2f     %6u/%-4u         %6.2f   (%u packets repaired)\n",
+           loss, sr.shown, sr.sent, sr.fps, be.shown, be.sent, be.fps, sr.repaired);
+
+    CHECK(sr.corrupt == 0 && be.corrupt == 0);
+    CHECK(sr.repaired > 0);
+    // Repairs show most frames even at 10% loss; best effort loses most
+    // frames of ~75 packets from 5% on
+    CHECK(sr.shown * 100 >= sr.sent * 60);
+    CHECK(sr.shown > be.shown);
+    if (loss >= 5) CHECK(sr.fps >= 3 * be.fps);
+    // Throughput: repairs cost airtime and round trips, but the rate stays
+    // within reach of the clean link
+    double keep = loss <= 1 ? 0.85 : loss <= 5 ? 0.65 : 0.5;
+    CHECK(sr.fps >= keep * clean.fps);
+  }
+}
+
+int main() {
+  testBuildNack();
+  testLossInjection(false);
+  testLossInjection(true);
+  return simTestResult("nack_loss_test");
+}
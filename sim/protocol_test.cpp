@@ -0,0 +1,122 @@
+// protocol_test.cpp
+//
+// CameraProtocol.h against fixed vectors: the CRC-16/CCITT-FALSE check
+// value, the exact bytes of a sealed data packet and frame header, and
+// camCheck() accepting those and rejecting damaged, short, long and
+// wrong-version messages.
+//
+
+#include "CameraProtocol.h"
+#include "SimTest.h"
+
+static bool sameBytes(const void* a, const uint8_t* b, size_t len) {
+  if (memcmp(a, b, len) == 0) return true;
+  fprintf(stderr, "  got:");
+  for (size_t i = 0; i < len; i++) fprintf(stderr, " %02x", ((const uint8_t*)a)[i]);
+  fprintf(stderr, "\n");
+  return false;
+}
+
+static void testCrc() {
+  // Catalogue check value of CRC-16/CCITT-FALSE
+  CHECK(camCrc16Update(0xFFFF, (const uint8_t*)"123456789", 9) == 0x29B1);
+  CHECK(camCrc16Update(0xFFFF, nullptr, 0) == 0xFFFF);
+
+  // Byte-wise in pieces = in one go
+  const uint8_t data[] = "ESP-NOW camera";
+  uint16_t crc = camCrc16Update(0xFFFF, data, 5);
+  CHECK(camCrc16Update(crc, data + 5, sizeof(data) - 5) == camCrc16Update(0xFFFF, data, sizeof(data)));
+}
+
+static void testLayout() {
+  CHECK(sizeof(CamMsgHeader) == 8);
+  CHECK(sizeof(ImageHeader) == 29);
+  CHECK(CAM_PACKET_HEADER_SIZE == 10);
+  CHECK(sizeof(ImagePacket) == 250);
+  CHECK(sizeof(NackPacket) == 46);
+  CHECK(sizeof(ImagePacket) <= CAM_MAX_MESSAGE);
+  CHECK(sizeof(TextMessagePacket) <= CAM_MAX_MESSAGE);
+}
+
+static void testDataPacket() {
+  ImagePacket packet;
+  camInitHeader(packet.hdr, CAM_MSG_DATA, 0x1234, 5);
+  packet.totalPackets = 75;
+  memcpy(packet.data, "ESP", 3);
+  const int len = CAM_PACKET_HEADER_SIZE + 3;
+  camSeal(&packet, len);
+
+  static const uint8_t expected[] = {
+    0x02, 0x06, 0x34, 0x12, 0x05, 0x00, 0xf7, 0x30,   // DATA, v6, frame 0x1234, seq 5, crc 0x30f7
+    0x4b, 0x00,                                       // 75 packets
+    0x45, 0x53, 0x50,                                 // "ESP"
+  };
+  CHECK(len == sizeof(expected));
+  CHECK(sameBytes(&packet, expected, sizeof(expected)));
+  CHECK(packet.hdr.crc == 0x30f7);
+  CHECK(camCheck((const uint8_t*)&packet, len) == CAM_MSG_DATA);
+
+  // Any single-bit error is caught
+  uint8_t damaged[sizeof(expected)];
+  for (size_t bit = 0; bit < sizeof(expected) * 8; bit++) {
+    memcpy(damaged, expected, sizeof(expected));
+    damaged[bit >> 3] ^= 1 << (bit & 7);
+    CHECK(camCheck(damaged, sizeof(expected)) == 0);
+  }
+
+  // Lengths: no payload, too long
+  CHECK(camCheck(expected, CAM_PACKET_HEADER_SIZE) == 0);
+  CHECK(camCheck(expected, sizeof(ImagePacket) + 1) == 0);
+  CHECK(camCheck(expected, 4) == 0);
+}
+
+static void testImageHeader() {
+  ImageHeader header;
+  memset(&header, 0, sizeof(header));
+  camInitHeader(header.hdr, CAM_MSG_HEADER, 0x1234, 0);
+  header.imageSize = 17811;
+  header.width = 320;
+  header.height = 240;
+  header.totalPackets = 75;
+  header.format = CAM_FORMAT_JPEG;
+  header.quality = 12;
+  header.resolutionMode = 1;
+  header.fecGroup = 8;
+  header.fecParity = 1;
+  header.captureMs = 123456;
+  header.layer = CAM_LAYER_FULL;
+  header.layers = 1;
+  camSeal(&header, sizeof(header));
+
+  static const uint8_t expected[] = {
+    0x01, 0x06, 0x34, 0x12, 0x00, 0x00, 0x74, 0xc2,   // HEADER, v6, frame 0x1234, crc 0xc274
+    0x93, 0x45, 0x00, 0x00,                           // 17811 bytes
+    0x40, 0x01, 0xf0, 0x00,                           // 320 x 240
+    0x4b, 0x00,                                       // 75 packets
+    0x00, 0x0c, 0x01,                                 // JPEG, quality 12, QVGA
+    0x08, 0x01,                                       // FEC 8:1
+    0x40, 0xe2, 0x01, 0x00,                           // captured at 123456 ms
+    0x00, 0x01,                                       // full layer of 1
+  };
+  CHECK(sizeof(expected) == sizeof(header));
+  CHECK(sameBytes(&header, expected, sizeof(expected)));
+  CHECK(camCheck(expected, sizeof(expected)) == CAM_MSG_HEADER);
+
+  // Older protocol versions and unknown types are not read
+  uint8_t old[sizeof(expected)];
+  memcpy(old, expected, sizeof(expected));
+  old[1] = CAM_PROTOCOL_VERSION - 1;
+  CHECK(camCheck(old, sizeof(old)) == 0);
+  memcpy(old, expected, sizeof(expected));
+  old[0] = CAM_MSG_TYPE_COUNT;
+  CHECK(camCheck(old, sizeof(old)) == 0);
+  CHECK(camCheck(expected, sizeof(expected) - 1) == 0);
+}
+
+int main() {
+  testCrc();
+  testLayout();
+  testDataPacket();
+  testImageHeader();
+  return simTestResult("protocol_test");
+}
@@ -0,0 +1,212 @@
+// rate_test.cpp
+//
+// RateController over receiver report traces. Synthetic links check the
+// ladder's behaviour: it climbs to the top of an ample link no faster than
+// RATE_HOLD_MS per rung, steps down within RATE_DOWN_REPORTS reports when
+// capacity drops, ignores a single loss spike, and does not flap on a link
+// that hovers at a rung boundary.
+//
+//   build/rate_test             synthetic traces
+//   build/rate_test sender.log  replay the RATE lines of a captured log
+//
+// A replay prints the rung the controller picks after every report next to
+// the rung the sender logged with the following one. Frame sizes are not
+// in the log; the mean size of the frames each report counted stands in.
+//
+
+#include <string.h>
+#include "CameraProtocol.h"
+#include "RateController.h"
+#include "SimTest.h"
+
+#define TARGET_FPS_X10       50      // As in ESPCAMSENDER.ino
+#define RATE_MAX_FRAME_BYTES 35000
+#define SENSOR_FPS           10      // Frames the camera can capture per second
+
+// rateLadder in ESPCAMSENDER.ino
+static const RateRung ladder[] = {
+  {4, 18,  3000},
+  {3, 20,  4000},
+  {3, 12,  6000},
+  {0, 20,  8000},
+  {0, 14, 11000},
+  {1, 18, 13000},
+  {1, 12, 18000},
+  {2, 12, 24000}
+};
+static const uint8_t RUNGS = sizeof(ladder) / sizeof(ladder[0]);
+static const uint8_t START_RUNG = 4;   // HQVGA, the sketch's default
+
+struct Trace {
+  RateController rate;
+  uint32_t now = 0;
+  double frameCredit = 0;   // Fractional frames carried to the next report
+  uint32_t changes = 0;
+  uint32_t lastChange = 0;
+  uint32_t minGapUp = UINT32_MAX;   // Shortest time between a change and a step up
+
+  Trace() { rate.begin(ladder, RUNGS, START_RUNG, TARGET_FPS_X10, RATE_MAX_FRAME_BYTES); }
+
+  // One RATE_REPORT_MS period over a link of `capacity` bytes/s losing
+  // `lossPct` of its packets on the first pass
+  uint8_t report(uint32_t capacity, double lossPct) {
+    uint32_t frameBytes = ladder[rate.getRungIndex()].expectedBytes;
+    double fps = capacity * (1 - lossPct / 100) / frameBytes;
+    if (fps > SENSOR_FPS) fps = SENSOR_FPS;
+    frameCredit += fps * RATE_REPORT_MS / 1000;
+    uint16_t frames = (uint16_t)frameCredit;
+    frameCredit -= frames;
+
+    for (uint16_t i = 0; i < frames; i++) rate.onFrame(frameBytes);
+
+    RateSample s = {};
+    s.periodMs = RATE_REPORT_MS;
+    s.framesDisplayed = frames;
+    s.packetsExpected = (uint32_t)frames * frameBytes / CAM_PACKET_PAYLOAD + 1;
+    s.packetsLost = s.packetsExpected * lossPct / 100;
+    s.bytesReceived = (uint32_t)frames * frameBytes;
+
+    now += RATE_REPORT_MS;
+    uint8_t before = rate.getRungIndex();
+    uint8_t rung = rate.update(s, now);
+    if (rung != before) {
+      if (rung > before && now - lastChange < minGapUp) minGapUp = now - lastChange;
+      changes++;
+      lastChange = now;
+    }
+    return rung;
+  }
+};
+
+static void testAmpleLink() {
+  Trace t;
+  for (int i = 0; i < 120; i++) t.report(300000, 0);
+  printf("ample link: rung %u after 120 s, %u changes, %lu ms between steps up\n", t.rate.getRungIndex(),
+         t.changes, (unsigned long)t.minGapUp);
+  CHECK(t.rate.getRungIndex() == RUNGS - 1);
+  CHECK(t.rate.getStepsDown() == 0);
+  CHECK(t.minGapUp >= RATE_HOLD_MS);
+}
+
+static void testCapacityDrop() {
+  Trace t;
+  for (int i = 0; i < 60; i++) t.report(150000, 0);
+  uint8_t high = t.rate.getRungIndex();
+
+  // Capacity falls to a fifth: the sender should be on a rung that fits
+  // the budget within RATE_DOWN_REPORTS reports
+  const uint32_t low = 30000;
+  int reports = 0;
+  while (ladder[t.rate.getRungIndex()].expectedBytes * TARGET_FPS_X10 / 10 > low && reports < 30) {
+    t.report(low, 0);
+    reports++;
+  }
+  printf("capacity drop: rung %u -> %u in %d reports\n", high, t.rate.getRungIndex(), reports);
+  CHECK(high > t.rate.getRungIndex());
+  CHECK(reports <= RATE_DOWN_REPORTS);
+  CHECK(t.rate.getStepsDown() == 1);   // One jump, not a staircase
+
+  // ...and stays there
+  uint32_t down = t.rate.getStepsDown();
+  for (int i = 0; i < 60; i++) t.report(low, 0);
+  CHECK(t.rate.getStepsDown() == down);
+}
+
+static void testLossSpike() {
+  Trace t;
+  for (int i = 0; i < 30; i++) t.report(150000, 0);
+  uint8_t before = t.rate.getRungIndex();
+  t.report(150000, 30);
+  for (int i = 0; i < 3; i++) t.report(150000, 0);
+  printf("loss spike: rung %u -> %u\n", before, t.rate.getRungIndex());
+  CHECK(t.rate.getStepsDown() == 0);
+  CHECK(t.rate.getRungIndex() >= before);
+
+  // Sustained loss does step down
+  for (int i = 0; i < RATE_DOWN_REPORTS; i++) t.report(150000, 20);
+  CHECK(t.rate.getStepsDown() == 1);
+}
+
+// Capacity alternating around what the top rung needs at the target rate
+static void testBoundary() {
+  Trace t;
+  const uint32_t edge = ladder[RUNGS - 1].expectedBytes * TARGET_FPS_X10 / 10;
+  for (int i = 0; i < 300; i++) t.report(i % 2 ? edge * 11 / 10 : edge * 9 / 10, 0);
+  printf("boundary: %u changes in 300 s (%u up, %u down)\n", t.changes, t.rate.getStepsUp(),
+         t.rate.getStepsDown());
+  CHECK(t.changes <= 300 * 1000 / RATE_HOLD_MS / 4);
+
+  // Noisy loss around the thresholds
+  Trace n;
+  uint32_t seed = 1;
+  for (int i = 0; i < 300; i++) {
+    seed = seed * 1103515245 + 12345;
+    n.report(200000, (seed >> 16) % 12);
+  }
+  printf("noisy loss 0-11%%: %u changes in 300 s\n", n.changes);
+  CHECK(n.changes <= 300 * 1000 / RATE_HOLD_MS / 4);
+}
+
+// RATE,<ms>,<periodMs>,<displayed>,<lost>,<packetsExpected>,<packetsLost>,<bytes>,<rung>
+static int replay(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Cannot read %s\n", path);
+    return 1;
+  }
+
+  RateController rate;
+  bool started = false;
+  int lines = 0, agree = 0;
+  int picked = -1;
+  char line[256];
+  printf("%8s  %5s  %5s  %7s  %7s  %6s  %6s\n", "ms", "fps", "loss", "budget", "frame", "logged", "picks");
+  while (fgets(line, sizeof(line), f)) {
+    const char* p = strstr(line, "RATE,");
+    if (!p) continue;
+    unsigned long now, period, displayed, lost, expected, packetsLost, bytes, rung;
+    if (sscanf(p, "RATE,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu", &now, &period, &displayed, &lost, &expected,
+               &packetsLost, &bytes, &rung) != 8 || rung >= RUNGS) {
+      continue;
+    }
+    if (!started) {
+      rate.begin(ladder, RUNGS, rung, TARGET_FPS_X10, RATE_MAX_FRAME_BYTES);
+      started = true;
+    } else {
+      lines++;
+      if ((int)rung == picked) agree++;
+    }
+
+    RateSample s;
+    s.periodMs = period;
+    s.framesDisplayed = displayed;
+    s.framesLost = lost;
+    s.packetsExpected = expected;
+    s.packetsLost = packetsLost;
+    s.bytesReceived = bytes;
+    if (displayed) rate.onFrame(bytes / displayed);
+    picked = rate.update(s, now);
+    printf("%8lu  %5.1f  %4.1f%%  %7lu  %7lu  %6lu  %6d\n", now, rate.getFpsX10() / 10.0,
+           rate.getLossPermille() / 10.0, (unsigned long)rate.getBudget(), (unsigned long)rate.getFrameBytes(),
+           rung, picked);
+  }
+  fclose(f);
+
+  if (!started) {
+    fprintf(stderr, "%s: no RATE lines\n", path);
+    return 1;
+  }
+  printf("\n%d reports, %lu steps up, %lu down; the next logged rung matches %d of %d\n", lines + 1,
+         (unsigned long)rate.getStepsUp(), (unsigned long)rate.getStepsDown(), agree, lines);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) return replay(argv[1]);
+
+  testAmpleLink();
+  testCapacityDrop();
+  testLossSpike();
+  testBoundary();
+  return simTestResult("rate_test");
+}
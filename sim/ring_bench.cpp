@@ -0,0 +1,150 @@
+// ring_bench.cpp
+//
+// PacketRing against the queue it replaced: a locked FIFO that copies a
+// whole 256-byte item in and out, as xQueueSend/xQueueReceive do. Both
+// move 250-byte messages between two threads as fast as they go; the
+// time the producer spends per message is what the Wi-Fi task pays in
+// the receive callback.
+//
+// Host threads and std::mutex stand in for FreeRTOS tasks, so the numbers
+// compare the two designs rather than predict ESP32 timings.
+//
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "PacketRing.h"
+
+struct QueueItem {
+  uint8_t mac[6];
+  int len;
+  uint8_t data[CAM_MAX_MESSAGE];
+};
+
+// xQueueCreate(depth, sizeof(QueueItem)) lookalike: copy in, copy out
+class LockedQueue {
+private:
+  std::mutex lock;
+  std::condition_variable ready;
+  QueueItem* items;
+  uint32_t depth, head, tail;
+
+public:
+  explicit LockedQueue(uint32_t n) : items(new QueueItem[n]), depth(n), head(0), tail(0) {}
+  ~LockedQueue() { delete[] items; }
+
+  bool send(const QueueItem& item) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (head - tail >= depth) return false;
+    items[head++ % depth] = item;
+    ready.notify_one();
+    return true;
+  }
+
+  bool receive(QueueItem& item) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (!ready.wait_for(guard, std::chrono::milliseconds(1), [this]() { return head != tail; })) return false;
+    item = items[tail++ % depth];
+    return true;
+  }
+};
+
+static const uint8_t benchMac[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x01};
+
+// Touches the message the way processPacket() would read it
+static inline uint32_t consume(const uint8_t* data, int len) {
+  uint32_t sum = 0;
+  for (int i = 0; i < len; i += 16) sum += data[i];
+  return sum;
+}
+
+struct Result {
+  double nsPerMessage;           // Wall time per message, both threads busy
+  double producerNs;             // Time in push()/send() per message
+};
+
+static Result runRing(uint32_t messages) {
+  std::unique_ptr<PacketRing> owner(new PacketRing());
+  PacketRing& ring = *owner;
+  std::atomic<bool> done(false);
+  uint32_t delivered = 0;
+  volatile uint32_t sink = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread consumer([&]() {
+    for (;;) {
+      PacketSlot* slot = ring.peek();
+      if (!slot) {
+        if (done.load()) break;
+        std::this_thread::yield();
+        continue;
+      }
+      sink = sink + consume(slot->data, slot->len);
+      delivered++;
+      ring.release();
+    }
+  });
+
+  uint8_t data[CAM_MAX_MESSAGE] = {};
+  double producerNs = 0;
+  for (uint32_t n = 0; n < messages; n++) {
+    data[0] = n;
+    auto t = std::chrono::steady_clock::now();
+    while (!ring.push(benchMac, data, CAM_MAX_MESSAGE)) std::this_thread::yield();
+    producerNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t).count();
+  }
+  done = true;
+  consumer.join();
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  if (delivered != messages) fprintf(stderr, "PacketRing lost messages\n");
+  return Result{ns / messages, producerNs / messages};
+}
+
+static Result runQueue(uint32_t messages) {
+  LockedQueue queue(PACKET_RING_SLOTS);
+  std::atomic<bool> done(false);
+  uint32_t delivered = 0;
+  volatile uint32_t sink = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread consumer([&]() {
+    QueueItem item;
+    for (;;) {
+      if (!queue.receive(item)) {
+        if (done.load()) break;
+        continue;
+      }
+      sink = sink + consume(item.data, item.len);
+      delivered++;
+    }
+  });
+
+  QueueItem item = {};
+  memcpy(item.mac, benchMac, 6);
+  item.len = CAM_MAX_MESSAGE;
+  double producerNs = 0;
+  for (uint32_t n = 0; n < messages; n++) {
+    item.data[0] = n;
+    auto t = std::chrono::steady_clock::now();
+    while (!queue.send(item)) std::this_thread::yield();
+    producerNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t).count();
+  }
+  done = true;
+  consumer.join();
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  if (delivered != messages) fprintf(stderr, "Locked queue lost messages\n");
+  return Result{ns / messages, producerNs / messages};
+}
+
+int main() {
+  const uint32_t messages = 1000000;
+  Result ring = runRing(messages);
+  Result queue = runQueue(messages);
+  printf("%u x %d-byte messages, producer and consumer threads\n", messages, CAM_MAX_MESSAGE);
+  printf("                ns/message  producer ns/message\n");
+  printf("  PacketRing    %10.1f  %19.1f\n", ring.nsPerMessage, ring.producerNs);
+  printf("  locked queue  %10.1f  %19.1f\n", queue.nsPerMessage, queue.producerNs);
+  return 0;
+}
@@ -0,0 +1,105 @@
+// ring_test.cpp
+//
+// PacketRing as a single-producer / single-consumer queue: full and empty
+// edges, wrap-around, and a two-thread stress run where every message the
+// producer got in must reach the consumer once, in order and intact.
+//
+
+#include <thread>
+#include "PacketRing.h"
+#include "SimTest.h"
+
+static const uint8_t testMac[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x01};
+
+// Message n: variable length, every byte derived from n
+static int fill(uint8_t* data, uint32_t n) {
+  int len = 9 + n % (CAM_MAX_MESSAGE - 8);
+  memcpy(data, &n, 4);
+  for (int i = 4; i < len; i++) data[i] = (uint8_t)(n * 31 + i);
+  return len;
+}
+
+static bool intact(const PacketSlot* slot, uint32_t n) {
+  uint8_t expected[CAM_MAX_MESSAGE];
+  int len = fill(expected, n);
+  return slot->len == len && memcmp(slot->data, expected, len) == 0 && memcmp(slot->mac, testMac, 6) == 0;
+}
+
+static void testEdges() {
+  static PacketRing ring;
+  uint8_t data[CAM_MAX_MESSAGE];
+
+  CHECK(ring.peek() == nullptr);
+  CHECK(!ring.push(testMac, data, 0));
+  CHECK(!ring.push(testMac, data, CAM_MAX_MESSAGE + 1));
+
+  for (uint32_t n = 0; n < PACKET_RING_SLOTS; n++) {
+    int len = fill(data, n);
+    CHECK(ring.push(testMac, data, len));
+  }
+  CHECK(ring.count() == PACKET_RING_SLOTS);
+  CHECK(!ring.push(testMac, data, 10));
+  CHECK(ring.getDrops() == 1);
+
+  // Drain half, refill past the end of the array, drain all in order
+  uint32_t next = 0;
+  for (int i = 0; i < PACKET_RING_SLOTS / 2; i++) {
+    PacketSlot* slot = ring.peek();
+    CHECK(slot && intact(slot, next++));
+    ring.release();
+  }
+  for (uint32_t n = PACKET_RING_SLOTS; n < PACKET_RING_SLOTS * 3 / 2; n++) {
+    int len = fill(data, n);
+    CHECK(ring.push(testMac, data, len));
+  }
+  while (PacketSlot* slot = ring.peek()) {
+    CHECK(intact(slot, next++));
+    ring.release();
+  }
+  CHECK(next == PACKET_RING_SLOTS * 3 / 2);
+  CHECK(ring.count() == 0);
+}
+
+static void testTwoThreads() {
+  static PacketRing ring;
+  const uint32_t messages = 2000000;
+  uint32_t corrupt = 0, outOfOrder = 0, received = 0;
+
+  std::thread consumer([&]() {
+    uint32_t next = 0;
+    while (next < messages) {
+      PacketSlot* slot = ring.peek();
+      if (!slot) {
+        std::this_thread::yield();
+        continue;
+      }
+      uint32_t n;
+      memcpy(&n, slot->data, 4);
+      if (n != next) outOfOrder++;
+      if (!intact(slot, n)) corrupt++;
+      next = n + 1;
+      received++;
+      ring.release();
+    }
+  });
+
+  // The producer retries a full ring, so nothing is lost
+  uint8_t data[CAM_MAX_MESSAGE];
+  for (uint32_t n = 0; n < messages; n++) {
+    int len = fill(data, n);
+    while (!ring.push(testMac, data, len)) std::this_thread::yield();
+  }
+  consumer.join();
+
+  printf("%u messages across threads, %u full-ring retries\n", received, ring.getDrops());
+  CHECK(received == messages);
+  CHECK(outOfOrder == 0);
+  CHECK(corrupt == 0);
+  CHECK(ring.count() == 0);
+}
+
+int main() {
+  testEdges();
+  testTwoThreads();
+  return simTestResult("ring_test");
+}
@@ -0,0 +1,170 @@
+// sendwindow_test.cpp
+//
+// SendWindow's AIMD on a fake clock: additive growth to the cap, halving
+// on failures and refusals, the floor, expiry and the rate estimate. Then
+// the sender task and the send callback updating it from two threads, and
+// the window driving a real stream over links of different capacity.
+//
+
+#include <thread>
+#include "SimCamera.h"
+#include "SimTest.h"
+
+static void testAimdTrace() {
+  SendWindow w;
+  uint32_t now = 0;
+  CHECK(w.getWindow() == SEND_WINDOW_INITIAL);
+
+  // Up to the cap: +1 per window of successes
+  int sends = 0;
+  printf("window after successes:");
+  while (w.getWindow() < SEND_WINDOW_MAX && sends < 1000) {
+    CHECK(w.canSend());
+    w.onSent();
+    w.onComplete(true, now += 2);
+    if (++sends % 4 == 0) printf(" %u", w.getWindow());
+  }
+  printf("  (%d sends)\n", sends);
+  CHECK(w.getWindow() == SEND_WINDOW_MAX);
+  // 4 -> 8 takes about 4 + 5 + 6 + 7 completions
+  CHECK(sends >= 18 && sends <= 26);
+  for (int i = 0; i < 100; i++) {
+    w.onSent();
+    w.onComplete(true, now += 2);
+  }
+  CHECK(w.getWindow() == SEND_WINDOW_MAX);
+
+  // The window limits what is outstanding
+  for (int i = 0; i < SEND_WINDOW_MAX; i++) {
+    CHECK(w.canSend());
+    w.onSent();
+  }
+  CHECK(!w.canSend());
+  CHECK(w.getInFlight() == SEND_WINDOW_MAX);
+
+  // Failure halves it, down to the floor
+  w.onComplete(false, now += 2);
+  CHECK(w.getWindow() == SEND_WINDOW_MAX / 2);
+  CHECK(w.getInFlight() == SEND_WINDOW_MAX - 1);
+  w.onComplete(false, now += 2);
+  w.onComplete(false, now += 2);
+  w.onComplete(false, now += 2);
+  CHECK(w.getWindow() == SEND_WINDOW_MIN);
+  CHECK(w.getBackoffs() == 4);
+  CHECK(w.getFailed() == 4);
+
+  // A refused send frees its place and backs off too
+  uint16_t inFlight = w.getInFlight();
+  w.onSent();
+  w.onRejected();
+  CHECK(w.getInFlight() == inFlight);
+  CHECK(w.getBackoffs() == 5);
+
+  // Overdue callbacks are forgotten
+  w.expire();
+  CHECK(w.getInFlight() == 0);
+  CHECK(w.canSend());
+  // A late callback after expire() does not underflow
+  w.onComplete(true, now += 2);
+  CHECK(w.getInFlight() == 0);
+
+  // Rate: completions over the last full period
+  SendWindow r;
+  for (uint32_t t = 1; t <= 2 * SEND_WINDOW_RATE_MS; t += 4) {
+    r.onSent();
+    r.onComplete(true, t);
+  }
+  CHECK(r.getRate() >= 240 && r.getRate() <= 260);
+}
+
+// onRejected() on the sender task races onComplete() on the callback
+static void testTwoSides() {
+  SendWindow w;
+  const int rounds = 200000;
+  std::atomic<bool> outOfRange(false);
+
+  std::thread callback([&]() {
+    for (int i = 0; i < rounds; i++) {
+      w.onComplete(i % 3 != 0, i);
+      uint16_t window = w.getWindow();
+      if (window < SEND_WINDOW_MIN || window > SEND_WINDOW_MAX) outOfRange = true;
+    }
+  });
+  for (int i = 0; i < rounds; i++) {
+    w.onSent();
+    w.onSent();
+    w.onRejected();
+    if (i % 8 == 0) w.expire();
+  }
+  callback.join();
+
+  // Every halving is counted: rejected + expired + failed
+  uint32_t expected = rounds + (rounds + 7) / 8 + (rounds + 2) / 3;
+  CHECK(w.getBackoffs() == expected);
+  CHECK(!outOfRange);
+  printf("two threads: %u backoffs counted, window %u\n", w.getBackoffs(), w.getWindow());
+}
+
+struct Capacity {
+  double framesPerSecond;
+  uint16_t window;
+  uint32_t backoffs;
+  uint32_t rejected;
+};
+
+static Capacity stream(uint32_t bitRate, double loss, uint8_t retries, uint8_t queueDepth,
+                       const std::vector<std::vector<uint8_t>>& frames) {
+  SimLinkConfig link;
+  link.bitRate = bitRate;
+  link.lossPct = loss;
+  link.retries = retries;
+  link.queueDepth = queueDepth;
+  SimSenderConfig config;
+
+  EspNowSim sim(link);
+  std::vector<SimMac> macs = {simMac(0x10)};
+  SimSender camera(sim, simMac(0x01), macs, frames, config);
+  SimReceiver display(sim, macs[0], frames, true);
+  sim.run(10 * 1000000ULL);
+  return Capacity{display.getStats().framesCompleted / 10.0, camera.getWindow(), camera.getBackoffs(),
+                  camera.getStats().packetsRejected};
+}
+
+static void testCapacity() {
+  std::vector<std::vector<uint8_t>> frames = simLoadFrames(0, nullptr);
+  CHECK(!frames.empty());
+  if (frames.empty()) return;
+
+  printf("bit/s     loss  retries  queue  frames/s  window  backoffs  refused\n");
+  Capacity slow = stream(250000, 0, 0, 8, frames);
+  Capacity base = stream(1000000, 0, 0, 8, frames);
+  Capacity fast = stream(2000000, 0, 0, 8, frames);
+  Capacity lossy = stream(1000000, 10, 0, 8, frames);
+  Capacity retried = stream(1000000, 10, 3, 8, frames);
+  Capacity shallow = stream(1000000, 0, 0, 2, frames);
+  const Capacity* runs[] = {&slow, &base, &fast, &lossy, &retried, &shallow};
+  const char* labels[] = {"250000    0%      0      8", "1000000   0%      0      8", "2000000   0%      0      8",
+                          "1000000  10%      0      8", "1000000  10%      3      8", "1000000   0%      0      2"};
+  for (int i = 0; i < 6; i++) {
+    printf("%s  %8.2f  %6u  %8u  %7u\n", labels[i], runs[i]->framesPerSecond, runs[i]->window,
+           runs[i]->backoffs, runs[i]->rejected);
+  }
+
+  // Throughput follows the link, the window stays open on a clean one
+  CHECK(slow.framesPerSecond < base.framesPerSecond);
+  CHECK(base.framesPerSecond < fast.framesPerSecond);
+  CHECK(base.backoffs == 0 && base.window == SEND_WINDOW_MAX);
+  // Failed sends close it
+  CHECK(lossy.backoffs > 0);
+  // A driver queue shorter than the window: refusals back it off, and
+  // the stream keeps going
+  CHECK(shallow.rejected > 0 && shallow.backoffs > 0);
+  CHECK(shallow.framesPerSecond > 0.5 * base.framesPerSecond);
+}
+
+int main() {
+  testAimdTrace();
+  testTwoSides();
+  testCapacity();
+  return simTestResult("sendwindow_test");
+}
@@ -0,0 +1,167 @@
+// simulcast_bench.cpp
+//
+// One camera feeding a 320x240 display and a smaller one: simulcast (the
+// full layer unicast to the large display, a base layer re-encoded at the
+// reduction that covers the small one and broadcast to it) against two
+// unicast streams of the full picture. Prints the frame rate each display
+// gets and what a capture costs on the air, on a clean and a lossy link.
+//
+//   build/simulcast_bench [--loss=PCT] [--seconds=S]
+//
+// The small display gets the base layer only when the capture is at least
+// twice its size, as fullLayerReceivers() in ESPCAMSENDER.ino decides; a
+// 240x240 panel would find a 160x120 base layer smaller than itself, so it
+// gets the full layer and crops it (both streams are then the same).
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "SimCamera.h"
+#include "CameraWindow.h"
+
+#define MAC_RETRIES         3
+#define CAPTURE_WIDTH       320   // QVGA, windowed to the large display
+#define CAPTURE_HEIGHT      240
+#define CAMERA_QUALITY      80    // libjpeg quality standing in for the sensor's JPEG
+#define BASE_LAYER_QUALITY  60    // ESPCAMSENDER.ino
+
+struct SimulcastResult {
+  double fullFps;
+  double smallFps;
+  uint32_t p99Ms;        // Worse display's p99 latency
+  double airBytesPerCapture;
+  double airMsPerCapture;
+  double airtimePct;
+  bool corrupt;
+};
+
+// Bilinear resize of an RGB image to the capture size
+static std::vector<uint8_t> resize(const std::vector<uint8_t>& src, int sw, int sh, int dw, int dh) {
+  std::vector<uint8_t> dst((size_t)dw * dh * 3);
+  for (int y = 0; y < dh; y++) {
+    float fy = (y + 0.5f) * sh / dh - 0.5f;
+    int y0 = fy < 0 ? 0 : (int)fy;
+    int y1 = y0 + 1 < sh ? y0 + 1 : sh - 1;
+    float wy = fy - y0 < 0 ? 0 : fy - y0;
+    for (int x = 0; x < dw; x++) {
+      float fx = (x + 0.5f) * sw / dw - 0.5f;
+      int x0 = fx < 0 ? 0 : (int)fx;
+      int x1 = x0 + 1 < sw ? x0 + 1 : sw - 1;
+      float wx = fx - x0 < 0 ? 0 : fx - x0;
+      for (int c = 0; c < 3; c++) {
+        float top = src[(y0 * sw + x0) * 3 + c] * (1 - wx) + src[(y0 * sw + x1) * 3 + c] * wx;
+        float bottom = src[(y1 * sw + x0) * 3 + c] * (1 - wx) + src[(y1 * sw + x1) * 3 + c] * wx;
+        dst[((size_t)y * dw + x) * 3 + c] = (uint8_t)(top * (1 - wy) + bottom * wy + 0.5f);
+      }
+    }
+  }
+  return dst;
+}
+
+// Base layer of a capture: decoded at 1/scale and re-encoded, as
+// encodeBaseLayer() does with jpg2rgb565 and fmt2jpg
+static std::vector<uint8_t> baseLayer(const std::vector<uint8_t>& jpeg, int scale) {
+  std::vector<uint8_t> rgb;
+  int width, height;
+  if (!simDecodeJpeg(jpeg.data(), jpeg.size(), 3, scale, rgb, width, height)) return {};
+  return simEncodeJpeg(rgb.data(), width, height, BASE_LAYER_QUALITY);
+}
+
+// Display 0 is the large one, display 1 the small one
+static SimulcastResult run(bool simulcast, double loss, uint32_t seconds,
+                           const std::vector<std::vector<uint8_t>>& frames,
+                           const std::vector<std::vector<uint8_t>>& baseFrames) {
+  SimLinkConfig link;
+  link.lossPct = loss;
+  link.retries = MAC_RETRIES;
+  SimSenderConfig config;
+  if (simulcast) {
+    config.baseReceivers = 1 << 1;
+    config.baseFrames = &baseFrames;
+  }
+
+  EspNowSim sim(link);
+  std::vector<SimMac> macs = {simMac(0x10), simMac(0x11)};
+  SimSender camera(sim, simMac(0x01), macs, frames, config);
+  SimReceiver large(sim, macs[0], frames, true);
+  SimReceiver small(sim, macs[1], simulcast ? baseFrames : frames, true);
+  sim.run((uint64_t)seconds * 1000000);
+
+  SimulcastResult r;
+  const SimReceiverStats& full = large.getStats();
+  const SimReceiverStats& base = small.getStats();
+  r.fullFps = full.framesCompleted / (double)seconds;
+  r.smallFps = base.framesCompleted / (double)seconds;
+  r.p99Ms = std::max(simPercentile(full.latencyMs, 99), simPercentile(base.latencyMs, 99));
+  r.corrupt = full.framesCorrupt || base.framesCorrupt;
+  const SimStats& air = sim.getStats();
+  uint32_t sent = camera.getStats().framesSent;
+  r.airBytesPerCapture = sent ? (double)air.bytesOnAir / sent : 0;
+  r.airMsPerCapture = sent ? air.airtimeUs / 1000.0 / sent : 0;
+  r.airtimePct = air.airtimeUs * 100.0 / ((uint64_t)seconds * 1000000);
+  return r;
+}
+
+int main(int argc, char** argv) {
+  std::vector<double> losses = {0, 5};
+  uint32_t seconds = 20;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--loss=", 7) == 0) losses = {atof(argv[i] + 7)};
+    else if (strncmp(argv[i], "--seconds=", 10) == 0) seconds = atoi(argv[i] + 10);
+    else {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  // The sample images as QVGA captures
+  std::vector<std::vector<uint8_t>> frames;
+  for (const std::vector<uint8_t>& sample : simLoadFrames(0, nullptr)) {
+    std::vector<uint8_t> rgb;
+    int width, height;
+    if (!simDecodeJpeg(sample.data(), sample.size(), 3, 1, rgb, width, height)) continue;
+    std::vector<uint8_t> capture = resize(rgb, width, height, CAPTURE_WIDTH, CAPTURE_HEIGHT);
+    frames.push_back(simEncodeJpeg(capture.data(), CAPTURE_WIDTH, CAPTURE_HEIGHT, CAMERA_QUALITY));
+  }
+  if (frames.empty()) {
+    fprintf(stderr, "No frames: run from sim/\n");
+    return 1;
+  }
+  uint32_t bytes = 0;
+  for (const auto& frame : frames) bytes += frame.size();
+  printf("%zu captures of %dx%d, %u bytes avg, %u s per run, %d MAC retries for unicast\n", frames.size(),
+         CAPTURE_WIDTH, CAPTURE_HEIGHT, (unsigned)(bytes / frames.size()), seconds, MAC_RETRIES);
+  printf("loss  small display  layer  stream      fps 320x240  fps small  p99 ms  kB/capture  air ms/capture  busy\n");
+
+  const struct { uint16_t width; uint16_t height; } smallViews[] = {{160, 80}, {240, 240}};
+  bool failed = false;
+  for (double loss : losses) {
+    for (const auto& view : smallViews) {
+      uint8_t scale = camDecodeScale(CAPTURE_WIDTH, CAPTURE_HEIGHT, view.width, view.height);
+      std::vector<std::vector<uint8_t>> baseFrames;
+      if (scale >= 2) {
+        for (const auto& frame : frames) baseFrames.push_back(baseLayer(frame, scale));
+      }
+      std::string layer = scale >= 2 ? "1/" + std::to_string(scale) : "full";
+
+      SimulcastResult unicast = run(false, loss, seconds, frames, baseFrames);
+      SimulcastResult simulcast = scale >= 2 ? run(true, loss, seconds, frames, baseFrames) : unicast;
+      for (bool sc : {false, true}) {
+        const SimulcastResult& r = sc ? simulcast : unicast;
+        printf("%3.0f%%  %6ux%-6u  %-5s  %-10s  %11.2f  %9.2f  %6u  %10.1f  %14.1f  %3.0f%%\n", loss,
+               view.width, view.height, layer.c_str(), sc ? "simulcast" : "2 unicast", r.fullFps, r.smallFps,
+               r.p99Ms, r.airBytesPerCapture / 1000, r.airMsPerCapture, r.airtimePct);
+        failed |= r.corrupt;
+      }
+
+      // The base layer has to cost less airtime per capture than a second
+      // full stream
+      if (scale >= 2 && simulcast.airMsPerCapture >= unicast.airMsPerCapture) {
+        printf("      simulcast uses more air than two unicast streams\n");
+        failed = true;
+      }
+    }
+  }
+  return failed ? 1 : 0;
+}
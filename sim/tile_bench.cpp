@@ -0,0 +1,186 @@
+// tile_bench.cpp
+//
+// Changed-tile delta frames against full-frame JPEG. Runs the door
+// camera's TileEncoder (Slave_Camera/TileEncoder.cpp, built with the shims
+// in host/) over frame sequences and counts the bytes that go on the air
+// either way.
+//
+//   build/tile_bench                   synthetic sequences from the samples
+//   build/tile_bench f1.jpg f2.jpg ..  one recorded sequence, in order
+//
+// Each sample image is cut to QVGA and becomes 60-frame sequences with
+// sensor noise, JPEG-encoded as the camera would send them: a still
+// doorway, something small moving in it (a parcel, a cat), a visitor
+// crossing it, and an exposure change halfway through.
+//
+
+#include <chrono>
+#include <string>
+#include "SimJpeg.h"
+#include "TileEncoder.h"
+#include "Modules/ESPNOWCamera/Slave_Camera/CameraWindow.h"
+
+#define SEQUENCE_FRAMES 60
+#define CAMERA_QUALITY  70   // libjpeg quality standing in for the sensor's JPEG
+
+struct Rgb {
+  std::vector<uint8_t> pixels;
+  int width;
+  int height;
+};
+
+struct Totals {
+  uint32_t frames = 0;
+  uint32_t fullBytes = 0;    // Every frame sent whole
+  uint32_t sentBytes = 0;    // Keyframes whole, deltas, skips nothing
+  uint32_t keyframes = 0;
+  uint32_t deltas = 0;
+  uint32_t skips = 0;
+  uint32_t tiles = 0;
+  double encodeMs = 0;
+};
+
+static uint32_t noiseState = 1;
+static int noise(int amplitude) {
+  noiseState = noiseState * 1103515245 + 12345;
+  return (int)((noiseState >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+static uint8_t clamp(int v) { return v < 0 ? 0 : v > 255 ? 255 : v; }
+
+static Totals encodeSequence(TileEncoder& encoder, const std::vector<std::vector<uint8_t>>& jpegs) {
+  Totals t;
+  uint32_t tilesBefore = encoder.getTilesSent();
+  encoder.forceKeyframe();
+  for (const auto& jpeg : jpegs) {
+    uint16_t width = 0, height = 0;
+    camJpegSize(jpeg.data(), jpeg.size(), width, height);
+    camera_fb_t fb = {};
+    fb.buf = (uint8_t*)jpeg.data();
+    fb.len = jpeg.size();
+    fb.width = width;
+    fb.height = height;
+    fb.format = PIXFORMAT_JPEG;
+
+    camera_fb_t delta;
+    auto start = std::chrono::steady_clock::now();
+    TileResult result = encoder.encode(&fb, delta);
+    t.encodeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    t.frames++;
+    t.fullBytes += jpeg.size();
+    switch (result) {
+      case TILE_KEYFRAME: t.keyframes++; t.sentBytes += jpeg.size(); break;
+      case TILE_DELTA:    t.deltas++;    t.sentBytes += delta.len;   break;
+      case TILE_SKIP:     t.skips++;                                 break;
+    }
+  }
+  t.tiles = encoder.getTilesSent() - tilesBefore;
+  return t;
+}
+
+static void printRow(const char* image, const char* scene, const Totals& t) {
+  printf("%-14s %-9s %6.1f kB  %6.1f kB  %5.1fx  %3u/%-3u/%-3u  %6.1f  %6.2f\n", image, scene,
+         t.fullBytes / 1000.0, t.sentBytes / 1000.0, t.sentBytes ? (double)t.fullBytes / t.sentBytes : 0.0,
+         t.keyframes, t.deltas, t.skips, t.deltas ? (double)t.tiles / t.deltas : 0.0, t.encodeMs / t.frames);
+}
+
+enum Scene { STILL, SMALL, VISITOR, EXPOSURE };
+
+static std::vector<uint8_t> renderFrame(const Rgb& base, Scene scene, int frame) {
+  std::vector<uint8_t> out(base.pixels.size());
+  int offset = scene == EXPOSURE && frame >= SEQUENCE_FRAMES / 2 ? 30 : 0;
+  for (size_t i = 0; i < out.size(); i++) out[i] = clamp(base.pixels[i] + offset + noise(2));
+
+  if ((scene == SMALL || scene == VISITOR) && frame >= 15 && frame < 45) {
+    int figureW = scene == SMALL ? 24 : base.width / 6;
+    int figureH = scene == SMALL ? 24 : base.height * 2 / 3;
+    int x0 = (frame - 15) * (base.width - figureW) / 30;
+    for (int y = base.height - figureH; y < base.height; y++) {
+      for (int x = x0; x < x0 + figureW; x++) {
+        uint8_t* p = &out[(y * base.width + x) * 3];
+        p[0] = clamp(60 + noise(2));
+        p[1] = clamp(40 + noise(2));
+        p[2] = clamp(90 + noise(2));
+      }
+    }
+  }
+  return simEncodeJpeg(out.data(), base.width, base.height, CAMERA_QUALITY);
+}
+
+// The middle TILE_MAX_WIDTH x TILE_MAX_HEIGHT of a sample image
+static bool loadScene(const char* path, Rgb& scene) {
+  std::vector<uint8_t> jpeg = simReadFile(path);
+  Rgb full;
+  if (jpeg.empty() || !simDecodeJpeg(jpeg.data(), jpeg.size(), 3, 1, full.pixels, full.width, full.height)) {
+    return false;
+  }
+  scene.width = std::min(full.width, TILE_MAX_WIDTH);
+  scene.height = std::min(full.height, TILE_MAX_HEIGHT);
+  int x0 = (full.width - scene.width) / 2, y0 = (full.height - scene.height) / 2;
+  scene.pixels.resize((size_t)scene.width * scene.height * 3);
+  for (int y = 0; y < scene.height; y++) {
+    memcpy(&scene.pixels[(size_t)y * scene.width * 3], &full.pixels[((size_t)(y0 + y) * full.width + x0) * 3],
+           scene.width * 3);
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  static TileEncoder encoder;
+  if (!encoder.begin()) return 1;
+
+  printf("%-14s %-9s %9s  %9s  %6s  %-11s  %6s  %6s\n", "sequence", "scene", "full", "tiles", "ratio",
+         "key/del/skip", "t/del", "ms/fr");
+
+  if (argc > 1) {
+    std::vector<std::vector<uint8_t>> jpegs;
+    for (int i = 1; i < argc; i++) {
+      jpegs.push_back(simReadFile(argv[i]));
+      if (jpegs.back().empty()) {
+        fprintf(stderr, "Cannot read %s\n", argv[i]);
+        return 1;
+      }
+    }
+    printRow("recorded", "-", encodeSequence(encoder, jpegs));
+    return 0;
+  }
+
+  static const char* samples[] = {
+    "../Signal/SignalMaster/Data/lena20k.jpg",
+    "../Signal/SignalMaster/Data/Baboon40.jpg",
+    "../Signal/SignalMaster/Data/EagleEye.jpg",
+    "../Signal/SignalMaster/Data/Mouse480.jpg",
+  };
+  const Scene scenes[] = {STILL, SMALL, VISITOR, EXPOSURE};
+  const char* names[] = {"still", "small", "visitor", "exposure"};
+
+  Totals still;
+  int worse = 0;
+  for (const char* path : samples) {
+    Rgb base;
+    if (!loadScene(path, base)) {
+      fprintf(stderr, "Cannot read %s: run from sim/\n", path);
+      return 1;
+    }
+    std::string image = path;
+    image = image.substr(image.rfind('/') + 1);
+
+    for (int s = 0; s < 4; s++) {
+      std::vector<std::vector<uint8_t>> jpegs;
+      for (int f = 0; f < SEQUENCE_FRAMES; f++) jpegs.push_back(renderFrame(base, scenes[s], f));
+      Totals t = encodeSequence(encoder, jpegs);
+      printRow(image.c_str(), names[s], t);
+      if (t.sentBytes > t.fullBytes) worse++;
+      if (scenes[s] == STILL) {
+        still.fullBytes += t.fullBytes;
+        still.sentBytes += t.sentBytes;
+      }
+    }
+  }
+
+  printf("\nStill scenes: %.1fx fewer bytes on air than full frames; %d sequences cost more than full frames\n",
+         still.sentBytes ? (double)still.fullBytes / still.sentBytes : 0.0, worse);
+  printf("ms/fr is host time for the decode, signatures and tile encodes\n");
+  return worse ? 1 : 0;
+}